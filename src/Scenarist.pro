@@ -1,10 +1,13 @@
 TEMPLATE = subdirs
 
 SUBDIRS = libs \
-    bin/scenarist-desktop.pro
+    bin/scenarist-desktop.pro \
+    tests
 #	bin/scenarist-mobile.pro
 #    bin/scenarist-desktop.pro bin/scenarist-mobile.pro
 
+tests.depends = libs
+
 TRANSLATIONS += bin/scenarist-core/Resources/Translations/Scenarist_ru.ts \
     bin/scenarist-core/Resources/Translations/Scenarist_es.ts \
     bin/scenarist-core/Resources/Translations/Scenarist_fr.ts \
@@ -8,6 +8,7 @@
 #include <QHash>
 #include <QSet>
 #include <QString>
+#include <QVector>
 #include <QRegularExpression>
 
 namespace {
@@ -113,6 +114,28 @@ public:
                     );
     }
 
+    /**
+     * @brief Сформировать патч между двумя фрагментами xml-текстов
+     * @param _plainOffset - длина в плоском представлении общей части документов, идущей перед фрагментами
+     * @note Позиции патча смещаются на _plainOffset, поэтому патч применим к документу целиком
+     */
+    static QString makePatchXml(const QString& _xml1, const QString& _xml2, int _plainOffset) {
+        diff_match_patch dmp;
+        QList<Patch> patches = dmp.patch_make(xmlToPlain(_xml1), xmlToPlain(_xml2));
+        for (Patch& patch : patches) {
+            patch.start1 += _plainOffset;
+            patch.start2 += _plainOffset;
+        }
+        return plainToXml(dmp.patch_toText(patches));
+    }
+
+    /**
+     * @brief Длина xml-текста в плоском представлении, в котором формируются патчи
+     */
+    static int plainLength(const QString& _xml) {
+        return xmlToPlain(_xml).length();
+    }
+
     /**
      * @brief Применить патч для простого текста
      */
@@ -135,6 +158,105 @@ public:
                     );
     }
 
+    /**
+     * @brief Применить патч для фрагмента xml-текста
+     * @param _plainOffset - позиция фрагмента в плоском представлении документа, для которого сформирован патч
+     * @param _isApplied - удалось ли применить все части патча
+     */
+    static QString applyPatchXml(const QString& _xml, const QString& _patch, int _plainOffset, bool& _isApplied) {
+        diff_match_patch dmp;
+        QList<Patch> patches = dmp.patch_fromText(xmlToPlain(_patch));
+        for (Patch& patch : patches) {
+            patch.start1 -= _plainOffset;
+            patch.start2 -= _plainOffset;
+        }
+        const QPair<QString, QVector<bool> > result = dmp.patch_apply(patches, xmlToPlain(_xml));
+        _isApplied = !result.second.contains(false);
+        return plainToXml(result.first);
+    }
+
+    /**
+     * @brief Определить диапазон плоского представления документа, который может быть затронут патчем
+     * @note Диапазон расширяется на расстояние, в пределах которого ищется место применения частей патча,
+     *		 поэтому применение патча к фрагменту, включающему этот диапазон, равносильно применению
+     *		 патча ко всему документу
+     * @return Удалось ли разобрать патч
+     */
+    static bool patchPlainRange(const QString& _patch, int& _from, int& _to) {
+        diff_match_patch dmp;
+        const QList<Patch> patches = dmp.patch_fromText(xmlToPlain(_patch));
+        if (patches.isEmpty()) {
+            return false;
+        }
+
+        patchesPlainRange(patches, _from, _to);
+        return true;
+    }
+
+    /**
+     * @brief Определить диапазон блоков xml-текста, которые может затронуть патч
+     * @param _blocksPlainLengths - длины блоков в плоском представлении
+     * @param _fromBlock, _toBlock - первый и последний блоки диапазона
+     * @param _plainOffset - позиция первого блока диапазона в плоском представлении
+     * @note Применение патча к xml блоков диапазона с помощью applyPatchXml(xml, patch, plainOffset, isApplied)
+     *		 равносильно применению патча ко всему тексту
+     * @return Удалось ли определить диапазон
+     */
+    static bool patchBlocksRange(const QString& _patch, const QVector<int>& _blocksPlainLengths,
+        int& _fromBlock, int& _toBlock, int& _plainOffset) {
+        int plainFrom = 0, plainTo = 0;
+        if (!patchPlainRange(_patch, plainFrom, plainTo)) {
+            return false;
+        }
+
+        _fromBlock = -1;
+        _toBlock = _blocksPlainLengths.size() - 1;
+        _plainOffset = 0;
+        int blockPlainStart = 0;
+        for (int blockNumber = 0; blockNumber < _blocksPlainLengths.size(); ++blockNumber) {
+            const int blockPlainEnd = blockPlainStart + _blocksPlainLengths.at(blockNumber);
+            if (_fromBlock == -1
+                && blockPlainEnd > plainFrom) {
+                _fromBlock = blockNumber;
+                _plainOffset = blockPlainStart;
+            }
+            if (_fromBlock != -1
+                && blockPlainEnd >= plainTo) {
+                _toBlock = blockNumber;
+                break;
+            }
+            blockPlainStart = blockPlainEnd;
+        }
+        return _fromBlock != -1;
+    }
+
+    /**
+     * @brief Применить патч для xml-текста к его плоскому представлению
+     * @note Патч применяется только к затрагиваемому им фрагменту, который затем замещается в тексте,
+     *		 поэтому последовательное применение множества патчей не копирует весь текст для каждого из них
+     * @return Удалось ли применить все части патча
+     */
+    static bool applyPatchPlain(QString& _plain, const QString& _patch) {
+        diff_match_patch dmp;
+        QList<Patch> patches = dmp.patch_fromText(xmlToPlain(_patch));
+        if (patches.isEmpty()) {
+            return true;
+        }
+
+        int from = 0, to = 0;
+        patchesPlainRange(patches, from, to);
+        from = qMin(from, _plain.length());
+        to = qMin(to, _plain.length());
+        for (Patch& patch : patches) {
+            patch.start1 -= from;
+            patch.start2 -= from;
+        }
+
+        const QPair<QString, QVector<bool> > result = dmp.patch_apply(patches, _plain.mid(from, to - from));
+        _plain.replace(from, to - from, result.first);
+        return !result.second.contains(false);
+    }
+
     /**
      * @brief Изменение xml
      */
@@ -336,7 +458,6 @@ public:
         return result;
     }
 
-private:
     /**
      * @brief Преобразовать xml в плоский текст, заменяя тэги спецсимволами
      */
@@ -364,6 +485,33 @@ private:
         return xml;
     }
 
+private:
+    /**
+     * @brief Определить диапазон плоского текста, который может быть затронут частями патча
+     */
+    static void patchesPlainRange(const QList<Patch>& _patches, int& _from, int& _to) {
+        _from = -1;
+        _to = -1;
+        foreach (const Patch& patch, _patches) {
+            const int from = qMin(patch.start1, patch.start2);
+            const int to = qMax(patch.start1, patch.start2) + qMax(patch.length1, patch.length2);
+            if (_from == -1 || from < _from) {
+                _from = from;
+            }
+            if (_to == -1 || to > _to) {
+                _to = to;
+            }
+        }
+
+        //
+        // Каждая часть патча может сместить место применения последующих не далее,
+        // чем на расстояние поиска совпадения
+        //
+        const int searchDistance = diff_match_patch().Match_Distance * _patches.size();
+        _from = qMax(0, _from - searchDistance);
+        _to += searchDistance;
+    }
+
     /**
      * @brief Добавить тэг и его закрывающий аналог в карту соответствий
      */
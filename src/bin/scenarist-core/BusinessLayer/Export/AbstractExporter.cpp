@@ -24,8 +24,8 @@ namespace {
 	/**
 	 * @brief Стиль экспорта
 	 */
-	static ScenarioTemplate exportStyle() {
-		return ScenarioTemplateFacade::getTemplate(
+	static QSharedPointer<const ScenarioTemplate> exportStyle() {
+		return ScenarioTemplateFacade::sharedTemplate(
 					DataStorageLayer::StorageFacade::settingsStorage()->value(
 						"export/style",
 						DataStorageLayer::SettingsStorage::ApplicationSettings)
@@ -36,8 +36,8 @@ namespace {
 	 * @brief Определить размер страницы документа
 	 */
 	static QSizeF documentSize() {
-		QSizeF pageSize = QPageSize(exportStyle().pageSizeId()).size(QPageSize::Millimeter);
-		QMarginsF pageMargins = exportStyle().pageMargins();
+		QSizeF pageSize = QPageSize(exportStyle()->pageSizeId()).size(QPageSize::Millimeter);
+		QMarginsF pageMargins = exportStyle()->pageMargins();
 
 		return QSizeF(
 					PageMetrics::mmToPx(pageSize.width() - pageMargins.left() - pageMargins.right()),
@@ -49,7 +49,7 @@ namespace {
 	 * @brief Получить стиль оформления символов для заданного типа
 	 */
 	static QTextCharFormat charFormatForType(ScenarioBlockStyle::Type _type) {
-		QTextCharFormat format = exportStyle().blockStyle(_type).charFormat();
+		QTextCharFormat format = exportStyle()->blockStyle(_type).charFormat();
 
 		//
 		// Очищаем цвета
@@ -63,7 +63,7 @@ namespace {
 	 * @brief Получить стиль оформления абзаца для заданного типа
 	 */
 	static QTextBlockFormat blockFormatForType(ScenarioBlockStyle::Type _type) {
-		ScenarioBlockStyle style = exportStyle().blockStyle(_type);
+		ScenarioBlockStyle style = exportStyle()->blockStyle(_type);
 		QTextBlockFormat format = style.blockFormat();
 
 		format.setProperty(ScenarioBlockStyle::PropertyType, _type);
@@ -139,87 +139,6 @@ namespace {
 		_cursor.insertBlock(_blockFormat, _charFormat);
 	}
 
-	/**
-	 * @brief Определить тип следующей строки документа
-	 */
-	static LineType currentLine(QTextDocument* _inDocument, const QTextBlockFormat& _blockFormat,
-		const QTextCharFormat& _charFormat) {
-		LineType type = UndefinedLine;
-
-		if (_inDocument->isEmpty()) {
-			type = FirstDocumentLine;
-		} else {
-			//
-			// Определяем конец страницы или середина при помощи проверки
-			// на количество страниц, после вставки новой строки
-			//
-			const int documentPagesCount = _inDocument->pageCount();
-			QTextCursor cursor(_inDocument);
-			cursor.movePosition(QTextCursor::End);
-			insertLine(cursor, _blockFormat, _charFormat);
-			const int documentPagesCountWithNextLine = _inDocument->pageCount();
-			cursor.deletePreviousChar();
-			if (documentPagesCount == documentPagesCountWithNextLine) {
-				type = MiddlePageLine;
-			} else {
-				type = LastPageLine;
-			}
-		}
-
-		return type;
-	}
-
-	/**
-	 * @brief Оптимизированная версия подсчёта кол-ва строк до конца страницы
-	 */
-	static int linesToEndOfPage(QTextDocument* _inDocument, const QTextBlockFormat& _blockFormat,
-		const QTextCharFormat& _charFormat, const int _blockLines) {
-		//
-		// Минимальное количество строк для проверки
-		//
-		const int MINIMUM_LINES_FOR_CHECK = 3;
-
-		int result = 0;
-
-		//
-		// Считаем количество строк
-		//
-		QTextCursor cursor(_inDocument);
-		cursor.movePosition(QTextCursor::End);
-		// ... количество страниц в исходном документе
-		const int documentPagesCount = _inDocument->pageCount();
-		// ... верхняя граница количества строк для проверки
-		const int checkLimit =
-				(_blockLines < MINIMUM_LINES_FOR_CHECK) ? MINIMUM_LINES_FOR_CHECK : _blockLines;
-		// ... тип текущей линии
-		LineType type = UndefinedLine;
-
-		while (type != LastPageLine
-			   && result <= checkLimit) {
-
-			insertLine(cursor, _blockFormat, _charFormat);
-			++result;
-
-			if (documentPagesCount == _inDocument->pageCount()) {
-				type = MiddlePageLine;
-			} else {
-				type = LastPageLine;
-				cursor.deletePreviousChar();
-				--result;
-			}
-		}
-
-		//
-		// Возвращаем документ в исходное состояние
-		//
-		int deleteLines = result;
-		while (deleteLines-- > 0)  {
-			cursor.deletePreviousChar();
-		}
-
-		return result;
-	}
-
 	/**
 	 * @brief Поссчитать кол-во строк, занимаемых текстом
 	 */
@@ -228,8 +147,11 @@ namespace {
 		//
 		// Определим ширину линии текста
 		//
+		// NOTE: берём ширину страницы, а не размер документа, т.к. для получения последнего
+		//		 документ будет полностью свёрстан
+		//
 		const qreal lineWidth =
-				_inDocument->size().width()
+				_inDocument->pageSize().width()
 				- _inDocument->rootFrame()->frameFormat().leftMargin()
 				- _inDocument->rootFrame()->frameFormat().rightMargin()
 				- _blockFormat.leftMargin()
@@ -260,6 +182,207 @@ namespace {
 		return linesCount;
 	}
 
+	/**
+	 * @brief Модель разбиения подготавливаемого документа на страницы
+	 *
+	 * Высота строк всех блоков зафиксирована стилями шаблона, поэтому разбиение на страницы
+	 * рассчитывается арифметически по количеству строк и отступам блоков, без вёрстки документа.
+	 * Расчёт запоминается для каждого блока и после изменения документа повторяется только
+	 * для изменённых блоков, которые при подготовке документа всегда находятся в его конце.
+	 */
+	class PageBreaksModel
+	{
+	public:
+		explicit PageBreaksModel(QTextDocument* _document) :
+			m_document(_document),
+			m_pageHeight(_document->pageSize().height())
+		{}
+
+		/**
+		 * @brief Определить тип следующей строки документа
+		 */
+		LineType nextLineType(const QTextBlockFormat& _blockFormat, const QTextCharFormat& _charFormat) {
+			if (m_document->isEmpty()) {
+				return FirstDocumentLine;
+			}
+
+			update();
+
+			//
+			// Определяем конец страницы или середина при помощи проверки на то,
+			// попадёт ли новая строка на текущую страницу
+			//
+			const BlockLayout lastBlock = m_blocks.isEmpty() ? BlockLayout() : m_blocks.last();
+			const BlockLayout nextLine = layoutBlock(lastBlock, _blockFormat, _charFormat, 1);
+			return nextLine.page == lastBlock.page ? MiddlePageLine : LastPageLine;
+		}
+
+		/**
+		 * @brief Посчитать сколько строк заданного формата поместится до конца страницы
+		 * @note Проверяется не более, чем _checkLimit + 1 строк
+		 */
+		int linesToEndOfPage(const QTextBlockFormat& _blockFormat, const QTextCharFormat& _charFormat,
+			int _checkLimit) {
+			update();
+
+			int result = 0;
+			const BlockLayout lastBlock = m_blocks.isEmpty() ? BlockLayout() : m_blocks.last();
+			BlockLayout nextLine = layoutBlock(lastBlock, _blockFormat, _charFormat, 1);
+			while (nextLine.page == lastBlock.page
+				   && result <= _checkLimit) {
+				++result;
+				nextLine = layoutBlock(nextLine, _blockFormat, _charFormat, 1);
+			}
+
+			return result;
+		}
+
+	private:
+		/**
+		 * @brief Расположение блока в документе
+		 */
+		struct BlockLayout {
+			BlockLayout() : position(0), length(0), page(0), bottom(0) {}
+
+			/**
+			 * @brief Данные блока, по которым определяется его изменение
+			 */
+			/** @{ */
+			int position;
+			int length;
+			QTextBlockFormat blockFormat;
+			QTextCharFormat charFormat;
+			/** @} */
+
+			/**
+			 * @brief Номер страницы, на которой заканчивается блок
+			 */
+			int page;
+
+			/**
+			 * @brief Позиция нижней границы блока, с учётом отступа, от начала страницы
+			 */
+			qreal bottom;
+		};
+
+		/**
+		 * @brief Расположить блок из заданного количества строк после заданного блока
+		 *
+		 * Повторяет правила вёрстки QTextDocument: строка, не умещающаяся на странице,
+		 * переносится в начало следующей
+		 */
+		BlockLayout layoutBlock(const BlockLayout& _previousBlock, const QTextBlockFormat& _blockFormat,
+			const QTextCharFormat& _charFormat, int _lines) const {
+			const qreal lineHeight =
+					_blockFormat.lineHeightType() == QTextBlockFormat::FixedHeight
+					? _blockFormat.lineHeight()
+					: TextEditHelper::fontLineHeight(_charFormat.font());
+
+			BlockLayout result;
+			result.page = _previousBlock.page;
+			qreal top = _previousBlock.bottom + _blockFormat.topMargin();
+			for (int line = 0; line < _lines; ++line) {
+				if (top > 0
+					&& top + lineHeight > m_pageHeight) {
+					++result.page;
+					top = 0;
+				}
+				top += lineHeight;
+			}
+			result.bottom = top + _blockFormat.bottomMargin();
+			return result;
+		}
+
+		/**
+		 * @brief Проверить, соответствует ли сохранённое расположение блоку документа
+		 */
+		static bool isActual(const BlockLayout& _layout, const QTextBlock& _block) {
+			return _layout.position == _block.position()
+					&& _layout.length == _block.length()
+					&& _layout.blockFormat == _block.blockFormat()
+					&& _layout.charFormat == _block.charFormat();
+		}
+
+		/**
+		 * @brief Обновить расположение изменившихся блоков
+		 */
+		void update() {
+			//
+			// Ищем последний не изменившийся блок, двигаясь от конца документа
+			//
+			int actualBlocksCount = qMin(m_blocks.size(), m_document->blockCount());
+			QTextBlock block = m_document->findBlockByNumber(actualBlocksCount - 1);
+			while (actualBlocksCount > 0
+				   && !isActual(m_blocks.at(actualBlocksCount - 1), block)) {
+				--actualBlocksCount;
+				block = block.previous();
+			}
+			m_blocks.resize(actualBlocksCount);
+
+			//
+			// Рассчитываем расположение всех последующих блоков
+			//
+			block = actualBlocksCount > 0 ? block.next() : m_document->begin();
+			while (block.isValid()) {
+				const QTextBlockFormat blockFormat = block.blockFormat();
+				const QTextCharFormat charFormat = block.charFormat();
+				const int lines = qMax(1, linesOfText(m_document, blockFormat, charFormat, block.text()));
+				BlockLayout layout =
+						layoutBlock(m_blocks.isEmpty() ? BlockLayout() : m_blocks.last(), blockFormat, charFormat, lines);
+				layout.position = block.position();
+				layout.length = block.length();
+				layout.blockFormat = blockFormat;
+				layout.charFormat = charFormat;
+				m_blocks.append(layout);
+
+				block = block.next();
+			}
+		}
+
+	private:
+		/**
+		 * @brief Документ
+		 */
+		QTextDocument* m_document;
+
+		/**
+		 * @brief Высота страницы
+		 */
+		const qreal m_pageHeight;
+
+		/**
+		 * @brief Расположение блоков документа
+		 */
+		QVector<BlockLayout> m_blocks;
+	};
+
+	/**
+	 * @brief Определить тип следующей строки документа
+	 */
+	static LineType currentLine(PageBreaksModel& _pageBreaks, const QTextBlockFormat& _blockFormat,
+		const QTextCharFormat& _charFormat) {
+		return _pageBreaks.nextLineType(_blockFormat, _charFormat);
+	}
+
+	/**
+	 * @brief Посчитать кол-во строк до конца страницы
+	 */
+	static int linesToEndOfPage(PageBreaksModel& _pageBreaks, const QTextBlockFormat& _blockFormat,
+		const QTextCharFormat& _charFormat, const int _blockLines) {
+		//
+		// Минимальное количество строк для проверки
+		//
+		const int MINIMUM_LINES_FOR_CHECK = 3;
+
+		//
+		// ... верхняя граница количества строк для проверки
+		//
+		const int checkLimit =
+				(_blockLines < MINIMUM_LINES_FOR_CHECK) ? MINIMUM_LINES_FOR_CHECK : _blockLines;
+
+		return _pageBreaks.linesToEndOfPage(_blockFormat, _charFormat, checkLimit);
+	}
+
 	/**
 	 * @brief Поссчитать кол-во строк, занимаемых текущим блоком
 	 */
@@ -386,7 +509,7 @@ namespace {
 					//
 					// ... пустые строки
 					//
-					int emptyLines = exportStyle().blockStyle(currentBlockType).topSpace();
+					int emptyLines = exportStyle()->blockStyle(currentBlockType).topSpace();
 					_destDocumentCursor.movePosition(QTextCursor::PreviousBlock, QTextCursor::MoveAnchor, emptyLines);
 					insertLines += emptyLines;
 					//
@@ -567,7 +690,7 @@ namespace {
 					//
 					// ... пустые строки
 					//
-					int emptyLines = exportStyle().blockStyle(currentBlockType).topSpace();
+					int emptyLines = exportStyle()->blockStyle(currentBlockType).topSpace();
 					_destDocumentCursor.movePosition(QTextCursor::PreviousBlock, QTextCursor::MoveAnchor, emptyLines);
 					insertLines += emptyLines;
 					//
@@ -593,7 +716,7 @@ namespace {
 					//
 					// ... пустые строки
 					//
-					int emptyLines = exportStyle().blockStyle(currentBlockType).topSpace();
+					int emptyLines = exportStyle()->blockStyle(currentBlockType).topSpace();
 					_destDocumentCursor.movePosition(QTextCursor::PreviousBlock, QTextCursor::MoveAnchor, emptyLines);
 					insertLines += emptyLines;
 					//
@@ -750,7 +873,7 @@ namespace {
 								//
 								// ... пустые строки
 								//
-								int emptyLines = exportStyle().blockStyle(currentBlockType).topSpace();
+								int emptyLines = exportStyle()->blockStyle(currentBlockType).topSpace();
 								_destDocumentCursor.movePosition(QTextCursor::PreviousBlock, QTextCursor::MoveAnchor, emptyLines);
 								insertLines += emptyLines;
 								//
@@ -773,7 +896,7 @@ namespace {
 								//
 								// ... пустые строки
 								//
-								int emptyLines = exportStyle().blockStyle(currentBlockType).topSpace();
+								int emptyLines = exportStyle()->blockStyle(currentBlockType).topSpace();
 								_destDocumentCursor.movePosition(QTextCursor::PreviousBlock, QTextCursor::MoveAnchor, emptyLines);
 								insertLines += emptyLines;
 								//
@@ -836,8 +959,10 @@ namespace {
 	 * @brief Проверить переносы текста на разрывах страниц и в случае необходимости их корректировка
 	 * @param Курсор в исходном документа
 	 * @param Крсор в целевом документе
+	 * @param Модель разбиения целевого документа на страницы
 	 */
-	static void checkPageBreak(QTextCursor& _sourceDocumentCursor, QTextCursor& _destDocumentCursor) {
+	static void checkPageBreak(QTextCursor& _sourceDocumentCursor, QTextCursor& _destDocumentCursor,
+		PageBreaksModel& _pageBreaks) {
 		//
 		// Получим необходимые для работы параметры
 		//
@@ -854,7 +979,7 @@ namespace {
 		// Посчитаем сколько строк до конца страницы и сколько строк в блоке
 		//
 		const int blockLines = linesOfText(preparedDocument, blockFormat, charFormat, _sourceDocumentCursor.block().text());
-		const int linesToEndOfPageCount = linesToEndOfPage(preparedDocument, blockFormat, charFormat, blockLines);
+		const int linesToEndOfPageCount = linesToEndOfPage(_pageBreaks, blockFormat, charFormat, blockLines);
 
 		//
 		// Для блоков "Время и место" и "Группа сцен"
@@ -901,7 +1026,7 @@ namespace {
 QTextDocument* AbstractExporter::prepareDocument(const BusinessLogic::ScenarioDocument* _scenario,
 		const ExportParameters& _exportParameters)
 {
-	ScenarioTemplate exportStyle = ::exportStyle();
+	const QSharedPointer<const ScenarioTemplate> exportStyle = ::exportStyle();
 
 	//
 	// Настроим новый документ
@@ -914,6 +1039,10 @@ QTextDocument* AbstractExporter::prepareDocument(const BusinessLogic::ScenarioDo
 	// Настроим размер страниц
 	//
 	preparedDocument->setPageSize(::documentSize());
+	//
+	// ... и модель разбиения на страницы
+	//
+	PageBreaksModel pageBreaks(preparedDocument);
 
 	//
 	// Данные считываются из исходного документа, если необходимо преобразовываются,
@@ -944,7 +1073,7 @@ QTextDocument* AbstractExporter::prepareDocument(const BusinessLogic::ScenarioDo
 	//
 	if (_exportParameters.printTilte) {
 		QTextCharFormat titleFormat;
-		titleFormat.setFont(exportStyle.blockStyle(ScenarioBlockStyle::Action).font());
+		titleFormat.setFont(exportStyle->blockStyle(ScenarioBlockStyle::Action).font());
 		QTextBlockFormat centerFormat;
 		centerFormat.setAlignment(Qt::AlignCenter);
 		centerFormat.setLineHeight(
@@ -1012,11 +1141,11 @@ QTextDocument* AbstractExporter::prepareDocument(const BusinessLogic::ScenarioDo
 		//
 		// Год печатается на последней строке документа
 		//
-		LineType currentLineType = ::currentLine(preparedDocument, centerFormat, titleFormat);
+		LineType currentLineType = ::currentLine(pageBreaks, centerFormat, titleFormat);
 		while (currentLineType != LastPageLine) {
 			++currentLineNumber;
 			::insertLine(destDocumentCursor, centerFormat, titleFormat);
-			currentLineType = ::currentLine(preparedDocument, centerFormat, titleFormat);
+			currentLineType = ::currentLine(pageBreaks, centerFormat, titleFormat);
 		}
 		destDocumentCursor.insertText(_exportParameters.scenarioYear);
 	}
@@ -1057,9 +1186,9 @@ QTextDocument* AbstractExporter::prepareDocument(const BusinessLogic::ScenarioDo
 			// Если вставляется не первый блок текста, возможно следует сделать отступы
 			//
 			{
-				LineType currentLineType = ::currentLine(preparedDocument, blockFormat, charFormat);
+				LineType currentLineType = ::currentLine(pageBreaks, blockFormat, charFormat);
 				if (currentLineType == MiddlePageLine) {
-					int emptyLines = exportStyle.blockStyle(currentBlockType).topSpace();
+					int emptyLines = exportStyle->blockStyle(currentBlockType).topSpace();
 					//
 					// Корректируем кол-во вставляемых строк в зависимости от предыдущего блока
 					//
@@ -1081,7 +1210,7 @@ QTextDocument* AbstractExporter::prepareDocument(const BusinessLogic::ScenarioDo
 						// ... вставим линию и настроим её стиль
 						//
 						::insertLine(destDocumentCursor, blockFormat, charFormat);
-						currentLineType = ::currentLine(preparedDocument, blockFormat, charFormat);
+						currentLineType = ::currentLine(pageBreaks, blockFormat, charFormat);
 					}
 				}
 			}
@@ -1090,7 +1219,7 @@ QTextDocument* AbstractExporter::prepareDocument(const BusinessLogic::ScenarioDo
 			// Проверяем разрывы страниц, на корректность переноса
 			//
 			if (_exportParameters.checkPageBreaks) {
-				::checkPageBreak(sourceDocumentCursor, destDocumentCursor);
+				::checkPageBreak(sourceDocumentCursor, destDocumentCursor, pageBreaks);
 			}
 
 			//
@@ -1100,7 +1229,7 @@ QTextDocument* AbstractExporter::prepareDocument(const BusinessLogic::ScenarioDo
 				//
 				// ... если вставляется не первый блок текста
 				//
-				LineType currentLineType = ::currentLine(preparedDocument, blockFormat, charFormat);
+				LineType currentLineType = ::currentLine(pageBreaks, blockFormat, charFormat);
 				if (currentLineType != FirstDocumentLine) {
 					//
 					// ... вставим новый абзац для наполнения текстом
@@ -1180,9 +1309,9 @@ QTextDocument* AbstractExporter::prepareDocument(const BusinessLogic::ScenarioDo
 			// После текста, так же возможно следует сделать отступы
 			//
 			{
-				LineType currentLineType = ::currentLine(preparedDocument, blockFormat, charFormat);
+				LineType currentLineType = ::currentLine(pageBreaks, blockFormat, charFormat);
 				if (currentLineType == MiddlePageLine) {
-					int emptyLines = exportStyle.blockStyle(currentBlockType).bottomSpace();
+					int emptyLines = exportStyle->blockStyle(currentBlockType).bottomSpace();
 					//
 					// ... сохраним кол-во пустых строк в последнем блоке
 					//
@@ -1197,7 +1326,7 @@ QTextDocument* AbstractExporter::prepareDocument(const BusinessLogic::ScenarioDo
 						// ... вставим линию и настроим её стиль
 						//
 						::insertLine(destDocumentCursor, blockFormat, charFormat);
-						currentLineType = ::currentLine(preparedDocument, blockFormat, charFormat);
+						currentLineType = ::currentLine(pageBreaks, blockFormat, charFormat);
 					}
 				}
 			}
@@ -27,8 +27,8 @@ namespace {
 	/**
 	 * @brief Стиль экспорта
 	 */
-	static ScenarioTemplate exportStyle() {
-		return ScenarioTemplateFacade::getTemplate(
+	static QSharedPointer<const ScenarioTemplate> exportStyle() {
+		return ScenarioTemplateFacade::sharedTemplate(
 					DataStorageLayer::StorageFacade::settingsStorage()->value(
 						"export/style",
 						DataStorageLayer::SettingsStorage::ApplicationSettings)
@@ -70,9 +70,9 @@ namespace {
 	 * @brief Нужно ли записывать шрифты в файл
 	 */
 	static bool needWriteFonts() {
-		const ScenarioTemplate exportTemplate = exportStyle();
+		const QSharedPointer<const ScenarioTemplate> exportTemplate = exportStyle();
 		for (const ScenarioBlockStyle::Type type : blockTypes().values()) {
-			if (exportTemplate.blockStyle(type).font().family() == "Courier Prime") {
+			if (exportTemplate->blockStyle(type).font().family() == "Courier Prime") {
 				return true;
 			}
 		}
@@ -536,7 +536,7 @@ void DocxExporter::writeStaticData(QtZipWriter* _zip, const ExportParameters& _e
 	// ... необходимы ли колонтитулы
 	//
 	if (_exportParameters.printPagesNumbers) {
-		if (::exportStyle().numberingAlignment().testFlag(Qt::AlignTop)) {
+		if (::exportStyle()->numberingAlignment().testFlag(Qt::AlignTop)) {
 			contentTypesXml.append("<Override PartName=\"/word/header1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.wordprocessingml.header+xml\"/>");
 		} else {
 			contentTypesXml.append("<Override PartName=\"/word/footer1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.wordprocessingml.footer+xml\"/>");
@@ -569,7 +569,7 @@ void DocxExporter::writeStaticData(QtZipWriter* _zip, const ExportParameters& _e
 	// ... необходимы ли колонтитулы
 	//
 	if (_exportParameters.printPagesNumbers) {
-		if (::exportStyle().numberingAlignment().testFlag(Qt::AlignTop)) {
+		if (::exportStyle()->numberingAlignment().testFlag(Qt::AlignTop)) {
 			documentXmlRels.append("<Relationship Id=\"docRId2\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/header\" Target=\"header1.xml\"/>");
 		} else {
 			documentXmlRels.append("<Relationship Id=\"docRId3\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/footer\" Target=\"footer1.xml\"/>");
@@ -629,10 +629,10 @@ void DocxExporter::writeStyles(QtZipWriter* _zip) const
 	//
 	// Настройки в соответсвии со стилем
 	//
-	ScenarioTemplate style = ::exportStyle();
-	const QString defaultFontFamily = style.blockStyle(ScenarioBlockStyle::Action).font().family();
+	const QSharedPointer<const ScenarioTemplate> style = ::exportStyle();
+	const QString defaultFontFamily = style->blockStyle(ScenarioBlockStyle::Action).font().family();
 	foreach (int blockNumber, ::blockTypes().keys()) {
-		ScenarioBlockStyle blockStyle = style.blockStyle(::blockTypes().value(blockNumber));
+		ScenarioBlockStyle blockStyle = style->blockStyle(::blockTypes().value(blockNumber));
 		styleXml.append(::docxBlockStyle(blockStyle, defaultFontFamily));
 	}
 
@@ -691,16 +691,16 @@ void DocxExporter::writeHeader(QtZipWriter* _zip, const ExportParameters& _expor
 	// Если нужна нумерация вверху
 	//
 	if (_exportParameters.printPagesNumbers
-		&& ::exportStyle().numberingAlignment().testFlag(Qt::AlignTop)) {
+		&& ::exportStyle()->numberingAlignment().testFlag(Qt::AlignTop)) {
 		QString headerXml =
 				"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
 				"<w:hdr xmlns:o=\"urn:schemas-microsoft-com:office:office\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" xmlns:v=\"urn:schemas-microsoft-com:vml\" xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\" xmlns:w10=\"urn:schemas-microsoft-com:office:word\" xmlns:wp=\"http://schemas.openxmlformats.org/drawingml/2006/wordprocessingDrawing\">";
 
 
 		headerXml.append("<w:p><w:pPr><w:jc w:val=\"");
-		if (::exportStyle().numberingAlignment().testFlag(Qt::AlignLeft)) {
+		if (::exportStyle()->numberingAlignment().testFlag(Qt::AlignLeft)) {
 			headerXml.append("left");
-		} else if (::exportStyle().numberingAlignment().testFlag(Qt::AlignCenter)) {
+		} else if (::exportStyle()->numberingAlignment().testFlag(Qt::AlignCenter)) {
 			headerXml.append("center");
 		} else {
 			headerXml.append("right");
@@ -721,15 +721,15 @@ void DocxExporter::writeFooter(QtZipWriter* _zip, const ExportParameters& _expor
 	// Если нужна нумерация внизу
 	//
 	if (_exportParameters.printPagesNumbers
-		&& ::exportStyle().numberingAlignment().testFlag(Qt::AlignBottom)) {
+		&& ::exportStyle()->numberingAlignment().testFlag(Qt::AlignBottom)) {
 		QString footerXml =
 				"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
 				"<w:ftr xmlns:o=\"urn:schemas-microsoft-com:office:office\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" xmlns:v=\"urn:schemas-microsoft-com:vml\" xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\" xmlns:w10=\"urn:schemas-microsoft-com:office:word\" xmlns:wp=\"http://schemas.openxmlformats.org/drawingml/2006/wordprocessingDrawing\">";
 
 		footerXml.append("<w:p><w:pPr><w:jc w:val=\"");
-		if (::exportStyle().numberingAlignment().testFlag(Qt::AlignLeft)) {
+		if (::exportStyle()->numberingAlignment().testFlag(Qt::AlignLeft)) {
 			footerXml.append("left");
-		} else if (::exportStyle().numberingAlignment().testFlag(Qt::AlignCenter)) {
+		} else if (::exportStyle()->numberingAlignment().testFlag(Qt::AlignCenter)) {
 			footerXml.append("center");
 		} else {
 			footerXml.append("right");
@@ -775,13 +775,13 @@ void DocxExporter::writeDocument(QtZipWriter* _zip, ScenarioDocument* _scenario,
 	//
 	// В конце идёт блок настроек страницы
 	//
-	ScenarioTemplate style = ::exportStyle();
+	const QSharedPointer<const ScenarioTemplate> style = ::exportStyle();
 	documentXml.append("<w:sectPr>");
 	//
 	// ... колонтитулы
 	//
 	if (_exportParameters.printPagesNumbers) {
-		if (style.numberingAlignment().testFlag(Qt::AlignTop)) {
+		if (style->numberingAlignment().testFlag(Qt::AlignTop)) {
 			documentXml.append("<w:headerReference w:type=\"default\" r:id=\"docRId2\"/>");
 		} else {
 			documentXml.append("<w:footerReference w:type=\"default\" r:id=\"docRId3\"/>");
@@ -790,7 +790,7 @@ void DocxExporter::writeDocument(QtZipWriter* _zip, ScenarioDocument* _scenario,
 	//
 	// ... размер страницы
 	//
-	QSizeF paperSize = QPageSize(style.pageSizeId()).size(QPageSize::Millimeter);
+	QSizeF paperSize = QPageSize(style->pageSizeId()).size(QPageSize::Millimeter);
 	documentXml.append(
 		QString("<w:pgSz w:w=\"%1\" w:h=\"%2\"/>")
 		.arg(::mmToTwips(paperSize.width()))
@@ -801,12 +801,12 @@ void DocxExporter::writeDocument(QtZipWriter* _zip, ScenarioDocument* _scenario,
 	//
 	documentXml.append(
 		QString("<w:pgMar w:left=\"%1\" w:right=\"%2\" w:top=\"%3\" w:bottom=\"%4\" w:header=\"%5\" w:footer=\"%6\" w:gutter=\"0\"/>")
-		.arg(::mmToTwips(style.pageMargins().left()))
-		.arg(::mmToTwips(style.pageMargins().right()))
-		.arg(::mmToTwips(style.pageMargins().top()))
-		.arg(::mmToTwips(style.pageMargins().bottom()))
-		.arg(::mmToTwips(style.pageMargins().top() / 2))
-		.arg(::mmToTwips(style.pageMargins().bottom() / 2))
+		.arg(::mmToTwips(style->pageMargins().left()))
+		.arg(::mmToTwips(style->pageMargins().right()))
+		.arg(::mmToTwips(style->pageMargins().top()))
+		.arg(::mmToTwips(style->pageMargins().bottom()))
+		.arg(::mmToTwips(style->pageMargins().top() / 2))
+		.arg(::mmToTwips(style->pageMargins().bottom() / 2))
 		);
 	//
 	// ... нужна ли титульная страница
@@ -19,8 +19,8 @@ namespace {
 	/**
 	 * @brief Стиль экспорта
 	 */
-	static ScenarioTemplate exportStyle() {
-		return ScenarioTemplateFacade::getTemplate(
+	static QSharedPointer<const ScenarioTemplate> exportStyle() {
+		return ScenarioTemplateFacade::sharedTemplate(
 					DataStorageLayer::StorageFacade::settingsStorage()->value(
 						"export/style",
 						DataStorageLayer::SettingsStorage::ApplicationSettings)
@@ -177,9 +177,9 @@ void FdxExporter::writeSettings(QXmlStreamWriter& _writer) const
 	//
 	// Информация о параметрах страницы
 	//
-	ScenarioTemplate exportStyle = ::exportStyle();
+	const QSharedPointer<const ScenarioTemplate> exportStyle = ::exportStyle();
 	QString pageHeight, pageWidth;
-	switch (exportStyle.pageSizeId()) {
+	switch (exportStyle->pageSizeId()) {
 		case QPageSize::A4: {
 			pageHeight = "11.69";
 			pageWidth = "8.26";
@@ -29,8 +29,8 @@ namespace {
 	/**
 	 * @brief Стиль экспорта
 	 */
-	static ScenarioTemplate exportStyle() {
-		return ScenarioTemplateFacade::getTemplate(
+	static QSharedPointer<const ScenarioTemplate> exportStyle() {
+		return ScenarioTemplateFacade::sharedTemplate(
 					DataStorageLayer::StorageFacade::settingsStorage()->value(
 						"export/style",
 						DataStorageLayer::SettingsStorage::ApplicationSettings)
@@ -105,15 +105,15 @@ namespace {
 				// Определяем где положено находиться нумерации
 				//
 				QRectF numberingRect;
-				if (exportStyle().numberingAlignment().testFlag(Qt::AlignTop)) {
+				if (exportStyle()->numberingAlignment().testFlag(Qt::AlignTop)) {
 					numberingRect = headerRect;
 				} else {
 					numberingRect = footerRect;
 				}
 				Qt::Alignment numberingAlignment = Qt::AlignVCenter;
-				if (exportStyle().numberingAlignment().testFlag(Qt::AlignLeft)) {
+				if (exportStyle()->numberingAlignment().testFlag(Qt::AlignLeft)) {
 					numberingAlignment |= Qt::AlignLeft;
-				} else if (exportStyle().numberingAlignment().testFlag(Qt::AlignCenter)) {
+				} else if (exportStyle()->numberingAlignment().testFlag(Qt::AlignCenter)) {
 					numberingAlignment |= Qt::AlignCenter;
 				} else {
 					numberingAlignment |= Qt::AlignRight;
@@ -349,8 +349,8 @@ void PdfExporter::aboutPrint(QPrinter* _printer)
 QPrinter* PdfExporter::preparePrinter(const QString& _forFile) const
 {
 	QPrinter* printer = new QPrinter;
-	printer->setPageSize(QPageSize(::exportStyle().pageSizeId()));
-	QMarginsF margins = ::exportStyle().pageMargins();
+	printer->setPageSize(QPageSize(::exportStyle()->pageSizeId()));
+	QMarginsF margins = ::exportStyle()->pageMargins();
 	printer->setPageMargins(margins.left(), margins.top(), margins.right(), margins.bottom(),
 							QPrinter::Millimeter);
 
@@ -13,7 +13,6 @@
 
 #include <Domain/Scenario.h>
 
-#include <QCryptographicHash>
 #include <QRegularExpression>
 #include <QTextDocument>
 #include <QTextCursor>
@@ -58,32 +57,17 @@ qreal ScenarioDocument::durationAtPosition(int _position) const
 
 	if (!m_modelItems.isEmpty()) {
 		//
-		// Определим сцену, в которой находится курсор
+		// Определим сцену, в которой находится курсор, и запомним позицию её начала
 		//
-		QMap<int, ScenarioModelItem*>::const_iterator iter = m_modelItems.lowerBound(_position);
-		if (iter == m_modelItems.end()
-			|| (iter.key() > _position
-				&& iter != m_modelItems.begin())) {
-			--iter;
+		int startPositionInLastScene = 0;
+		if (m_modelItems.previousItem(_position, startPositionInLastScene) == 0) {
+			m_modelItems.nextItem(_position, startPositionInLastScene);
 		}
 
-		//
-		// Запомним позицию начала сцены
-		//
-		int startPositionInLastScene = iter.key();
-
 		//
 		// Посчитаем хронометраж всех предыдущих сцен
 		//
-		if (iter.value()->type() == ScenarioModelItem::Scene) {
-			iter.value()->duration();
-		}
-		while (iter != m_modelItems.begin()) {
-			--iter;
-			if (iter.value()->type() == ScenarioModelItem::Scene) {
-				duration += iter.value()->duration();
-			}
-		}
+		duration += m_modelItems.durationBefore(startPositionInLastScene);
 
 		//
 		// Добавим к суммарному хрономертажу хронометраж от начала сцены
@@ -292,7 +276,7 @@ void ScenarioDocument::setItemDescriptionAtPosition(int _position, const QString
 			// Обновить описание внутри текста
 			//
 			cursor.beginEditBlock();
-			ScenarioBlockStyle descriptionBlockStyle = ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::SceneDescription);
+			ScenarioBlockStyle descriptionBlockStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::SceneDescription);
 			cursor.movePosition(QTextCursor::NextBlock);
 			if (ScenarioBlockStyle::forBlock(cursor.block()) == ScenarioBlockStyle::SceneCharacters) {
 				cursor.movePosition(QTextCursor::NextBlock);
@@ -433,7 +417,7 @@ int ScenarioDocument::positionToInsertMime(ScenarioModelItem* _insertParent, Sce
 	// Если необходимо вставить перед заданным элементом
 	//
 	if (_insertBefore != 0) {
-		int insertBeforeItemStartPos = m_modelItems.key(_insertBefore);
+		int insertBeforeItemStartPos = m_modelItems.position(_insertBefore);
 
 		//
 		// Шаг назад
@@ -483,28 +467,22 @@ int ScenarioDocument::positionToInsertMime(ScenarioModelItem* _insertParent, Sce
 void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int _charsAdded)
 {
 	//
-	// Сохраняем изменённый xml и его хэш
+	// Обновляем xml изменённых блоков
 	//
-	m_document->updateScenarioXml();
+	const bool isScenarioXmlChanged = m_document->updateScenarioXml();
 
 	//
 	// Прерываем ситуацию с ложным срабатыванием изменения документа
 	//
-	const QByteArray currentTextMd5Hash = m_document->scenarioXmlHash();
 	if (_charsRemoved == _charsAdded) {
 		//
 		// ... на самом ли деле текст изменился?
 		//
-		if (currentTextMd5Hash == m_lastTextMd5Hash) {
+		if (!isScenarioXmlChanged) {
 			return;
 		}
 	}
 
-	//
-	// Сохранить md5 хэш текста документа
-	//
-	m_lastTextMd5Hash = currentTextMd5Hash;
-
 	//
 	// Сохраняем позицию начала правок для последующей корректировки
 	//
@@ -530,42 +508,40 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
 		// Удаляем элементы начиная с того, который находится под курсором, если курсор в начале
 		// строки, или со следующего за курсором, если курсор не в начале строки
 		//
-		QMap<int, ScenarioModelItem*>::iterator iter = m_modelItems.lowerBound(position);
 		const int charsAddedDelta = _charsAdded - _charsRemoved;
 		const int charsRemovedDelta = _charsRemoved - _charsAdded;
-		while (iter != m_modelItems.end()
-			   && iter.key() >= position
-			   && iter.key() < (position + _charsRemoved)) {
+		//
+		// Элемент для удаления и его позиция
+		//
+		int itemToDeletePosition = 0;
+		ScenarioModelItem* itemToDelete = m_modelItems.nextItem(position, itemToDeletePosition);
+		while (itemToDelete != 0
+			   && itemToDeletePosition < (position + _charsRemoved)) {
 			//
-			// Элемент для удаления
+			// Расширяем диапозон последующего построения дерева, для включения в него всех
+			// кто был удалён тут по причине не самого оптимального алгоритма
 			//
-			ScenarioModelItem* itemToDelete = iter.value();
-
-			if (itemToDelete != 0) {
-				//
-				// Расширяем диапозон последующего построения дерева, для включения в него всех
-				// кто был удалён тут по причине не самого оптимального алгоритма
-				//
-				if (itemToDelete->hasChildren()) {
-					const int charsModified = itemToDelete->endPosition() - position;
-					if (_charsAdded < charsModified + charsAddedDelta) {
-						_charsAdded = charsModified + charsAddedDelta;
-					}
-					if (_charsRemoved < charsModified - charsRemovedDelta) {
-						_charsRemoved = charsModified - charsRemovedDelta;
-					}
+			if (itemToDelete->hasChildren()) {
+				const int charsModified = itemToDelete->endPosition() - position;
+				if (_charsAdded < charsModified + charsAddedDelta) {
+					_charsAdded = charsModified + charsAddedDelta;
+				}
+				if (_charsRemoved < charsModified - charsRemovedDelta) {
+					_charsRemoved = charsModified - charsRemovedDelta;
 				}
-
-				//
-				// Удалим элемент из модели
-				//
-				m_model->removeItem(iter.value());
 			}
 
 			//
 			// Удалим элемент из кэша
 			//
-			iter = m_modelItems.erase(iter);
+			m_modelItems.remove(itemToDelete);
+
+			//
+			// Удалим элемент из модели
+			//
+			m_model->removeItem(itemToDelete);
+
+			itemToDelete = m_modelItems.nextItem(position, itemToDeletePosition);
 		}
 	}
 
@@ -597,28 +573,7 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
 			}
 		}
 
-		QMutableMapIterator<int, ScenarioModelItem*> removeIter(m_modelItems);
-		QMap<int, ScenarioModelItem*> updatedItems;
-		//
-		// Изымаем элементы из хэша и формируем обновлённый список
-		//
-		while (removeIter.hasNext()) {
-			removeIter.next();
-			if (removeIter.key() >= position) {
-				ScenarioModelItem* item = removeIter.value();
-				item->setPosition(removeIter.key() - _charsRemoved + _charsAdded);
-				updatedItems.insert(item->position(), item);
-				removeIter.remove();
-			}
-		}
-		//
-		// Переносим элементы из обновлённого списка в хэш
-		//
-		QMapIterator<int, ScenarioModelItem*> updateIter(updatedItems);
-		while (updateIter.hasNext()) {
-			updateIter.next();
-			m_modelItems.insert(updateIter.key(), updateIter.value());
-		}
+		m_modelItems.shift(position, _charsAdded - _charsRemoved);
 	}
 
 	//
@@ -629,10 +584,10 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
 		// получить первый блок и обновить/создать его
 		// идти по документу, до конца вставленных символов и добавлять блоки
 		//
-		QMap<int, ScenarioModelItem*>::iterator iter = m_modelItems.lowerBound(_position);
-		if (iter != m_modelItems.begin()
-			&& iter.key() > _position) {
-			--iter;
+		int itemStartPos = 0;
+		ScenarioModelItem* item = m_modelItems.previousItem(_position, itemStartPos);
+		if (item == 0) {
+			item = m_modelItems.nextItem(_position, itemStartPos);
 		}
 
 		//
@@ -645,7 +600,7 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
 		//
 		// Если в документе нет ни одного элемента, создадим первый
 		//
-		if (iter == m_modelItems.end()) {
+		if (item == 0) {
 			currentItem = itemForPosition(0);
 			m_model->addItem(currentItem);
 			m_modelItems.insert(0, currentItem);
@@ -653,7 +608,7 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
 		//
 		// Или если вставляется новый элемент в начале текста
 		//
-		else if (_position == 0 && iter == m_modelItems.begin() && iter.key() > 0) {
+		else if (_position == 0 && itemStartPos > 0) {
 			currentItem = itemForPosition(0);
 			m_model->prependItem(currentItem);
 			m_modelItems.insert(0, currentItem);
@@ -662,8 +617,8 @@ void ScenarioDocument::aboutContentsChange(int _position, int _charsRemoved, int
 		// В противном случае получим необходимый к обновлению элемент
 		//
 		else {
-			currentItem = iter.value();
-			currentItemStartPos = iter.key();
+			currentItem = item;
+			currentItemStartPos = itemStartPos;
 		}
 
 		//
@@ -950,6 +905,7 @@ void ScenarioDocument::updateItem(ScenarioModelItem* _item, int _itemStartPos, i
 	bool isNeedIncludeBlock = true; // нужно ли включать текущий блок
 	int openedScenesGroups = 0; // кол-во открытых групп
 	int openedFolders = 0; // кол-во открытых папок
+	const QSharedPointer<const ScenarioTemplate> scenarioTemplate = ScenarioTemplateFacade::sharedTemplate();
 	cursor.movePosition(QTextCursor::NextBlock);
 	while (!cursor.atEnd()
 		   && cursor.position() < _itemEndPos) {
@@ -1039,9 +995,8 @@ void ScenarioDocument::updateItem(ScenarioModelItem* _item, int _itemStartPos, i
 						itemText = "";
 						isFirstTextBlock = false;
 					}
-					ScenarioBlockStyle blockStyle = ScenarioTemplateFacade::getTemplate().blockStyle(blockType);
 					itemText +=
-							blockStyle.charFormat().fontCapitalization() == QFont::AllUppercase
+							scenarioTemplate->blockStyle(blockType).charFormat().fontCapitalization() == QFont::AllUppercase
 							? cursor.block().text().toUpper()
 							: cursor.block().text();
 				}
@@ -1116,24 +1071,20 @@ void ScenarioDocument::updateItem(ScenarioModelItem* _item, int _itemStartPos, i
 
 ScenarioModelItem* ScenarioDocument::itemForPosition(int _position, bool _findNear) const
 {
-	ScenarioModelItem* item = m_modelItems.value(_position, 0);
+	ScenarioModelItem* item = m_modelItems.item(_position);
 	if (item == 0) {
 		//
 		// Если необходимо ищем ближайшего
 		//
 		if (_findNear) {
-			QMap<int, ScenarioModelItem*>::const_iterator i = m_modelItems.lowerBound(_position);
-			if (i != m_modelItems.begin()
-				|| i != m_modelItems.end()) {
-				if (i != m_modelItems.begin()) {
-					--i;
-				}
-				item = i.value();
-			} else {
-				//
-				// не найден, т.к. в модели нет элементов
-				//
+			int itemPosition = 0;
+			item = m_modelItems.previousItem(_position, itemPosition);
+			if (item == 0) {
+				item = m_modelItems.nextItem(_position, itemPosition);
 			}
+			//
+			// ... если не найден, значит в модели нет элементов
+			//
 		}
 		//
 		// В противном случае создаём новый элемент
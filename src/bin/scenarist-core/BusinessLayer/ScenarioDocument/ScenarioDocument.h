@@ -1,8 +1,9 @@
 #ifndef SCENARIODOCUMENT_H
 #define SCENARIODOCUMENT_H
 
+#include "ScenarioModelItemsIndex.h"
+
 #include <QObject>
-#include <QMap>
 #include <QUuid>
 
 class QTextDocument;
@@ -245,14 +246,9 @@ namespace BusinessLogic
 		ScenarioModel* m_model;
 
 		/**
-		 * @brief Карта элементов дерева сценария
-		 */
-		QMap<int, ScenarioModelItem*> m_modelItems;
-
-		/**
-		 * @brief MD5-хэш текста сценария, используется для отслеживания изменённости текста
+		 * @brief Индекс элементов дерева сценария по позициям
 		 */
-		QByteArray m_lastTextMd5Hash;
+		ScenarioModelItemsIndex m_modelItems;
 
 		/**
 		 * @brief Флаг операции обновления описания сцены, для предотвращения рекурсии
@@ -1,5 +1,7 @@
 #include "ScenarioModelItem.h"
 
+#include "ScenarioModelItemsIndex.h"
+
 #include <QPainter>
 
 using namespace BusinessLogic;
@@ -11,6 +13,7 @@ namespace {
 
 ScenarioModelItem::ScenarioModelItem(int _position) :
 	m_position(_position),
+	m_positionsIndex(0),
 	m_sceneNumber(0),
 	m_textLength(0),
 	m_duration(0),
@@ -39,7 +42,7 @@ void ScenarioModelItem::setUuid(const QString& _uuid)
 
 int ScenarioModelItem::position() const
 {
-	return m_position;
+	return m_positionsIndex != 0 ? m_positionsIndex->position(this) : m_position;
 }
 
 void ScenarioModelItem::setPosition(int _position)
@@ -187,6 +190,7 @@ void ScenarioModelItem::setDuration(qreal _duration)
 {
 	if (m_duration != _duration) {
 		m_duration = _duration;
+		updatePositionsIndex();
 		updateParentDuration();
 	}
 }
@@ -200,6 +204,7 @@ void ScenarioModelItem::setType(ScenarioModelItem::Type _type)
 {
 	if (m_type != _type) {
 		m_type = _type;
+		updatePositionsIndex();
 	}
 }
 
@@ -332,6 +337,18 @@ void ScenarioModelItem::clear()
 	updateParentDuration();
 }
 
+void ScenarioModelItem::setPositionsIndex(ScenarioModelItemsIndex* _index)
+{
+	m_positionsIndex = _index;
+}
+
+void ScenarioModelItem::updatePositionsIndex()
+{
+	if (m_positionsIndex != 0) {
+		m_positionsIndex->updateItem(this);
+	}
+}
+
 //! Вспомогательные методы для организации работы модели
 
 void ScenarioModelItem::prependItem(ScenarioModelItem* _item)
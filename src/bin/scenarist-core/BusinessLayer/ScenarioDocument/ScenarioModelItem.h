@@ -9,11 +9,16 @@
 
 namespace BusinessLogic
 {
+	class ScenarioModelItemsIndex;
+
+
 	/**
 	 * @brief Класс элемента модели сценария
 	 */
 	class ScenarioModelItem
 	{
+		friend class ScenarioModelItemsIndex;
+
 	public:
 		/**
 		 * @brief Перечисление типов элементов
@@ -38,6 +43,7 @@ namespace BusinessLogic
 
 		/**
 		 * @brief Позиция элемента
+		 * @note Для элемента из индекса позиций она определяется индексом
 		 */
 		int position() const;
 		void setPosition(int _position);
@@ -143,6 +149,16 @@ namespace BusinessLogic
 		 */
 		void clear();
 
+		/**
+		 * @brief Установить индекс позиций, в котором хранится элемент
+		 */
+		void setPositionsIndex(ScenarioModelItemsIndex* _index);
+
+		/**
+		 * @brief Обновить длительность элемента в индексе позиций
+		 */
+		void updatePositionsIndex();
+
 	private:
 		/**
 		 * @brief Идентификатор сцены
@@ -154,6 +170,11 @@ namespace BusinessLogic
 		 */
 		int m_position;
 
+		/**
+		 * @brief Индекс позиций, в котором хранится элемент
+		 */
+		ScenarioModelItemsIndex* m_positionsIndex;
+
 		/**
 		 * @brief Номер сцены
 		 */
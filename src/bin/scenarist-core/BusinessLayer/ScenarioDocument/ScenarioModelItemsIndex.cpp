@@ -0,0 +1,454 @@
+#include "ScenarioModelItemsIndex.h"
+
+#include "ScenarioModelItem.h"
+
+using BusinessLogic::ScenarioModelItem;
+using BusinessLogic::ScenarioModelItemsIndex;
+
+
+namespace {
+    /**
+     * @brief Вспомогательные функции для получения данных поддерева, которое может быть пустым
+     */
+    /** @{ */
+    template <typename NodeType>
+    static int sizeOf(const NodeType* _node) {
+        return _node != nullptr ? _node->size : 0;
+    }
+    template <typename NodeType>
+    static int gapsSumOf(const NodeType* _node) {
+        return _node != nullptr ? _node->gapsSum : 0;
+    }
+    template <typename NodeType>
+    static qreal durationsSumOf(const NodeType* _node) {
+        return _node != nullptr ? _node->durationsSum : 0;
+    }
+    /** @} */
+}
+
+
+/**
+ * @brief Узел дерева элементов
+ */
+class ScenarioModelItemsIndex::Node
+{
+public:
+    Node(ScenarioModelItem* _item, int _gap, quint32 _priority) :
+        item(_item), gap(_gap), duration(0), priority(_priority), size(1), gapsSum(_gap),
+        durationsSum(0), left(nullptr), right(nullptr), parent(nullptr)
+    {
+        updateItemData();
+        durationsSum = duration;
+    }
+
+    /**
+     * @brief Обновить длительность элемента, учитываются только сцены
+     */
+    void updateItemData() {
+        duration = item->type() == ScenarioModelItem::Scene ? item->duration() : 0;
+    }
+
+    /**
+     * @brief Пересчитать данные поддерева по данным потомков
+     */
+    void update() {
+        size = 1;
+        gapsSum = gap;
+        durationsSum = duration;
+        if (left != nullptr) {
+            size += left->size;
+            gapsSum += left->gapsSum;
+            durationsSum += left->durationsSum;
+            left->parent = this;
+        }
+        if (right != nullptr) {
+            size += right->size;
+            gapsSum += right->gapsSum;
+            durationsSum += right->durationsSum;
+            right->parent = this;
+        }
+    }
+
+    /**
+     * @brief Элемент
+     */
+    ScenarioModelItem* item;
+
+    /**
+     * @brief Расстояние от предыдущего элемента, или от начала текста для первого
+     */
+    int gap;
+
+    /**
+     * @brief Длительность элемента
+     */
+    qreal duration;
+
+    /**
+     * @brief Приоритет узла для балансировки
+     */
+    quint32 priority;
+
+    /**
+     * @brief Количество элементов в поддереве
+     */
+    int size;
+
+    /**
+     * @brief Сумма расстояний поддерева, т.е. позиция последнего элемента относительно начала поддерева
+     */
+    int gapsSum;
+
+    /**
+     * @brief Суммарная длительность поддерева
+     */
+    qreal durationsSum;
+
+    /**
+     * @brief Связи узла
+     */
+    /** @{ */
+    Node* left;
+    Node* right;
+    Node* parent;
+    /** @} */
+};
+
+
+ScenarioModelItemsIndex::ScenarioModelItemsIndex() :
+    m_root(nullptr),
+    m_priorityState(2463534242U)
+{
+}
+
+ScenarioModelItemsIndex::~ScenarioModelItemsIndex()
+{
+    clear();
+}
+
+bool ScenarioModelItemsIndex::isEmpty() const
+{
+    return m_root == nullptr;
+}
+
+void ScenarioModelItemsIndex::clear()
+{
+    foreach (const ScenarioModelItem* item, m_nodes.keys()) {
+        const_cast<ScenarioModelItem*>(item)->setPositionsIndex(nullptr);
+    }
+    m_nodes.clear();
+
+    deleteTree(m_root);
+    m_root = nullptr;
+}
+
+void ScenarioModelItemsIndex::insert(int _position, ScenarioModelItem* _item)
+{
+    if (_item == nullptr) {
+        return;
+    }
+
+    if (m_nodes.contains(_item)) {
+        remove(_item);
+    }
+
+    Node* left = nullptr;
+    Node* right = nullptr;
+    splitByPosition(m_root, _position, 0, left, right);
+
+    //
+    // Если в позиции уже есть элемент, то замещаем его
+    //
+    Node* first = right;
+    while (first != nullptr && first->left != nullptr) {
+        first = first->left;
+    }
+    const int leftEnd = gapsSumOf(left);
+    if (first != nullptr
+        && leftEnd + first->gap == _position) {
+        m_nodes.remove(first->item);
+        first->item->setPositionsIndex(nullptr);
+        first->item->setPosition(_position);
+
+        first->item = _item;
+        first->updateItemData();
+        m_nodes.insert(_item, first);
+        _item->setPositionsIndex(this);
+
+        //
+        // ... пересчитываем длительность на пути к корню
+        //
+        for (Node* node = first; ; node = node->parent) {
+            node->update();
+            if (node == right) {
+                break;
+            }
+        }
+    }
+    //
+    // В противном случае вставляем новый узел, отсчитывая расстояние до следующего элемента от него
+    //
+    else {
+        Node* node = new Node(_item, _position - leftEnd, nextPriority());
+        addToFirstGap(right, -node->gap);
+        m_nodes.insert(_item, node);
+        _item->setPositionsIndex(this);
+        right = merge(node, right);
+    }
+
+    m_root = merge(left, right);
+    m_root->parent = nullptr;
+}
+
+void ScenarioModelItemsIndex::remove(ScenarioModelItem* _item)
+{
+    Node* node = m_nodes.value(_item, nullptr);
+    if (node == nullptr) {
+        return;
+    }
+
+    //
+    // Определим порядковый номер элемента
+    //
+    int index = sizeOf(node->left);
+    for (const Node* child = node; child->parent != nullptr; child = child->parent) {
+        if (child == child->parent->right) {
+            index += sizeOf(child->parent->left) + 1;
+        }
+    }
+
+    //
+    // Изымаем узел, передавая его расстояние следующему элементу
+    //
+    Node* left = nullptr;
+    Node* middle = nullptr;
+    Node* right = nullptr;
+    splitByCount(m_root, index, left, middle);
+    splitByCount(middle, 1, middle, right);
+    addToFirstGap(right, middle->gap);
+
+    _item->setPosition(gapsSumOf(left) + middle->gap);
+    _item->setPositionsIndex(nullptr);
+    m_nodes.remove(_item);
+    delete middle;
+
+    m_root = merge(left, right);
+    if (m_root != nullptr) {
+        m_root->parent = nullptr;
+    }
+}
+
+void ScenarioModelItemsIndex::shift(int _fromPosition, int _delta)
+{
+    if (_delta == 0) {
+        return;
+    }
+
+    //
+    // Находим первый смещаемый элемент
+    //
+    Node* first = nullptr;
+    Node* node = m_root;
+    int base = 0;
+    while (node != nullptr) {
+        const int nodePosition = base + gapsSumOf(node->left) + node->gap;
+        if (nodePosition >= _fromPosition) {
+            first = node;
+            node = node->left;
+        } else {
+            base = nodePosition;
+            node = node->right;
+        }
+    }
+
+    //
+    // Увеличиваем его расстояние от предыдущего, а значит и позиции всех последующих,
+    // после чего корректируем суммы расстояний поддеревьев, в которые он входит
+    //
+    if (first != nullptr) {
+        first->gap += _delta;
+        for (node = first; node != nullptr; node = node->parent) {
+            node->gapsSum += _delta;
+        }
+    }
+}
+
+int ScenarioModelItemsIndex::position(const ScenarioModelItem* _item) const
+{
+    const Node* node = m_nodes.value(_item, nullptr);
+    if (node == nullptr) {
+        return -1;
+    }
+
+    int position = gapsSumOf(node->left) + node->gap;
+    for (; node->parent != nullptr; node = node->parent) {
+        if (node == node->parent->right) {
+            position += gapsSumOf(node->parent->left) + node->parent->gap;
+        }
+    }
+    return position;
+}
+
+ScenarioModelItem* ScenarioModelItemsIndex::item(int _position) const
+{
+    int itemPosition = 0;
+    ScenarioModelItem* item = nextItem(_position, itemPosition);
+    return item != nullptr && itemPosition == _position ? item : nullptr;
+}
+
+ScenarioModelItem* ScenarioModelItemsIndex::nextItem(int _position, int& _itemPosition) const
+{
+    ScenarioModelItem* item = nullptr;
+    const Node* node = m_root;
+    int base = 0;
+    while (node != nullptr) {
+        const int nodePosition = base + gapsSumOf(node->left) + node->gap;
+        if (nodePosition >= _position) {
+            item = node->item;
+            _itemPosition = nodePosition;
+            node = node->left;
+        } else {
+            base = nodePosition;
+            node = node->right;
+        }
+    }
+    return item;
+}
+
+ScenarioModelItem* ScenarioModelItemsIndex::previousItem(int _position, int& _itemPosition) const
+{
+    ScenarioModelItem* item = nullptr;
+    const Node* node = m_root;
+    int base = 0;
+    while (node != nullptr) {
+        const int nodePosition = base + gapsSumOf(node->left) + node->gap;
+        if (nodePosition <= _position) {
+            item = node->item;
+            _itemPosition = nodePosition;
+            base = nodePosition;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return item;
+}
+
+qreal ScenarioModelItemsIndex::durationBefore(int _position) const
+{
+    qreal duration = 0;
+    const Node* node = m_root;
+    int base = 0;
+    while (node != nullptr) {
+        const int nodePosition = base + gapsSumOf(node->left) + node->gap;
+        if (nodePosition < _position) {
+            duration += durationsSumOf(node->left) + node->duration;
+            base = nodePosition;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return duration;
+}
+
+void ScenarioModelItemsIndex::updateItem(const ScenarioModelItem* _item)
+{
+    Node* node = m_nodes.value(_item, nullptr);
+    if (node == nullptr) {
+        return;
+    }
+
+    node->updateItemData();
+    for (; node != nullptr; node = node->parent) {
+        node->update();
+    }
+}
+
+void ScenarioModelItemsIndex::splitByPosition(Node* _node, int _position, int _base, Node*& _left, Node*& _right)
+{
+    if (_node == nullptr) {
+        _left = nullptr;
+        _right = nullptr;
+        return;
+    }
+
+    const int nodePosition = _base + gapsSumOf(_node->left) + _node->gap;
+    if (nodePosition < _position) {
+        splitByPosition(_node->right, _position, nodePosition, _node->right, _right);
+        _left = _node;
+    } else {
+        splitByPosition(_node->left, _position, _base, _left, _node->left);
+        _right = _node;
+    }
+    _node->update();
+}
+
+void ScenarioModelItemsIndex::splitByCount(Node* _node, int _count, Node*& _left, Node*& _right)
+{
+    if (_node == nullptr) {
+        _left = nullptr;
+        _right = nullptr;
+        return;
+    }
+
+    const int leftSize = sizeOf(_node->left);
+    if (_count <= leftSize) {
+        splitByCount(_node->left, _count, _left, _node->left);
+        _right = _node;
+    } else {
+        splitByCount(_node->right, _count - leftSize - 1, _node->right, _right);
+        _left = _node;
+    }
+    _node->update();
+}
+
+ScenarioModelItemsIndex::Node* ScenarioModelItemsIndex::merge(Node* _left, Node* _right)
+{
+    if (_left == nullptr) {
+        return _right;
+    }
+    if (_right == nullptr) {
+        return _left;
+    }
+
+    if (_left->priority > _right->priority) {
+        _left->right = merge(_left->right, _right);
+        _left->update();
+        return _left;
+    } else {
+        _right->left = merge(_left, _right->left);
+        _right->update();
+        return _right;
+    }
+}
+
+void ScenarioModelItemsIndex::addToFirstGap(Node* _node, int _delta)
+{
+    for (; _node != nullptr; _node = _node->left) {
+        _node->gapsSum += _delta;
+        if (_node->left == nullptr) {
+            _node->gap += _delta;
+        }
+    }
+}
+
+void ScenarioModelItemsIndex::deleteTree(Node* _node)
+{
+    if (_node != nullptr) {
+        deleteTree(_node->left);
+        deleteTree(_node->right);
+        delete _node;
+    }
+}
+
+quint32 ScenarioModelItemsIndex::nextPriority()
+{
+    //
+    // Генератор xorshift32
+    //
+    m_priorityState ^= m_priorityState << 13;
+    m_priorityState ^= m_priorityState >> 17;
+    m_priorityState ^= m_priorityState << 5;
+    return m_priorityState;
+}
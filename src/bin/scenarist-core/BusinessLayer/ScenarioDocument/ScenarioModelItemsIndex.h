@@ -0,0 +1,150 @@
+#ifndef SCENARIOMODELITEMSINDEX_H
+#define SCENARIOMODELITEMSINDEX_H
+
+#include <QHash>
+
+
+namespace BusinessLogic
+{
+    class ScenarioModelItem;
+
+
+    /**
+     * @brief Индекс элементов модели сценария по их позициям в тексте документа
+     *
+     * Элементы хранятся в сбалансированном дереве (декартово дерево по неявному ключу) в порядке
+     * следования в тексте, при этом каждый узел хранит не позицию элемента, а расстояние от
+     * предыдущего элемента. Поэтому смещение всех элементов после места правки текста сводится
+     * к изменению расстояния одного узла и обходится в O(log n), как и поиск элемента по позиции.
+     *
+     * Кроме того узлы хранят суммы длительностей сцен своего поддерева, что позволяет получить
+     * хронометраж от начала текста до любой позиции так же за O(log n). Элементы сами сообщают
+     * индексу об изменении своих длительности и типа.
+     *
+     * Суммы счётчиков сцен в индексе не хранятся: получать счётчики до позиции было некому,
+     * поэтому от них отказались вместе с неиспользуемым counterAtPosition.
+     */
+    class ScenarioModelItemsIndex
+    {
+    public:
+        ScenarioModelItemsIndex();
+        ~ScenarioModelItemsIndex();
+
+        /**
+         * @brief Пуст ли индекс
+         */
+        bool isEmpty() const;
+
+        /**
+         * @brief Очистить индекс
+         */
+        void clear();
+
+        /**
+         * @brief Добавить элемент в заданную позицию
+         * @note Если в позиции уже есть элемент, то он замещается новым
+         */
+        void insert(int _position, ScenarioModelItem* _item);
+
+        /**
+         * @brief Удалить элемент из индекса
+         */
+        void remove(ScenarioModelItem* _item);
+
+        /**
+         * @brief Сместить все элементы, начиная с заданной позиции, на _delta символов
+         */
+        void shift(int _fromPosition, int _delta);
+
+        /**
+         * @brief Позиция элемента, или -1, если элемента нет в индексе
+         */
+        int position(const ScenarioModelItem* _item) const;
+
+        /**
+         * @brief Элемент в заданной позиции, или 0, если его нет
+         */
+        ScenarioModelItem* item(int _position) const;
+
+        /**
+         * @brief Первый элемент, находящийся в заданной позиции или после неё
+         * @param _itemPosition - позиция найденного элемента
+         */
+        ScenarioModelItem* nextItem(int _position, int& _itemPosition) const;
+
+        /**
+         * @brief Последний элемент, находящийся в заданной позиции или перед ней
+         * @param _itemPosition - позиция найденного элемента
+         */
+        ScenarioModelItem* previousItem(int _position, int& _itemPosition) const;
+
+        /**
+         * @brief Суммарная длительность сцен, начинающихся перед заданной позицией
+         */
+        qreal durationBefore(int _position) const;
+
+        /**
+         * @brief Обновить длительность элемента
+         * @note Вызывается элементом после изменения длительности или типа
+         */
+        void updateItem(const ScenarioModelItem* _item);
+
+    private:
+        /**
+         * @brief Узел дерева
+         */
+        class Node;
+
+        /**
+         * @brief Разделить дерево на элементы, находящиеся перед позицией _position, и остальные
+         * @param _base - позиция, относительно которой отсчитывается первый элемент поддерева
+         */
+        void splitByPosition(Node* _node, int _position, int _base, Node*& _left, Node*& _right);
+
+        /**
+         * @brief Разделить дерево на первые _count элементов и остальные
+         */
+        void splitByCount(Node* _node, int _count, Node*& _left, Node*& _right);
+
+        /**
+         * @brief Объединить два дерева, все элементы _left идут перед элементами _right
+         */
+        Node* merge(Node* _left, Node* _right);
+
+        /**
+         * @brief Изменить расстояние первого элемента поддерева
+         */
+        void addToFirstGap(Node* _node, int _delta);
+
+        /**
+         * @brief Удалить поддерево
+         */
+        void deleteTree(Node* _node);
+
+        /**
+         * @brief Получить следующий приоритет узла
+         */
+        quint32 nextPriority();
+
+    private:
+        /**
+         * @brief Корень дерева
+         */
+        Node* m_root;
+
+        /**
+         * @brief Узлы дерева по элементам
+         */
+        QHash<const ScenarioModelItem*, Node*> m_nodes;
+
+        /**
+         * @brief Состояние генератора приоритетов узлов
+         */
+        quint32 m_priorityState;
+
+    private:
+        Q_DISABLE_COPY(ScenarioModelItemsIndex)
+    };
+}
+
+#endif // SCENARIOMODELITEMSINDEX_H
@@ -146,7 +146,7 @@ bool ScenarioReviewModel::removeRows(int _row, int _count, const QModelIndex& _p
 					//
 					if (!cursor.atBlockStart()) {
 						const ScenarioBlockStyle::Type type = ScenarioBlockStyle::forBlock(cursor.block());
-						const ScenarioBlockStyle style = ScenarioTemplateFacade::getTemplate().blockStyle(type);
+						const ScenarioBlockStyle style = ScenarioTemplateFacade::sharedTemplate()->blockStyle(type);
 
 						ScenarioTextDocument::updateBlockRevision(cursor);
 						cursor.setCharFormat(style.charFormat());
@@ -631,7 +631,14 @@ void ScenarioTemplate::saveToFile(const QString& _filePath) const
 		writer.writeAttribute("page_format", PageMetrics::stringFromPageSizeId(m_pageSizeId));
 		writer.writeAttribute("page_margins", ::stringFromMargins(m_pageMargins));
 		writer.writeAttribute("numbering_alignment", ::toString(m_numberingAlignment));
-		foreach (const ScenarioBlockStyle& blockStyle, m_blockStyles.values()) {
+		for (const ScenarioBlockStyle& blockStyle : m_blockStyles) {
+			//
+			// Пропускаем не заданные в шаблоне стили
+			//
+			if (blockStyle.type() == ScenarioBlockStyle::Undefined) {
+				continue;
+			}
+
 			writer.writeStartElement("block");
 			writer.writeAttribute("id", ::toString(blockStyle.type()));
 			writer.writeAttribute("active", ::toString(blockStyle.isActive()));
@@ -662,12 +669,16 @@ void ScenarioTemplate::saveToFile(const QString& _filePath) const
 	}
 }
 
-ScenarioBlockStyle ScenarioTemplate::blockStyle(ScenarioBlockStyle::Type _forType) const
+const ScenarioBlockStyle& ScenarioTemplate::blockStyle(ScenarioBlockStyle::Type _forType) const
 {
-	return m_blockStyles.value(_forType);
+	if (_forType < 0 || _forType >= BLOCK_STYLES_COUNT) {
+		return m_blockStyles[ScenarioBlockStyle::Undefined];
+	}
+
+	return m_blockStyles[_forType];
 }
 
-BusinessLogic::ScenarioBlockStyle ScenarioTemplate::blockStyle(const QTextBlock& _forBlock) const
+const BusinessLogic::ScenarioBlockStyle& ScenarioTemplate::blockStyle(const QTextBlock& _forBlock) const
 {
 	return blockStyle(ScenarioBlockStyle::forBlock(_forBlock));
 }
@@ -709,7 +720,9 @@ void ScenarioTemplate::setNumberingAlignment(Qt::Alignment _alignment)
 
 void ScenarioTemplate::setBlockStyle(const BusinessLogic::ScenarioBlockStyle& _blockStyle)
 {
-	m_blockStyles.insert(_blockStyle.type(), _blockStyle);
+	if (_blockStyle.type() >= 0 && _blockStyle.type() < BLOCK_STYLES_COUNT) {
+		m_blockStyles[_blockStyle.type()] = _blockStyle;
+	}
 }
 
 void ScenarioTemplate::updateBlocksColors()
@@ -755,9 +768,12 @@ void ScenarioTemplate::updateBlocksColors()
 	//
 	// Обновим цвета блоков
 	//
-	foreach (ScenarioBlockStyle::Type blockStyleType, m_blockStyles.keys()) {
-		ScenarioBlockStyle& blockStyle = m_blockStyles[blockStyleType];
-		switch (blockStyleType) {
+	for (ScenarioBlockStyle& blockStyle : m_blockStyles) {
+		if (blockStyle.type() == ScenarioBlockStyle::Undefined) {
+			continue;
+		}
+
+		switch (blockStyle.type()) {
 
 			default: {
 				blockStyle.setTextColor(mainTextColor);
@@ -820,8 +836,7 @@ void ScenarioTemplate::load(const QString& _fromFile)
 			//
 			while (reader.readNextStartElement() && (reader.name() == "block"))
 			{
-				ScenarioBlockStyle blockStyle(reader.attributes());
-				m_blockStyles.insert(blockStyle.type(), blockStyle);
+				setBlockStyle(ScenarioBlockStyle(reader.attributes()));
 
 				//
 				// Если ещё не находимся в конце элемента, то остальное пропускаем
@@ -834,11 +849,11 @@ void ScenarioTemplate::load(const QString& _fromFile)
 			// NOTE: Для файлов шаблона созданных в старых версиях программы, проверяем наличие
 			//		 стиля для описания сцены, если его нет, то копируем из описания действия
 			//
-			if (!m_blockStyles.contains(ScenarioBlockStyle::SceneDescription)) {
-				ScenarioBlockStyle sceneDescriptionStyle = m_blockStyles.value(ScenarioBlockStyle::Action);
+			if (m_blockStyles[ScenarioBlockStyle::SceneDescription].type() != ScenarioBlockStyle::SceneDescription) {
+				ScenarioBlockStyle sceneDescriptionStyle = m_blockStyles[ScenarioBlockStyle::Action];
 				sceneDescriptionStyle.m_type = ScenarioBlockStyle::SceneDescription;
 				sceneDescriptionStyle.m_blockFormat.setProperty(ScenarioBlockStyle::PropertyType, sceneDescriptionStyle.type());
-				m_blockStyles.insert(sceneDescriptionStyle.type(), sceneDescriptionStyle);
+				setBlockStyle(sceneDescriptionStyle);
 			}
 		}
 	}
@@ -862,33 +877,49 @@ bool ScenarioTemplateFacade::containsTemplate(const QString& _templateName)
 }
 
 ScenarioTemplate ScenarioTemplateFacade::getTemplate(const QString& _templateName)
+{
+	return *sharedTemplate(_templateName);
+}
+
+QSharedPointer<const ScenarioTemplate> ScenarioTemplateFacade::sharedTemplate(const QString& _templateName)
 {
 	init();
 
-	const QString currentTemplate =
-			DataStorageLayer::StorageFacade::settingsStorage()->value(
-				"scenario-editor/current-style",
-				DataStorageLayer::SettingsStorage::ApplicationSettings);
-
-	ScenarioTemplate result;
-	if (_templateName.isEmpty()) {
-		if (!currentTemplate.isEmpty()
-			&& s_instance->m_templates.contains(currentTemplate)) {
-			result = s_instance->m_templates.value(currentTemplate);
-		} else {
-			result = s_instance->m_defaultTemplate;
-		}
-	} else {
-		//
-		// Передаём значением по-умолчанию стандартный шаблон, т.к. иногда, например при смене языка
-		// может возникнуть ситуация с передачей стандартного шаблона на другом языке
-		//
-		result = s_instance->m_templates.value(_templateName, s_instance->m_defaultTemplate);
+	QString templateName = _templateName;
+	if (templateName.isEmpty()) {
+		templateName =
+				DataStorageLayer::StorageFacade::settingsStorage()->value(
+					"scenario-editor/current-style",
+					DataStorageLayer::SettingsStorage::ApplicationSettings);
+	}
+	//
+	// Передаём стандартный шаблон, если запрошенного нет в библиотеке, т.к. иногда, например
+	// при смене языка может возникнуть ситуация с передачей стандартного шаблона на другом языке
+	//
+	if (!s_instance->m_templates.contains(templateName)) {
+		templateName.clear();
+	}
+
+	QSharedPointer<const ScenarioTemplate> result = s_instance->m_sharedTemplates.value(templateName);
+	if (result.isNull()) {
+		result.reset(
+			new ScenarioTemplate(
+				templateName.isEmpty()
+				? s_instance->m_defaultTemplate
+				: s_instance->m_templates.value(templateName)));
+		s_instance->m_sharedTemplates.insert(templateName, result);
 	}
 
 	return result;
 }
 
+quint64 ScenarioTemplateFacade::templatesGeneration()
+{
+	init();
+
+	return s_instance->m_templatesGeneration;
+}
+
 void ScenarioTemplateFacade::saveTemplate(const BusinessLogic::ScenarioTemplate& _template)
 {
 	init();
@@ -918,7 +949,7 @@ void ScenarioTemplateFacade::saveTemplate(const BusinessLogic::ScenarioTemplate&
 	// Добавляем/обновляем шаблон в библиотеке
 	//
 	s_instance->m_templates.insert(_template.name(), _template);
-
+	resetSharedTemplates();
 
 	//
 	// Настроим путь к папке с шаблонами
@@ -963,6 +994,7 @@ void ScenarioTemplateFacade::removeTemplate(const QString& _templateName)
 	// Удалим шаблон из библиотеки
 	//
 	s_instance->m_templates.remove(_templateName);
+	resetSharedTemplates();
 	foreach (QStandardItem* templateItem, s_instance->m_templatesModel->findItems(_templateName)) {
 		s_instance->m_templatesModel->removeRow(templateItem->row());
 	}
@@ -989,9 +1021,11 @@ void ScenarioTemplateFacade::updateTemplatesColors()
 	foreach (const QString& templateName, s_instance->m_templates.keys()) {
 		s_instance->m_templates[templateName].updateBlocksColors();
 	}
+	resetSharedTemplates();
 }
 
-ScenarioTemplateFacade::ScenarioTemplateFacade()
+ScenarioTemplateFacade::ScenarioTemplateFacade() :
+	m_templatesGeneration(0)
 {
 	//
 	// Настроим путь к папке с шаблонами
@@ -1083,4 +1117,10 @@ void ScenarioTemplateFacade::init()
 	}
 }
 
+void ScenarioTemplateFacade::resetSharedTemplates()
+{
+	s_instance->m_sharedTemplates.clear();
+	++s_instance->m_templatesGeneration;
+}
+
 ScenarioTemplateFacade* ScenarioTemplateFacade::s_instance = 0;
@@ -2,8 +2,11 @@
 #define SCENARIOTEMPLATE_H
 
 #include <QPageSize>
+#include <QSharedPointer>
 #include <QTextFormat>
 
+#include <array>
+
 class QStandardItemModel;
 class QTextBlock;
 class QXmlStreamAttributes;
@@ -430,12 +433,12 @@ namespace BusinessLogic
 		/**
 		 * @brief Получить стиль блока заданного типа
 		 */
-		ScenarioBlockStyle blockStyle(ScenarioBlockStyle::Type _forType) const;
+		const ScenarioBlockStyle& blockStyle(ScenarioBlockStyle::Type _forType) const;
 
 		/**
 		 * @brief Получить стиль заданного блока
 		 */
-		ScenarioBlockStyle blockStyle(const QTextBlock& _forBlock) const;
+		const ScenarioBlockStyle& blockStyle(const QTextBlock& _forBlock) const;
 
 		/**
 		 * @brief Установить наименование
@@ -473,6 +476,12 @@ namespace BusinessLogic
 		void updateBlocksColors();
 
 	private:
+		/**
+		 * @brief Количество типов блоков
+		 * @note Последним в перечислении типов должно идти описание элемента сценария
+		 */
+		static const int BLOCK_STYLES_COUNT = ScenarioBlockStyle::SceneDescription + 1;
+
 		ScenarioTemplate(const QString& _fromFile);
 		friend class ScenarioTemplateFacade;
 
@@ -508,9 +517,10 @@ namespace BusinessLogic
 		Qt::Alignment m_numberingAlignment;
 
 		/**
-		 * @brief Стили блоков текста
+		 * @brief Стили блоков текста, индексированные по типу блока
+		 * @note Для типов, стиль которых не задан в шаблоне, хранится стиль по умолчанию
 		 */
-		QMap<ScenarioBlockStyle::Type, ScenarioBlockStyle> m_blockStyles;
+		std::array<ScenarioBlockStyle, BLOCK_STYLES_COUNT> m_blockStyles;
 	};
 
 	/**
@@ -536,6 +546,21 @@ namespace BusinessLogic
 		 */
 		static ScenarioTemplate getTemplate(const QString& _templateName = QString());
 
+		/**
+		 * @brief Получить неизменяемый шаблон в соответствии с заданным именем без копирования
+		 *
+		 * Шаблоны кэшируются до изменения библиотеки шаблонов, поэтому этим методом следует
+		 * пользоваться в местах, где стили запрашиваются для каждого блока текста
+		 */
+		static QSharedPointer<const ScenarioTemplate> sharedTemplate(const QString& _templateName = QString());
+
+		/**
+		 * @brief Поколение библиотеки шаблонов, увеличивается при каждом её изменении
+		 *
+		 * Позволяет понять, что полученный ранее шаблон устарел
+		 */
+		static quint64 templatesGeneration();
+
 		/**
 		 * @brief Сохранить стиль в библиотеке шаблонов
 		 */
@@ -559,6 +584,11 @@ namespace BusinessLogic
 		static ScenarioTemplateFacade* s_instance;
 		static void init();
 
+		/**
+		 * @brief Сбросить кэш неизменяемых шаблонов
+		 */
+		static void resetSharedTemplates();
+
 	private:
 		/**
 		 * @brief Шаблон по умолчанию
@@ -574,6 +604,16 @@ namespace BusinessLogic
 		 * @brief Модель шаблонов
 		 */
 		QStandardItemModel* m_templatesModel;
+
+		/**
+		 * @brief Кэш неизменяемых шаблонов, стандартный шаблон хранится с пустым именем
+		 */
+		QHash<QString, QSharedPointer<const ScenarioTemplate> > m_sharedTemplates;
+
+		/**
+		 * @brief Поколение библиотеки шаблонов
+		 */
+		quint64 m_templatesGeneration;
 	};
 }
 
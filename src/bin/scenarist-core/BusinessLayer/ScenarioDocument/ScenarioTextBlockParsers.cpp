@@ -130,7 +130,7 @@ QStringList SceneCharactersParser::characters(const QString& _text)
 	//
 	// Удалим потенциальные приставку и окончание
 	//
-	ScenarioBlockStyle style = ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::SceneCharacters);
+	ScenarioBlockStyle style = ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::SceneCharacters);
 	QString stylePrefix = style.prefix();
 	if (!stylePrefix.isEmpty()
 		&& characters.startsWith(stylePrefix)) {
@@ -13,11 +13,8 @@
 
 #include <3rd_party/Helpers/PasswordStorage.h>
 
-#include <3rd_party/Widgets/QLightBoxWidget/qlightboxprogress.h>
-
-#include <QApplication>
-#include <QCryptographicHash>
 #include <QDomDocument>
+#include <QElapsedTimer>
 #include <QTextBlock>
 
 //
@@ -37,19 +34,10 @@ namespace {
      */
     const int MAX_UNDO_REDO_STACK_SIZE = 50;
 
-    /**
-     * @brief Получить хэш текста
-     */
-    static QByteArray textMd5Hash(const QString& _text) {
-        QCryptographicHash hash(QCryptographicHash::Md5);
-        hash.addData(_text.toUtf8());
-        return hash.result();
-    }
-
     /**
      * @brief Сохранить изменение
      */
-    static Domain::ScenarioChange* saveChange(const QString& _undoPatch, const QString& _redoPatch) {
+    static Domain::ScenarioChange* saveChange(const QByteArray& _undoPatch, const QByteArray& _redoPatch) {
         const QString username = DataStorageLayer::StorageFacade::username();
         return DataStorageLayer::StorageFacade::scenarioChangeStorage()->append(username, _undoPatch, _redoPatch);
     }
@@ -61,42 +49,55 @@ namespace {
 void ScenarioTextDocument::updateBlockRevision(QTextCursor& _cursor)
 {
     _cursor.block().setRevision(_cursor.block().revision() + 1);
+
+    //
+    // Изменение пользовательских свойств не приводит к изменению содержимого документа,
+    // поэтому помечаем блок для обновления его xml самостоятельно
+    //
+    if (ScenarioTextDocument* document = qobject_cast<ScenarioTextDocument*>(_cursor.document())) {
+        const int blockNumber = _cursor.block().blockNumber();
+        document->markBlocksXmlDirty(blockNumber, blockNumber);
+    }
 }
 
 ScenarioTextDocument::ScenarioTextDocument(QObject *parent, ScenarioXml* _xmlHandler) :
     QTextDocument(parent),
     m_xmlHandler(_xmlHandler),
     m_isPatchApplyProcessed(false),
+    m_dirtyBlocksFrom(-1),
+    m_dirtyBlocksTo(-1),
+    m_isBlocksCountChanged(false),
+    m_isScenarioXmlDirty(false),
+    m_unsavedBlocksFrom(-1),
+    m_unsavedBlocksTo(-1),
+    m_lastSavedScenarioXmlHash(0),
     m_reviewModel(new ScenarioReviewModel(this)),
     m_outlineMode(false)
 {
+    resetBlocksXml();
+
+    connect(this, &ScenarioTextDocument::contentsChange, this, &ScenarioTextDocument::aboutContentsChange);
     connect(m_reviewModel, SIGNAL(reviewChanged()), this, SIGNAL(reviewChanged()));
 }
 
-void ScenarioTextDocument::updateScenarioXml()
+bool ScenarioTextDocument::updateScenarioXml()
 {
+    bool isChanged = false;
     if (!m_isPatchApplyProcessed) {
-        const QString newScenarioXml = m_xmlHandler->scenarioToXml();
-        const QByteArray newScenarioXmlHash = ::textMd5Hash(newScenarioXml);
-
-        //
-        // Если текущий текст сценария отличается от последнего сохранённого
-        //
-        if (newScenarioXmlHash != m_scenarioXmlHash) {
-            m_scenarioXml = newScenarioXml;
-            m_scenarioXmlHash = newScenarioXmlHash;
-        }
+        isChanged = updateBlocksXml();
     }
+    return isChanged;
 }
 
 QString ScenarioTextDocument::scenarioXml() const
 {
+    buildScenarioXml();
     return m_scenarioXml;
 }
 
-QByteArray ScenarioTextDocument::scenarioXmlHash() const
+quint64 ScenarioTextDocument::scenarioXmlHash() const
 {
-    return m_scenarioXmlHash;
+    return m_xmlChecksum.value();
 }
 
 void ScenarioTextDocument::load(const QString& _scenarioXml)
@@ -120,10 +121,17 @@ void ScenarioTextDocument::load(const QString& _scenarioXml)
     // Загружаем проект
     //
     m_xmlHandler->xmlToScenario(0, scenarioXml);
-    m_scenarioXml = scenarioXml;
-    m_scenarioXmlHash = ::textMd5Hash(scenarioXml);
-    m_lastSavedScenarioXml = m_scenarioXml;
-    m_lastSavedScenarioXmlHash = m_scenarioXmlHash;
+    resetBlocksXml();
+    updateBlocksXml();
+    markChangesSaved();
+    //
+    // ... если сформированный xml отличается от загруженного, то контрольная сумма последнего
+    //     сохранения неизвестна, и разница будет сохранена при следующем сохранении изменений
+    //
+    if (this->scenarioXml() != scenarioXml) {
+        m_lastSavedScenarioXml = scenarioXml;
+        m_lastSavedScenarioXmlHash = 0;
+    }
 
     //
     // Восстанавливаем режим
@@ -149,6 +157,12 @@ void ScenarioTextDocument::load(const QString& _scenarioXml)
 #endif
 }
 
+void ScenarioTextDocument::clear()
+{
+    QTextDocument::clear();
+    resetBlocksXml();
+}
+
 QString ScenarioTextDocument::mimeFromSelection(int _startPosition, int _endPosition) const
 {
     QString mime;
@@ -174,87 +188,60 @@ void ScenarioTextDocument::insertFromMime(int _insertPosition, const QString& _m
     }
 }
 
-void ScenarioTextDocument::applyPatch(const QString& _patch)
+void ScenarioTextDocument::applyPatch(const QByteArray& _patch)
 {
     updateScenarioXml();
     saveChanges();
 
     m_isPatchApplyProcessed = true;
 
-    //
-    // Определим xml для применения патча
-    //
-    QPair<DiffMatchPatchHelper::ChangeXml, DiffMatchPatchHelper::ChangeXml> xmlsForUpdate;
-    const QString patchUncopressed = DatabaseHelper::uncompress(_patch);
-    xmlsForUpdate = DiffMatchPatchHelper::changedXml(m_scenarioXml, patchUncopressed);
-
-    xmlsForUpdate.first.xml = ScenarioXml::makeMimeFromXml(xmlsForUpdate.first.xml);
-    xmlsForUpdate.second.xml = ScenarioXml::makeMimeFromXml(xmlsForUpdate.second.xml);
-
-    //
-    // Удалим одинаковые первые и последние символы
-    //
-    removeIdenticalParts(xmlsForUpdate, false);
-    removeIdenticalParts(xmlsForUpdate, true);
-
-    //
-    // Выделяем текст сценария, соответствующий xml для обновления
-    //
-    QTextCursor cursor(this);
-    cursor.beginEditBlock();
-    const int selectionStartPos = xmlsForUpdate.first.plainPos;
-    const int selectionEndPos = selectionStartPos + xmlsForUpdate.first.plainLength;
-    //
-    // ... собственно выделение
-    //
-    setCursorPosition(cursor, selectionStartPos);
-    setCursorPosition(cursor, selectionEndPos, QTextCursor::KeepAnchor);
-
-#ifdef PATCH_DEBUG
-    qDebug() << "===================================================================";
-    qDebug() << cursor.selectedText();
-    qDebug() << "###################################################################";
-    qDebug() << qPrintable(xmlsForUpdate.first.xml);
-    qDebug() << "###################################################################";
-    qDebug() << qPrintable(QByteArray::fromPercentEncoding(patchUncopressed.toUtf8()));
-    qDebug() << "###################################################################";
-    qDebug() << qPrintable(xmlsForUpdate.second.xml);
-#endif
+    const QString patchUncopressed = DatabaseHelper::uncompressRaw(_patch);
 
     //
-    // Замещаем его обновлённым
+    // Применяем патч только к затрагиваемым им блокам, а если это невозможно, то ко всему документу
     //
-    cursor.removeSelectedText();
-    m_xmlHandler->xmlToScenario(selectionStartPos, xmlsForUpdate.second.xml);
-    cursor.endEditBlock();
+    if (!applyPatchToBlocks(patchUncopressed)) {
+        applyPatchToDocument(patchUncopressed);
+    }
 
     //
     // Запомним новый текст
     //
-    m_scenarioXml = m_xmlHandler->scenarioToXml();
-    m_scenarioXmlHash = ::textMd5Hash(m_scenarioXml);
-    m_lastSavedScenarioXml = m_scenarioXml;
-    m_lastSavedScenarioXmlHash = m_scenarioXmlHash;
+    updateBlocksXml();
+    markChangesSaved();
 
     m_isPatchApplyProcessed = false;
 }
 
-void ScenarioTextDocument::applyPatches(const QList<QString>& _patches)
+void ScenarioTextDocument::applyPatches(const QList<QByteArray>& _patches)
 {
+    updateBlocksXml();
     m_isPatchApplyProcessed = true;
 
 
     //
-    // Применяем патчи
+    // Применяем патчи к плоскому представлению сценария, которое формируется единожды для всех патчей
     //
-    QString newXml = m_scenarioXml;
-    int currentIndex = 0, max = _patches.size();
-    foreach (const QString& patch, _patches) {
-        const QString patchUncopressed = DatabaseHelper::uncompress(patch);
-        newXml = DiffMatchPatchHelper::applyPatchXml(newXml, patchUncopressed);
-        QLightBoxProgress::setProgressValue(++currentIndex * 100 / max);
-        QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+    QString plainXml = DiffMatchPatchHelper::xmlToPlain(scenarioXml());
+    QElapsedTimer timer;
+    timer.start();
+    int appliedPatches = 0, lastProgress = -1;
+    const int patchesCount = _patches.size();
+    foreach (const QByteArray& patch, _patches) {
+        DiffMatchPatchHelper::applyPatchPlain(plainXml, DatabaseHelper::uncompressRaw(patch));
+        ++appliedPatches;
+
+        //
+        // ... уведомляем о ходе применения при изменении процента выполнения
+        //
+        const int progress = appliedPatches * 100 / patchesCount;
+        if (progress != lastProgress) {
+            lastProgress = progress;
+            const qreal patchesPerSecond = appliedPatches * 1000. / qMax(qint64(1), timer.elapsed());
+            emit patchesApplyProgress(appliedPatches, patchesCount, patchesPerSecond);
+        }
     }
+    const QString newXml = DiffMatchPatchHelper::plainToXml(plainXml);
 
     //
     // Перезагружаем текст документа
@@ -269,10 +256,8 @@ void ScenarioTextDocument::applyPatches(const QList<QString>& _patches)
     //
     // Запомним новый текст
     //
-    m_scenarioXml = m_xmlHandler->scenarioToXml();
-    m_scenarioXmlHash = ::textMd5Hash(m_scenarioXml);
-    m_lastSavedScenarioXml = m_scenarioXml;
-    m_lastSavedScenarioXmlHash = m_scenarioXmlHash;
+    updateBlocksXml();
+    markChangesSaved();
 
 
     m_isPatchApplyProcessed = false;
@@ -283,19 +268,23 @@ Domain::ScenarioChange* ScenarioTextDocument::saveChanges()
     Domain::ScenarioChange* change = 0;
 
     if (!m_isPatchApplyProcessed) {
+        updateBlocksXml();
+
         //
         // Если текущий текст сценария отличается от последнего сохранённого
         //
-        if (m_scenarioXmlHash != m_lastSavedScenarioXmlHash) {
+        if (scenarioXmlHash() != m_lastSavedScenarioXmlHash) {
             //
             // Сформируем изменения
             //
-            const QString undoPatch = DiffMatchPatchHelper::makePatchXml(m_scenarioXml, m_lastSavedScenarioXml);
-            const QString undoPatchCompressed = DatabaseHelper::compress(undoPatch);
-            const QString redoPatch = DiffMatchPatchHelper::makePatchXml(m_lastSavedScenarioXml, m_scenarioXml);
-            const QString redoPatchCompressed = DatabaseHelper::compress(redoPatch);
-
-            if (undoPatchCompressed == "AAAAAA==" || redoPatchCompressed == "AAAAAA==") {
+            const QPair<QString, QString> patches = makeChangesPatches();
+            const QString undoPatch = patches.first;
+            const QByteArray undoPatchCompressed = DatabaseHelper::compressRaw(undoPatch);
+            const QString redoPatch = patches.second;
+            const QByteArray redoPatchCompressed = DatabaseHelper::compressRaw(redoPatch);
+
+            const QByteArray emptyPatchCompressed = DatabaseHelper::compressRaw(QString());
+            if (undoPatchCompressed == emptyPatchCompressed || redoPatchCompressed == emptyPatchCompressed) {
                 qDebug() << "Shit!";
             }
 
@@ -307,8 +296,7 @@ Domain::ScenarioChange* ScenarioTextDocument::saveChanges()
             //
             // Запомним новый текст
             //
-            m_lastSavedScenarioXml = m_scenarioXml;
-            m_lastSavedScenarioXmlHash = m_scenarioXmlHash;
+            markChangesSaved();
 
             //
             // Корректируем стеки последних действий
@@ -473,6 +461,363 @@ QList<ScenarioBlockStyle::Type> ScenarioTextDocument::visibleBlocksTypes() const
     return m_outlineMode ? s_outlineVisibleBlocksTypes : s_scenarioVisibleBlocksTypes;
 }
 
+void ScenarioTextDocument::aboutContentsChange(int _position, int _charsRemoved, int _charsAdded)
+{
+    Q_UNUSED(_charsRemoved);
+
+    //
+    // Определим диапазон блоков, затронутых изменением, в их текущей нумерации
+    //
+    const int lastPosition = qMin(_position + _charsAdded, characterCount() - 1);
+    const int firstBlock = findBlock(_position).blockNumber();
+    const int lastBlock = findBlock(lastPosition).blockNumber();
+
+    //
+    // ... и в нумерации до изменения
+    //
+    const int blocksDelta = blockCount() - m_blocksXml.size();
+    const int lastBlockBeforeChange = lastBlock - blocksDelta;
+
+    //
+    // Если изменение не согласуется с сохранённой структурой, то сбрасываем xml всех блоков
+    //
+    if (firstBlock < 0
+        || lastBlock < firstBlock
+        || lastBlockBeforeChange < firstBlock - 1
+        || lastBlockBeforeChange >= m_blocksXml.size()) {
+        resetBlocksXml();
+        return;
+    }
+
+    //
+    // Корректируем список xml блоков, оставляя прежний xml затронутых блоков для последующего сравнения
+    //
+    if (blocksDelta > 0) {
+        m_blocksXml.insert(lastBlockBeforeChange + 1, blocksDelta, BlockXml());
+        m_xmlChecksum.insert(lastBlockBeforeChange + 1, blocksDelta, ScenarioXmlChecksum::blockChecksum(QString()));
+        m_isBlocksCountChanged = true;
+    } else if (blocksDelta < 0) {
+        m_blocksXml.remove(lastBlock + 1, -blocksDelta);
+        m_xmlChecksum.remove(lastBlock + 1, -blocksDelta);
+        m_isBlocksCountChanged = true;
+    }
+
+    //
+    // Смещаем ранее помеченный диапазон, если он находится после изменения
+    //
+    if (m_dirtyBlocksFrom > lastBlockBeforeChange) {
+        m_dirtyBlocksFrom += blocksDelta;
+    }
+    if (m_dirtyBlocksTo > lastBlockBeforeChange) {
+        m_dirtyBlocksTo += blocksDelta;
+    }
+    if (m_unsavedBlocksFrom > lastBlockBeforeChange) {
+        m_unsavedBlocksFrom += blocksDelta;
+    }
+    if (m_unsavedBlocksTo > lastBlockBeforeChange) {
+        m_unsavedBlocksTo += blocksDelta;
+    }
+
+    markBlocksXmlDirty(firstBlock, lastBlock);
+}
+
+void ScenarioTextDocument::markBlocksXmlDirty(int _fromBlock, int _toBlock)
+{
+    _toBlock = qMin(_toBlock, m_blocksXml.size() - 1);
+    for (int blockNumber = _fromBlock; blockNumber <= _toBlock; ++blockNumber) {
+        m_blocksXml[blockNumber].isDirty = true;
+    }
+
+    if (m_dirtyBlocksFrom == -1
+        || _fromBlock < m_dirtyBlocksFrom) {
+        m_dirtyBlocksFrom = _fromBlock;
+    }
+    if (m_dirtyBlocksTo == -1
+        || _toBlock > m_dirtyBlocksTo) {
+        m_dirtyBlocksTo = _toBlock;
+    }
+
+    //
+    // ... и запоминаем их, как изменённые с момента последнего сохранения
+    //
+    if (m_unsavedBlocksFrom == -1
+        || _fromBlock < m_unsavedBlocksFrom) {
+        m_unsavedBlocksFrom = _fromBlock;
+    }
+    if (m_unsavedBlocksTo == -1
+        || _toBlock > m_unsavedBlocksTo) {
+        m_unsavedBlocksTo = _toBlock;
+    }
+}
+
+void ScenarioTextDocument::resetBlocksXml()
+{
+    m_blocksXml = QVector<BlockXml>(blockCount());
+    m_xmlChecksum.clear();
+    m_xmlChecksum.insert(0, blockCount(), ScenarioXmlChecksum::blockChecksum(QString()));
+    m_dirtyBlocksFrom = 0;
+    m_dirtyBlocksTo = blockCount() - 1;
+    m_unsavedBlocksFrom = 0;
+    m_unsavedBlocksTo = blockCount() - 1;
+    m_isBlocksCountChanged = true;
+}
+
+bool ScenarioTextDocument::updateBlocksXml()
+{
+    bool isChanged = m_isBlocksCountChanged;
+
+    if (m_dirtyBlocksFrom != -1) {
+        //
+        // Формируем xml только для помеченных блоков, сравнивая его с прежним
+        //
+        const int lastDirtyBlock = qMin(m_dirtyBlocksTo, m_blocksXml.size() - 1);
+        QTextBlock block = findBlockByNumber(m_dirtyBlocksFrom);
+        for (int blockNumber = m_dirtyBlocksFrom;
+             blockNumber <= lastDirtyBlock && block.isValid();
+             ++blockNumber, block = block.next()) {
+            BlockXml& blockXml = m_blocksXml[blockNumber];
+            if (!blockXml.isDirty) {
+                continue;
+            }
+
+            const QString newXml = m_xmlHandler->blockToXml(block);
+            if (blockXml.xml != newXml) {
+                blockXml.xml = newXml;
+                blockXml.plainLength = DiffMatchPatchHelper::plainLength(newXml);
+                m_xmlChecksum.update(blockNumber, ScenarioXmlChecksum::blockChecksum(newXml));
+                isChanged = true;
+            }
+            blockXml.isDirty = false;
+        }
+    }
+
+    m_dirtyBlocksFrom = -1;
+    m_dirtyBlocksTo = -1;
+    m_isBlocksCountChanged = false;
+
+    if (isChanged) {
+        m_isScenarioXmlDirty = true;
+    }
+
+    return isChanged;
+}
+
+void ScenarioTextDocument::buildScenarioXml() const
+{
+    if (m_isScenarioXmlDirty) {
+        int xmlLength = 0;
+        foreach (const BlockXml& blockXml, m_blocksXml) {
+            xmlLength += blockXml.xml.length();
+        }
+
+        QString scenarioXml;
+        scenarioXml.reserve(xmlLength);
+        foreach (const BlockXml& blockXml, m_blocksXml) {
+            scenarioXml.append(blockXml.xml);
+        }
+
+        m_scenarioXml = ScenarioXml::makeMimeFromXml(scenarioXml);
+        m_isScenarioXmlDirty = false;
+    }
+}
+
+void ScenarioTextDocument::unsavedBlocksRanges(int& _fromBlock, int& _toBlock, int& _lastSavedToBlock) const
+{
+    //
+    // Блоки после изменённого диапазона совпадают с сохранёнными, поэтому конец диапазона
+    // в сохранённой нумерации отличается на разницу в количестве блоков
+    //
+    const int blocksDelta = m_blocksXml.size() - m_lastSavedBlocksXml.size();
+    _fromBlock = m_unsavedBlocksFrom;
+    _toBlock = qMin(m_unsavedBlocksTo, m_blocksXml.size() - 1);
+    _lastSavedToBlock = _toBlock - blocksDelta;
+
+    //
+    // Если диапазон не согласуется с сохранённым xml, то считаем изменёнными все блоки
+    //
+    if (_fromBlock < 0
+        || _toBlock < _fromBlock - 1
+        || _lastSavedToBlock < _fromBlock - 1
+        || _lastSavedToBlock >= m_lastSavedBlocksXml.size()) {
+        _fromBlock = 0;
+        _toBlock = m_blocksXml.size() - 1;
+        _lastSavedToBlock = m_lastSavedBlocksXml.size() - 1;
+    }
+}
+
+QPair<QString, QString> ScenarioTextDocument::makeChangesPatches() const
+{
+    //
+    // Если сохранённый текст не разбит на блоки, то сравниваем документы целиком
+    //
+    if (!m_lastSavedScenarioXml.isEmpty()) {
+        const QString scenarioXml = this->scenarioXml();
+        return qMakePair(DiffMatchPatchHelper::makePatchXml(scenarioXml, m_lastSavedScenarioXml),
+                         DiffMatchPatchHelper::makePatchXml(m_lastSavedScenarioXml, scenarioXml));
+    }
+
+    int fromBlock = 0, toBlock = 0, lastSavedToBlock = 0;
+    unsavedBlocksRanges(fromBlock, toBlock, lastSavedToBlock);
+
+    //
+    // Захватываем по одному неизменённому блоку с каждой стороны, чтобы патчи содержали
+    // контекст, по которому они будут применяться к тексту других пользователей
+    //
+    if (fromBlock > 0) {
+        --fromBlock;
+    }
+    if (toBlock < m_blocksXml.size() - 1) {
+        ++toBlock;
+        ++lastSavedToBlock;
+    }
+
+    //
+    // Блоки перед окном не изменялись, поэтому смещение окна одинаково для обоих текстов
+    //
+    int plainOffset = 0;
+    for (int blockNumber = 0; blockNumber < fromBlock; ++blockNumber) {
+        plainOffset += m_blocksXml.at(blockNumber).plainLength;
+    }
+
+    QString xml;
+    for (int blockNumber = fromBlock; blockNumber <= toBlock; ++blockNumber) {
+        xml.append(m_blocksXml.at(blockNumber).xml);
+    }
+    QString lastSavedXml;
+    for (int blockNumber = fromBlock; blockNumber <= lastSavedToBlock; ++blockNumber) {
+        lastSavedXml.append(m_lastSavedBlocksXml.at(blockNumber));
+    }
+
+    return qMakePair(DiffMatchPatchHelper::makePatchXml(xml, lastSavedXml, plainOffset),
+                     DiffMatchPatchHelper::makePatchXml(lastSavedXml, xml, plainOffset));
+}
+
+void ScenarioTextDocument::markChangesSaved()
+{
+    //
+    // Заменяем в сохранённом xml только диапазон изменённых блоков
+    //
+    int fromBlock = 0, toBlock = 0, lastSavedToBlock = 0;
+    unsavedBlocksRanges(fromBlock, toBlock, lastSavedToBlock);
+
+    const int blocksDelta = toBlock - lastSavedToBlock;
+    if (blocksDelta > 0) {
+        m_lastSavedBlocksXml.insert(fromBlock, blocksDelta, QString());
+    } else if (blocksDelta < 0) {
+        m_lastSavedBlocksXml.remove(fromBlock, -blocksDelta);
+    }
+    for (int blockNumber = fromBlock; blockNumber <= toBlock; ++blockNumber) {
+        m_lastSavedBlocksXml[blockNumber] = m_blocksXml.at(blockNumber).xml;
+    }
+
+    m_unsavedBlocksFrom = -1;
+    m_unsavedBlocksTo = -1;
+    m_lastSavedScenarioXml.clear();
+    m_lastSavedScenarioXmlHash = scenarioXmlHash();
+}
+
+bool ScenarioTextDocument::applyPatchToBlocks(const QString& _patch)
+{
+    //
+    // Определим блоки, которые может затронуть патч, и позицию первого из них в плоском тексте
+    //
+    QVector<int> blocksPlainLengths;
+    blocksPlainLengths.reserve(m_blocksXml.size());
+    foreach (const BlockXml& blockXml, m_blocksXml) {
+        blocksPlainLengths.append(blockXml.plainLength);
+    }
+    int fromBlock = -1, toBlock = -1, plainOffset = 0;
+    if (!DiffMatchPatchHelper::patchBlocksRange(_patch, blocksPlainLengths, fromBlock, toBlock, plainOffset)) {
+        return false;
+    }
+
+    //
+    // Применяем патч к xml найденных блоков
+    //
+    QString xml;
+    for (int blockNumber = fromBlock; blockNumber <= toBlock; ++blockNumber) {
+        xml.append(m_blocksXml.at(blockNumber).xml);
+    }
+    bool isApplied = false;
+    const QString newXml = DiffMatchPatchHelper::applyPatchXml(xml, _patch, plainOffset, isApplied);
+    if (!isApplied
+        || newXml.isEmpty()) {
+        return false;
+    }
+    if (newXml == xml) {
+        return true;
+    }
+
+    //
+    // Замещаем текст найденных блоков обновлённым
+    //
+    const QTextBlock firstBlock = findBlockByNumber(fromBlock);
+    const QTextBlock lastBlock = findBlockByNumber(toBlock);
+    QTextCursor cursor(this);
+    cursor.beginEditBlock();
+    cursor.setPosition(firstBlock.position());
+    cursor.setPosition(lastBlock.position() + lastBlock.length() - 1, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    //
+    // ... в оставшийся пустой блок будет загружен первый из обновлённых, поэтому
+    //     сбрасываем информацию о сцене, которая в нём хранилась
+    //
+    cursor.block().setUserData(nullptr);
+    m_xmlHandler->xmlToScenario(cursor.position(), ScenarioXml::makeMimeFromXml(newXml));
+    cursor.endEditBlock();
+
+    return true;
+}
+
+void ScenarioTextDocument::applyPatchToDocument(const QString& _patch)
+{
+    //
+    // Определим xml для применения патча
+    //
+    QPair<DiffMatchPatchHelper::ChangeXml, DiffMatchPatchHelper::ChangeXml> xmlsForUpdate;
+    xmlsForUpdate = DiffMatchPatchHelper::changedXml(scenarioXml(), _patch);
+
+    xmlsForUpdate.first.xml = ScenarioXml::makeMimeFromXml(xmlsForUpdate.first.xml);
+    xmlsForUpdate.second.xml = ScenarioXml::makeMimeFromXml(xmlsForUpdate.second.xml);
+
+    //
+    // Удалим одинаковые первые и последние символы
+    //
+    removeIdenticalParts(xmlsForUpdate, false);
+    removeIdenticalParts(xmlsForUpdate, true);
+
+    //
+    // Выделяем текст сценария, соответствующий xml для обновления
+    //
+    QTextCursor cursor(this);
+    cursor.beginEditBlock();
+    const int selectionStartPos = xmlsForUpdate.first.plainPos;
+    const int selectionEndPos = selectionStartPos + xmlsForUpdate.first.plainLength;
+    //
+    // ... собственно выделение
+    //
+    setCursorPosition(cursor, selectionStartPos);
+    setCursorPosition(cursor, selectionEndPos, QTextCursor::KeepAnchor);
+
+#ifdef PATCH_DEBUG
+    qDebug() << "===================================================================";
+    qDebug() << cursor.selectedText();
+    qDebug() << "###################################################################";
+    qDebug() << qPrintable(xmlsForUpdate.first.xml);
+    qDebug() << "###################################################################";
+    qDebug() << qPrintable(QByteArray::fromPercentEncoding(_patch.toUtf8()));
+    qDebug() << "###################################################################";
+    qDebug() << qPrintable(xmlsForUpdate.second.xml);
+#endif
+
+    //
+    // Замещаем его обновлённым
+    //
+    cursor.removeSelectedText();
+    m_xmlHandler->xmlToScenario(selectionStartPos, xmlsForUpdate.second.xml);
+    cursor.endEditBlock();
+}
+
 void ScenarioTextDocument::removeIdenticalParts(QPair<DiffMatchPatchHelper::ChangeXml, DiffMatchPatchHelper::ChangeXml>& _xmls, bool _reversed)
 {
     //
@@ -2,10 +2,12 @@
 #define SCENARIOTEXTDOCUMENT_H
 
 #include "ScenarioTemplate.h"
+#include "ScenarioXmlChecksum.h"
 #include <3rd_party/Helpers/DiffMatchPatchHelper.h>
 
 #include <QTextDocument>
 #include <QTextCursor>
+#include <QVector>
 
 namespace Domain {
     class ScenarioChange;
@@ -38,9 +40,11 @@ namespace BusinessLogic
         explicit ScenarioTextDocument(QObject *parent, ScenarioXml* _xmlHandler);
 
         /**
-         * @brief Сформировать xml из сценария и рассчитать его хэш
+         * @brief Обновить xml блоков сценария, изменённых с момента последнего обновления
+         * @return Изменился ли xml сценария
+         * @note Xml всего сценария и его хэш пересобираются лениво, при обращении к ним
          */
-        void updateScenarioXml();
+        bool updateScenarioXml();
 
         /**
          * @brief Получить xml сценария
@@ -48,15 +52,21 @@ namespace BusinessLogic
         QString scenarioXml() const;
 
         /**
-         * @brief Получить текущий хэш сценария
+         * @brief Получить текущую контрольную сумму xml сценария
+         * @note Сумма поддерживается по мере изменения блоков и не требует обхода всего документа
          */
-        QByteArray scenarioXmlHash() const;
+        quint64 scenarioXmlHash() const;
 
         /**
          * @brief Загрузить сценарий
          */
         void load(const QString& _scenarioXml);
 
+        /**
+         * @brief Переопределяется для сброса xml блоков
+         */
+        void clear() override;
+
         /**
          * @brief Получить майм представление данных в указанном диапазоне
          */
@@ -68,15 +78,17 @@ namespace BusinessLogic
         void insertFromMime(int _insertPosition, const QString& _mimeData);
 
         /**
-         * @brief Применить патч
+         * @brief Применить сжатый патч
          */
-        void applyPatch(const QString& _patch);
+        void applyPatch(const QByteArray& _patch);
 
         /**
          * @brief Применить множество патчей
-         * @note Метод для оптимизации, перестраивается весь документ
+         * @note Метод для оптимизации, патчи применяются к плоскому представлению сценария,
+         *		 после чего весь документ перестраивается единожды. О ходе применения патчей
+         *		 уведомляет сигнал patchesApplyProgress
          */
-        void applyPatches(const QList<QString>& _patches);
+        void applyPatches(const QList<QByteArray>& _patches);
 
         /**
          * @brief Сохранить изменения текста
@@ -134,12 +146,102 @@ namespace BusinessLogic
         void afterPatchApply();
         /** @} */
 
+        /**
+         * @brief Ход применения множества патчей
+         * @param _applied - количество применённых патчей
+         * @param _total - общее количество патчей
+         * @param _patchesPerSecond - скорость применения патчей
+         */
+        void patchesApplyProgress(int _applied, int _total, qreal _patchesPerSecond);
+
         /**
          * @brief В документ были внесены редакторские примечания
          */
         void reviewChanged();
 
     private:
+        /**
+         * @brief Xml-представление блока текста
+         */
+        class BlockXml
+        {
+        public:
+            BlockXml() : plainLength(0), isDirty(true) {}
+
+            /**
+             * @brief Сам xml
+             */
+            QString xml;
+
+            /**
+             * @brief Длина xml в плоском представлении, в котором формируются патчи изменений
+             */
+            int plainLength;
+
+            /**
+             * @brief Необходимо ли сформировать xml блока заново
+             */
+            bool isDirty;
+        };
+
+    private slots:
+        /**
+         * @brief Изменилось содержимое документа, помечаем затронутые блоки для обновления их xml
+         */
+        void aboutContentsChange(int _position, int _charsRemoved, int _charsAdded);
+
+    private:
+        /**
+         * @brief Пометить блоки из заданного диапазона, как требующие обновления xml
+         */
+        void markBlocksXmlDirty(int _fromBlock, int _toBlock);
+
+        /**
+         * @brief Сбросить xml всех блоков, чтобы он был сформирован заново
+         */
+        void resetBlocksXml();
+
+        /**
+         * @brief Сформировать xml изменённых блоков
+         * @return Изменился ли xml хотя бы одного из блоков
+         */
+        bool updateBlocksXml();
+
+        /**
+         * @brief Собрать xml сценария из xml блоков и рассчитать его хэш, если это необходимо
+         */
+        void buildScenarioXml() const;
+
+        /**
+         * @brief Определить диапазон блоков, изменённых с момента последнего сохранения,
+         *		  в текущей нумерации и конец этого диапазона в нумерации сохранённого xml
+         * @note Если диапазон определить не удалось, то возвращается диапазон всех блоков
+         */
+        void unsavedBlocksRanges(int& _fromBlock, int& _toBlock, int& _lastSavedToBlock) const;
+
+        /**
+         * @brief Сформировать патчи отмены и повтора изменений, сделанных с момента последнего сохранения
+         * @return Пара: 1) патч отмены; 2) патч повтора
+         * @note Сравниваются только блоки, изменённые с момента последнего сохранения, и их соседи
+         */
+        QPair<QString, QString> makeChangesPatches() const;
+
+        /**
+         * @brief Запомнить текущий xml блоков, как сохранённый
+         */
+        void markChangesSaved();
+
+        /**
+         * @brief Применить патч только к тем блокам, которые он затрагивает
+         * @return Удалось ли применить патч таким образом
+         */
+        bool applyPatchToBlocks(const QString& _patch);
+
+        /**
+         * @brief Применить патч, определив изменённую часть по тексту всего документа
+         */
+        void applyPatchToDocument(const QString& _patch);
+
         /**
          * @brief Процедура удаления одинаковый первых и последних частей в xml-строках у _xmls
          * _reversed = false - удаляем первые, = true - удаляем последние
@@ -173,21 +275,64 @@ namespace BusinessLogic
         bool m_isPatchApplyProcessed;
 
         /**
-         * @brief  Xml текст сценария и его MD5-хэш
+         * @brief Xml каждого из блоков документа
+         * @note Индекс в списке соответствует номеру блока в документе, размер списка не ограничен
+         */
+        QVector<BlockXml> m_blocksXml;
+
+        /**
+         * @brief Границы диапазона номеров блоков, среди которых есть помеченные для обновления
          */
         /** @{ */
-        QString m_scenarioXml;
-        QByteArray m_scenarioXmlHash;
+        int m_dirtyBlocksFrom;
+        int m_dirtyBlocksTo;
         /** @} */
 
         /**
-         * @brief Xml текст сценария и его MD5-хэш на момент последнего сохранения изменений
+         * @brief Изменилось ли количество блоков с момента последнего обновления xml
+         */
+        bool m_isBlocksCountChanged;
+
+        /**
+         * @brief Необходимо ли пересобрать xml сценария из xml блоков
+         */
+        mutable bool m_isScenarioXmlDirty;
+
+        /**
+         * @brief Xml текст сценария
+         */
+        mutable QString m_scenarioXml;
+
+        /**
+         * @brief Контрольная сумма xml сценария, составленная из сумм блоков
+         */
+        ScenarioXmlChecksum m_xmlChecksum;
+
+        /**
+         * @brief Xml блоков на момент последнего сохранения изменений
+         */
+        QVector<QString> m_lastSavedBlocksXml;
+
+        /**
+         * @brief Границы диапазона номеров блоков, изменённых с момента последнего сохранения изменений
          */
         /** @{ */
-        QString m_lastSavedScenarioXml;
-        QByteArray m_lastSavedScenarioXmlHash;
+        int m_unsavedBlocksFrom;
+        int m_unsavedBlocksTo;
         /** @} */
 
+        /**
+         * @brief Xml текст сценария на момент последнего сохранения изменений
+         * @note Задаётся только если он не совпадает с xml, собранным из сохранённых блоков,
+         *		 например, если загруженный текст был сформирован предыдущей версией программы
+         */
+        QString m_lastSavedScenarioXml;
+
+        /**
+         * @brief Контрольная сумма xml сценария на момент последнего сохранения изменений
+         */
+        quint64 m_lastSavedScenarioXmlHash;
+
         /**
          * @brief Стеки для отмены/повтора последнего действия
          */
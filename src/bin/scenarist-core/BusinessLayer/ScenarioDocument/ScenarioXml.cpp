@@ -57,58 +57,6 @@ namespace {
         }
         return hasMarks;
     }
-
-    /**
-     * @brief Сформировать хэш для текстового блока
-     */
-    static inline uint blockHash(const QTextBlock& _block)
-    {
-        //
-        // Формируем уникальную строку, главное, чтобы два разных блока не имели одинакового хэша,
-        // но в то же время, нельзя опираться на позицию блока, т.к. при смещение текста на абзац
-        // вниз, придётся пересчитывать хэши всех остальных блоков
-        //
-        QString hash;
-        hash.append(_block.text());
-        hash.append("#");
-        hash.append(_block.revision());
-        if (ScenarioTextBlockInfo* blockInfo = dynamic_cast<ScenarioTextBlockInfo*>(_block.userData())) {
-            hash.append("#");
-            hash.append(QString::number(blockInfo->sceneNumber()));
-            hash.append("#");
-            hash.append(blockInfo->colors());
-            hash.append("#");
-            hash.append(blockInfo->title());
-            hash.append("#");
-            hash.append(blockInfo->description());
-        }
-        foreach (const QTextLayout::FormatRange& range, _block.textFormats()) {
-            hash.append("#");
-            hash.append(QString::number(range.start));
-            hash.append("#");
-            hash.append(QString::number(range.length));
-            hash.append("#");
-            hash.append(range.format.foreground().color().name());
-            hash.append("#");
-            hash.append(range.format.background().color().name());
-            hash.append("#");
-            hash.append(range.format.boolProperty(ScenarioBlockStyle::PropertyIsReviewMark) ? "true" : "false");
-            hash.append("#");
-            hash.append(range.format.boolProperty(ScenarioBlockStyle::PropertyIsHighlight) ? "true" : "false");
-            hash.append("#");
-            hash.append(range.format.boolProperty(ScenarioBlockStyle::PropertyIsDone) ? "true" : "false");
-            hash.append("#");
-            hash.append(range.format.property(ScenarioBlockStyle::PropertyComments).toStringList().join("#"));
-            hash.append("#");
-            hash.append(range.format.property(ScenarioBlockStyle::PropertyCommentsAuthors).toStringList().join("#"));
-            hash.append("#");
-            hash.append(range.format.property(ScenarioBlockStyle::PropertyCommentsDates).toStringList().join("#"));
-        }
-        hash.append("#");
-        hash.append(ScenarioBlockStyle::forBlock(_block));
-
-        return qHash(hash);
-    }
 }
 
 
@@ -153,11 +101,9 @@ ScenarioXml::ScenarioXml(ScenarioDocument* _scenario) :
     m_lastMimeTo(0)
 {
     Q_ASSERT(m_scenario);
-
-    m_xmlCache.setMaxCost(2000);
 }
 
-QString ScenarioXml::scenarioToXml()
+QString ScenarioXml::blockToXml(const QTextBlock& _block)
 {
     //
     // Для формирования xml не используем QXmlStreamWriter, т.к. нам нужно хранить по отдельности
@@ -166,163 +112,142 @@ QString ScenarioXml::scenarioToXml()
     // странных последовательностей, наподобии ">>" или ">/>"
     //
 
-    QString resultXml;
-
-    QTextBlock currentBlock = m_scenario->document()->begin();
+    QTextBlock currentBlock = _block;
     QString currentBlockXml;
-    do {
-        currentBlockXml.clear();
-        const uint currentBlockHash = ::blockHash(currentBlock);
 
-        //
-        // Если для блока есть кэш, используем его
-        //
-        if (m_xmlCache.contains(currentBlockHash)) {
-            resultXml.append(m_xmlCache[currentBlockHash]);
-        }
-        //
-        // В противном случае формируем xml
-        //
-        else {
-            //
-            // Определим тип текущего блока
-            //
-            ScenarioBlockStyle::Type currentType = ScenarioBlockStyle::forBlock(currentBlock);
+    //
+    // Определим тип текущего блока
+    //
+    ScenarioBlockStyle::Type currentType = ScenarioBlockStyle::forBlock(currentBlock);
 
-            //
-            // Получить текст под курсором
-            //
-            QString textToSave = TextEditHelper::toHtmlEscaped(currentBlock.text());
+    //
+    // Получить текст под курсором
+    //
+    QString textToSave = TextEditHelper::toHtmlEscaped(currentBlock.text());
 
-            //
-            // Определить параметры текущего абзаца
-            //
-            bool needWrite = true; // пишем абзац?
-            QString currentNode = ScenarioBlockStyle::typeName(currentType); // имя текущей ячейки
-            bool canHaveColors = false; // может иметь цвета
-            switch (currentType) {
-                case ScenarioBlockStyle::SceneHeading: {
-                    canHaveColors = true;
-                    break;
-                }
+    //
+    // Определить параметры текущего абзаца
+    //
+    bool needWrite = true; // пишем абзац?
+    QString currentNode = ScenarioBlockStyle::typeName(currentType); // имя текущей ячейки
+    bool canHaveColors = false; // может иметь цвета
+    switch (currentType) {
+        case ScenarioBlockStyle::SceneHeading: {
+            canHaveColors = true;
+            break;
+        }
 
-                case ScenarioBlockStyle::Parenthetical: {
-                    needWrite = !textToSave.isEmpty();
-                    break;
-                }
+        case ScenarioBlockStyle::Parenthetical: {
+            needWrite = !textToSave.isEmpty();
+            break;
+        }
 
-                case ScenarioBlockStyle::SceneGroupHeader: {
-                    canHaveColors = true;
-                    break;
-                }
+        case ScenarioBlockStyle::SceneGroupHeader: {
+            canHaveColors = true;
+            break;
+        }
 
-                case ScenarioBlockStyle::FolderHeader: {
-                    canHaveColors = true;
-                    break;
-                }
+        case ScenarioBlockStyle::FolderHeader: {
+            canHaveColors = true;
+            break;
+        }
 
-                default: {
-                    break;
-                }
-            }
+        default: {
+            break;
+        }
+    }
 
+    //
+    // Дописать xml
+    //
+    if (needWrite) {
+        //
+        // Если возможно, сохраним uuid, цвета элемента и его заголовок
+        //
+        QString uuidColorsAndTitle;
+        if (canHaveColors) {
+            ScenarioTextBlockInfo* info = dynamic_cast<ScenarioTextBlockInfo*>(currentBlock.userData());
+            if (info == nullptr) {
+                info = new ScenarioTextBlockInfo;
+                currentBlock.setUserData(info);
+            }
             //
-            // Дописать xml
-            //
-            if (needWrite) {
-                //
-                // Если возможно, сохраним uuid, цвета элемента и его заголовок
-                //
-                QString uuidColorsAndTitle;
-                if (canHaveColors) {
-                    ScenarioTextBlockInfo* info = dynamic_cast<ScenarioTextBlockInfo*>(currentBlock.userData());
-                    if (info == nullptr) {
-                        info = new ScenarioTextBlockInfo;
-                        currentBlock.setUserData(info);
-                    }
-                    //
-                    if (!info->uuid().isEmpty()) {
-                        uuidColorsAndTitle = QString(" %1=\"%2\"").arg(ATTRIBUTE_UUID, info->uuid());
-                    }
-                    if (!info->colors().isEmpty()) {
-                        uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_COLOR, info->colors());
-                    }
-                    if (!info->title().isEmpty()) {
-                        uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_TITLE, info->title());
-                    }
-                }
+            if (!info->uuid().isEmpty()) {
+                uuidColorsAndTitle = QString(" %1=\"%2\"").arg(ATTRIBUTE_UUID, info->uuid());
+            }
+            if (!info->colors().isEmpty()) {
+                uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_COLOR, info->colors());
+            }
+            if (!info->title().isEmpty()) {
+                uuidColorsAndTitle += QString(" %1=\"%2\"").arg(ATTRIBUTE_TITLE, info->title());
+            }
+        }
 
-                //
-                // Открыть ячейку текущего элемента
-                //
-                currentBlockXml.append(QString("<%1%2>\n").arg(currentNode, uuidColorsAndTitle));
+        //
+        // Открыть ячейку текущего элемента
+        //
+        currentBlockXml.append(QString("<%1%2>\n").arg(currentNode, uuidColorsAndTitle));
 
-                //
-                // Пишем текст текущего элемента
-                //
-                currentBlockXml.append(QString("<%1><![CDATA[%2]]></%1>\n").arg(NODE_VALUE, textToSave));
+        //
+        // Пишем текст текущего элемента
+        //
+        currentBlockXml.append(QString("<%1><![CDATA[%2]]></%1>\n").arg(NODE_VALUE, textToSave));
+
+        //
+        // Пишем редакторские комментарии, если они есть в блоке
+        //
+        if (::hasReviewMarks(currentBlock)) {
+            currentBlockXml.append(QString("<%1>\n").arg(NODE_REVIEW_GROUP));
+            foreach (const QTextLayout::FormatRange& range, currentBlock.textFormats()) {
+                bool isReviewMark =
+                    range.format.boolProperty(ScenarioBlockStyle::PropertyIsReviewMark);
 
                 //
-                // Пишем редакторские комментарии, если они есть в блоке
+                // Все редакторские правки, и только, если выделен записываемый текст
                 //
-                if (::hasReviewMarks(currentBlock)) {
-                    currentBlockXml.append(QString("<%1>\n").arg(NODE_REVIEW_GROUP));
-                    foreach (const QTextLayout::FormatRange& range, currentBlock.textFormats()) {
-                        bool isReviewMark =
-                            range.format.boolProperty(ScenarioBlockStyle::PropertyIsReviewMark);
-
-                        //
-                        // Все редакторские правки, и только, если выделен записываемый текст
-                        //
-                        if (isReviewMark) {
-                            currentBlockXml.append(QString("<%1").arg(NODE_REVIEW));
-                            currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_FROM, QString::number(range.start)));
-                            currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_LENGTH, QString::number(range.length)));
-                            if (range.format.hasProperty(QTextFormat::ForegroundBrush)) {
-                                currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_COLOR, range.format.foreground().color().name()));
-                            }
-                            if (range.format.hasProperty(QTextFormat::BackgroundBrush)) {
-                                currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_BGCOLOR, range.format.background().color().name()));
-                            }
-                            currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_IS_HIGHLIGHT,
-                                range.format.boolProperty(ScenarioBlockStyle::PropertyIsHighlight) ? "true" : "false"));
-                            currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_DONE,
-                                range.format.boolProperty(ScenarioBlockStyle::PropertyIsDone) ? "true" : "false"));
-                            currentBlockXml.append(">\n");
-                            //
-                            // ... комментарии
-                            //
-                            const QStringList comments = range.format.property(ScenarioBlockStyle::PropertyComments).toStringList();
-                            const QStringList authors = range.format.property(ScenarioBlockStyle::PropertyCommentsAuthors).toStringList();
-                            const QStringList dates = range.format.property(ScenarioBlockStyle::PropertyCommentsDates).toStringList();
-                            for (int commentIndex = 0; commentIndex < comments.size(); ++commentIndex) {
-                                currentBlockXml.append(QString("<%1").arg(NODE_REVIEW_COMMENT));
-                                currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_COMMENT,
-                                    TextEditHelper::toHtmlEscaped(comments.at(commentIndex))));
-                                currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_AUTHOR, authors.at(commentIndex)));
-                                currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_DATE, dates.at(commentIndex)));
-                                currentBlockXml.append("/>\n");
-                            }
-                            //
-                            currentBlockXml.append(QString("</%1>\n").arg(NODE_REVIEW));
-                        }
+                if (isReviewMark) {
+                    currentBlockXml.append(QString("<%1").arg(NODE_REVIEW));
+                    currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_FROM, QString::number(range.start)));
+                    currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_LENGTH, QString::number(range.length)));
+                    if (range.format.hasProperty(QTextFormat::ForegroundBrush)) {
+                        currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_COLOR, range.format.foreground().color().name()));
+                    }
+                    if (range.format.hasProperty(QTextFormat::BackgroundBrush)) {
+                        currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_BGCOLOR, range.format.background().color().name()));
                     }
-                    currentBlockXml.append(QString("</%1>\n").arg(NODE_REVIEW_GROUP));
+                    currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_IS_HIGHLIGHT,
+                        range.format.boolProperty(ScenarioBlockStyle::PropertyIsHighlight) ? "true" : "false"));
+                    currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_DONE,
+                        range.format.boolProperty(ScenarioBlockStyle::PropertyIsDone) ? "true" : "false"));
+                    currentBlockXml.append(">\n");
+                    //
+                    // ... комментарии
+                    //
+                    const QStringList comments = range.format.property(ScenarioBlockStyle::PropertyComments).toStringList();
+                    const QStringList authors = range.format.property(ScenarioBlockStyle::PropertyCommentsAuthors).toStringList();
+                    const QStringList dates = range.format.property(ScenarioBlockStyle::PropertyCommentsDates).toStringList();
+                    for (int commentIndex = 0; commentIndex < comments.size(); ++commentIndex) {
+                        currentBlockXml.append(QString("<%1").arg(NODE_REVIEW_COMMENT));
+                        currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_COMMENT,
+                            TextEditHelper::toHtmlEscaped(comments.at(commentIndex))));
+                        currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_AUTHOR, authors.at(commentIndex)));
+                        currentBlockXml.append(QString(" %1=\"%2\"").arg(ATTRIBUTE_REVIEW_DATE, dates.at(commentIndex)));
+                        currentBlockXml.append("/>\n");
+                    }
+                    //
+                    currentBlockXml.append(QString("</%1>\n").arg(NODE_REVIEW));
                 }
-
-                //
-                // Закрываем текущий элемент
-                //
-                currentBlockXml.append(QString("</%1>\n").arg(currentNode));
             }
-
-            m_xmlCache.insert(currentBlockHash, new QString(currentBlockXml));
-            resultXml.append(currentBlockXml);
+            currentBlockXml.append(QString("</%1>\n").arg(NODE_REVIEW_GROUP));
         }
-        currentBlock = currentBlock.next();
-    } while (currentBlock.isValid());
 
-    return makeMimeFromXml(resultXml);
+        //
+        // Закрываем текущий элемент
+        //
+        currentBlockXml.append(QString("</%1>\n").arg(currentNode));
+    }
+
+    return currentBlockXml;
 }
 
 QString ScenarioXml::scenarioToXml(int _startPosition, int _endPosition, bool _correctLastMime)
@@ -828,6 +753,11 @@ void ScenarioXml::xmlToScenarioV0(int _position, const QString& _xml)
     //
     ScenarioBlockStyle::Type lastTokenType = ScenarioBlockStyle::Undefined;
 
+    //
+    // Шаблон, стили которого применяются к загружаемым блокам
+    //
+    const QSharedPointer<const ScenarioTemplate> scenarioTemplate = ScenarioTemplateFacade::sharedTemplate();
+
     QXmlStreamReader reader(_xml);
     while (!reader.atEnd()) {
         //
@@ -848,7 +778,7 @@ void ScenarioXml::xmlToScenarioV0(int _position, const QString& _xml)
                 // Если определён тип блока, то обработать его
                 //
                 if (tokenType != ScenarioBlockStyle::Undefined) {
-                    ScenarioBlockStyle currentStyle = ScenarioTemplateFacade::getTemplate().blockStyle(tokenType);
+                    ScenarioBlockStyle currentStyle = scenarioTemplate->blockStyle(tokenType);
 
                     if (!firstBlockHandling) {
                         cursor.insertBlock();
@@ -858,7 +788,7 @@ void ScenarioXml::xmlToScenarioV0(int _position, const QString& _xml)
                     // Если нужно добавим заголовок стиля
                     //
                     if (currentStyle.hasHeader()) {
-                        ScenarioBlockStyle headerStyle = ScenarioTemplateFacade::getTemplate().blockStyle(currentStyle.headerType());
+                        ScenarioBlockStyle headerStyle = scenarioTemplate->blockStyle(currentStyle.headerType());
                         cursor.setBlockFormat(headerStyle.blockFormat());
                         cursor.setBlockCharFormat(headerStyle.charFormat());
                         cursor.setCharFormat(headerStyle.charFormat());
@@ -916,7 +846,7 @@ void ScenarioXml::xmlToScenarioV0(int _position, const QString& _xml)
                     //
                     // Если необходимо так же вставляем префикс и постфикс стиля
                     //
-                    ScenarioBlockStyle currentStyle = ScenarioTemplateFacade::getTemplate().blockStyle(lastTokenType);
+                    ScenarioBlockStyle currentStyle = scenarioTemplate->blockStyle(lastTokenType);
                     if (!currentStyle.prefix().isEmpty()
                         && !textToInsert.startsWith(currentStyle.prefix())) {
                         textToInsert.prepend(currentStyle.prefix());
@@ -976,6 +906,11 @@ void ScenarioXml::xmlToScenarioV1(int _position, const QString& _xml)
     //
     ScenarioBlockStyle::Type lastTokenType = ScenarioBlockStyle::Undefined;
 
+    //
+    // Шаблон, стили которого применяются к загружаемым блокам
+    //
+    const QSharedPointer<const ScenarioTemplate> scenarioTemplate = ScenarioTemplateFacade::sharedTemplate();
+
     QXmlStreamReader reader(_xml);
     while (!reader.atEnd()) {
         //
@@ -996,7 +931,7 @@ void ScenarioXml::xmlToScenarioV1(int _position, const QString& _xml)
                 // Если определён тип блока, то обработать его
                 //
                 if (tokenType != ScenarioBlockStyle::Undefined) {
-                    ScenarioBlockStyle currentStyle = ScenarioTemplateFacade::getTemplate().blockStyle(tokenType);
+                    ScenarioBlockStyle currentStyle = scenarioTemplate->blockStyle(tokenType);
 
                     if (firstBlockHandling) {
                         cursor.block().setVisible(true);
@@ -1130,7 +1065,7 @@ void ScenarioXml::xmlToScenarioV1(int _position, const QString& _xml)
                     //
                     // Если необходимо так же вставляем префикс и постфикс стиля
                     //
-                    ScenarioBlockStyle currentStyle = ScenarioTemplateFacade::getTemplate().blockStyle(lastTokenType);
+                    ScenarioBlockStyle currentStyle = scenarioTemplate->blockStyle(lastTokenType);
                     if (!currentStyle.prefix().isEmpty()
                         && !textToInsert.startsWith(currentStyle.prefix())) {
                         textToInsert.prepend(currentStyle.prefix());
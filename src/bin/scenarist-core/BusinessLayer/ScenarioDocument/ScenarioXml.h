@@ -1,7 +1,6 @@
 #ifndef SCENARIOXML_H
 #define SCENARIOXML_H
 
-#include <QCache>
 #include <QString>
 #include <QTextBlock>
 
@@ -42,10 +41,11 @@ namespace BusinessLogic
 		ScenarioXml(ScenarioDocument* _scenario);
 
 		/**
-		 * @brief Сохранить весь сценарий в xml-строку, не корректируются значения последнего
-		 *		  сохранённого майм выделения
+		 * @brief Сформировать xml-описание отдельного блока текста
+		 * @note Xml всего сценария собирается из xml блоков в ScenarioTextDocument, который
+		 *		 отслеживает изменённые блоки и хранит xml каждого из них
 		 */
-		QString scenarioToXml();
+		QString blockToXml(const QTextBlock& _block);
 
 		/**
 		 * @brief Записать сценарий в xml-строку из заданного диапазона текста
@@ -100,12 +100,6 @@ namespace BusinessLogic
 		int m_lastMimeFrom;
 		int m_lastMimeTo;
 		/** @} */
-
-		/**
-		 * @brief Закешированное xml-содержимое блоков
-		 * @note Используется, для ускорения формирования xml всего сценария
-		 */
-		QCache<uint, QString> m_xmlCache;
 	};
 }
 
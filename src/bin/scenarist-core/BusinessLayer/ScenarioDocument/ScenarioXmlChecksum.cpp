@@ -0,0 +1,236 @@
+#include "ScenarioXmlChecksum.h"
+
+using BusinessLogic::ScenarioXmlChecksum;
+
+namespace {
+    /**
+     * @brief Основание полиномиальной суммы
+     */
+    const quint64 CHECKSUM_BASE = 0x100000001B3ULL * 2 + 1;
+
+    /**
+     * @brief Параметры хэша FNV-1a для сумм блоков
+     */
+    /** @{ */
+    const quint64 FNV_OFFSET_BASIS = 0xCBF29CE484222325ULL;
+    const quint64 FNV_PRIME = 0x100000001B3ULL;
+    /** @} */
+}
+
+
+/**
+ * @brief Узел дерева контрольных сумм
+ */
+class ScenarioXmlChecksum::Node
+{
+public:
+    Node(quint64 _checksum, quint32 _priority) :
+        checksum(_checksum), priority(_priority), size(1), value(_checksum), power(CHECKSUM_BASE),
+        left(nullptr), right(nullptr)
+    {}
+
+    /**
+     * @brief Пересчитать данные поддерева по данным потомков
+     */
+    void update() {
+        const int rightSize = right != nullptr ? right->size : 0;
+        const quint64 rightValue = right != nullptr ? right->value : 0;
+        const quint64 rightPower = right != nullptr ? right->power : 1;
+
+        size = 1 + rightSize;
+        value = checksum * rightPower + rightValue;
+        power = CHECKSUM_BASE * rightPower;
+        if (left != nullptr) {
+            size += left->size;
+            value += left->value * power;
+            power *= left->power;
+        }
+    }
+
+    /**
+     * @brief Контрольная сумма блока
+     */
+    quint64 checksum;
+
+    /**
+     * @brief Приоритет узла для балансировки
+     */
+    quint32 priority;
+
+    /**
+     * @brief Количество блоков в поддереве
+     */
+    int size;
+
+    /**
+     * @brief Полиномиальная сумма поддерева
+     */
+    quint64 value;
+
+    /**
+     * @brief Основание в степени количества блоков поддерева
+     */
+    quint64 power;
+
+    /**
+     * @brief Потомки
+     */
+    /** @{ */
+    Node* left;
+    Node* right;
+    /** @} */
+};
+
+
+quint64 ScenarioXmlChecksum::blockChecksum(const QString& _blockXml)
+{
+    quint64 checksum = FNV_OFFSET_BASIS;
+    const ushort* data = _blockXml.utf16();
+    for (int index = 0; index < _blockXml.length(); ++index) {
+        checksum ^= data[index];
+        checksum *= FNV_PRIME;
+    }
+    return checksum;
+}
+
+ScenarioXmlChecksum::ScenarioXmlChecksum() :
+    m_root(nullptr),
+    m_priorityState(2463534242U)
+{
+}
+
+ScenarioXmlChecksum::~ScenarioXmlChecksum()
+{
+    clear();
+}
+
+int ScenarioXmlChecksum::size() const
+{
+    return m_root != nullptr ? m_root->size : 0;
+}
+
+quint64 ScenarioXmlChecksum::value() const
+{
+    return m_root != nullptr ? m_root->value : 0;
+}
+
+void ScenarioXmlChecksum::clear()
+{
+    deleteTree(m_root);
+    m_root = nullptr;
+}
+
+void ScenarioXmlChecksum::insert(int _index, int _count, quint64 _checksum)
+{
+    if (_count <= 0) {
+        return;
+    }
+
+    Node* inserted = nullptr;
+    for (int index = 0; index < _count; ++index) {
+        inserted = merge(inserted, new Node(_checksum, nextPriority()));
+    }
+
+    Node* left = nullptr;
+    Node* right = nullptr;
+    split(m_root, _index, left, right);
+    m_root = merge(merge(left, inserted), right);
+}
+
+void ScenarioXmlChecksum::remove(int _index, int _count)
+{
+    if (_count <= 0) {
+        return;
+    }
+
+    Node* left = nullptr;
+    Node* middle = nullptr;
+    Node* right = nullptr;
+    split(m_root, _index, left, middle);
+    split(middle, _count, middle, right);
+    deleteTree(middle);
+    m_root = merge(left, right);
+}
+
+void ScenarioXmlChecksum::update(int _index, quint64 _checksum)
+{
+    if (_index >= 0 && _index < size()) {
+        update(m_root, _index, _checksum);
+    }
+}
+
+void ScenarioXmlChecksum::update(Node* _node, int _index, quint64 _checksum)
+{
+    const int leftSize = _node->left != nullptr ? _node->left->size : 0;
+    if (_index < leftSize) {
+        update(_node->left, _index, _checksum);
+    } else if (_index == leftSize) {
+        _node->checksum = _checksum;
+    } else {
+        update(_node->right, _index - leftSize - 1, _checksum);
+    }
+
+    //
+    // Пересчитываем суммы на обратном пути к корню
+    //
+    _node->update();
+}
+
+void ScenarioXmlChecksum::split(Node* _node, int _count, Node*& _left, Node*& _right)
+{
+    if (_node == nullptr) {
+        _left = nullptr;
+        _right = nullptr;
+        return;
+    }
+
+    const int leftSize = _node->left != nullptr ? _node->left->size : 0;
+    if (_count <= leftSize) {
+        split(_node->left, _count, _left, _node->left);
+        _right = _node;
+    } else {
+        split(_node->right, _count - leftSize - 1, _node->right, _right);
+        _left = _node;
+    }
+    _node->update();
+}
+
+ScenarioXmlChecksum::Node* ScenarioXmlChecksum::merge(Node* _left, Node* _right)
+{
+    if (_left == nullptr) {
+        return _right;
+    }
+    if (_right == nullptr) {
+        return _left;
+    }
+
+    if (_left->priority > _right->priority) {
+        _left->right = merge(_left->right, _right);
+        _left->update();
+        return _left;
+    } else {
+        _right->left = merge(_left, _right->left);
+        _right->update();
+        return _right;
+    }
+}
+
+void ScenarioXmlChecksum::deleteTree(Node* _node)
+{
+    if (_node != nullptr) {
+        deleteTree(_node->left);
+        deleteTree(_node->right);
+        delete _node;
+    }
+}
+
+quint32 ScenarioXmlChecksum::nextPriority()
+{
+    //
+    // Генератор xorshift32
+    //
+    m_priorityState ^= m_priorityState << 13;
+    m_priorityState ^= m_priorityState >> 17;
+    m_priorityState ^= m_priorityState << 5;
+    return m_priorityState;
+}
@@ -0,0 +1,105 @@
+#ifndef SCENARIOXMLCHECKSUM_H
+#define SCENARIOXMLCHECKSUM_H
+
+#include <QString>
+
+
+namespace BusinessLogic
+{
+    /**
+     * @brief Контрольная сумма xml сценария, составленная из контрольных сумм его блоков
+     *
+     * Суммы блоков хранятся в сбалансированном дереве (декартово дерево по неявному ключу),
+     * каждый узел которого хранит полиномиальную сумму своего поддерева. Поэтому вставка,
+     * удаление и изменение блока обходятся в O(log n), а сумма всего сценария доступна сразу.
+     */
+    class ScenarioXmlChecksum
+    {
+    public:
+        /**
+         * @brief Рассчитать контрольную сумму xml отдельного блока
+         */
+        static quint64 blockChecksum(const QString& _blockXml);
+
+    public:
+        ScenarioXmlChecksum();
+        ~ScenarioXmlChecksum();
+
+        /**
+         * @brief Количество блоков
+         */
+        int size() const;
+
+        /**
+         * @brief Контрольная сумма всей последовательности блоков
+         */
+        quint64 value() const;
+
+        /**
+         * @brief Очистить
+         */
+        void clear();
+
+        /**
+         * @brief Вставить заданное количество блоков с одинаковой суммой перед блоком с индексом _index
+         */
+        void insert(int _index, int _count, quint64 _checksum);
+
+        /**
+         * @brief Удалить заданное количество блоков начиная с индекса _index
+         */
+        void remove(int _index, int _count);
+
+        /**
+         * @brief Обновить контрольную сумму блока
+         */
+        void update(int _index, quint64 _checksum);
+
+    private:
+        /**
+         * @brief Узел дерева
+         */
+        class Node;
+
+        /**
+         * @brief Обновить контрольную сумму блока в поддереве
+         */
+        void update(Node* _node, int _index, quint64 _checksum);
+
+        /**
+         * @brief Разделить дерево на первые _count блоков и остальные
+         */
+        void split(Node* _node, int _count, Node*& _left, Node*& _right);
+
+        /**
+         * @brief Объединить два дерева, все блоки _left идут перед блоками _right
+         */
+        Node* merge(Node* _left, Node* _right);
+
+        /**
+         * @brief Удалить поддерево
+         */
+        void deleteTree(Node* _node);
+
+        /**
+         * @brief Получить следующий приоритет узла
+         */
+        quint32 nextPriority();
+
+    private:
+        /**
+         * @brief Корень дерева
+         */
+        Node* m_root;
+
+        /**
+         * @brief Состояние генератора приоритетов узлов
+         */
+        quint32 m_priorityState;
+
+    private:
+        Q_DISABLE_COPY(ScenarioXmlChecksum)
+    };
+}
+
+#endif // SCENARIOXMLCHECKSUM_H
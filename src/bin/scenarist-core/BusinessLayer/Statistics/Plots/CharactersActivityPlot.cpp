@@ -24,8 +24,8 @@ namespace {
 	/**
 	 * @brief Стиль документа
 	 */
-	static ScenarioTemplate editorStyle() {
-		return ScenarioTemplateFacade::getTemplate();
+	static QSharedPointer<const ScenarioTemplate> editorStyle() {
+		return ScenarioTemplateFacade::sharedTemplate();
 	}
 
 	/**
@@ -54,8 +54,8 @@ Plot CharactersActivityPlot::makePlot(QTextDocument* _scenario, const BusinessLo
 {
 	PageTextEdit edit;
 	edit.setUsePageMode(true);
-	edit.setPageFormat(::editorStyle().pageSizeId());
-	edit.setPageMargins(::editorStyle().pageMargins());
+	edit.setPageFormat(::editorStyle()->pageSizeId());
+	edit.setPageMargins(::editorStyle()->pageMargins());
 	edit.setDocument(_scenario->clone());
 
 	//
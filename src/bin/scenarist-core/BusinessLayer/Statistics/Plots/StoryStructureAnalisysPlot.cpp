@@ -24,8 +24,8 @@ namespace {
 	/**
 	 * @brief Стиль документа
 	 */
-	static ScenarioTemplate editorStyle() {
-		return ScenarioTemplateFacade::getTemplate();
+	static QSharedPointer<const ScenarioTemplate> editorStyle() {
+		return ScenarioTemplateFacade::sharedTemplate();
 	}
 
 	/**
@@ -61,8 +61,8 @@ Plot StoryStructureAnalisysPlot::makePlot(QTextDocument* _scenario, const Busine
 {
 	PageTextEdit edit;
 	edit.setUsePageMode(true);
-	edit.setPageFormat(::editorStyle().pageSizeId());
-	edit.setPageMargins(::editorStyle().pageMargins());
+	edit.setPageFormat(::editorStyle()->pageSizeId());
+	edit.setPageMargins(::editorStyle()->pageMargins());
 	edit.setDocument(_scenario->clone());
 
 	//
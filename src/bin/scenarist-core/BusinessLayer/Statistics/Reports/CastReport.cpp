@@ -19,8 +19,8 @@ namespace {
 	/**
 	 * @brief Стиль документа
 	 */
-	static ScenarioTemplate editorStyle() {
-		return ScenarioTemplateFacade::getTemplate();
+	static QSharedPointer<const ScenarioTemplate> editorStyle() {
+		return ScenarioTemplateFacade::sharedTemplate();
 	}
 }
 
@@ -24,8 +24,8 @@ namespace {
 	/**
 	 * @brief Стиль документа
 	 */
-	static ScenarioTemplate editorStyle() {
-		return ScenarioTemplateFacade::getTemplate();
+	static QSharedPointer<const ScenarioTemplate> editorStyle() {
+		return ScenarioTemplateFacade::sharedTemplate();
 	}
 }
 
@@ -40,8 +40,8 @@ QString SceneReport::makeReport(QTextDocument* _scenario,
 {
 	PageTextEdit edit;
 	edit.setUsePageMode(true);
-	edit.setPageFormat(::editorStyle().pageSizeId());
-	edit.setPageMargins(::editorStyle().pageMargins());
+	edit.setPageFormat(::editorStyle()->pageSizeId());
+	edit.setPageMargins(::editorStyle()->pageMargins());
 	edit.setDocument(_scenario->clone());
 
 	//
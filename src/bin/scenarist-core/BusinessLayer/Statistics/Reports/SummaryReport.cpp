@@ -23,8 +23,8 @@ namespace {
 	/**
 	 * @brief Стиль документа
 	 */
-	static ScenarioTemplate editorStyle() {
-		return ScenarioTemplateFacade::getTemplate();
+	static QSharedPointer<const ScenarioTemplate> editorStyle() {
+		return ScenarioTemplateFacade::sharedTemplate();
 	}
 
 	/**
@@ -132,8 +132,8 @@ QString SummaryReport::makeReport(QTextDocument* _scenario, const BusinessLogic:
 		//
 		PageTextEdit edit;
 		edit.setUsePageMode(true);
-		edit.setPageFormat(::editorStyle().pageSizeId());
-		edit.setPageMargins(::editorStyle().pageMargins());
+		edit.setPageFormat(::editorStyle()->pageSizeId());
+		edit.setPageMargins(::editorStyle()->pageMargins());
 		edit.setDocument(_scenario->clone());
 
 		const qreal chron = ChronometerFacade::calculate(_scenario);
@@ -4,6 +4,7 @@
 
 #include <DataLayer/Database/Database.h>
 #include <DataLayer/Database/DatabaseHelper.h>
+#include <DataLayer/Database/DatabaseWriter.h>
 
 #include <3rd_party/Helpers/QVariantMapWriter.h>
 
@@ -20,7 +21,8 @@ using namespace DataMappingLayer;
 using namespace DatabaseLayer;
 
 
-AbstractMapper::AbstractMapper()
+AbstractMapper::AbstractMapper() :
+	m_maxLoadedId(0)
 {
 }
 
@@ -31,6 +33,7 @@ void AbstractMapper::clear()
 		domainObject = 0;
 	}
 	m_loadedObjectsMap.clear();
+	m_maxLoadedId = Identifier(0);
 }
 
 void AbstractMapper::refresh(DomainObjectsItemModel* _model)
@@ -79,7 +82,7 @@ void AbstractMapper::refresh(DomainObjectsItemModel* _model)
 			//
 			// ... из карты загруженных объектов
 			//
-			m_loadedObjectsMap.remove(domainObject->id());
+			removeLoadedObject(domainObject->id());
 			//
 			// ... сам объект
 			//
@@ -113,6 +116,147 @@ DomainObjectsItemModel* AbstractMapper::abstractFindAll(const QString& _filter)
 }
 
 void AbstractMapper::abstractInsert(DomainObject* _subject)
+{
+	QList<QVariantList> history;
+	insertObject(_subject, history);
+	storeHistory(history);
+}
+
+void AbstractMapper::abstractUpdate(DomainObject* _subject)
+{
+	QList<QVariantList> history;
+	updateObject(_subject, history);
+	storeHistory(history);
+}
+
+void AbstractMapper::abstractDelete(DomainObject* _subject)
+{
+	//
+	// Получим данные для формирования запроса на их удаление
+	//
+	QVariantList deleteValues;
+	QString deleteQuery = deleteStatement(_subject, deleteValues);
+
+	//
+	// Сформируем запрос на удаление данных из базы
+	//
+	QSqlQuery q_delete = preparedQuery(deleteQuery, deleteValues);
+
+	//
+	// Удалим данные из базы
+	//
+	QList<QVariantList> history;
+	if (executeSql(q_delete, history)) {
+		storeHistory(history);
+
+		//
+		// Удалим объекст из списка загруженных
+		//
+		removeLoadedObject(_subject->id());
+		delete _subject;
+		_subject = 0;
+	}
+}
+
+void AbstractMapper::abstractInsertBatch(const QList<DomainObject*>& _subjects)
+{
+	if (_subjects.isEmpty()) {
+		return;
+	}
+
+	QList<QVariantList> history;
+	Database::transaction();
+	foreach (DomainObject* subject, _subjects) {
+		insertObject(subject, history);
+	}
+	storeHistory(history);
+	Database::commit();
+}
+
+void AbstractMapper::abstractUpdateBatch(const QList<DomainObject*>& _subjects)
+{
+	if (_subjects.isEmpty()) {
+		return;
+	}
+
+	QList<QVariantList> history;
+	Database::transaction();
+	foreach (DomainObject* subject, _subjects) {
+		updateObject(subject, history);
+	}
+	storeHistory(history);
+	Database::commit();
+}
+
+DomainObject* AbstractMapper::loadObjectFromDatabase(const Identifier& _id)
+{
+	QSqlQuery query = Database::query();
+	query.prepare( findStatement( _id ) );
+	query.exec();
+	query.next();
+	QSqlRecord record = query.record();
+	DomainObject* result = load( record );
+	return result;
+}
+
+Identifier AbstractMapper::findNextIdentifier()
+{
+	return m_maxLoadedId.next();
+}
+
+DomainObject* AbstractMapper::load(const QSqlRecord& _record )
+{
+	DomainObject* result = 0;
+
+	const int idValue = _record.value("id").toInt();
+	if (idValue != 0) {
+		Identifier id(idValue);
+		//
+		// Если объект загружен, обновляем его и используем указатель на него
+		//
+		result = m_loadedObjectsMap.value(id, 0);
+		if (result != 0) {
+			doLoad(result, _record);
+		}
+		//
+		// В противном случае создаём новый объект и сохраняем указатель на него
+		//
+		else {
+			result = doLoad(id, _record);
+			addLoadedObject(result);
+		}
+	}
+
+	return result;
+}
+
+void AbstractMapper::addLoadedObject(DomainObject* _object)
+{
+	m_loadedObjectsMap.insert(_object->id(), _object);
+	if (_object->id() > m_maxLoadedId) {
+		m_maxLoadedId = _object->id();
+	}
+}
+
+void AbstractMapper::removeLoadedObject(const Identifier& _id)
+{
+	m_loadedObjectsMap.remove(_id);
+
+	//
+	// Если удалён объект с наибольшим идентификатором, то ищем новый наибольший,
+	// чтобы идентификаторы выдавались так же, как и раньше
+	//
+	if (_id == m_maxLoadedId) {
+		m_maxLoadedId = Identifier(0);
+		foreach (const Identifier& id, m_loadedObjectsMap.keys()) {
+			if (id > m_maxLoadedId) {
+				m_maxLoadedId = id;
+			}
+		}
+	}
+}
+
+void AbstractMapper::insertObject(DomainObject* _subject, QList<QVariantList>& _history)
 {
 	//
 	// Установим идентификатор для нового объекта
@@ -122,7 +266,7 @@ void AbstractMapper::abstractInsert(DomainObject* _subject)
 	//
 	// Добавим вновь созданный объект в список загруженных объектов
 	//
-	m_loadedObjectsMap.insert(_subject->id(), _subject);
+	addLoadedObject(_subject);
 
 	//
 	// Получим данные для формирования запроса на их добавление
@@ -133,19 +277,15 @@ void AbstractMapper::abstractInsert(DomainObject* _subject)
 	//
 	// Сформируем запрос на добавление данных в базу
 	//
-	QSqlQuery q_insert = Database::query();
-	q_insert.prepare(insertQuery);
-	foreach (const QVariant& value, insertValues) {
-		q_insert.addBindValue(value);
-	}
+	QSqlQuery q_insert = preparedQuery(insertQuery, insertValues);
 
 	//
 	// Добавим данные в базу
 	//
-	executeSql(q_insert);
+	executeSql(q_insert, _history);
 }
 
-void AbstractMapper::abstractUpdate(DomainObject* _subject)
+void AbstractMapper::updateObject(DomainObject* _subject, QList<QVariantList>& _history)
 {
 	//
 	// Если есть не сохранённые изменения
@@ -165,160 +305,170 @@ void AbstractMapper::abstractUpdate(DomainObject* _subject)
 		//
 		// Сформируем запрос на обновление данных в базе
 		//
-		QSqlQuery q_update = Database::query();
-		q_update.prepare(updateQuery);
-		foreach (const QVariant& value, updateValues) {
-			q_update.addBindValue(value);
-		}
+		QSqlQuery q_update = preparedQuery(updateQuery, updateValues);
 
 		//
 		// Обновим данные в базе
 		//
-		if (executeSql(q_update)) {
+		if (executeSql(q_update, _history)) {
+			DatabaseWriter* writer = DatabaseWriter::instance();
+			//
+			// Если запрос попал в снимок, то изменения будут сохранены только после его записи в файл,
+			// а если объект к этому моменту изменится снова, то он останется несохранённым
+			//
+			if (writer->isSnapshotStarted()) {
+				const Identifier id = _subject->id();
+				const int changesVersion = _subject->changesVersion();
+				writer->appendWrittenAction([this, id, changesVersion] {
+					DomainObject* subject = m_loadedObjectsMap.value(id, 0);
+					if (subject != 0) {
+						subject->changesStored(changesVersion);
+					}
+				});
+			}
 			//
-			// Изменения сохранены
+			// В противном случае изменения уже сохранены
 			//
-			_subject->changesStored();
+			else {
+				_subject->changesStored();
+			}
 		}
 	}
 }
 
-void AbstractMapper::abstractDelete(DomainObject* _subject)
+QSqlQuery AbstractMapper::preparedQuery(const QString& _statement, const QVariantList& _values) const
 {
 	//
-	// Получим данные для формирования запроса на их удаление
+	// Запросы одного вида отличаются только параметрами, поэтому не подготавливаем их каждый раз заново
 	//
-	QVariantList deleteValues;
-	QString deleteQuery = deleteStatement(_subject, deleteValues);
+	QSqlQuery query = Database::preparedQuery(_statement);
+	for (int index = 0; index < _values.size(); ++index) {
+		query.bindValue(index, _values.at(index));
+	}
+	return query;
+}
+
+bool AbstractMapper::executeSql(QSqlQuery& _sqlQuery, QList<QVariantList>& _history)
+{
+	DatabaseWriter* writer = DatabaseWriter::instance();
 
 	//
-	// Сформируем запрос на удаление данных из базы
+	// Если формируется снимок изменений, то запрос будет выполнен в потоке записи
 	//
-	QSqlQuery q_delete = Database::query();
-	q_delete.prepare(deleteQuery);
-	foreach (const QVariant& value, deleteValues) {
-		q_delete.addBindValue(value);
+	if (writer->isSnapshotStarted()) {
+		QVariantList values;
+		for (int index = 0; index < _sqlQuery.boundValues().size(); ++index) {
+			values.append(_sqlQuery.boundValue(index));
+		}
+		writer->append(_sqlQuery.lastQuery(), values);
 	}
-
 	//
-	// Удалим данные из базы
+	// Если запись ранее сформированных снимков приостановлена из-за ошибки, то запрос не выполняем,
+	// иначе он опередит их, а при повторной записи они затрут его изменения
+	//
+	else if (!writer->waitForFinished()) {
+		Database::setLastError(writer->lastError());
+		return false;
+	}
+	//
+	// В противном случае выполняем его сразу, уже после записи ранее сформированных снимков,
+	// чтобы изменения попали в базу данных в исходном порядке
 	//
-	if (executeSql(q_delete)) {
+	else {
 		//
-		// Удалим объекст из списка загруженных
+		// Если запрос завершился с ошибкой, выводим отладочную информацию
 		//
-		m_loadedObjectsMap.remove(_subject->id());
-		delete _subject;
-		_subject = 0;
-	}
-}
+		if (!_sqlQuery.exec()) {
+			Database::setLastError(_sqlQuery.lastError().text());
 
-DomainObject* AbstractMapper::loadObjectFromDatabase(const Identifier& _id)
-{
-	QSqlQuery query = Database::query();
-	query.prepare( findStatement( _id ) );
-	query.exec();
-	query.next();
-	QSqlRecord record = query.record();
-	DomainObject* result = load( record );
-	return result;
-}
+			qDebug() << _sqlQuery.lastError();
+			qDebug() << _sqlQuery.lastQuery();
+			qDebug() << _sqlQuery.boundValues();
 
-Identifier AbstractMapper::findNextIdentifier()
-{
-	Identifier maxId(0);
-	if (!m_loadedObjectsMap.isEmpty()) {
-		QMap<Identifier, DomainObject*>::const_iterator iter = m_loadedObjectsMap.end();
-		--iter;
-		maxId = iter.key();
+			return false;
+		}
 	}
-	return maxId.next();
-}
 
-DomainObject* AbstractMapper::load(const QSqlRecord& _record )
-{
-	DomainObject* result = 0;
+	//
+	// Если всё завершилось успешно запоминаем запрос и данные для таблицы истории запросов
+	//
+	Database::setLastError(QString::null);
 
-	const int idValue = _record.value("id").toInt();
-	if (idValue != 0) {
-		Identifier id(idValue);
+	//
+	// NOTE: Оптимизация размера файла проекта
+	// Сохраняем всё, кроме изменений сценария и текста самого сценария
+	//
+	if (!_sqlQuery.lastQuery().contains(" scenario_changes ")
+		&& !_sqlQuery.lastQuery().contains(" scenario ")) {
+		QVariantList historyRecord;
 		//
-		// Если объект загружен, обновляем его и используем указатель на него
+		// ... uuid
 		//
-		if (m_loadedObjectsMap.contains(id)) {
-			doLoad(m_loadedObjectsMap.value(id), _record);
-			result = m_loadedObjectsMap.value(id);
-		}
+		historyRecord.append(QUuid::createUuid().toString());
 		//
-		// В противном случае создаём новый объект и сохраняем указатель на него
+		// ... запрос
 		//
-		else {
-			result = doLoad(id, _record);
-			m_loadedObjectsMap.insert(id, result);
-		}
+		historyRecord.append(_sqlQuery.lastQuery());
+		//
+		// ... данные в сжатом виде
+		//
+		QString valueString = QVariantMapWriter::mapToDataString(_sqlQuery.boundValues());
+		valueString = DatabaseHelper::compress(valueString);
+		historyRecord.append(valueString);
+
+		_history.append(historyRecord);
 	}
 
-	return result;
+	return true;
 }
 
-bool AbstractMapper::executeSql(QSqlQuery& _sqlQuery)
+void AbstractMapper::storeHistory(const QList<QVariantList>& _history)
 {
+	if (_history.isEmpty()) {
+		return;
+	}
+
 	//
-	// Если запрос завершился с ошибкой, выводим отладочную информацию
+	// Имя пользователя и время выполнения общие для всех записей пакета
 	//
-	if (!_sqlQuery.exec()) {
-		Database::setLastError(_sqlQuery.lastError().text());
-
-		qDebug() << _sqlQuery.lastError();
-		qDebug() << _sqlQuery.lastQuery();
-		qDebug() << _sqlQuery.boundValues();
+	const QString username = DataStorageLayer::StorageFacade::username();
+	const QString datetime = QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss");
 
-		return false;
-	}
 	//
-	// Если всё завершилось успешно сохраняем запрос и данные в таблицу истории запросов
+	// Сохраняем записи многострочными вставками, ограничивая количество строк в одном запросе,
+	// чтобы не превысить допустимое в SQLite количество параметров
 	//
-	else {
-		Database::setLastError(QString::null);
-
-		//
-		// NOTE: Оптимизация размера файла проекта
-		// Сохраняем всё, кроме изменений сценария и текста самого сценария
-		//
-		if (!_sqlQuery.lastQuery().contains(" scenario_changes ")
-			&& !_sqlQuery.lastQuery().contains(" scenario ")) {
+	const int MAX_ROWS_IN_QUERY = 100;
+	for (int rowIndex = 0; rowIndex < _history.size(); rowIndex += MAX_ROWS_IN_QUERY) {
+		const int rowsCount = qMin(MAX_ROWS_IN_QUERY, _history.size() - rowIndex);
+
+		QString statement =
+				"INSERT INTO _database_history (id, query, query_values, username, datetime) VALUES ";
+		for (int row = 0; row < rowsCount; ++row) {
+			statement.append(row == 0 ? "(?, ?, ?, ?, ?)" : ", (?, ?, ?, ?, ?)");
+		}
 
-			QSqlQuery q_history(_sqlQuery);
-            q_history.prepare("INSERT INTO _database_history (id, query, query_values, username, datetime) VALUES(?, ?, ?, ?, ?);");
-			//
-			// ... uuid
+		QVariantList values;
+		for (int row = rowIndex; row < rowIndex + rowsCount; ++row) {
+			values.append(_history.at(row));
 			//
-			q_history.addBindValue(QUuid::createUuid().toString());
+			// ... имя пользователя
 			//
-			// ... запрос
-			//
-			q_history.addBindValue(_sqlQuery.lastQuery());
-			//
-			// ... данные в сжатом виде
-			//
-			QString valueString = QVariantMapWriter::mapToDataString(_sqlQuery.boundValues());
-			valueString = DatabaseHelper::compress(valueString);
-			q_history.addBindValue(valueString);
-            //
-            // ... имя пользовтаеля
-            //
-            q_history.addBindValue(DataStorageLayer::StorageFacade::username());
+			values.append(username);
 			//
 			// ... время выполнения
 			//
-			q_history.addBindValue(QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss"));
+			values.append(datetime);
+		}
 
-			//
-			// Сохраняем данные
-			//
+		//
+		// Сохраняем данные
+		//
+		if (DatabaseWriter::instance()->isSnapshotStarted()) {
+			DatabaseWriter::instance()->append(statement, values);
+		} else {
+			QSqlQuery q_history = preparedQuery(statement, values);
 			q_history.exec();
 		}
 	}
-
-	return true;
 }
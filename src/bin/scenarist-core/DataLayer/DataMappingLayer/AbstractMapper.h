@@ -3,7 +3,7 @@
 
 #include <Domain/DomainObject.h>
 
-#include <QMap>
+#include <QHash>
 #include <QSqlRecord>
 
 class QSqlQuery;
@@ -57,6 +57,14 @@ namespace DataMappingLayer
 		void abstractUpdate(DomainObject* _subject);
 		void abstractDelete(DomainObject* _subject);
 
+		/**
+		 * @brief Сохранить пакет объектов в одной транзакции
+		 */
+		/** @{ */
+		void abstractInsertBatch(const QList<DomainObject*>& _subjects);
+		void abstractUpdateBatch(const QList<DomainObject*>& _subjects);
+		/** @} */
+
 	protected:
 		AbstractMapper();
 
@@ -76,16 +84,53 @@ namespace DataMappingLayer
 		 */
 		DomainObject* load(const QSqlRecord& _record);
 
+		/**
+		 * @brief Добавить объект в список загруженных
+		 */
+		void addLoadedObject(DomainObject* _object);
+
+		/**
+		 * @brief Удалить объект из списка загруженных
+		 */
+		void removeLoadedObject(const Identifier& _id);
+
+		/**
+		 * @brief Добавить объект в БД
+		 */
+		void insertObject(DomainObject* _subject, QList<QVariantList>& _history);
+
+		/**
+		 * @brief Обновить объект в БД
+		 */
+		void updateObject(DomainObject* _subject, QList<QVariantList>& _history);
+
+		/**
+		 * @brief Получить подготовленный запрос с установленными параметрами
+		 */
+		QSqlQuery preparedQuery(const QString& _statement, const QVariantList& _values) const;
+
 		/**
 		 * @brief Выполнить запрос
+		 * @param _history - список записей истории, в который добавляется выполненный запрос
 		 */
-		bool executeSql(QSqlQuery& _sqlQuery);
+		bool executeSql(QSqlQuery& _sqlQuery, QList<QVariantList>& _history);
+
+		/**
+		 * @brief Сохранить записи в историю запросов
+		 */
+		void storeHistory(const QList<QVariantList>& _history);
 
 	private:
 		/**
 		 * @brief Загруженные объекты из базы данных
 		 */
-		QMap<Identifier, DomainObject*> m_loadedObjectsMap;
+		QHash<Identifier, DomainObject*> m_loadedObjectsMap;
+
+		/**
+		 * @brief Наибольший идентификатор загруженных объектов
+		 * @note Используется для получения идентификатора нового объекта без перебора загруженных
+		 */
+		Identifier m_maxLoadedId;
 	};
 
 }
@@ -28,6 +28,15 @@ void CharacterMapper::insert(Character* _character)
 	abstractInsert(_character);
 }
 
+void CharacterMapper::insert(const QList<Character*>& _characters)
+{
+	QList<DomainObject*> subjects;
+	foreach (Character* character, _characters) {
+		subjects.append(character);
+	}
+	abstractInsertBatch(subjects);
+}
+
 void CharacterMapper::update(Character* _character)
 {
 	abstractUpdate(_character);
@@ -20,6 +20,7 @@ namespace DataMappingLayer
 		Character* find(const Identifier& _id);
 		CharactersTable* findAll();
 		void insert(Character* _character);
+		void insert(const QList<Character*>& _characters);
 		void update(Character* _character);
 		void remove(Character* _character);
 
@@ -3,8 +3,6 @@
 #include <Domain/Character.h>
 #include <Domain/CharacterPhoto.h>
 
-#include <3rd_party/Helpers/ImageHelper.h>
-
 #include <QBuffer>
 
 using namespace DataMappingLayer;
@@ -78,7 +76,7 @@ QString CharacterPhotoMapper::insertStatement(DomainObject* _subject, QVariantLi
 	_insertValues.clear();
 	_insertValues.append(photo->id().value());
 	_insertValues.append(photo->character()->id().value());
-	_insertValues.append(ImageHelper::bytesFromImage(photo->photo()));
+	_insertValues.append(photo->photoData());
 	_insertValues.append(photo->sortOrder());
 
 	return insertStatement;
@@ -97,7 +95,7 @@ QString CharacterPhotoMapper::updateStatement(DomainObject* _subject, QVariantLi
 	CharacterPhoto* photo = dynamic_cast<CharacterPhoto*>(_subject);
 	_updateValues.clear();
 	_updateValues.append(photo->character()->id().value());
-	_updateValues.append(ImageHelper::bytesFromImage(photo->photo()));
+	_updateValues.append(photo->photoData());
 	_updateValues.append(photo->sortOrder());
 	_updateValues.append(photo->id().value());
 
@@ -121,7 +119,7 @@ DomainObject* CharacterPhotoMapper::doLoad(const Identifier& _id, const QSqlReco
 	// связывание фотографий с персонажами осуществляется посредством метода findAllForCharacter
 	//
 	Character* character = 0;
-	const QPixmap photo = ImageHelper::imageFromBytes(_record.value("photo").toByteArray());
+	const LazyPixmap photo(_record.value("photo").toByteArray());
 	const int sortOrder = _record.value("sort_order").toInt();
 
 	return new CharacterPhoto(_id, character, photo, sortOrder);
@@ -130,8 +128,8 @@ DomainObject* CharacterPhotoMapper::doLoad(const Identifier& _id, const QSqlReco
 void CharacterPhotoMapper::doLoad(DomainObject* _domainObject, const QSqlRecord& _record)
 {
 	if (CharacterPhoto* characterPhoto = dynamic_cast<CharacterPhoto*>(_domainObject)) {
-		const QPixmap photo = ImageHelper::imageFromBytes(_record.value("photo").toByteArray());
-		characterPhoto->setPhoto(photo);
+		const QByteArray photoData = _record.value("photo").toByteArray();
+		characterPhoto->setPhotoData(photoData);
 
 		const int sortOrder = _record.value("sort_order").toInt();
 		characterPhoto->setSortOrder(sortOrder);
@@ -113,6 +113,18 @@ void DatabaseHistoryMapper::applyHistoryRecord(const QString& _query, const QStr
     q_saver.exec();
 }
 
+int DatabaseHistoryMapper::compact(const QString& _toDatetime)
+{
+    QSqlQuery q_compactor = Database::query();
+    q_compactor.prepare(
+        QString("DELETE FROM _database_history WHERE %1 < ?")
+        .arg(DATETIME_KEY)
+        );
+    q_compactor.addBindValue(_toDatetime);
+    q_compactor.exec();
+    return q_compactor.numRowsAffected();
+}
+
 DatabaseHistoryMapper::DatabaseHistoryMapper()
 {
 }
@@ -40,6 +40,12 @@ namespace DataMappingLayer
          */
         void applyHistoryRecord(const QString& _query, const QString& _queryValues);
 
+        /**
+         * @brief Удалить изменения данных, сделанные до заданного времени
+         * @return Количество удалённых изменений
+         */
+        int compact(const QString& _toDatetime);
+
     private:
         DatabaseHistoryMapper();
 
@@ -28,6 +28,15 @@ void LocationMapper::insert(Location* _location)
 	abstractInsert(_location);
 }
 
+void LocationMapper::insert(const QList<Location*>& _locations)
+{
+	QList<DomainObject*> subjects;
+	foreach (Location* location, _locations) {
+		subjects.append(location);
+	}
+	abstractInsertBatch(subjects);
+}
+
 void LocationMapper::update(Location* _location)
 {
 	abstractUpdate(_location);
@@ -20,6 +20,7 @@ namespace DataMappingLayer
 		Location* find(const Identifier& _id);
 		LocationsTable* findAll();
 		void insert(Location* _location);
+		void insert(const QList<Location*>& _locations);
 		void update(Location* _location);
 		void remove(Location* _location);
 
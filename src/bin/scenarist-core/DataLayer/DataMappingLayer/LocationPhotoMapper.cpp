@@ -3,8 +3,6 @@
 #include <Domain/Location.h>
 #include <Domain/LocationPhoto.h>
 
-#include <3rd_party/Helpers/ImageHelper.h>
-
 #include <QBuffer>
 
 using namespace DataMappingLayer;
@@ -78,7 +76,7 @@ QString LocationPhotoMapper::insertStatement(DomainObject* _subject, QVariantLis
 	_insertValues.clear();
 	_insertValues.append(photo->id().value());
 	_insertValues.append(photo->location()->id().value());
-	_insertValues.append(ImageHelper::bytesFromImage(photo->photo()));
+	_insertValues.append(photo->photoData());
 	_insertValues.append(photo->sortOrder());
 
 	return insertStatement;
@@ -97,7 +95,7 @@ QString LocationPhotoMapper::updateStatement(DomainObject* _subject, QVariantLis
 	LocationPhoto* photo = dynamic_cast<LocationPhoto*>(_subject);
 	_updateValues.clear();
 	_updateValues.append(photo->location()->id().value());
-	_updateValues.append(ImageHelper::bytesFromImage(photo->photo()));
+	_updateValues.append(photo->photoData());
 	_updateValues.append(photo->sortOrder());
 	_updateValues.append(photo->id().value());
 
@@ -121,7 +119,7 @@ DomainObject* LocationPhotoMapper::doLoad(const Identifier& _id, const QSqlRecor
 	// связывание фотографий с локациями осуществляется посредством метода findAllForLocation
 	//
 	Location* location = 0;
-	const QPixmap photo = ImageHelper::imageFromBytes(_record.value("photo").toByteArray());
+	const LazyPixmap photo(_record.value("photo").toByteArray());
 	const int sortOrder = _record.value("sort_order").toInt();
 
 	return new LocationPhoto(_id, location, photo, sortOrder);
@@ -130,8 +128,8 @@ DomainObject* LocationPhotoMapper::doLoad(const Identifier& _id, const QSqlRecor
 void LocationPhotoMapper::doLoad(DomainObject* _domainObject, const QSqlRecord& _record)
 {
 	if (LocationPhoto* locationPhoto = dynamic_cast<LocationPhoto*>(_domainObject)) {
-		const QPixmap photo = ImageHelper::imageFromBytes(_record.value("photo").toByteArray());
-		locationPhoto->setPhoto(photo);
+		const QByteArray photoData = _record.value("photo").toByteArray();
+		locationPhoto->setPhotoData(photoData);
 
 		const int sortOrder = _record.value("sort_order").toInt();
 		locationPhoto->setSortOrder(sortOrder);
@@ -2,8 +2,6 @@
 
 #include <Domain/Research.h>
 
-#include <3rd_party/Helpers/ImageHelper.h>
-
 using namespace DataMappingLayer;
 
 
@@ -74,7 +72,7 @@ QString ResearchMapper::insertStatement(DomainObject* _subject, QVariantList& _i
 	_insertValues.append(research->name());
 	_insertValues.append(research->description());
 	_insertValues.append(research->url());
-	_insertValues.append(ImageHelper::bytesFromImage(research->image()));
+	_insertValues.append(research->imageData());
 	_insertValues.append(research->sortOrder());
 
 	return insertStatement;
@@ -101,7 +99,7 @@ QString ResearchMapper::updateStatement(DomainObject* _subject, QVariantList& _u
 	_updateValues.append(research->name());
 	_updateValues.append(research->description());
 	_updateValues.append(research->url());
-	_updateValues.append(ImageHelper::bytesFromImage(research->image()));
+	_updateValues.append(research->imageData());
 	_updateValues.append(research->sortOrder());
 	_updateValues.append(research->id().value());
 
@@ -128,10 +126,10 @@ DomainObject* ResearchMapper::doLoad(const Identifier& _id, const QSqlRecord& _r
 	const QString name = _record.value("name").toString();
 	const QString description = _record.value("description").toString();
 	const QString url = _record.value("url").toString();
-	const QPixmap image = ImageHelper::imageFromBytes(_record.value("image").toByteArray());
+	const QByteArray imageData = _record.value("image").toByteArray();
 	const int sortOrder = _record.value("sort_order").toInt();
 
-	return new Research(_id, parent, type, sortOrder, name, description, url, image);
+	return new Research(_id, parent, type, sortOrder, name, description, url, imageData);
 }
 
 void ResearchMapper::doLoad(DomainObject* _domainObject, const QSqlRecord& _record)
@@ -155,8 +153,8 @@ void ResearchMapper::doLoad(DomainObject* _domainObject, const QSqlRecord& _reco
 		const QString url = _record.value("url").toString();
 		research->setUrl(url);
 
-		const QPixmap image = ImageHelper::imageFromBytes(_record.value("image").toByteArray());
-		research->setImage(image);
+		const QByteArray imageData = _record.value("image").toByteArray();
+		research->setImageData(imageData);
 
 		const int sortOrder = _record.value("sort_order").toInt();
 		research->setSortOrder(sortOrder);
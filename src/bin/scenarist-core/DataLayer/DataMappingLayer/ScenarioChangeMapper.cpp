@@ -3,16 +3,30 @@
 #include <Domain/ScenarioChange.h>
 
 #include <DataLayer/Database/Database.h>
+#include <DataLayer/Database/DatabaseHelper.h>
 
+#include <QHash>
 #include <QSet>
 #include <QSqlQuery>
+#include <QStringList>
 
 using namespace DataMappingLayer;
+using DatabaseLayer::DatabaseHelper;
 
 
 namespace {
 	const QString COLUMNS = " id, uuid, datetime, username, undo_patch, redo_patch, is_draft ";
 	const QString TABLE_NAME = " scenario_changes ";
+
+	/**
+	 * @brief Колонки сведений об изменении, без патчей
+	 */
+	const QString INFO_COLUMNS = " id, uuid, datetime, username, is_draft ";
+
+	/**
+	 * @brief Максимальное количество uuid'ов в одном запросе
+	 */
+	const int MAX_UUIDS_IN_QUERY = 500;
 }
 
 ScenarioChange* ScenarioChangeMapper::find(const Identifier& _id)
@@ -36,6 +50,15 @@ void ScenarioChangeMapper::insert(ScenarioChange* _change)
 	abstractInsert(_change);
 }
 
+void ScenarioChangeMapper::insert(const QList<ScenarioChange*>& _changes)
+{
+	QList<DomainObject*> subjects;
+	foreach (ScenarioChange* change, _changes) {
+		subjects.append(change);
+	}
+	abstractInsertBatch(subjects);
+}
+
 void ScenarioChangeMapper::update(ScenarioChange* _change)
 {
 	abstractUpdate(_change);
@@ -62,6 +85,52 @@ QList<QString> ScenarioChangeMapper::uuids() const
 	return uuids;
 }
 
+QList<QString> ScenarioChangeMapper::missingUuids(const QList<QString>& _uuids) const
+{
+	if (_uuids.isEmpty()) {
+		return QList<QString>();
+	}
+
+	//
+	// Проверяемые uuid'ы складываем во временную таблицу, чтобы найти отсутствующие одним
+	// запросом по индексу uuid'ов, а не выполнять отдельный запрос для каждого изменения
+	//
+	DatabaseLayer::Database::transaction();
+	QSqlQuery query = DatabaseLayer::Database::query();
+	query.exec("CREATE TEMP TABLE IF NOT EXISTS _checked_uuids "
+			   "(uuid TEXT PRIMARY KEY ON CONFLICT IGNORE)");
+	query.exec("DELETE FROM _checked_uuids");
+	query.prepare("INSERT INTO _checked_uuids (uuid) VALUES(?)");
+	QVariantList values;
+	foreach (const QString& uuid, _uuids) {
+		values.append(uuid);
+	}
+	query.addBindValue(values);
+	query.execBatch();
+
+	query.exec("SELECT checked.uuid FROM _checked_uuids AS checked "
+			   "WHERE NOT EXISTS (SELECT 1 FROM " + TABLE_NAME + " AS changes "
+			   "WHERE changes.uuid = checked.uuid)");
+	QSet<QString> missing;
+	while (query.next()) {
+		missing.insert(query.value(0).toString());
+	}
+
+	query.exec("DELETE FROM _checked_uuids");
+	DatabaseLayer::Database::commit();
+
+	//
+	// Восстанавливаем исходный порядок
+	//
+	QList<QString> result;
+	foreach (const QString& uuid, _uuids) {
+		if (missing.remove(uuid)) {
+			result.append(uuid);
+		}
+	}
+	return result;
+}
+
 ScenarioChange ScenarioChangeMapper::change(const QString& _uuid) const
 {
 	QSqlQuery loader = DatabaseLayer::Database::query();
@@ -71,8 +140,92 @@ ScenarioChange ScenarioChangeMapper::change(const QString& _uuid) const
 	loader.next();
 	return
 			ScenarioChange(Identifier(), _uuid, loader.value("datetime").toDateTime(),
-				loader.value("username").toString(), loader.value("undo_patch").toString(),
-				loader.value("redo_patch").toString(), loader.value("is_draft").toInt());
+				loader.value("username").toString(),
+				DatabaseHelper::compressedFromStorage(loader.value("undo_patch")),
+				DatabaseHelper::compressedFromStorage(loader.value("redo_patch")),
+				loader.value("is_draft").toInt());
+}
+
+QList<ScenarioChange> ScenarioChangeMapper::changes(const QList<QString>& _uuids) const
+{
+	QHash<QString, ScenarioChange> loadedChanges;
+	for (int uuidIndex = 0; uuidIndex < _uuids.size(); uuidIndex += MAX_UUIDS_IN_QUERY) {
+		const QList<QString> uuids = _uuids.mid(uuidIndex, MAX_UUIDS_IN_QUERY);
+		QStringList placeholders;
+		for (int index = 0; index < uuids.size(); ++index) {
+			placeholders.append("?");
+		}
+
+		QSqlQuery loader = DatabaseLayer::Database::query();
+		loader.prepare("SELECT " + COLUMNS + " FROM " + TABLE_NAME
+					   + " WHERE uuid IN (" + placeholders.join(", ") + ")");
+		foreach (const QString& uuid, uuids) {
+			loader.addBindValue(uuid);
+		}
+		loader.exec();
+		while (loader.next()) {
+			const QString uuid = loader.value("uuid").toString();
+			loadedChanges.insert(uuid,
+				ScenarioChange(Identifier(loader.value("id").toInt()), uuid,
+					QDateTime::fromString(loader.value("datetime").toString(), "yyyy-MM-dd hh:mm:ss"),
+					loader.value("username").toString(),
+					DatabaseHelper::compressedFromStorage(loader.value("undo_patch")),
+					DatabaseHelper::compressedFromStorage(loader.value("redo_patch")),
+					loader.value("is_draft").toInt()));
+		}
+	}
+
+	QList<ScenarioChange> result;
+	foreach (const QString& uuid, _uuids) {
+		if (loadedChanges.contains(uuid)) {
+			result.append(loadedChanges.value(uuid));
+		}
+	}
+	return result;
+}
+
+QList<ScenarioChange> ScenarioChangeMapper::changesPage(int _afterId, int _limit) const
+{
+	return loadChangesInfo("WHERE id > ? ORDER BY id LIMIT ?", QVariantList() << _afterId << _limit);
+}
+
+QList<ScenarioChange> ScenarioChangeMapper::changesSince(const QString& _fromDatetime, int _afterId, int _limit) const
+{
+	return
+			loadChangesInfo("WHERE datetime >= ? AND id > ? ORDER BY id LIMIT ?",
+				QVariantList() << _fromDatetime << _afterId << _limit);
+}
+
+int ScenarioChangeMapper::compact(const QString& _toDatetime)
+{
+	QSqlQuery compactor = DatabaseLayer::Database::query();
+	compactor.prepare("UPDATE " + TABLE_NAME + " SET undo_patch = '', redo_patch = '' "
+					  "WHERE datetime < ? "
+					  "AND id < (SELECT MAX(id) FROM " + TABLE_NAME + ") "
+					  "AND (undo_patch != '' OR redo_patch != '')");
+	compactor.addBindValue(_toDatetime);
+	compactor.exec();
+	return compactor.numRowsAffected();
+}
+
+QList<ScenarioChange> ScenarioChangeMapper::loadChangesInfo(const QString& _filter, const QVariantList& _values) const
+{
+	QSqlQuery loader = DatabaseLayer::Database::query();
+	loader.prepare("SELECT " + INFO_COLUMNS + " FROM " + TABLE_NAME + _filter);
+	foreach (const QVariant& value, _values) {
+		loader.addBindValue(value);
+	}
+	loader.exec();
+
+	QList<ScenarioChange> changes;
+	while (loader.next()) {
+		changes.append(
+			ScenarioChange(Identifier(loader.value("id").toInt()), QUuid(loader.value("uuid").toString()),
+				QDateTime::fromString(loader.value("datetime").toString(), "yyyy-MM-dd hh:mm:ss"),
+				loader.value("username").toString(), QByteArray(), QByteArray(),
+				loader.value("is_draft").toInt()));
+	}
+	return changes;
 }
 
 QString ScenarioChangeMapper::findStatement(const Identifier& _id) const
@@ -93,20 +246,29 @@ QString ScenarioChangeMapper::findAllStatement() const
 
 QString ScenarioChangeMapper::insertStatement(DomainObject* _subject, QVariantList& _insertValues) const
 {
+	//
+	// Изменение с уже сохранённым uuid пропускается, чтобы повтор одного изменения
+	// при пакетном сохранении не прерывал сохранение остальных
+	//
 	QString insertStatement =
-			QString("INSERT INTO " + TABLE_NAME +
+			QString("INSERT OR IGNORE INTO " + TABLE_NAME +
 					" (" + COLUMNS + ") "
 					" VALUES(?, ?, ?, ?, ?, ?, ?) "
 					);
 
+	//
+	// Патчи сохраняются в двоичном виде только в файлы, которые не могут открыть прежние версии программы
+	//
+	const bool isBinary = DatabaseLayer::Database::canStoreBinaryPatches();
+
 	ScenarioChange* change = dynamic_cast<ScenarioChange*>(_subject );
 	_insertValues.clear();
 	_insertValues.append(change->id().value());
 	_insertValues.append(change->uuid().toString());
 	_insertValues.append(change->datetime().toString("yyyy-MM-dd hh:mm:ss"));
 	_insertValues.append(change->user());
-	_insertValues.append(change->undoPatch());
-	_insertValues.append(change->redoPatch());
+	_insertValues.append(DatabaseHelper::compressedToStorage(change->undoPatch(), isBinary));
+	_insertValues.append(DatabaseHelper::compressedToStorage(change->redoPatch(), isBinary));
 	_insertValues.append(change->isDraft() ? "1" : "0");
 
 	return insertStatement;
@@ -125,13 +287,15 @@ QString ScenarioChangeMapper::updateStatement(DomainObject* _subject, QVariantLi
 					" WHERE id = ? "
 					);
 
+	const bool isBinary = DatabaseLayer::Database::canStoreBinaryPatches();
+
 	ScenarioChange* change = dynamic_cast<ScenarioChange*>(_subject);
 	_updateValues.clear();
 	_updateValues.append(change->uuid().toString());
 	_updateValues.append(change->datetime().toString("yyyy-MM-dd hh:mm:ss"));
 	_updateValues.append(change->user());
-	_updateValues.append(change->undoPatch());
-	_updateValues.append(change->redoPatch());
+	_updateValues.append(DatabaseHelper::compressedToStorage(change->undoPatch(), isBinary));
+	_updateValues.append(DatabaseHelper::compressedToStorage(change->redoPatch(), isBinary));
 	_updateValues.append(change->isDraft() ? "1" : "0");
 	_updateValues.append(change->id().value());
 
@@ -153,8 +317,8 @@ DomainObject* ScenarioChangeMapper::doLoad(const Identifier& _id, const QSqlReco
 	const QUuid uuid = QUuid(_record.value("uuid").toString());
 	const QDateTime datetime = QDateTime::fromString(_record.value("datetime").toString(), "yyyy-MM-dd hh:mm:ss");
 	const QString user = _record.value("username").toString();
-	const QString undoPatch = _record.value("undo_patch").toString();
-	const QString redoPatch = _record.value("redo_patch").toString();
+	const QByteArray undoPatch = DatabaseHelper::compressedFromStorage(_record.value("undo_patch"));
+	const QByteArray redoPatch = DatabaseHelper::compressedFromStorage(_record.value("redo_patch"));
 	const bool isDraft = _record.value("is_draft").toInt();
 
 	return new ScenarioChange(_id, uuid, datetime, user, undoPatch, redoPatch, isDraft);
@@ -172,10 +336,10 @@ void ScenarioChangeMapper::doLoad(DomainObject* _domainObject, const QSqlRecord&
 		const QString user = _record.value("username").toString();
 		change->setUser(user);
 
-		const QString undoPatch = _record.value("undo_patch").toString();
+		const QByteArray undoPatch = DatabaseHelper::compressedFromStorage(_record.value("undo_patch"));
 		change->setUndoPatch(undoPatch);
 
-		const QString redoPatch = _record.value("redo_patch").toString();
+		const QByteArray redoPatch = DatabaseHelper::compressedFromStorage(_record.value("redo_patch"));
 		change->setRedoPatch(redoPatch);
 
 		const bool isDraft = _record.value("is_draft").toInt();
@@ -21,6 +21,7 @@ namespace DataMappingLayer
 		ScenarioChangesTable* findLastOne();
 		ScenarioChangesTable* findAll(const QString& _queryFilter = QString::null);
 		void insert(ScenarioChange* _change);
+		void insert(const QList<ScenarioChange*>& _changes);
 		void update(ScenarioChange* _change);
 
 		/**
@@ -33,11 +34,43 @@ namespace DataMappingLayer
 		 */
 		QList<QString> uuids() const;
 
+		/**
+		 * @brief Получить из заданного списка uuid'ы изменений, которых нет в БД
+		 * @note Порядок следования uuid'ов сохраняется, повторы отбрасываются
+		 */
+		QList<QString> missingUuids(const QList<QString>& _uuids) const;
+
 		/**
 		 * @brief Получить изменение по uuid'у не загружая в кучу
 		 */
 		ScenarioChange change(const QString& _uuid) const;
 
+		/**
+		 * @brief Получить изменения по списку uuid'ов не загружая в кучу
+		 * @note Порядок изменений соответствует порядку uuid'ов
+		 */
+		QList<ScenarioChange> changes(const QList<QString>& _uuids) const;
+
+		/**
+		 * @brief Получить страницу сведений об изменениях, следующих за изменением с заданным идентификатором
+		 * @note Патчи не загружаются
+		 */
+		QList<ScenarioChange> changesPage(int _afterId, int _limit) const;
+
+		/**
+		 * @brief Получить страницу сведений об изменениях, сделанных начиная с заданного времени
+		 * @note Патчи не загружаются
+		 */
+		QList<ScenarioChange> changesSince(const QString& _fromDatetime, int _afterId, int _limit) const;
+
+		/**
+		 * @brief Удалить патчи изменений, сделанных до заданного времени
+		 * @note Сами записи об изменениях остаются, чтобы при синхронизации они не загружались повторно,
+		 *		 последнее изменение не сжимается
+		 * @return Количество сжатых изменений
+		 */
+		int compact(const QString& _toDatetime);
+
 	protected:
 		QString findStatement(const Identifier& _id) const;
 		QString findAllStatement() const;
@@ -50,6 +83,12 @@ namespace DataMappingLayer
 		void doLoad(DomainObject* _domainObject, const QSqlRecord& _record);
 		DomainObjectsItemModel* modelInstance();
 
+	private:
+		/**
+		 * @brief Загрузить сведения об изменениях, удовлетворяющих условию
+		 */
+		QList<ScenarioChange> loadChangesInfo(const QString& _filter, const QVariantList& _values) const;
+
 	private:
 		ScenarioChangeMapper();
 
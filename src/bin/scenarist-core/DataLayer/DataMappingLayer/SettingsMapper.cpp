@@ -9,6 +9,13 @@
 using namespace DataMappingLayer;
 using namespace DatabaseLayer;
 
+namespace {
+	/**
+	 * @brief Разделитель значений в списке
+	 */
+	const QString VALUES_SEPARATOR = ";";
+}
+
 
 void SettingsMapper::setValue(const QString& _key, const QString& _value)
 {
@@ -29,6 +36,25 @@ QString SettingsMapper::value(const QString& _key)
 	return q_loader.value("value").toString();
 }
 
+void SettingsMapper::appendValues(const QString& _key, const QStringList& _values)
+{
+	if (_values.isEmpty()) {
+		return;
+	}
+
+	QString values = value(_key);
+	if (!values.isEmpty()) {
+		values.append(VALUES_SEPARATOR);
+	}
+	values.append(_values.join(VALUES_SEPARATOR));
+	setValue(_key, values);
+}
+
+QStringList SettingsMapper::values(const QString& _key)
+{
+	return value(_key).split(VALUES_SEPARATOR, QString::SkipEmptyParts);
+}
+
 SettingsMapper::SettingsMapper()
 {
 }
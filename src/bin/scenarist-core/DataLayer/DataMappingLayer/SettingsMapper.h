@@ -2,6 +2,7 @@
 #define SETTINGSMAPPER_H
 
 #include <QString>
+#include <QStringList>
 
 
 namespace DataMappingLayer
@@ -19,6 +20,16 @@ namespace DataMappingLayer
 		 */
 		QString value(const QString& _key);
 
+		/**
+		 * @brief Добавить значения в список, сохранённый с заданным ключём
+		 */
+		void appendValues(const QString& _key, const QStringList& _values);
+
+		/**
+		 * @brief Получить список значений по ключу
+		 */
+		QStringList values(const QString& _key);
+
 	private:
 		SettingsMapper();
 
@@ -8,6 +8,9 @@
 #include <Domain/Character.h>
 #include <Domain/CharacterPhoto.h>
 
+#include <QSet>
+#include <QStringList>
+
 using namespace DataStorageLayer;
 using namespace DataMappingLayer;
 
@@ -75,6 +78,41 @@ Character* CharacterStorage::storeCharacter(const QString& _name)
 	return newCharacter;
 }
 
+void CharacterStorage::storeCharacters(const QStringList& _names)
+{
+	QSet<QString> storedNames;
+	foreach (DomainObject* domainObject, all()->toList()) {
+		Character* character = dynamic_cast<Character*>(domainObject);
+		storedNames.insert(character->name());
+	}
+
+	//
+	// Сформируем персонажей, которых ещё нет
+	//
+	QList<Character*> newCharacters;
+	foreach (const QString& name, _names) {
+		const QString characterName = name.toUpper().trimmed();
+		if (!characterName.isEmpty()
+			&& !storedNames.contains(characterName)) {
+			storedNames.insert(characterName);
+			newCharacters.append(
+				new Character(Identifier(), characterName, QString(), QString(), new CharacterPhotosTable));
+		}
+	}
+
+	//
+	// ... сохраним их в базе данных
+	//
+	MapperFacade::characterMapper()->insert(newCharacters);
+
+	//
+	// ... и в текущем списке персонажей
+	//
+	foreach (Character* character, newCharacters) {
+		all()->append(character);
+	}
+}
+
 void CharacterStorage::updateCharacter(Character* _character)
 {
 	//
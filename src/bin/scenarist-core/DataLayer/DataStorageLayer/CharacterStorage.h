@@ -34,6 +34,11 @@ namespace DataStorageLayer
 		 */
 		Character* storeCharacter(const QString& _name);
 
+		/**
+		 * @brief Сохранить персонажей, которых ещё нет, одним пакетом
+		 */
+		void storeCharacters(const QStringList& _names);
+
 		/**
 		 * @brief Обновить персонажа
 		 */
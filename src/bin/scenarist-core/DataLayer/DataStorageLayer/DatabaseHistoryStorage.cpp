@@ -2,12 +2,32 @@
 
 #include <DataLayer/DataMappingLayer/MapperFacade.h>
 #include <DataLayer/DataMappingLayer/DatabaseHistoryMapper.h>
+#include <DataLayer/DataMappingLayer/SettingsMapper.h>
 
 #include <QString>
+#include <QStringList>
 
 using DataStorageLayer::DatabaseHistoryStorage;
 using DataMappingLayer::MapperFacade;
 using DataMappingLayer::DatabaseHistoryMapper;
+using DataMappingLayer::SettingsMapper;
+
+namespace {
+    /**
+     * @brief Ключ системной переменной с временем, до которого все изменения данных есть на сервере
+     */
+    const QString SYNCED_DATETIME_KEY = "database-history-synced-to";
+
+    /**
+     * @brief Ключ системной переменной со списком изменений данных, отправленных на сервер после времени синхронизации
+     */
+    const QString UPLOADED_UUIDS_KEY = "database-history-uploaded";
+
+    /**
+     * @brief Ключ системной переменной с временем, до которого изменения данных удалены из истории
+     */
+    const QString COMPACTED_DATETIME_KEY = "database-history-compacted-to";
+}
 
 
 QList<QString> DatabaseHistoryStorage::history(const QString& _fromDatetime)
@@ -37,6 +57,50 @@ void DatabaseHistoryStorage::storeAndApplyHistoryRecord(const QString& _uuid, co
     MapperFacade::databaseHistoryMapper()->applyHistoryRecord(_query, _queryValues);
 }
 
+void DatabaseHistoryStorage::setSyncedDatetime(const QString& _datetime)
+{
+    MapperFacade::settingsMapper()->setValue(SYNCED_DATETIME_KEY, _datetime);
+
+    //
+    // Отправленные ранее изменения теперь учтены во времени синхронизации
+    //
+    MapperFacade::settingsMapper()->setValue(UPLOADED_UUIDS_KEY, "");
+}
+
+QString DatabaseHistoryStorage::syncedDatetime() const
+{
+    return MapperFacade::settingsMapper()->value(SYNCED_DATETIME_KEY);
+}
+
+void DatabaseHistoryStorage::addUploadedUuids(const QList<QString>& _uuids)
+{
+    MapperFacade::settingsMapper()->appendValues(UPLOADED_UUIDS_KEY, _uuids);
+}
+
+QSet<QString> DatabaseHistoryStorage::uploadedUuids() const
+{
+    return MapperFacade::settingsMapper()->values(UPLOADED_UUIDS_KEY).toSet();
+}
+
+int DatabaseHistoryStorage::compact(const QString& _toDatetime)
+{
+    const int compacted = MapperFacade::databaseHistoryMapper()->compact(_toDatetime);
+
+    //
+    // Запоминаем, до какого времени удалены изменения, чтобы не загружать их с сервера повторно
+    //
+    if (_toDatetime > compactedDatetime()) {
+        MapperFacade::settingsMapper()->setValue(COMPACTED_DATETIME_KEY, _toDatetime);
+    }
+
+    return compacted;
+}
+
+QString DatabaseHistoryStorage::compactedDatetime() const
+{
+    return MapperFacade::settingsMapper()->value(COMPACTED_DATETIME_KEY);
+}
+
 DatabaseHistoryStorage::DatabaseHistoryStorage()
 {
 }
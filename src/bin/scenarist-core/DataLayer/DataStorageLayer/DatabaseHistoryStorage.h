@@ -2,6 +2,7 @@
 #define DATABASEHISTORYSTORAGE_H
 
 #include <QMap>
+#include <QSet>
 
 
 namespace DataStorageLayer
@@ -38,6 +39,41 @@ namespace DataStorageLayer
         void storeAndApplyHistoryRecord(const QString& _uuid, const QString& _query,
             const QString& _queryValues, const QString& _username, const QString& _datetime);
 
+        /**
+         * @brief Запомнить, что все изменения данных, сделанные до заданного времени, есть на сервере
+         */
+        void setSyncedDatetime(const QString& _datetime);
+
+        /**
+         * @brief Время, до которого все изменения данных есть на сервере
+         * @note Если синхронизация не выполнялась, возвращается пустая строка
+         */
+        QString syncedDatetime() const;
+
+        /**
+         * @brief Запомнить изменения данных, которые уже отправлены на сервер после времени синхронизации
+         * @note Список очищается при обновлении времени синхронизации
+         */
+        void addUploadedUuids(const QList<QString>& _uuids);
+
+        /**
+         * @brief Изменения данных, которые уже отправлены на сервер после времени синхронизации
+         */
+        QSet<QString> uploadedUuids() const;
+
+        /**
+         * @brief Сжать историю, удалив изменения данных, сделанные до заданного времени
+         * @note Изменения уже применены к таблицам, поэтому нужны только для синхронизации
+         * @return Количество удалённых изменений
+         */
+        int compact(const QString& _toDatetime);
+
+        /**
+         * @brief Время, до которого изменения данных удалены из истории
+         * @note Такие изменения уже применены, поэтому при синхронизации их не нужно загружать повторно
+         */
+        QString compactedDatetime() const;
+
     private:
         DatabaseHistoryStorage();
 
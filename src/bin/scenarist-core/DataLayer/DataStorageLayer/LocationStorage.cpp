@@ -8,6 +8,9 @@
 #include <Domain/Location.h>
 #include <Domain/LocationPhoto.h>
 
+#include <QSet>
+#include <QStringList>
+
 using namespace DataStorageLayer;
 using namespace DataMappingLayer;
 
@@ -75,6 +78,40 @@ Location* LocationStorage::storeLocation(const QString& _locationName)
 	return newLocation;
 }
 
+void LocationStorage::storeLocations(const QStringList& _locationsNames)
+{
+	QSet<QString> storedNames;
+	foreach (DomainObject* domainObject, all()->toList()) {
+		Location* location = dynamic_cast<Location*>(domainObject);
+		storedNames.insert(location->name());
+	}
+
+	//
+	// Сформируем локации, которых ещё нет
+	//
+	QList<Location*> newLocations;
+	foreach (const QString& name, _locationsNames) {
+		const QString locationName = name.toUpper().simplified();
+		if (!locationName.isEmpty()
+			&& !storedNames.contains(locationName)) {
+			storedNames.insert(locationName);
+			newLocations.append(new Location(Identifier(), locationName, QString(), new LocationPhotosTable));
+		}
+	}
+
+	//
+	// ... сохраним их в базе данных
+	//
+	MapperFacade::locationMapper()->insert(newLocations);
+
+	//
+	// ... и в списках
+	//
+	foreach (Location* location, newLocations) {
+		all()->append(location);
+	}
+}
+
 void LocationStorage::updateLocation(Location* _location)
 {
 	//
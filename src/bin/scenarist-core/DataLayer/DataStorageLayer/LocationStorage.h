@@ -5,6 +5,8 @@
 
 #include <QMap>
 
+class QStringList;
+
 namespace Domain {
 	class Location;
 	class LocationsTable;
@@ -33,6 +35,11 @@ namespace DataStorageLayer
 		 */
 		Location* storeLocation(const QString& _locationName);
 
+		/**
+		 * @brief Сохранить локации, которых ещё нет, одним пакетом
+		 */
+		void storeLocations(const QStringList& _locationsNames);
+
 		/**
 		 * @brief Обновить локацию
 		 */
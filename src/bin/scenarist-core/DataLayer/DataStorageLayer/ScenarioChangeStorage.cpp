@@ -5,14 +5,35 @@
 #include <DataLayer/Database/Database.h>
 #include <DataLayer/DataMappingLayer/MapperFacade.h>
 #include <DataLayer/DataMappingLayer/ScenarioChangeMapper.h>
+#include <DataLayer/DataMappingLayer/SettingsMapper.h>
 
 #include <Domain/ScenarioChange.h>
 
 #include <3rd_party/Helpers/PasswordStorage.h>
 
+#include <QHash>
+#include <QStringList>
+
 using namespace DataStorageLayer;
 using namespace DataMappingLayer;
 
+namespace {
+    /**
+     * @brief Количество изменений, загружаемых из БД за один запрос
+     */
+    const int CHANGES_PAGE_SIZE = 1000;
+
+    /**
+     * @brief Ключ системной переменной с временем, до которого все изменения есть на сервере
+     */
+    const QString SYNCED_DATETIME_KEY = "scenario-changes-synced-to";
+
+    /**
+     * @brief Ключ системной переменной со списком изменений, отправленных на сервер после времени синхронизации
+     */
+    const QString UPLOADED_UUIDS_KEY = "scenario-changes-uploaded";
+}
+
 
 ScenarioChangesTable* ScenarioChangeStorage::all()
 {
@@ -33,7 +54,7 @@ ScenarioChange* ScenarioChangeStorage::last()
 }
 
 ScenarioChange* ScenarioChangeStorage::append(const QString& _id, const QString& _datetime,
-    const QString& _user, const QString& _undoPatch, const QString& _redoPatch, bool _isDraft)
+    const QString& _user, const QByteArray& _undoPatch, const QByteArray& _redoPatch, bool _isDraft)
 {
     if (m_uuids.contains(_id)) {
         return nullptr;
@@ -67,8 +88,8 @@ ScenarioChange* ScenarioChangeStorage::append(const QString& _id, const QString&
     return change;
 }
 
-ScenarioChange* ScenarioChangeStorage::append(const QString& _user, const QString& _undoPatch,
-    const QString& _redoPatch, bool _isDraft)
+ScenarioChange* ScenarioChangeStorage::append(const QString& _user, const QByteArray& _undoPatch,
+    const QByteArray& _redoPatch, bool _isDraft)
 {
     return
             append(QUuid::createUuid().toString(), QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss"),
@@ -80,14 +101,14 @@ void ScenarioChangeStorage::store()
     //
     // Сохраняем все несохранённые изменения
     //
-    DatabaseLayer::Database::transaction();
+    QList<ScenarioChange*> changesToInsert;
     foreach (DomainObject* domainObject, allToSave()->toList()) {
         ScenarioChange* change = dynamic_cast<ScenarioChange*>(domainObject);
         if (!change->id().isValid()) {
-            MapperFacade::scenarioChangeMapper()->insert(change);
+            changesToInsert.append(change);
         }
     }
-    DatabaseLayer::Database::commit();
+    MapperFacade::scenarioChangeMapper()->insert(changesToInsert);
 
     //
     // Очищаем список на сохранение
@@ -131,6 +152,24 @@ QList<QString> ScenarioChangeStorage::uuids() const
     return MapperFacade::scenarioChangeMapper()->uuids();
 }
 
+QList<QString> ScenarioChangeStorage::missingUuids(const QList<QString>& _uuids) const
+{
+    //
+    // Отбрасываем изменения, которые ещё не сохранены в БД
+    //
+    QList<QString> uuidsToCheck;
+    foreach (const QString& uuid, _uuids) {
+        if (!m_uuids.contains(uuid)) {
+            uuidsToCheck.append(uuid);
+        }
+    }
+
+    //
+    // ... а остальные проверяем в БД
+    //
+    return MapperFacade::scenarioChangeMapper()->missingUuids(uuidsToCheck);
+}
+
 QList<QString> ScenarioChangeStorage::newUuids(const QString& _fromDatetime)
 {
     //
@@ -139,11 +178,35 @@ QList<QString> ScenarioChangeStorage::newUuids(const QString& _fromDatetime)
     const QString username = DataStorageLayer::StorageFacade::username();
 
     QList<QString> allNew;
+    QSet<QString> allNewUuids;
+
+    //
+    // Сохранённые изменения постранично загружаем из БД без патчей
+    //
+    int lastId = 0;
+    QList<ScenarioChange> changesPage;
+    do {
+        changesPage =
+                MapperFacade::scenarioChangeMapper()->changesSince(_fromDatetime, lastId, CHANGES_PAGE_SIZE);
+        foreach (const ScenarioChange& change, changesPage) {
+            if (change.user() == username) {
+                allNew.append(change.uuid().toString());
+                allNewUuids.insert(allNew.last());
+            }
+            lastId = change.id().value();
+        }
+    } while (changesPage.size() == CHANGES_PAGE_SIZE);
+
+    //
+    // ... и добавляем те, что ещё не успели попасть в БД
+    //
     foreach (DomainObject* domainObject, all()->toList()) {
         ScenarioChange* change = dynamic_cast<ScenarioChange*>(domainObject);
+        const QString uuid = change->uuid().toString();
         if (change->user() == username
-            && change->datetime().toString("yyyy-MM-dd hh:mm:ss") >= _fromDatetime) {
-            allNew.append(change->uuid().toString());
+            && change->datetime().toString("yyyy-MM-dd hh:mm:ss") >= _fromDatetime
+            && !allNewUuids.contains(uuid)) {
+            allNew.append(uuid);
         }
     }
     return allNew;
@@ -169,6 +232,88 @@ ScenarioChange ScenarioChangeStorage::change(const QString& _uuid)
     return MapperFacade::scenarioChangeMapper()->change(_uuid);
 }
 
+QList<ScenarioChange> ScenarioChangeStorage::changes(const QList<QString>& _uuids)
+{
+    //
+    // Несохранённые изменения берём из памяти
+    //
+    QHash<QString, ScenarioChange*> unsavedChanges;
+    foreach (DomainObject* domainObject, all()->toList()) {
+        ScenarioChange* change = dynamic_cast<ScenarioChange*>(domainObject);
+        const QString uuid = change->uuid().toString();
+        if (m_uuids.contains(uuid)) {
+            unsavedChanges.insert(uuid, change);
+        }
+    }
+
+    //
+    // ... а остальные загружаем из БД одним пакетом
+    //
+    QList<QString> uuidsToLoad;
+    foreach (const QString& uuid, _uuids) {
+        if (!unsavedChanges.contains(uuid)) {
+            uuidsToLoad.append(uuid);
+        }
+    }
+    QHash<QString, ScenarioChange> loadedChanges;
+    foreach (const ScenarioChange& change, MapperFacade::scenarioChangeMapper()->changes(uuidsToLoad)) {
+        loadedChanges.insert(change.uuid().toString(), change);
+    }
+
+    //
+    // Формируем результат в исходном порядке
+    //
+    QList<ScenarioChange> result;
+    foreach (const QString& uuid, _uuids) {
+        if (unsavedChanges.contains(uuid)) {
+            result.append(*unsavedChanges.value(uuid));
+        } else if (loadedChanges.contains(uuid)) {
+            result.append(loadedChanges.value(uuid));
+        }
+    }
+    return result;
+}
+
+QList<ScenarioChange> ScenarioChangeStorage::changesPage(int _afterId, int _limit)
+{
+    return MapperFacade::scenarioChangeMapper()->changesPage(_afterId, _limit);
+}
+
+QList<ScenarioChange> ScenarioChangeStorage::changesSince(const QString& _fromDatetime, int _afterId, int _limit)
+{
+    return MapperFacade::scenarioChangeMapper()->changesSince(_fromDatetime, _afterId, _limit);
+}
+
+void ScenarioChangeStorage::setSyncedDatetime(const QString& _datetime)
+{
+    MapperFacade::settingsMapper()->setValue(SYNCED_DATETIME_KEY, _datetime);
+
+    //
+    // Отправленные ранее изменения теперь учтены во времени синхронизации
+    //
+    MapperFacade::settingsMapper()->setValue(UPLOADED_UUIDS_KEY, "");
+}
+
+QString ScenarioChangeStorage::syncedDatetime() const
+{
+    return MapperFacade::settingsMapper()->value(SYNCED_DATETIME_KEY);
+}
+
+void ScenarioChangeStorage::addUploadedUuids(const QList<QString>& _uuids)
+{
+    MapperFacade::settingsMapper()->appendValues(UPLOADED_UUIDS_KEY, _uuids);
+}
+
+QSet<QString> ScenarioChangeStorage::uploadedUuids() const
+{
+    return MapperFacade::settingsMapper()->values(UPLOADED_UUIDS_KEY).toSet();
+}
+
+int ScenarioChangeStorage::compact(const QString& _toDatetime)
+{
+    return MapperFacade::scenarioChangeMapper()->compact(_toDatetime);
+}
+
 ScenarioChangesTable* ScenarioChangeStorage::allToSave()
 {
     if (m_allToSave == 0) {
@@ -33,9 +33,9 @@ namespace DataStorageLayer
 		 */
 		/** @{ */
 		ScenarioChange* append(const QString& _id, const QString& _datetime, const QString& _user,
-			const QString& _undoPatch, const QString& _redoPatch, bool _isDraft = false);
-		ScenarioChange* append(const QString& _user, const QString& _undoPatch,
-			const QString& _redoPatch, bool _isDraft = false);
+			const QByteArray& _undoPatch, const QByteArray& _redoPatch, bool _isDraft = false);
+		ScenarioChange* append(const QString& _user, const QByteArray& _undoPatch,
+			const QByteArray& _redoPatch, bool _isDraft = false);
 		/** @} */
 
 		/**
@@ -59,6 +59,11 @@ namespace DataStorageLayer
 		 */
 		QList<QString> uuids() const;
 
+		/**
+		 * @brief Получить из заданного списка uuid'ы изменений, которых нет в хранилище
+		 */
+		QList<QString> missingUuids(const QList<QString>& _uuids) const;
+
 		/**
 		 * @brief Изменения сценария с заданной даты
 		 */
@@ -69,6 +74,53 @@ namespace DataStorageLayer
 		 */
 		ScenarioChange change(const QString& _uuid);
 
+		/**
+		 * @brief Получить изменения по списку uuid'ов не загружая в кучу
+		 */
+		QList<ScenarioChange> changes(const QList<QString>& _uuids);
+
+		/**
+		 * @brief Страница сведений о сохранённых в БД изменениях, следующих за заданным
+		 * @note Патчи не загружаются, их нужно запрашивать отдельно при помощи changes()
+		 */
+		QList<ScenarioChange> changesPage(int _afterId, int _limit);
+
+		/**
+		 * @brief Страница сведений о сохранённых в БД изменениях, сделанных начиная с заданного времени
+		 * @note Патчи не загружаются, их нужно запрашивать отдельно при помощи changes()
+		 */
+		QList<ScenarioChange> changesSince(const QString& _fromDatetime, int _afterId, int _limit);
+
+		/**
+		 * @brief Запомнить, что все изменения, сделанные до заданного времени, есть на сервере
+		 */
+		void setSyncedDatetime(const QString& _datetime);
+
+		/**
+		 * @brief Время, до которого все изменения есть на сервере
+		 * @note Если синхронизация не выполнялась, возвращается пустая строка
+		 */
+		QString syncedDatetime() const;
+
+		/**
+		 * @brief Запомнить изменения, которые уже отправлены на сервер после времени синхронизации
+		 * @note Список очищается при обновлении времени синхронизации
+		 */
+		void addUploadedUuids(const QList<QString>& _uuids);
+
+		/**
+		 * @brief Изменения, которые уже отправлены на сервер после времени синхронизации
+		 */
+		QSet<QString> uploadedUuids() const;
+
+		/**
+		 * @brief Сжать историю изменений, сделанных до заданного времени
+		 * @note Текст сценария хранится целиком, поэтому патчи старых изменений нужны только
+		 *		 для синхронизации и могут быть удалены, если сервер их уже получил
+		 * @return Количество сжатых изменений
+		 */
+		int compact(const QString& _toDatetime);
+
 	private:
 		/**
 		 * @brief Список загруженных изменений
@@ -477,6 +477,11 @@ SettingsStorage::SettingsStorage()
     m_defaultValues.insert("application/autosave", "1");
     m_defaultValues.insert("application/autosave-interval", "5");
     m_defaultValues.insert("application/save-backups", "1");
+    m_defaultValues.insert("application/database-durable-writes", "0");
+    m_defaultValues.insert("application/database-cache-size", "16384");
+    m_defaultValues.insert("application/database-mmap-size", "64");
+    m_defaultValues.insert("application/sync-transfer-window", "4");
+    m_defaultValues.insert("application/sync-transfer-chunk-size", "100");
     m_defaultValues.insert("application/save-backups-folder",
         QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/KITScenarist/backups");
     m_defaultValues.insert("application/modules/research", "1");
@@ -1,11 +1,15 @@
 #include "Database.h"
 
+#include "DatabaseHelper.h"
+#include "DatabaseWriter.h"
+
 #include <BusinessLayer/ScenarioDocument/ScenarioXml.h>
 
 #include <3rd_party/Helpers/DiffMatchPatchHelper.h>
 
 #include <QApplication>
 #include <QDateTime>
+#include <QDebug>
 #include <QRegularExpression>
 #include <QStringList>
 #include <QSqlQuery>
@@ -28,6 +32,31 @@ namespace {
 				"application-version";
 #endif
 	}
+
+	/**
+	 * @brief Ключ хранения версии схемы базы данных
+	 * @note Версия схемы не связана с версией приложения и меняется, только когда нужно
+	 *		 изменить структуру или данные существующих файлов
+	 */
+	const QString DATABASE_SCHEMA_VERSION_KEY = "database-schema-version";
+
+	/**
+	 * @brief Старшая версия схемы базы данных, с которой умеет работать приложение
+	 */
+	const int DATABASE_SCHEMA_VERSION = 2;
+
+	/**
+	 * @brief Версия схемы, с которой создаются новые файлы и до которой обновляются существующие
+	 * @note Прежние версии программы не проверяют версию схемы и приняли бы двоичные патчи
+	 *		 за текст в base64, поэтому, пока не выпущена версия, проверяющая схему,
+	 *		 файлы с двоичными патчами не создаются
+	 */
+	const int COMPATIBLE_SCHEMA_VERSION = 1;
+
+	/**
+	 * @brief Версия схемы, начиная с которой патчи изменений сценария хранятся в двоичном виде
+	 */
+	const int BINARY_PATCHES_SCHEMA_VERSION = 2;
 }
 
 
@@ -56,6 +85,19 @@ bool Database::canOpenFile(const QString& _databaseFileName, bool _isLocal)
 				QApplication::translate("DatabaseLayer::Database",
 					"Project was modified in higher version. You need update application to latest version for open it.");
 		}
+		//
+		// 2. Если схема файла новее, чем та, с которой умеет работать приложение, его нельзя открывать
+		//
+		else if (q_checker.exec(
+					 QString("SELECT value FROM system_variables WHERE variable = '%1' ")
+					 .arg(DATABASE_SCHEMA_VERSION_KEY))
+				 && q_checker.next()
+				 && q_checker.value("value").toInt() > DATABASE_SCHEMA_VERSION) {
+			canOpen = false;
+			s_openFileError =
+				QApplication::translate("DatabaseLayer::Database",
+					"Project was modified in higher version. You need update application to latest version for open it.");
+		}
 	}
 
 	QSqlDatabase::removeDatabase("tmp_database");
@@ -108,7 +150,34 @@ void Database::setCurrentFile(const QString& _databaseFileName)
 
 void Database::closeCurrentFile()
 {
+	//
+	// Дожидаемся записи отправленных в поток записи изменений, а если запись приостановлена
+	// из-за ошибки, сообщаем об этом - незаписанные изменения при этом остаются в очереди
+	//
+	if (!DatabaseWriter::instance()->close()) {
+		setLastError(DatabaseWriter::instance()->lastError());
+	}
+
+	//
+	// Подготовленные запросы держат соединение, поэтому освобождаем их перед закрытием
+	//
+	s_preparedQueries.clear();
+
 	if (QSqlDatabase::contains(CONNECTION_NAME)) {
+		{
+			//
+			// Переносим все изменения из журнала в файл и возвращаемся к обычному журналу,
+			// чтобы проект снова состоял из одного файла, который можно копировать
+			//
+			QSqlDatabase database = QSqlDatabase::database(CONNECTION_NAME, false);
+			if (database.isOpen()) {
+				QSqlQuery q_closer(database);
+				q_closer.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+				q_closer.exec("PRAGMA journal_mode = DELETE");
+				q_closer.finish();
+				database.close();
+			}
+		}
 		QSqlDatabase::removeDatabase(CONNECTION_NAME);
 	}
 }
@@ -118,11 +187,52 @@ QString Database::currentFile()
 	return instanse().databaseName();
 }
 
+void Database::checkpoint()
+{
+	query().exec("PRAGMA wal_checkpoint(TRUNCATE)");
+}
+
+void Database::setConnectionSettings(bool _isDurableWrites, int _cacheSize, int _mmapSize)
+{
+	s_isDurableWrites = _isDurableWrites;
+	s_cacheSize = _cacheSize;
+	s_mmapSize = _mmapSize;
+}
+
+QStringList Database::connectionPragmas()
+{
+	return s_connectionPragmas;
+}
+
+bool Database::canStoreBinaryPatches()
+{
+	return s_schemaVersion >= BINARY_PATCHES_SCHEMA_VERSION;
+}
+
+void Database::setupConnection(QSqlDatabase& _database, const QStringList& _pragmas)
+{
+	QSqlQuery q_setup(_database);
+	foreach (const QString& pragma, _pragmas) {
+		q_setup.exec(pragma);
+	}
+}
+
 QSqlQuery Database::query()
 {
 	return QSqlQuery(instanse());
 }
 
+QSqlQuery Database::preparedQuery(const QString& _statement)
+{
+	QHash<QString, QSqlQuery>::iterator iter = s_preparedQueries.find(_statement);
+	if (iter == s_preparedQueries.end()) {
+		QSqlQuery query(instanse());
+		query.prepare(_statement);
+		iter = s_preparedQueries.insert(_statement, query);
+	}
+	return iter.value();
+}
+
 void Database::transaction()
 {
 	//
@@ -165,6 +275,12 @@ QString Database::DATABASE_NAME   = ":memory:";
 QString Database::s_openFileError = QString::null;
 QString Database::s_lastError = QString::null;
 int Database::s_openedTransactions = 0;
+QHash<QString, QSqlQuery> Database::s_preparedQueries;
+QStringList Database::s_connectionPragmas;
+bool Database::s_isDurableWrites = false;
+int Database::s_cacheSize = 0;
+int Database::s_mmapSize = 0;
+int Database::s_schemaVersion = 0;
 
 QSqlDatabase Database::instanse()
 {
@@ -187,16 +303,40 @@ void Database::open(QSqlDatabase& _database, const QString& _connectionName, con
 	_database.setDatabaseName(_databaseName);
 	_database.open();
 
+	prepareConnectionPragmas();
+	setupConnection(_database, s_connectionPragmas);
+
 	Database::States states = checkState(_database);
 
 	if (!states.testFlag(SchemeFlag))
 		createTables(_database);
-	if (!states.testFlag(IndexesFlag))
-		createIndexes(_database);
 	if (!states.testFlag(EnumsFlag))
 		createEnums(_database);
 	if (states.testFlag(OldVersionFlag))
 		updateDatabase(_database);
+
+	//
+	// Схема проверяется при каждом открытии, а индексы создаются уже после неё, т.к.
+	// для создания некоторых из них сперва нужно привести в порядок данные
+	//
+	updateDatabaseSchema(_database);
+	createIndexes(_database);
+}
+
+void Database::prepareConnectionPragmas()
+{
+	//
+	// При надёжной записи данные сбрасываются на диск при каждой фиксации транзакции,
+	// а в обычном режиме только при переносе журнала в файл базы данных
+	//
+	s_connectionPragmas.clear();
+	s_connectionPragmas.append("PRAGMA journal_mode = WAL");
+	s_connectionPragmas.append(QString("PRAGMA synchronous = %1").arg(s_isDurableWrites ? "FULL" : "NORMAL"));
+	s_connectionPragmas.append("PRAGMA temp_store = MEMORY");
+	if (s_cacheSize > 0) {
+		s_connectionPragmas.append(QString("PRAGMA cache_size = -%1").arg(s_cacheSize));
+	}
+	s_connectionPragmas.append(QString("PRAGMA mmap_size = %1").arg(static_cast<qint64>(s_mmapSize) * 1024 * 1024));
 }
 
 // Проверка состояния базы данных
@@ -398,7 +538,30 @@ void Database::createTables(QSqlDatabase& _database)
 
 void Database::createIndexes(QSqlDatabase& _database)
 {
-	Q_UNUSED(_database);
+	QSqlQuery q_creator(_database);
+	_database.transaction();
+
+	//
+	// Изменения сценария при синхронизации ищутся по uuid
+	//
+	q_creator.exec("CREATE UNIQUE INDEX IF NOT EXISTS scenario_changes_uuid_index "
+				   "ON scenario_changes (uuid)"
+				   );
+	//
+	// ... и выбираются по дате и автору изменения
+	//
+	q_creator.exec("CREATE INDEX IF NOT EXISTS scenario_changes_datetime_username_index "
+				   "ON scenario_changes (datetime, username)"
+				   );
+
+	//
+	// История запросов выбирается по дате
+	//
+	q_creator.exec("CREATE INDEX IF NOT EXISTS database_history_datetime_index "
+				   "ON _database_history (datetime)"
+				   );
+
+	_database.commit();
 }
 
 void Database::createEnums(QSqlDatabase& _database)
@@ -417,6 +580,11 @@ void Database::createEnums(QSqlDatabase& _database)
 					.arg(::applicationVersionKey())
 					.arg(QApplication::applicationVersion())
 					);
+		q_creator.exec(
+					QString("INSERT INTO system_variables VALUES ('%1', '%2')")
+					.arg(DATABASE_SCHEMA_VERSION_KEY)
+					.arg(COMPATIBLE_SCHEMA_VERSION)
+					);
 	}
 
 	// Справочник мест
@@ -1138,3 +1306,101 @@ void Database::updateDatabaseTo_0_7_0(QSqlDatabase& _database)
 
 	_database.commit();
 }
+
+void Database::updateDatabaseSchema(QSqlDatabase& _database)
+{
+	QSqlQuery q_checker(_database);
+
+	//
+	// Определим версию схемы, в файлах без неё считаем её нулевой
+	//
+	int schemaVersion = 0;
+	if (q_checker.exec(
+			QString("SELECT value FROM system_variables WHERE variable = '%1' ")
+			.arg(DATABASE_SCHEMA_VERSION_KEY))
+		&& q_checker.next()) {
+		schemaVersion = q_checker.value("value").toInt();
+	}
+
+	s_schemaVersion = schemaVersion;
+	if (schemaVersion >= COMPATIBLE_SCHEMA_VERSION) {
+		return;
+	}
+
+	if (schemaVersion < 1) {
+		updateDatabaseSchemaTo_1(_database);
+	}
+
+	//
+	// Обновляется версия схемы
+	//
+	q_checker.exec(
+				QString("INSERT INTO system_variables VALUES ('%1', '%2')")
+				.arg(DATABASE_SCHEMA_VERSION_KEY)
+				.arg(COMPATIBLE_SCHEMA_VERSION)
+				);
+	s_schemaVersion = COMPATIBLE_SCHEMA_VERSION;
+}
+
+void Database::updateDatabaseSchemaTo_1(QSqlDatabase& _database)
+{
+	QSqlQuery q_updater(_database);
+
+	_database.transaction();
+
+	{
+		//
+		// Извлекаем изменения сценария, сохранённые более одного раза,
+		// без этого не удастся создать уникальный индекс по uuid
+		//
+		q_updater.exec("SELECT id, uuid, undo_patch, redo_patch FROM scenario_changes "
+					   "WHERE uuid IN "
+					   "(SELECT uuid FROM scenario_changes GROUP BY uuid HAVING COUNT(*) > 1) "
+					   "ORDER BY uuid, id"
+					   );
+		QMap<QString, QList<QStringList> > duplicates;
+		while (q_updater.next()) {
+			const QSqlRecord record = q_updater.record();
+			duplicates[record.value("uuid").toString()].append(
+				QStringList()
+				<< record.value("id").toString()
+				<< DatabaseHelper::compressedToBase64(DatabaseHelper::compressedFromStorage(record.value("undo_patch")))
+				<< DatabaseHelper::compressedToBase64(DatabaseHelper::compressedFromStorage(record.value("redo_patch"))));
+		}
+
+		//
+		// Повторы с тем же содержимым удаляем, оставляя самую раннюю запись, а если записи
+		// с одинаковым uuid отличаются, то оставляем самую новую из них и сообщаем об этом
+		//
+		QStringList idsToRemove;
+		foreach (const QString& uuid, duplicates.keys()) {
+			const QList<QStringList>& rows = duplicates[uuid];
+			bool isSameContent = true;
+			foreach (const QStringList& row, rows) {
+				if (row.mid(1) != rows.first().mid(1)) {
+					isSameContent = false;
+					break;
+				}
+			}
+
+			const QString keptId = isSameContent ? rows.first().first() : rows.last().first();
+			if (!isSameContent) {
+				qWarning() << "Scenario change" << uuid << "is stored" << rows.size()
+						   << "times with different patches, keeping the latest row" << keptId;
+			}
+
+			foreach (const QStringList& row, rows) {
+				if (row.first() != keptId) {
+					idsToRemove.append(row.first());
+				}
+			}
+		}
+
+		if (!idsToRemove.isEmpty()) {
+			q_updater.exec(
+				QString("DELETE FROM scenario_changes WHERE id IN (%1)").arg(idsToRemove.join(", ")));
+		}
+	}
+
+	_database.commit();
+}
@@ -1,7 +1,9 @@
 #ifndef DATABASE_H
 #define DATABASE_H
 
+#include <QHash>
 #include <QSqlDatabase>
+#include <QStringList>
 
 
 namespace DatabaseLayer
@@ -44,11 +46,52 @@ namespace DatabaseLayer
 		 */
 		static QString currentFile();
 
+		/**
+		 * @brief Перенести изменения из журнала в файл базы данных
+		 * @note Нужно вызывать перед копированием файла проекта
+		 */
+		static void checkpoint();
+
+		/**
+		 * @brief Задать параметры соединений с базой данных
+		 * @param _isDurableWrites - сбрасывать ли данные на диск при каждой фиксации транзакции
+		 * @param _cacheSize - размер кэша в килобайтах, 0 - размер по умолчанию
+		 * @param _mmapSize - размер отображения файла в память в мегабайтах, 0 - не использовать
+		 * @note Применяются к файлам, открываемым после их задания
+		 */
+		static void setConnectionSettings(bool _isDurableWrites, int _cacheSize, int _mmapSize);
+
+		/**
+		 * @brief Получить настройки соединений с текущей базой данных
+		 *
+		 * Включается журнал упреждающей записи, временные данные хранятся в памяти, а размер кэша,
+		 * отображения файла в память и надёжность записи задаются в setConnectionSettings
+		 * @note Список формируется при открытии файла, поток записи получает его копию вместе со снимком
+		 */
+		static QStringList connectionPragmas();
+
+		/**
+		 * @brief Можно ли сохранять патчи изменений сценария в двоичном виде
+		 * @note Можно только в файлы, созданные со схемой, о которой знают все открывающие их версии
+		 */
+		static bool canStoreBinaryPatches();
+
+		/**
+		 * @brief Настроить открытое соединение с базой данных заданными настройками
+		 */
+		static void setupConnection(QSqlDatabase& _database, const QStringList& _pragmas);
+
 		/**
 		 * @brief Получить объект для выполнения запросов в БД
 		 */
 		static QSqlQuery query();
 
+		/**
+		 * @brief Получить подготовленный запрос для заданного выражения
+		 * @note Запросы переиспользуются до закрытия файла, параметры нужно задавать по индексу
+		 */
+		static QSqlQuery preparedQuery(const QString& _statement);
+
 		/**
 		 * @brief Запустить транзакцию, если ещё не запущена
 		 */
@@ -96,6 +139,37 @@ namespace DatabaseLayer
 		 */
 		static int s_openedTransactions;
 
+		/**
+		 * @brief Подготовленные запросы текущего соединения
+		 */
+		static QHash<QString, QSqlQuery> s_preparedQueries;
+
+		/**
+		 * @brief Настройки соединений с текущей базой данных
+		 * @note Формируются при открытии файла, чтобы поток записи не обращался к настройкам,
+		 *		 используются только в основном потоке
+		 */
+		static QStringList s_connectionPragmas;
+
+		/**
+		 * @brief Параметры соединений с базой данных
+		 */
+		/** @{ */
+		static bool s_isDurableWrites;
+		static int s_cacheSize;
+		static int s_mmapSize;
+		/** @} */
+
+		/**
+		 * @brief Версия схемы текущей базы данных
+		 */
+		static int s_schemaVersion;
+
+		/**
+		 * @brief Сформировать настройки соединений из заданных параметров
+		 */
+		static void prepareConnectionPragmas();
+
 		/**
 		 * @brief Получить объект текущей базы данных
 		 */
@@ -202,6 +276,19 @@ namespace DatabaseLayer
 		 * - в таблицу scenario добавляется поле для хранения схемы
 		 */
 		static void updateDatabaseTo_0_7_0(QSqlDatabase& _database);
+
+		/**
+		 * @brief Привести схему базы данных к текущей версии
+		 * @note Версия схемы хранится отдельно от версии приложения и проверяется при каждом открытии
+		 */
+		static void updateDatabaseSchema(QSqlDatabase& _database);
+
+		/**
+		 * @brief Обновить схему базы данных до версии 1
+		 *
+		 * - удаляются повторы изменений сценария с одинаковыми uuid
+		 */
+		static void updateDatabaseSchemaTo_1(QSqlDatabase& _database);
 	};
 
 	Q_DECLARE_OPERATORS_FOR_FLAGS(Database::States)
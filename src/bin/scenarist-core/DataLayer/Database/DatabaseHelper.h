@@ -3,12 +3,18 @@
 
 #include <QByteArray>
 #include <QString>
+#include <QVariant>
 
 namespace {
 	/**
 	 * @brief Сила сжатия
 	 */
 	const int COMPRESSION_LEVEL = 6;
+
+	/**
+	 * @brief Признак сжатых данных, сохранённых в двоичном виде
+	 */
+	const char BINARY_FORMAT_MARKER = '\x01';
 }
 
 
@@ -35,7 +41,77 @@ namespace DatabaseLayer {
 				result = _data;
 			}
 			return result;
-        }
+		}
+
+		/**
+		 * @brief Сжать данные без перевода в base64
+		 */
+		static QByteArray compressRaw(const QString& _data) {
+			return qCompress(_data.toUtf8(), COMPRESSION_LEVEL);
+		}
+
+		/**
+		 * @brief Разжать данные, сжатые без перевода в base64
+		 */
+		static QString uncompressRaw(const QByteArray& _data) {
+			return QString::fromUtf8(qUncompress(_data));
+		}
+
+		/**
+		 * @brief Получить сжатые данные из строки в base64, в которой они передаются по сети
+		 * @note Строка, не являющаяся корректным base64, считается несжатыми данными
+		 *		 и сжимается, так хранились изменения в ранних версиях
+		 */
+		static QByteArray compressedFromBase64(const QString& _compressed) {
+			if (_compressed.isEmpty()) {
+				return QByteArray();
+			}
+
+			const QByteArray base64 = _compressed.toUtf8();
+			const QByteArray binary = QByteArray::fromBase64(base64);
+			if (binary.isEmpty()
+				|| binary.toBase64() != base64) {
+				return compressRaw(_compressed);
+			}
+
+			return binary;
+		}
+
+		/**
+		 * @brief Подготовить сжатые данные к передаче по сети
+		 */
+		static QString compressedToBase64(const QByteArray& _compressed) {
+			return _compressed.toBase64();
+		}
+
+		/**
+		 * @brief Подготовить сжатые данные к сохранению в БД
+		 *
+		 * В двоичном виде данные хранятся без base64, что экономит примерно треть объёма,
+		 * но такие файлы не могут прочитать прежние версии программы
+		 */
+		static QVariant compressedToStorage(const QByteArray& _compressed, bool _isBinary) {
+			if (!_isBinary) {
+				return compressedToBase64(_compressed);
+			}
+
+			return QByteArray(1, BINARY_FORMAT_MARKER) + _compressed;
+		}
+
+		/**
+		 * @brief Получить сжатые данные из значения, сохранённого в БД
+		 * @note Значения, сохранённые в прежнем текстовом виде, переводятся из base64
+		 */
+		static QByteArray compressedFromStorage(const QVariant& _value) {
+			if (_value.type() == QVariant::ByteArray) {
+				const QByteArray binary = _value.toByteArray();
+				if (!binary.isEmpty()
+					&& binary.at(0) == BINARY_FORMAT_MARKER) {
+					return binary.mid(1);
+				}
+			}
+			return compressedFromBase64(_value.toString());
+		}
 	};
 }
 
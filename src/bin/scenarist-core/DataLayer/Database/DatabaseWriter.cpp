@@ -0,0 +1,409 @@
+#include "DatabaseWriter.h"
+
+#include "Database.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QSqlError>
+
+using DatabaseLayer::DatabaseSnapshot;
+using DatabaseLayer::DatabaseWriter;
+using DatabaseLayer::DatabaseWriterWorker;
+
+namespace {
+	/**
+	 * @brief Имя соединения потока записи
+	 */
+	const QString CONNECTION_NAME = "database_writer";
+
+	/**
+	 * @brief Драйвер базы данных
+	 */
+	const QString SQL_DRIVER = "QSQLITE";
+}
+
+
+DatabaseWriter* DatabaseWriter::instance()
+{
+	static DatabaseWriter s_writer;
+	return &s_writer;
+}
+
+DatabaseWriter::~DatabaseWriter()
+{
+	//
+	// Объект разрушается уже после выхода из main, когда соединение закрывать поздно,
+	// поэтому здесь лишь страхуемся от разрушения работающего потока
+	//
+	m_thread.quit();
+	m_thread.wait();
+}
+
+void DatabaseWriter::shutdown()
+{
+	if (!m_thread.isRunning()) {
+		return;
+	}
+
+	close();
+
+	m_thread.quit();
+	m_thread.wait();
+}
+
+void DatabaseWriter::beginSnapshot()
+{
+	m_snapshot = DatabaseSnapshot();
+	m_snapshot.databaseFile = Database::currentFile();
+	m_snapshot.connectionPragmas = Database::connectionPragmas();
+	m_snapshotWrittenActions.clear();
+	m_isSnapshotStarted = true;
+}
+
+bool DatabaseWriter::isSnapshotStarted() const
+{
+	return m_isSnapshotStarted;
+}
+
+void DatabaseWriter::append(const QString& _statement, const QVariantList& _values)
+{
+	m_snapshot.statements.append(qMakePair(_statement, _values));
+}
+
+void DatabaseWriter::appendWrittenAction(const std::function<void()>& _action)
+{
+	m_snapshotWrittenActions.append(_action);
+}
+
+void DatabaseWriter::commitSnapshot()
+{
+	m_isSnapshotStarted = false;
+
+	//
+	// Если изменений нет, то и записывать нечего
+	//
+	if (m_snapshot.statements.isEmpty()) {
+		foreach (const std::function<void()>& action, m_snapshotWrittenActions) {
+			action();
+		}
+		m_snapshotWrittenActions.clear();
+		emit snapshotWritten();
+		return;
+	}
+
+	m_pendingWrittenActions.append(m_snapshotWrittenActions);
+	m_snapshotWrittenActions.clear();
+	m_worker->enqueue(m_snapshot);
+	m_snapshot = DatabaseSnapshot();
+	QMetaObject::invokeMethod(m_worker, "writeSnapshots", Qt::QueuedConnection);
+}
+
+void DatabaseWriter::vacuum()
+{
+	DatabaseSnapshot snapshot;
+	snapshot.databaseFile = Database::currentFile();
+	snapshot.connectionPragmas = Database::connectionPragmas();
+	snapshot.isVacuum = true;
+
+	//
+	// Пересборка занимает место в очереди наравне со снимками, поэтому и список действий для неё нужен
+	//
+	m_pendingWrittenActions.append(QList<std::function<void()> >());
+	m_worker->enqueue(snapshot);
+	QMetaObject::invokeMethod(m_worker, "writeSnapshots", Qt::QueuedConnection);
+}
+
+bool DatabaseWriter::isBusy() const
+{
+	return m_worker->pendingCount() > 0;
+}
+
+bool DatabaseWriter::waitForFinished()
+{
+	//
+	// Вызовы исполнителю обрабатываются по очереди, поэтому блокирующий вызов вернётся
+	// только после того, как будут обработаны все ранее отправленные снимки
+	//
+	if (isBusy()) {
+		QMetaObject::invokeMethod(m_worker, "sync", Qt::BlockingQueuedConnection);
+	}
+
+	processWrittenSnapshots();
+
+	//
+	// Снимки в очереди после обработки всех вызовов остаются, только если запись не удалась
+	//
+	return !isBusy();
+}
+
+QString DatabaseWriter::lastError() const
+{
+	return m_worker->lastError();
+}
+
+void DatabaseWriter::retry()
+{
+	QMetaObject::invokeMethod(m_worker, "resume", Qt::QueuedConnection);
+}
+
+void DatabaseWriter::discardFailed()
+{
+	//
+	// Запись приостановлена, поэтому исполнитель не обращается к очереди, пока она очищается
+	//
+	m_worker->clearQueue();
+	m_pendingWrittenActions.clear();
+	QMetaObject::invokeMethod(m_worker, "resume", Qt::QueuedConnection);
+}
+
+bool DatabaseWriter::close()
+{
+	const bool isFinished = waitForFinished();
+
+	//
+	// Действия незаписанных снимков относятся к объектам закрываемого файла, поэтому отказываемся
+	// от них, но сами снимки оставляем в очереди, чтобы их можно было записать повторно
+	//
+	for (int index = 0; index < m_pendingWrittenActions.size(); ++index) {
+		m_pendingWrittenActions[index].clear();
+	}
+
+	QMetaObject::invokeMethod(m_worker, "closeDatabase", Qt::BlockingQueuedConnection);
+
+	return isFinished;
+}
+
+void DatabaseWriter::aboutSnapshotWritten()
+{
+	processWrittenSnapshots();
+	emit snapshotWritten();
+}
+
+DatabaseWriter::DatabaseWriter() :
+	m_worker(new DatabaseWriterWorker),
+	m_isSnapshotStarted(false)
+{
+	m_worker->moveToThread(&m_thread);
+	connect(&m_thread, SIGNAL(finished()), m_worker, SLOT(deleteLater()));
+	connect(m_worker, SIGNAL(snapshotWritten()), this, SLOT(aboutSnapshotWritten()));
+	connect(m_worker, SIGNAL(snapshotFailed(QString)), this, SIGNAL(snapshotFailed(QString)));
+
+	m_thread.start();
+}
+
+void DatabaseWriter::processWrittenSnapshots()
+{
+	//
+	// Снимки записываются по порядку, поэтому записанным снимкам соответствуют первые списки действий
+	//
+	while (m_pendingWrittenActions.size() > m_worker->pendingCount()) {
+		foreach (const std::function<void()>& action, m_pendingWrittenActions.takeFirst()) {
+			action();
+		}
+	}
+}
+
+// ****
+
+
+DatabaseWriterWorker::DatabaseWriterWorker() :
+	m_isFailed(false)
+{
+}
+
+void DatabaseWriterWorker::enqueue(const DatabaseSnapshot& _snapshot)
+{
+	QMutexLocker locker(&m_queueMutex);
+	m_queue.append(_snapshot);
+	m_pendingCount.ref();
+}
+
+int DatabaseWriterWorker::pendingCount() const
+{
+	return m_pendingCount.load();
+}
+
+void DatabaseWriterWorker::clearQueue()
+{
+	QMutexLocker locker(&m_queueMutex);
+	m_queue.clear();
+	m_pendingCount.store(0);
+}
+
+QString DatabaseWriterWorker::lastError() const
+{
+	QMutexLocker locker(&m_queueMutex);
+	return m_lastError;
+}
+
+void DatabaseWriterWorker::writeSnapshots()
+{
+	while (!m_isFailed) {
+		DatabaseSnapshot snapshot;
+		{
+			QMutexLocker locker(&m_queueMutex);
+			if (m_queue.isEmpty()) {
+				break;
+			}
+			snapshot = m_queue.first();
+		}
+
+		//
+		// Записываем снимок в одной транзакции
+		//
+		//
+		// Пересборка файла не меняет данных, поэтому при ошибке просто пропускаем её
+		//
+		if (snapshot.isVacuum) {
+			if (openDatabase(snapshot.databaseFile, snapshot.connectionPragmas)) {
+				vacuumDatabase();
+			}
+
+			QMutexLocker locker(&m_queueMutex);
+			if (!m_queue.isEmpty()) {
+				m_queue.removeFirst();
+				m_pendingCount.deref();
+			}
+			continue;
+		}
+
+		QString error;
+		if (!openDatabase(snapshot.databaseFile, snapshot.connectionPragmas)) {
+			error = m_database.isValid() && m_database.lastError().isValid()
+					? m_database.lastError().text()
+					: tr("File %1 does not exist").arg(snapshot.databaseFile);
+		} else {
+			m_database.transaction();
+			QList<QPair<QString, QVariantList> >::const_iterator iter = snapshot.statements.constBegin();
+			for (; iter != snapshot.statements.constEnd(); ++iter) {
+				if (!m_preparedQueries.contains(iter->first)) {
+					QSqlQuery query(m_database);
+					query.prepare(iter->first);
+					m_preparedQueries.insert(iter->first, query);
+				}
+				QSqlQuery query = m_preparedQueries.value(iter->first);
+				for (int index = 0; index < iter->second.size(); ++index) {
+					query.bindValue(index, iter->second.at(index));
+				}
+				if (!query.exec()) {
+					error = query.lastError().text();
+					break;
+				}
+			}
+
+			if (error.isEmpty()) {
+				if (!m_database.commit()) {
+					error = m_database.lastError().text();
+				}
+			} else {
+				m_database.rollback();
+			}
+		}
+
+		//
+		// При ошибке оставляем снимок в очереди и ждём решения о повторной записи
+		//
+		if (!error.isEmpty()) {
+			{
+				QMutexLocker locker(&m_queueMutex);
+				m_lastError = error;
+			}
+			m_isFailed = true;
+			emit snapshotFailed(error);
+			break;
+		}
+
+		bool isQueueEmpty = true;
+		{
+			QMutexLocker locker(&m_queueMutex);
+			if (!m_queue.isEmpty()) {
+				m_queue.removeFirst();
+				m_pendingCount.deref();
+			}
+			isQueueEmpty = m_queue.isEmpty();
+		}
+
+		//
+		// Когда всё записано, переносим журнал в файл, чтобы его можно было копировать
+		//
+		if (isQueueEmpty) {
+			checkpointDatabase();
+		}
+		emit snapshotWritten();
+	}
+}
+
+void DatabaseWriterWorker::sync()
+{
+}
+
+void DatabaseWriterWorker::resume()
+{
+	{
+		QMutexLocker locker(&m_queueMutex);
+		m_lastError.clear();
+	}
+	m_isFailed = false;
+	writeSnapshots();
+}
+
+void DatabaseWriterWorker::closeDatabase()
+{
+	m_preparedQueries.clear();
+
+	if (m_database.isValid()) {
+		m_database.close();
+		m_database = QSqlDatabase();
+		QSqlDatabase::removeDatabase(CONNECTION_NAME);
+	}
+}
+
+bool DatabaseWriterWorker::openDatabase(const QString& _databaseFile, const QStringList& _connectionPragmas)
+{
+	if (m_database.isOpen()
+		&& m_database.databaseName() == _databaseFile) {
+		return true;
+	}
+
+	closeDatabase();
+
+	//
+	// Не создаём новый файл, если прежний был перемещён или удалён
+	//
+	if (!QFile::exists(_databaseFile)) {
+		return false;
+	}
+
+	m_database = QSqlDatabase::addDatabase(SQL_DRIVER, CONNECTION_NAME);
+	m_database.setDatabaseName(_databaseFile);
+	if (!m_database.open()) {
+		return false;
+	}
+
+	Database::setupConnection(m_database, _connectionPragmas);
+	return true;
+}
+
+void DatabaseWriterWorker::vacuumDatabase()
+{
+	//
+	// Пересборка меняет структуру файла, поэтому подготовленные запросы больше не нужны
+	//
+	m_preparedQueries.clear();
+
+	QSqlQuery q_vacuum(m_database);
+	if (!q_vacuum.exec("VACUUM")) {
+		qWarning() << "Database vacuum failed:" << q_vacuum.lastError().text();
+	}
+	q_vacuum.finish();
+
+	checkpointDatabase();
+}
+
+void DatabaseWriterWorker::checkpointDatabase()
+{
+	QSqlQuery q_checkpoint(m_database);
+	q_checkpoint.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+}
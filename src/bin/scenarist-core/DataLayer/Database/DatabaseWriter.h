@@ -0,0 +1,309 @@
+#ifndef DATABASEWRITER_H
+#define DATABASEWRITER_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QThread>
+#include <QVariant>
+
+#include <functional>
+
+
+namespace DatabaseLayer
+{
+	/**
+	 * @brief Снимок изменений базы данных - набор запросов с параметрами
+	 */
+	class DatabaseSnapshot
+	{
+	public:
+		/**
+		 * @brief Файл базы данных, в который нужно записать изменения
+		 */
+		QString databaseFile;
+
+		/**
+		 * @brief Настройки соединения с базой данных
+		 */
+		QStringList connectionPragmas;
+
+		/**
+		 * @brief Запросы и их параметры
+		 */
+		QList<QPair<QString, QVariantList> > statements;
+
+		/**
+		 * @brief Пересобрать файл вместо выполнения запросов
+		 */
+		bool isVacuum = false;
+	};
+
+	class DatabaseWriterWorker;
+
+
+	/**
+	 * @brief Запись снимков изменений базы данных в отдельном потоке
+	 *
+	 * Пока снимок открыт, мапперы не выполняют запросы на изменение данных, а добавляют их в снимок.
+	 * Закрытый снимок передаётся в поток записи, который работает через собственное соединение
+	 * с базой данных и выполняет снимки по очереди, каждый в своей транзакции.
+	 *
+	 * Если снимок записать не удалось, он остаётся в очереди до вызова retry() или discardFailed(),
+	 * а запросы, выполняемые в обход снимков, до этого момента не выполняются, чтобы не опередить его.
+	 */
+	class DatabaseWriter : public QObject
+	{
+		Q_OBJECT
+
+	public:
+		/**
+		 * @brief Получить объект записи
+		 */
+		static DatabaseWriter* instance();
+
+		~DatabaseWriter();
+
+		/**
+		 * @brief Начать формирование снимка изменений
+		 */
+		void beginSnapshot();
+
+		/**
+		 * @brief Формируется ли сейчас снимок изменений
+		 */
+		bool isSnapshotStarted() const;
+
+		/**
+		 * @brief Добавить запрос в снимок изменений
+		 */
+		void append(const QString& _statement, const QVariantList& _values);
+
+		/**
+		 * @brief Выполнить действие, когда формируемый снимок будет записан в файл
+		 * @note Если снимок записать не удастся, и от него откажутся, то действие не выполняется
+		 */
+		void appendWrittenAction(const std::function<void()>& _action);
+
+		/**
+		 * @brief Завершить формирование снимка и отправить его на запись в файл текущей базы данных
+		 */
+		void commitSnapshot();
+
+		/**
+		 * @brief Пересобрать файл текущей базы данных после записи отправленных снимков
+		 * @note Выполняется в потоке записи, ошибки пересборки не приостанавливают запись
+		 */
+		void vacuum();
+
+		/**
+		 * @brief Есть ли снимки, ожидающие записи
+		 */
+		bool isBusy() const;
+
+		/**
+		 * @brief Дождаться записи всех отправленных снимков
+		 * @return false, если запись приостановлена из-за ошибки и в очереди остались снимки
+		 */
+		bool waitForFinished();
+
+		/**
+		 * @brief Текст ошибки, из-за которой приостановлена запись
+		 */
+		QString lastError() const;
+
+		/**
+		 * @brief Повторить запись снимка, которую не удалось выполнить
+		 */
+		void retry();
+
+		/**
+		 * @brief Отказаться от записи снимков, которую не удалось выполнить
+		 */
+		void discardFailed();
+
+		/**
+		 * @brief Дождаться записи и закрыть соединение с базой данных
+		 * @return false, если запись приостановлена из-за ошибки
+		 * @note Незаписанные снимки остаются в очереди, повторить или отменить их запись
+		 *		 по-прежнему можно вызовом retry() или discardFailed()
+		 */
+		bool close();
+
+		/**
+		 * @brief Закрыть соединение с базой данных и остановить поток записи
+		 * @note Нужно вызвать до завершения работы приложения, после этого объектом пользоваться нельзя
+		 */
+		void shutdown();
+
+	signals:
+		/**
+		 * @brief Снимок успешно записан
+		 */
+		void snapshotWritten();
+
+		/**
+		 * @brief Не удалось записать снимок
+		 * @note Запись последующих снимков приостанавливается до вызова retry() или discardFailed()
+		 */
+		void snapshotFailed(const QString& _error);
+
+	private slots:
+		/**
+		 * @brief Исполнитель записал очередной снимок
+		 */
+		void aboutSnapshotWritten();
+
+	private:
+		DatabaseWriter();
+
+		/**
+		 * @brief Выполнить действия для снимков, которые уже записаны
+		 */
+		void processWrittenSnapshots();
+
+		/**
+		 * @brief Поток записи
+		 */
+		QThread m_thread;
+
+		/**
+		 * @brief Исполнитель записи, работающий в потоке записи
+		 */
+		DatabaseWriterWorker* m_worker;
+
+		/**
+		 * @brief Формируемый снимок
+		 */
+		DatabaseSnapshot m_snapshot;
+
+		/**
+		 * @brief Формируется ли снимок
+		 */
+		bool m_isSnapshotStarted;
+
+		/**
+		 * @brief Действия, выполняемые после записи формируемого снимка
+		 */
+		QList<std::function<void()> > m_snapshotWrittenActions;
+
+		/**
+		 * @brief Действия, выполняемые после записи снимков из очереди, по списку на каждый снимок
+		 */
+		QList<QList<std::function<void()> > > m_pendingWrittenActions;
+	};
+
+
+	/**
+	 * @brief Исполнитель записи снимков
+	 * @note Используется только объектом записи
+	 */
+	class DatabaseWriterWorker : public QObject
+	{
+		Q_OBJECT
+
+	public:
+		DatabaseWriterWorker();
+
+		/**
+		 * @brief Добавить снимок в очередь записи
+		 */
+		void enqueue(const DatabaseSnapshot& _snapshot);
+
+		/**
+		 * @brief Количество снимков в очереди
+		 */
+		int pendingCount() const;
+
+		/**
+		 * @brief Удалить из очереди все снимки
+		 */
+		void clearQueue();
+
+		/**
+		 * @brief Текст ошибки, из-за которой приостановлена запись
+		 */
+		QString lastError() const;
+
+	public slots:
+		/**
+		 * @brief Записать снимки из очереди
+		 */
+		void writeSnapshots();
+
+		/**
+		 * @brief Ничего не делает, используется для ожидания обработки ранее отправленных вызовов
+		 */
+		void sync();
+
+		/**
+		 * @brief Возобновить запись после ошибки
+		 */
+		void resume();
+
+		/**
+		 * @brief Закрыть соединение с базой данных
+		 */
+		void closeDatabase();
+
+	signals:
+		void snapshotWritten();
+		void snapshotFailed(const QString& _error);
+
+	private:
+		/**
+		 * @brief Открыть соединение с заданным файлом, если ещё не открыто
+		 */
+		bool openDatabase(const QString& _databaseFile, const QStringList& _connectionPragmas);
+
+		/**
+		 * @brief Пересобрать файл базы данных
+		 */
+		void vacuumDatabase();
+
+		/**
+		 * @brief Перенести журнал в файл базы данных
+		 */
+		void checkpointDatabase();
+
+	private:
+		/**
+		 * @brief Очередь снимков
+		 */
+		QList<DatabaseSnapshot> m_queue;
+		mutable QMutex m_queueMutex;
+
+		/**
+		 * @brief Количество снимков в очереди, доступное без блокировки
+		 */
+		QAtomicInt m_pendingCount;
+
+		/**
+		 * @brief Приостановлена ли запись из-за ошибки
+		 */
+		bool m_isFailed;
+
+		/**
+		 * @brief Текст ошибки, из-за которой приостановлена запись
+		 * @note Защищается мьютексом очереди
+		 */
+		QString m_lastError;
+
+		/**
+		 * @brief Соединение потока записи
+		 */
+		QSqlDatabase m_database;
+
+		/**
+		 * @brief Подготовленные запросы соединения потока записи
+		 */
+		QHash<QString, QSqlQuery> m_preparedQueries;
+	};
+}
+
+#endif // DATABASEWRITER_H
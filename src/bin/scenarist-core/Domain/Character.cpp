@@ -96,7 +96,7 @@ void Character::setPhotos(const QList<QPixmap>& _photos)
 	m_photos->clear();
 
 	for (int index = 0; index < _photos.count(); ++index) {
-		CharacterPhoto* newPhoto = new CharacterPhoto(Identifier(), this, _photos.value(index), index);
+		CharacterPhoto* newPhoto = new CharacterPhoto(Identifier(), this, LazyPixmap(_photos.value(index)), index);
 		m_photos->append(newPhoto);
 	}
 
@@ -2,15 +2,13 @@
 
 #include "Character.h"
 
-#include <3rd_party/Helpers/ImageHelper.h>
-
 using namespace Domain;
 
 
 CharacterPhoto::CharacterPhoto(
 		const Identifier& _id,
 		Character* _character,
-		const QPixmap& _photo,
+		const LazyPixmap& _photo,
 		int _sortOrder
 		) :
 	DomainObject(_id),
@@ -41,13 +39,30 @@ void CharacterPhoto::setCharacter(Character* _character, bool _onLoad)
 
 QPixmap CharacterPhoto::photo() const
 {
-	return m_photo;
+	return m_photo.pixmap();
 }
 
 void CharacterPhoto::setPhoto(const QPixmap& _photo)
 {
-	if (!ImageHelper::isImagesEqual(m_photo, _photo)) {
-		m_photo = _photo;
+	//
+	// Сжатие с потерями, поэтому сравниваем с исходным изображением, а не с заново сжатыми данными
+	//
+	if (!m_photo.isSame(_photo)) {
+		m_photo = LazyPixmap(_photo);
+
+		changesNotStored();
+	}
+}
+
+QByteArray CharacterPhoto::photoData() const
+{
+	return m_photo.data();
+}
+
+void CharacterPhoto::setPhotoData(const QByteArray& _photoData)
+{
+	if (m_photo.data() != _photoData) {
+		m_photo = LazyPixmap(_photoData);
 
 		changesNotStored();
 	}
@@ -2,8 +2,7 @@
 #define CHARACTERPHOTO_H
 
 #include "DomainObject.h"
-
-#include <QPixmap>
+#include "LazyPixmap.h"
 
 
 namespace Domain
@@ -19,7 +18,7 @@ namespace Domain
 		CharacterPhoto(
 				const Identifier& _id,
 				Character* _character,
-				const QPixmap& _photo,
+				const LazyPixmap& _photo,
 				int _sortOrder
 				);
 
@@ -29,6 +28,12 @@ namespace Domain
 		QPixmap photo() const;
 		void setPhoto(const QPixmap& _photo);
 
+		/**
+		 * @brief Сжатые данные фотографии
+		 */
+		QByteArray photoData() const;
+		void setPhotoData(const QByteArray& _photoData);
+
 		int sortOrder() const;
 		void setSortOrder(int _sortOrder);
 
@@ -40,8 +45,9 @@ namespace Domain
 
 		/**
 		 * @brief Собственно фотография
+		 * @note Декодируется при первом обращении
 		 */
-		QPixmap m_photo;
+		LazyPixmap m_photo;
 
 		/**
 		 * @brief Порядок следования фотографии
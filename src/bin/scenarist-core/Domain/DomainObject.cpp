@@ -12,13 +12,15 @@ bool DomainObject::isValid(const DomainObject* _object)
 
 DomainObject::DomainObject() :
 	m_id(Identifier()),
-	m_isChangesStored(false)
+	m_isChangesStored(false),
+	m_changesVersion(0)
 {
 }
 
 DomainObject::DomainObject(Identifier _id) :
 	m_id(_id),
-	m_isChangesStored(_id.isValid() ? true : false)
+	m_isChangesStored(_id.isValid() ? true : false),
+	m_changesVersion(0)
 {
 }
 
@@ -49,15 +51,30 @@ void DomainObject::changesStored()
 	m_isChangesStored = true;
 }
 
+void DomainObject::changesStored(int _changesVersion)
+{
+	if (m_changesVersion == _changesVersion) {
+		m_isChangesStored = true;
+	}
+}
+
+int DomainObject::changesVersion() const
+{
+	return m_changesVersion;
+}
+
 void DomainObject::changesNotStored()
 {
 	m_isChangesStored = false;
+	++m_changesVersion;
 }
 
 // ****
 
 DomainObjectsItemModel::DomainObjectsItemModel(QObject* _parent) :
-	QAbstractItemModel(_parent)
+	QAbstractItemModel(_parent),
+	m_isRowsIndexValid(true),
+	m_hasItemsWithoutId(false)
 {
 
 }
@@ -104,7 +121,20 @@ DomainObject *DomainObjectsItemModel::itemForIndex(const QModelIndex &index) con
 
 QModelIndex DomainObjectsItemModel::indexForItem(DomainObject* _item) const
 {
-	return index(domainObjects().indexOf(_item), 0, QModelIndex());
+	int row = -1;
+	if (_item != 0
+		&& _item->id().isValid()) {
+		row = rowForId(_item->id());
+	}
+
+	//
+	// Если в таблице другой объект с тем же идентификатором, ищем сам объект
+	//
+	if (row == -1
+		|| m_domainObjects.at(row) != _item) {
+		row = m_domainObjects.indexOf(_item);
+	}
+	return index(row, 0, QModelIndex());
 }
 
 QList<DomainObject*> DomainObjectsItemModel::toList() const
@@ -120,7 +150,14 @@ int DomainObjectsItemModel::size() const
 bool DomainObjectsItemModel::contains(DomainObject* domainObject) const
 {
 	//
+	// Объекты с идентификатором ищем по индексу
+	//
+	if (domainObject->id().isValid()) {
+		return rowForId(domainObject->id()) != -1;
+	}
+
 	//
+	// ... а без идентификатора перебором
 	//
 	bool contains = false;
 	foreach (DomainObject* object, domainObjects()) {
@@ -150,6 +187,9 @@ void DomainObjectsItemModel::clear(bool _removeItems)
         else {
             emit beginRemoveRows(QModelIndex(), 0, size() - 1);
             m_domainObjects.clear();
+            m_rowsById.clear();
+            m_isRowsIndexValid = true;
+            m_hasItemsWithoutId = false;
             emit endRemoveRows();
         }
     }
@@ -159,14 +199,37 @@ void DomainObjectsItemModel::append(DomainObject* domainObject)
 {
 	emit beginInsertRows(QModelIndex(), size(), size());
 	m_domainObjects.append( domainObject );
+	if (m_isRowsIndexValid) {
+		if (domainObject->id().isValid()) {
+			if (!m_rowsById.contains(domainObject->id())) {
+				m_rowsById.insert(domainObject->id(), m_domainObjects.size() - 1);
+			}
+		} else {
+			m_hasItemsWithoutId = true;
+		}
+	}
 	emit endInsertRows();
 }
 
 void DomainObjectsItemModel::remove(DomainObject* domainObject)
 {
-	const int index = m_domainObjects.indexOf(domainObject);
+	const int index = indexForItem(domainObject).row();
+	if (index == -1) {
+		return;
+	}
+
 	beginRemoveRows(QModelIndex(), index, index);
-	m_domainObjects.removeOne( domainObject );
+	m_domainObjects.removeAt(index);
+	//
+	// Номера последующих строк сдвинулись, поэтому индекс нужно перестроить
+	//
+	if (index == m_domainObjects.size()) {
+		if (m_rowsById.value(domainObject->id(), -1) == index) {
+			m_rowsById.remove(domainObject->id());
+		}
+	} else {
+		m_isRowsIndexValid = false;
+	}
 	endRemoveRows();
 }
 
@@ -180,3 +243,44 @@ QList<DomainObject*> DomainObjectsItemModel::domainObjects() const
 {
 	return m_domainObjects;
 }
+
+int DomainObjectsItemModel::rowForId(const Identifier& _id) const
+{
+	if (!m_isRowsIndexValid) {
+		rebuildRowsIndex();
+	}
+
+	int row = m_rowsById.value(_id, -1);
+
+	//
+	// Если объект не найден или идентификатор объекта в строке изменился, то индекс мог устареть
+	//
+	const bool isRowOutdated = row != -1 && m_domainObjects.at(row)->id() != _id;
+	if (isRowOutdated
+		|| (row == -1 && m_hasItemsWithoutId)) {
+		rebuildRowsIndex();
+		row = m_rowsById.value(_id, -1);
+	}
+
+	return row;
+}
+
+void DomainObjectsItemModel::rebuildRowsIndex() const
+{
+	m_rowsById.clear();
+	m_hasItemsWithoutId = false;
+	for (int row = 0; row < m_domainObjects.size(); ++row) {
+		const Identifier id = m_domainObjects.at(row)->id();
+		if (id.isValid()) {
+			//
+			// При повторах идентификатора используем первую строку, как и при переборе
+			//
+			if (!m_rowsById.contains(id)) {
+				m_rowsById.insert(id, row);
+			}
+		} else {
+			m_hasItemsWithoutId = true;
+		}
+	}
+	m_isRowsIndexValid = true;
+}
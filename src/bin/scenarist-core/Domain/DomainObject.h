@@ -47,6 +47,16 @@ namespace Domain
 		 */
 		void changesStored();
 
+		/**
+		 * @brief Изменения сохранены, если с момента получения версии изменений объект не менялся
+		 */
+		void changesStored(int _changesVersion);
+
+		/**
+		 * @brief Версия изменений объекта, увеличивается при каждом изменении
+		 */
+		int changesVersion() const;
+
 		/**
 		 * @brief Изменения не сохранены
 		 */
@@ -62,6 +72,11 @@ namespace Domain
 		 * @brief Флаг изменений объекта
 		 */
 		bool m_isChangesStored;
+
+		/**
+		 * @brief Версия изменений объекта
+		 */
+		int m_changesVersion;
 	};
 
 	//******
@@ -109,8 +124,39 @@ namespace Domain
 	protected:
 		QList<DomainObject*> domainObjects() const;
 
+	private:
+		/**
+		 * @brief Получить номер строки объекта с заданным идентификатором
+		 * @return -1, если такого объекта нет в таблице
+		 */
+		int rowForId(const Identifier& _id) const;
+
+		/**
+		 * @brief Перестроить индекс строк по идентификаторам объектов
+		 */
+		void rebuildRowsIndex() const;
+
 	private:
 		QList<DomainObject*> m_domainObjects;
+
+		/**
+		 * @brief Индекс номеров строк по идентификаторам объектов
+		 * @note Строится лениво: после удаления строк номера сдвигаются и индекс перестраивается
+		 *		 при следующем поиске
+		 */
+		mutable QHash<Identifier, int> m_rowsById;
+
+		/**
+		 * @brief Актуален ли индекс строк
+		 */
+		mutable bool m_isRowsIndexValid;
+
+		/**
+		 * @brief Есть ли в таблице объекты без идентификатора
+		 * @note Идентификатор таким объектам назначается при сохранении, поэтому индекс может
+		 *		 не содержать объект, у которого идентификатор уже есть
+		 */
+		mutable bool m_hasItemsWithoutId;
 	};
 }
 
@@ -60,8 +60,7 @@ namespace Domain
 	}
 	inline uint qHash( const Identifier &key )
 	{
-		double hash = qHash( QString( "%1.%2" ).arg( key.value() ).arg( key.version() ) );
-		return hash;
+		return ::qHash( key.value() ) ^ ( ::qHash( key.version() ) << 16 );
 	}
 }
 
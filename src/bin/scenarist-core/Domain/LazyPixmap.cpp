@@ -0,0 +1,113 @@
+#include "LazyPixmap.h"
+
+#include <3rd_party/Helpers/ImageHelper.h>
+
+#include <QCache>
+
+using Domain::LazyPixmap;
+
+namespace {
+	/**
+	 * @brief Максимальный размер кэша декодированных изображений в килобайтах
+	 */
+	const int PIXMAP_CACHE_SIZE = 64 * 1024;
+
+	/**
+	 * @brief Кэш декодированных изображений
+	 */
+	static QCache<qint64, QPixmap>& pixmapCache() {
+		static QCache<qint64, QPixmap> s_cache(PIXMAP_CACHE_SIZE);
+		return s_cache;
+	}
+
+	/**
+	 * @brief Получить новый ключ для изображения в кэше
+	 */
+	static qint64 nextCacheKey() {
+		static qint64 s_lastCacheKey = 0;
+		return ++s_lastCacheKey;
+	}
+}
+
+
+LazyPixmap::LazyPixmap() :
+	m_cacheKey(nextCacheKey()),
+	m_pixmapKey(0)
+{
+}
+
+LazyPixmap::LazyPixmap(const QByteArray& _data) :
+	m_data(_data),
+	m_cacheKey(nextCacheKey()),
+	m_pixmapKey(0)
+{
+}
+
+LazyPixmap::LazyPixmap(const QPixmap& _pixmap) :
+	m_data(_pixmap.isNull() ? QByteArray() : ImageHelper::bytesFromImage(_pixmap)),
+	m_cacheKey(nextCacheKey()),
+	m_pixmapKey(_pixmap.cacheKey())
+{
+}
+
+LazyPixmap::LazyPixmap(const LazyPixmap& _other) :
+	m_data(_other.m_data),
+	m_cacheKey(nextCacheKey()),
+	m_pixmapKey(_other.m_pixmapKey)
+{
+}
+
+LazyPixmap::~LazyPixmap()
+{
+	pixmapCache().remove(m_cacheKey);
+}
+
+LazyPixmap& LazyPixmap::operator=(const LazyPixmap& _other)
+{
+	if (this != &_other
+		&& m_data != _other.m_data) {
+		m_data = _other.m_data;
+		pixmapCache().remove(m_cacheKey);
+	}
+	m_pixmapKey = _other.m_pixmapKey;
+	return *this;
+}
+
+bool LazyPixmap::isNull() const
+{
+	return m_data.isEmpty();
+}
+
+QByteArray LazyPixmap::data() const
+{
+	return m_data;
+}
+
+QPixmap LazyPixmap::pixmap() const
+{
+	if (isNull()) {
+		return QPixmap();
+	}
+
+	if (QPixmap* cachedPixmap = pixmapCache().object(m_cacheKey)) {
+		return *cachedPixmap;
+	}
+
+	//
+	// Декодируем изображение и помещаем его в кэш, стоимость определяется объёмом памяти в килобайтах
+	//
+	const QPixmap pixmap = ImageHelper::imageFromBytes(m_data);
+	const int cost = qMax(1, pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024);
+	pixmapCache().insert(m_cacheKey, new QPixmap(pixmap), cost);
+	m_pixmapKey = pixmap.cacheKey();
+	return pixmap;
+}
+
+bool LazyPixmap::isSame(const QPixmap& _pixmap) const
+{
+	if (_pixmap.isNull()) {
+		return isNull();
+	}
+
+	return !isNull() && m_pixmapKey == _pixmap.cacheKey();
+}
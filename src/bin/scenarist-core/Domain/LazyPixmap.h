@@ -0,0 +1,66 @@
+#ifndef LAZYPIXMAP_H
+#define LAZYPIXMAP_H
+
+#include <QByteArray>
+#include <QPixmap>
+
+
+namespace Domain
+{
+	/**
+	 * @brief Изображение, которое хранится в сжатом виде и декодируется только при обращении к нему
+	 *
+	 * Декодированные изображения помещаются в общий кэш ограниченного размера, из которого
+	 * давно не использовавшиеся изображения вытесняются
+	 */
+	class LazyPixmap
+	{
+	public:
+		LazyPixmap();
+		explicit LazyPixmap(const QByteArray& _data);
+		explicit LazyPixmap(const QPixmap& _pixmap);
+		LazyPixmap(const LazyPixmap& _other);
+		~LazyPixmap();
+
+		LazyPixmap& operator=(const LazyPixmap& _other);
+
+		/**
+		 * @brief Пустое ли изображение
+		 */
+		bool isNull() const;
+
+		/**
+		 * @brief Получить сжатые данные изображения
+		 */
+		QByteArray data() const;
+
+		/**
+		 * @brief Получить декодированное изображение
+		 */
+		QPixmap pixmap() const;
+
+		/**
+		 * @brief Хранится ли заданное изображение
+		 * @note Сравнивается по ключу кэша изображения, поэтому повторно изображение не сжимается
+		 */
+		bool isSame(const QPixmap& _pixmap) const;
+
+	private:
+		/**
+		 * @brief Сжатые данные изображения
+		 */
+		QByteArray m_data;
+
+		/**
+		 * @brief Ключ декодированного изображения в кэше
+		 */
+		qint64 m_cacheKey;
+
+		/**
+		 * @brief Ключ кэша изображения, из которого получены сжатые данные, или в которое они декодированы
+		 */
+		mutable qint64 m_pixmapKey;
+	};
+}
+
+#endif // LAZYPIXMAP_H
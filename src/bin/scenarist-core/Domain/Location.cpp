@@ -80,7 +80,7 @@ void Location::setPhotos(const QList<QPixmap>& _photos)
 	m_photos->clear();
 
 	for (int index = 0; index < _photos.count(); ++index) {
-		LocationPhoto* newPhoto = new LocationPhoto(Identifier(), this, _photos.value(index), index);
+		LocationPhoto* newPhoto = new LocationPhoto(Identifier(), this, LazyPixmap(_photos.value(index)), index);
 		m_photos->append(newPhoto);
 	}
 
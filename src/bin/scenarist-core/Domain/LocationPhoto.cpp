@@ -2,15 +2,13 @@
 
 #include "Location.h"
 
-#include <3rd_party/Helpers/ImageHelper.h>
-
 using namespace Domain;
 
 
 LocationPhoto::LocationPhoto(
 		const Identifier& _id,
 		Location* _location,
-		const QPixmap& _photo,
+		const LazyPixmap& _photo,
 		int _sortOrder
 		) :
 	DomainObject(_id),
@@ -41,13 +39,30 @@ void LocationPhoto::setLocation(Location* _location, bool _onLoad)
 
 QPixmap LocationPhoto::photo() const
 {
-	return m_photo;
+	return m_photo.pixmap();
 }
 
 void LocationPhoto::setPhoto(const QPixmap& _photo)
 {
-	if (!ImageHelper::isImagesEqual(m_photo, _photo)) {
-		m_photo = _photo;
+	//
+	// Сжатие с потерями, поэтому сравниваем с исходным изображением, а не с заново сжатыми данными
+	//
+	if (!m_photo.isSame(_photo)) {
+		m_photo = LazyPixmap(_photo);
+
+		changesNotStored();
+	}
+}
+
+QByteArray LocationPhoto::photoData() const
+{
+	return m_photo.data();
+}
+
+void LocationPhoto::setPhotoData(const QByteArray& _photoData)
+{
+	if (m_photo.data() != _photoData) {
+		m_photo = LazyPixmap(_photoData);
 
 		changesNotStored();
 	}
@@ -1,19 +1,17 @@
 #include "Research.h"
 
-#include <3rd_party/Helpers/ImageHelper.h>
-
 using namespace Domain;
 
 
 Research::Research(const Identifier& _id, Research* _parent, Research::Type _type, int _sortOrder,
-	const QString& _name, const QString& _description, const QString& _url, const QPixmap& _image) :
+	const QString& _name, const QString& _description, const QString& _url, const QByteArray& _imageData) :
 	DomainObject(_id),
 	m_parent(_parent),
 	m_type(_type),
 	m_name(_name),
 	m_description(_description),
 	m_url(_url),
-	m_image(_image),
+	m_image(_imageData),
 	m_sortOrder(_sortOrder)
 {
 }
@@ -90,13 +88,30 @@ void Research::setUrl(const QString& _url)
 
 QPixmap Research::image() const
 {
-	return m_image;
+	return m_image.pixmap();
 }
 
 void Research::setImage(const QPixmap& _image)
 {
-	if (!ImageHelper::isImagesEqual(m_image, _image)) {
-		m_image = _image;
+	//
+	// Сжатие с потерями, поэтому сравниваем с исходным изображением, а не с заново сжатыми данными
+	//
+	if (!m_image.isSame(_image)) {
+		m_image = LazyPixmap(_image);
+
+		changesNotStored();
+	}
+}
+
+QByteArray Research::imageData() const
+{
+	return m_image.data();
+}
+
+void Research::setImageData(const QByteArray& _imageData)
+{
+	if (m_image.data() != _imageData) {
+		m_image = LazyPixmap(_imageData);
 
 		changesNotStored();
 	}
@@ -2,8 +2,8 @@
 #define RESEARCH_H
 
 #include "DomainObject.h"
+#include "LazyPixmap.h"
 
-#include <QPixmap>
 #include <QString>
 
 
@@ -34,7 +34,7 @@ namespace Domain
 	public:
 		Research(const Identifier& _id, Research* _parent, Type _type, int _sortOrder,
 			const QString& _name, const QString& _description = QString::null,
-			const QString& _url = QString::null, const QPixmap& _image = QPixmap());
+			const QString& _url = QString::null, const QByteArray& _imageData = QByteArray());
 
 		/**
 		 * @brief Получить родителя
@@ -96,6 +96,16 @@ namespace Domain
 		 */
 		void setImage(const QPixmap& _image);
 
+		/**
+		 * @brief Получить сжатые данные изображения
+		 */
+		QByteArray imageData() const;
+
+		/**
+		 * @brief Установить сжатые данные изображения
+		 */
+		void setImageData(const QByteArray& _imageData);
+
 		/**
 		 * @brief Получить позицию сортировки
 		 */
@@ -136,8 +146,9 @@ namespace Domain
 
 		/**
 		 * @brief Изображение
+		 * @note Декодируется при первом обращении
 		 */
-		QPixmap m_image;
+		LazyPixmap m_image;
 
 		/**
 		 * @brief Порядок сортировки
@@ -4,8 +4,8 @@ using namespace Domain;
 
 
 ScenarioChange::ScenarioChange(const Identifier& _id, const QUuid& _uuid,
-	const QDateTime& _datetime, const QString& _user, const QString& _undoPatch,
-	const QString& _redoPatch, bool _isDraft) :
+	const QDateTime& _datetime, const QString& _user, const QByteArray& _undoPatch,
+	const QByteArray& _redoPatch, bool _isDraft) :
 	DomainObject(_id),
 	m_uuid(_uuid),
 	m_datetime(_datetime),
@@ -58,12 +58,12 @@ void ScenarioChange::setUser(const QString& _user)
 	}
 }
 
-QString ScenarioChange::undoPatch() const
+QByteArray ScenarioChange::undoPatch() const
 {
 	return m_undoPatch;
 }
 
-void ScenarioChange::setUndoPatch(const QString& _patch)
+void ScenarioChange::setUndoPatch(const QByteArray& _patch)
 {
 	if (m_undoPatch != _patch) {
 		m_undoPatch = _patch;
@@ -72,12 +72,12 @@ void ScenarioChange::setUndoPatch(const QString& _patch)
 	}
 }
 
-QString ScenarioChange::redoPatch() const
+QByteArray ScenarioChange::redoPatch() const
 {
 	return m_redoPatch;
 }
 
-void ScenarioChange::setRedoPatch(const QString& _patch)
+void ScenarioChange::setRedoPatch(const QByteArray& _patch)
 {
 	if (m_redoPatch != _patch) {
 		m_redoPatch = _patch;
@@ -16,7 +16,7 @@ namespace Domain
 	{
 	public:
 		ScenarioChange(const Identifier& _id, const QUuid& _uuid, const QDateTime& _datetime,
-			const QString& _user, const QString& _undoPatch, const QString& _redoPatch, bool _isDraft);
+			const QString& _user, const QByteArray& _undoPatch, const QByteArray& _redoPatch, bool _isDraft);
 
 		/**
 		 * @brief Уникальный айди
@@ -44,18 +44,19 @@ namespace Domain
 
 		/**
 		 * @brief Патч для отмены изменения
+		 * @note Патчи хранятся сжатыми, в base64 они переводятся только для передачи по сети
 		 */
 		/** @{ */
-		QString undoPatch() const;
-		void setUndoPatch(const QString& _patch);
+		QByteArray undoPatch() const;
+		void setUndoPatch(const QByteArray& _patch);
 		/** @} */
 
 		/**
 		 * @brief Патч для повтора/наложения изменения
 		 */
 		/** @{ */
-		QString redoPatch() const;
-		void setRedoPatch(const QString& _patch);
+		QByteArray redoPatch() const;
+		void setRedoPatch(const QByteArray& _patch);
 		/** @} */
 
 		/**
@@ -85,12 +86,12 @@ namespace Domain
 		/**
 		 * @brief Патч для отмены изменения
 		 */
-		QString m_undoPatch;
+		QByteArray m_undoPatch;
 
 		/**
 		 * @brief Патч для повтора/наложения изменения
 		 */
-		QString m_redoPatch;
+		QByteArray m_redoPatch;
 
 		/**
 		 * @brief Изменение чистовика (0) или черновика (1)
@@ -0,0 +1,180 @@
+#include "ChunkedTransfer.h"
+
+#include <NetworkRequest.h>
+
+#include <QTimer>
+
+using ManagementLayer::ChunkedTransfer;
+
+
+ChunkedTransfer::ChunkedTransfer(const QUrl& _url, QObject* _parent) :
+    QObject(_parent),
+    m_url(_url)
+{
+}
+
+void ChunkedTransfer::setWindowSize(int _size)
+{
+    m_windowSize = qMax(1, _size);
+}
+
+void ChunkedTransfer::setMaxRetries(int _retries)
+{
+    m_maxRetries = qMax(0, _retries);
+}
+
+void ChunkedTransfer::setRetryDelay(int _msecs)
+{
+    m_retryDelay = qMax(0, _msecs);
+}
+
+void ChunkedTransfer::setPriority(NetworkRequest::Priority _priority)
+{
+    m_priority = _priority;
+}
+
+void ChunkedTransfer::setResponseValidator(const std::function<bool(const QByteArray&)>& _validator)
+{
+    m_responseValidator = _validator;
+}
+
+void ChunkedTransfer::addRequestAttribute(const QString& _name, const QVariant& _value)
+{
+    m_attributes.append(qMakePair(_name, _value));
+}
+
+void ChunkedTransfer::addChunk(const QString& _name, const QVariant& _value)
+{
+    Chunk chunk;
+    chunk.name = _name;
+    chunk.value = _value;
+    m_chunks.append(chunk);
+}
+
+int ChunkedTransfer::chunksCount() const
+{
+    return m_chunks.size();
+}
+
+void ChunkedTransfer::start()
+{
+    m_nextChunk = 0;
+    m_loadingChunks = 0;
+    m_transferredChunks = 0;
+    m_isFailed = false;
+    m_isFinished = false;
+
+    //
+    // Если передавать нечего, то сразу сообщаем о завершении, но уже после возврата в цикл событий
+    //
+    if (m_chunks.isEmpty()) {
+        m_isFinished = true;
+        QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+        return;
+    }
+
+    loadNextChunks();
+}
+
+bool ChunkedTransfer::isSucceed() const
+{
+    return m_isFinished && m_transferredChunks == m_chunks.size();
+}
+
+QList<QByteArray> ChunkedTransfer::responses() const
+{
+    QList<QByteArray> result;
+    foreach (const Chunk& chunk, m_chunks) {
+        if (!chunk.isTransferred) {
+            break;
+        }
+        result.append(chunk.response);
+    }
+    return result;
+}
+
+void ChunkedTransfer::loadNextChunks()
+{
+    //
+    // Новые части не отправляются, пока окно заполнено, а если одну из частей передать не удалось,
+    // то и следующие за ней уже не отправляем
+    //
+    while (!m_isFailed
+           && m_loadingChunks < m_windowSize
+           && m_nextChunk < m_chunks.size()) {
+        loadChunk(m_nextChunk++);
+    }
+}
+
+void ChunkedTransfer::loadChunk(int _index)
+{
+    ++m_loadingChunks;
+
+    NetworkRequest* loader = new NetworkRequest(this);
+    loader->setRequestMethod(NetworkRequest::Post);
+    loader->setPriority(m_priority);
+    for (int attributeIndex = 0; attributeIndex < m_attributes.size(); ++attributeIndex) {
+        const QPair<QString, QVariant>& attribute = m_attributes.at(attributeIndex);
+        loader->addRequestAttribute(attribute.first, attribute.second);
+    }
+    if (!m_chunks.at(_index).name.isEmpty()) {
+        loader->addRequestAttribute(m_chunks.at(_index).name, m_chunks.at(_index).value);
+    }
+
+    connect(loader, &NetworkRequest::downloadComplete, this, [this, _index] (const QByteArray& _response) {
+        m_chunks[_index].response = _response;
+    });
+    connect(loader, &NetworkRequest::finished, this, [this, _index] {
+        chunkLoaded(_index);
+    });
+    connect(loader, &NetworkRequest::finished, loader, &NetworkRequest::deleteLater);
+
+    loader->loadAsync(m_url);
+}
+
+void ChunkedTransfer::chunkLoaded(int _index)
+{
+    Chunk& chunk = m_chunks[_index];
+
+    //
+    // Часть передана, если сервер прислал ответ и подтвердил в нём получение части
+    //
+    const bool isResponseValid =
+            !chunk.response.isEmpty()
+            && (!m_responseValidator || m_responseValidator(chunk.response));
+    if (isResponseValid) {
+        --m_loadingChunks;
+        chunk.isTransferred = true;
+        ++m_transferredChunks;
+        emit chunkTransferred(_index);
+    }
+    //
+    // Если не удалось, пробуем ещё раз, но позже, место в окне при этом остаётся занятым.
+    // Ответ с ошибкой от сервера повторно не отправляем, он не изменится
+    //
+    else if (chunk.response.isEmpty()
+             && chunk.retries < m_maxRetries) {
+        const int delay = m_retryDelay << chunk.retries;
+        ++chunk.retries;
+        QTimer::singleShot(delay, this, [this, _index] {
+            --m_loadingChunks;
+            loadChunk(_index);
+        });
+        return;
+    }
+    //
+    // А если попытки закончились, то передача не удалась
+    //
+    else {
+        --m_loadingChunks;
+        m_isFailed = true;
+    }
+
+    loadNextChunks();
+
+    if (m_loadingChunks == 0
+        && (m_isFailed || m_nextChunk == m_chunks.size())) {
+        m_isFinished = true;
+        emit finished();
+    }
+}
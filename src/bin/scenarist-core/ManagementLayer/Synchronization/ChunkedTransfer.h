@@ -0,0 +1,209 @@
+#ifndef CHUNKEDTRANSFER_H
+#define CHUNKEDTRANSFER_H
+
+#include <NetworkRequest.h>
+
+#include <QObject>
+#include <QPair>
+#include <QUrl>
+#include <QVariant>
+#include <QVector>
+
+#include <functional>
+
+
+namespace ManagementLayer
+{
+    /**
+     * @brief Передача данных на сервер частями
+     *
+     * Каждая часть отправляется отдельным запросом, одновременно выполняется не более заданного
+     * количества запросов. Часть, которую не удалось передать, отправляется повторно с экспоненциально
+     * растущей задержкой, уже переданные части при этом повторно не отправляются
+     */
+    class ChunkedTransfer : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit ChunkedTransfer(const QUrl& _url, QObject* _parent = 0);
+
+        /**
+         * @brief Установить максимальное количество одновременно передаваемых частей
+         */
+        void setWindowSize(int _size);
+
+        /**
+         * @brief Установить количество повторных попыток передачи части
+         */
+        void setMaxRetries(int _retries);
+
+        /**
+         * @brief Установить задержку перед первой повторной попыткой, каждая следующая вдвое дольше
+         */
+        void setRetryDelay(int _msecs);
+
+        /**
+         * @brief Установить приоритет запросов в очереди загрузчика
+         */
+        void setPriority(NetworkRequest::Priority _priority);
+
+        /**
+         * @brief Установить проверку ответа сервера
+         * @note Часть считается переданной, только если сервер подтвердил её получение
+         */
+        void setResponseValidator(const std::function<bool(const QByteArray&)>& _validator);
+
+        /**
+         * @brief Добавить атрибут, общий для запросов всех частей
+         */
+        void addRequestAttribute(const QString& _name, const QVariant& _value);
+
+        /**
+         * @brief Добавить часть, передаваемую в заданном атрибуте запроса
+         * @note Для части без имени отправляется запрос только с общими атрибутами
+         */
+        void addChunk(const QString& _name, const QVariant& _value);
+
+        /**
+         * @brief Количество частей
+         */
+        int chunksCount() const;
+
+        /**
+         * @brief Начать передачу
+         */
+        void start();
+
+        /**
+         * @brief Удалось ли передать все части
+         */
+        bool isSucceed() const;
+
+        /**
+         * @brief Ответы сервера на идущие подряд с начала успешно переданные части
+         */
+        QList<QByteArray> responses() const;
+
+    signals:
+        /**
+         * @brief Часть с заданным индексом передана
+         */
+        void chunkTransferred(int _index);
+
+        /**
+         * @brief Передача завершена
+         */
+        void finished();
+
+    private:
+        /**
+         * @brief Запустить передачу следующих частей, если позволяет размер окна
+         */
+        void loadNextChunks();
+
+        /**
+         * @brief Запустить передачу части
+         */
+        void loadChunk(int _index);
+
+        /**
+         * @brief Передача части завершена
+         */
+        void chunkLoaded(int _index);
+
+    private:
+        /**
+         * @brief Часть передаваемых данных
+         */
+        struct Chunk {
+            /**
+             * @brief Атрибут запроса, в котором передаётся часть
+             */
+            QString name;
+            QVariant value;
+
+            /**
+             * @brief Ответ сервера
+             */
+            QByteArray response;
+
+            /**
+             * @brief Количество выполненных повторных попыток
+             */
+            int retries = 0;
+
+            /**
+             * @brief Передана ли часть
+             */
+            bool isTransferred = false;
+        };
+
+        /**
+         * @brief Адрес, по которому передаются данные
+         */
+        QUrl m_url;
+
+        /**
+         * @brief Атрибуты, общие для всех частей
+         */
+        QList<QPair<QString, QVariant> > m_attributes;
+
+        /**
+         * @brief Части
+         */
+        QVector<Chunk> m_chunks;
+
+        /**
+         * @brief Максимальное количество одновременно передаваемых частей
+         */
+        int m_windowSize = 1;
+
+        /**
+         * @brief Количество повторных попыток передачи части
+         */
+        int m_maxRetries = 0;
+
+        /**
+         * @brief Задержка перед первой повторной попыткой
+         */
+        int m_retryDelay = 1000;
+
+        /**
+         * @brief Приоритет запросов
+         */
+        NetworkRequest::Priority m_priority = NetworkRequest::SyncPriority;
+
+        /**
+         * @brief Проверка ответа сервера
+         */
+        std::function<bool(const QByteArray&)> m_responseValidator;
+
+        /**
+         * @brief Индекс следующей части для передачи
+         */
+        int m_nextChunk = 0;
+
+        /**
+         * @brief Количество частей, которые передаются, или ожидают повторной попытки
+         */
+        int m_loadingChunks = 0;
+
+        /**
+         * @brief Количество переданных частей
+         */
+        int m_transferredChunks = 0;
+
+        /**
+         * @brief Не удалось передать одну из частей
+         */
+        bool m_isFailed = false;
+
+        /**
+         * @brief Завершена ли передача
+         */
+        bool m_isFinished = false;
+    };
+}
+
+#endif // CHUNKEDTRANSFER_H
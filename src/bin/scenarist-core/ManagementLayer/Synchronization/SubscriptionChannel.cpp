@@ -0,0 +1,291 @@
+#include "SubscriptionChannel.h"
+
+#include <NetworkRequest.h>
+
+#include <QXmlStreamReader>
+
+using ManagementLayer::SubscriptionChannel;
+
+namespace {
+    /**
+     * @brief Адрес подписки на события проекта
+     */
+    const QUrl URL_PROJECT_SUBSCRIBE = QUrl("https://kitscenarist.ru/api/projects/subscribe/");
+
+    /**
+     * @brief Ключи для параметров запросов
+     */
+    /** @{ */
+    const QString KEY_SESSION_KEY = "session_key";
+    const QString KEY_PROJECT = "project_id";
+    const QString KEY_LAST_EVENT_ID = "last_event_id";
+    const QString KEY_WAIT_SECONDS = "wait_seconds";
+    /** @} */
+
+    /**
+     * @brief Сколько секунд сервер может удерживать запрос
+     */
+    const int WAIT_SECONDS = 25;
+
+    /**
+     * @brief Таймаут запроса подписки, должен быть больше времени удержания запроса сервером
+     */
+    const int POLL_TIMEOUT = (WAIT_SECONDS + 10) * 1000;
+
+    /**
+     * @brief Задержка перед первой повторной попыткой после ошибки связи, каждая следующая вдвое дольше
+     */
+    const int RETRY_DELAY = 1000;
+
+    /**
+     * @brief Максимальная задержка перед повторной попыткой
+     * @note Через такое же время повторяется попытка подписки, если сервер её не поддерживает
+     */
+    const int MAX_RETRY_DELAY = 5 * 60 * 1000;
+}
+
+
+SubscriptionChannel::SubscriptionChannel(QObject* _parent) :
+    QObject(_parent),
+    m_url(URL_PROJECT_SUBSCRIBE)
+{
+    m_retryTimer.setSingleShot(true);
+    connect(&m_retryTimer, &QTimer::timeout, this, &SubscriptionChannel::poll);
+}
+
+void SubscriptionChannel::setUrl(const QUrl& _url)
+{
+    m_url = _url;
+}
+
+void SubscriptionChannel::start(const QString& _sessionKey, int _projectId)
+{
+    if (m_isRunning
+        && m_sessionKey == _sessionKey
+        && m_projectId == _projectId) {
+        return;
+    }
+
+    stop();
+
+    m_sessionKey = _sessionKey;
+    m_projectId = _projectId;
+    m_isRunning = true;
+    poll();
+}
+
+void SubscriptionChannel::stop()
+{
+    if (!m_isRunning) {
+        return;
+    }
+
+    //
+    // Прерываем выполняющийся запрос, чтобы он не занимал загрузчик до ответа сервера,
+    // а если он всё же успеет завершиться, то ответ на него не будет обработан
+    //
+    ++m_generation;
+    if (!m_loader.isNull()) {
+        m_loader->stop();
+        m_loader->deleteLater();
+        m_loader.clear();
+    }
+    m_isRunning = false;
+    m_lastEventId.clear();
+    m_failures = 0;
+    m_retryTimer.stop();
+    setActive(false);
+}
+
+bool SubscriptionChannel::isRunning() const
+{
+    return m_isRunning;
+}
+
+bool SubscriptionChannel::isActive() const
+{
+    return m_isActive;
+}
+
+int SubscriptionChannel::projectId() const
+{
+    return m_projectId;
+}
+
+void SubscriptionChannel::poll()
+{
+    if (!m_isRunning) {
+        return;
+    }
+
+    m_response.clear();
+
+    NetworkRequest* loader = new NetworkRequest(this);
+    loader->setRequestMethod(NetworkRequest::Post);
+    loader->setLoadingTimeout(POLL_TIMEOUT);
+    loader->setPriority(NetworkRequest::BackgroundPriority);
+    loader->addRequestAttribute(KEY_SESSION_KEY, m_sessionKey);
+    loader->addRequestAttribute(KEY_PROJECT, m_projectId);
+    loader->addRequestAttribute(KEY_LAST_EVENT_ID, m_lastEventId);
+    loader->addRequestAttribute(KEY_WAIT_SECONDS, WAIT_SECONDS);
+
+    const int generation = m_generation;
+    connect(loader, &NetworkRequest::downloadComplete, this, [this, generation] (const QByteArray& _response) {
+        if (generation == m_generation) {
+            m_response = _response;
+        }
+    });
+    connect(loader, &NetworkRequest::finished, this, [this, generation] {
+        pollFinished(generation);
+    });
+    connect(loader, &NetworkRequest::finished, loader, &NetworkRequest::deleteLater);
+
+    m_loader = loader;
+    loader->loadAsync(m_url);
+}
+
+void SubscriptionChannel::pollFinished(int _generation)
+{
+    if (_generation != m_generation
+        || !m_isRunning) {
+        return;
+    }
+
+    const PollResult result = processResponse(m_response);
+    m_response.clear();
+
+    //
+    // Обработчики событий могли остановить канал
+    //
+    if (_generation != m_generation) {
+        return;
+    }
+
+    switch (result) {
+        //
+        // Если события получены, сразу же ждём следующих
+        //
+        case EventsReceived: {
+            m_failures = 0;
+            setActive(true);
+            m_retryTimer.start(0);
+            break;
+        }
+
+        //
+        // Если сервер не поддерживает подписку, то синхронизация будет работать опросом,
+        // а подписаться попробуем не скоро
+        //
+        case SubscriptionRejected: {
+            m_failures = 0;
+            setActive(false);
+            m_retryTimer.start(MAX_RETRY_DELAY);
+            break;
+        }
+
+        //
+        // А если нарушена связь, то повторяем попытки со всё большей задержкой
+        //
+        case ConnectionFailed: {
+            setActive(false);
+            const int MAX_DELAY_SHIFT = 16;
+            m_retryTimer.start(qMin(RETRY_DELAY << qMin(m_failures, MAX_DELAY_SHIFT), MAX_RETRY_DELAY));
+            ++m_failures;
+            break;
+        }
+    }
+}
+
+SubscriptionChannel::PollResult SubscriptionChannel::processResponse(const QByteArray& _response)
+{
+    if (_response.isEmpty()) {
+        return ConnectionFailed;
+    }
+
+    QXmlStreamReader eventsReader(_response);
+
+    //
+    // Проверяем статус операции, ошибки подписки не должны закрывать сессию, поэтому
+    // не обрабатываются как ошибки синхронизации
+    //
+    bool hasStatus = false;
+    while (!eventsReader.atEnd()) {
+        eventsReader.readNext();
+        if (eventsReader.name() == "status") {
+            hasStatus = true;
+            if (eventsReader.attributes().value("result").toString() != "true") {
+                return SubscriptionRejected;
+            }
+            break;
+        }
+    }
+    if (!hasStatus) {
+        return ConnectionFailed;
+    }
+
+    //
+    // Считываем события
+    //
+    QList<QString> scenarioChanges;
+    QList<QString> dataChanges;
+    QMap<QString, int> cleanCursors;
+    QMap<QString, int> draftCursors;
+    bool hasCursors = false;
+    while (!eventsReader.atEnd()) {
+        if (!eventsReader.readNextStartElement()) {
+            continue;
+        }
+
+        if (eventsReader.name() == "events") {
+            const QString lastEventId = eventsReader.attributes().value("last_event_id").toString();
+            if (!lastEventId.isEmpty()) {
+                m_lastEventId = lastEventId;
+            }
+        } else if (eventsReader.name() == "change") {
+            const QString changeUuid = eventsReader.attributes().value("id").toString();
+            if (!changeUuid.isEmpty()) {
+                scenarioChanges.append(changeUuid);
+            }
+        } else if (eventsReader.name() == "data") {
+            const QString changeUuid = eventsReader.attributes().value("id").toString();
+            if (!changeUuid.isEmpty()) {
+                dataChanges.append(changeUuid);
+            }
+        } else if (eventsReader.name() == "cursors") {
+            hasCursors = true;
+        } else if (eventsReader.name() == "cursor") {
+            const QString username = eventsReader.attributes().value("username").toString();
+            const int cursorPosition = eventsReader.attributes().value("position").toInt();
+            const bool isDraft = eventsReader.attributes().value("is_draft").toInt();
+
+            QMap<QString, int>& cursors = isDraft ? draftCursors : cleanCursors;
+            cursors.insert(username, cursorPosition);
+        }
+    }
+
+    //
+    // Уведомляем о событиях
+    //
+    if (!scenarioChanges.isEmpty()) {
+        emit scenarioChangesAvailable(scenarioChanges);
+    }
+    if (!dataChanges.isEmpty()) {
+        emit dataChangesAvailable(dataChanges);
+    }
+    if (hasCursors) {
+        const bool IS_CLEAN = false;
+        const bool IS_DRAFT = true;
+        emit cursorsUpdated(cleanCursors, IS_CLEAN);
+        emit cursorsUpdated(draftCursors, IS_DRAFT);
+    }
+
+    return EventsReceived;
+}
+
+void SubscriptionChannel::setActive(bool _isActive)
+{
+    if (m_isActive != _isActive) {
+        m_isActive = _isActive;
+        emit activeChanged(m_isActive);
+    }
+}
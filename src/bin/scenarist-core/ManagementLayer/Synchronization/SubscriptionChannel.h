@@ -0,0 +1,171 @@
+#ifndef SUBSCRIPTIONCHANNEL_H
+#define SUBSCRIPTIONCHANNEL_H
+
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QUrl>
+
+class NetworkRequest;
+
+
+namespace ManagementLayer
+{
+    /**
+     * @brief Канал подписки на события проекта
+     *
+     * Сервер удерживает запрос, пока в проекте не появятся новые изменения сценария, данных,
+     * или не сместятся курсоры соавторов, и сразу после ответа запрос отправляется снова.
+     * Если сервер не поддерживает подписку, или связь нарушена, канал становится неактивным,
+     * синхронизация при этом продолжает работать опросом, а подписка возобновляется позже
+     */
+    class SubscriptionChannel : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit SubscriptionChannel(QObject* _parent = 0);
+
+        /**
+         * @brief Задать адрес подписки
+         * @note Используется для работы с локальным сервером, по умолчанию подписка идёт на основной
+         */
+        void setUrl(const QUrl& _url);
+
+        /**
+         * @brief Подписаться на события заданного проекта
+         * @note Если канал уже подписан на этот проект в той же сессии, то ничего не происходит
+         */
+        void start(const QString& _sessionKey, int _projectId);
+
+        /**
+         * @brief Прекратить подписку
+         */
+        void stop();
+
+        /**
+         * @brief Запущен ли канал
+         */
+        bool isRunning() const;
+
+        /**
+         * @brief Активен ли канал, т.е. доставляет ли сервер события по подписке
+         */
+        bool isActive() const;
+
+        /**
+         * @brief Проект, на события которого оформлена подписка
+         */
+        int projectId() const;
+
+    signals:
+        /**
+         * @brief Изменилась активность канала
+         */
+        void activeChanged(bool _isActive);
+
+        /**
+         * @brief На сервере появились новые изменения сценария
+         */
+        void scenarioChangesAvailable(const QList<QString>& _changesUuids);
+
+        /**
+         * @brief На сервере появились новые изменения данных
+         */
+        void dataChangesAvailable(const QList<QString>& _changesUuids);
+
+        /**
+         * @brief Получены новые позиции курсоров соавторов
+         */
+        void cursorsUpdated(const QMap<QString, int>& _cursors, bool _isDraft);
+
+    private:
+        /**
+         * @brief Отправить запрос подписки
+         */
+        void poll();
+
+        /**
+         * @brief Результат запроса подписки
+         */
+        enum PollResult {
+            EventsReceived,
+            ConnectionFailed,
+            SubscriptionRejected
+        };
+
+        /**
+         * @brief Обработать ответ сервера
+         */
+        PollResult processResponse(const QByteArray& _response);
+
+        /**
+         * @brief Запрос подписки завершён
+         */
+        void pollFinished(int _generation);
+
+        /**
+         * @brief Установить активность канала
+         */
+        void setActive(bool _isActive);
+
+    private:
+        /**
+         * @brief Адрес подписки
+         */
+        QUrl m_url;
+
+        /**
+         * @brief Ключ сессии
+         */
+        QString m_sessionKey;
+
+        /**
+         * @brief Проект, на события которого оформлена подписка
+         */
+        int m_projectId = 0;
+
+        /**
+         * @brief Идентификатор последнего полученного события
+         */
+        QString m_lastEventId;
+
+        /**
+         * @brief Запущен ли канал
+         */
+        bool m_isRunning = false;
+
+        /**
+         * @brief Активен ли канал
+         */
+        bool m_isActive = false;
+
+        /**
+         * @brief Номер запуска канала, ответы на запросы предыдущих запусков игнорируются
+         */
+        int m_generation = 0;
+
+        /**
+         * @brief Выполняемый запрос подписки
+         */
+        QPointer<NetworkRequest> m_loader;
+
+        /**
+         * @brief Ответ на выполняемый запрос
+         */
+        QByteArray m_response;
+
+        /**
+         * @brief Количество неудачных запросов подряд
+         */
+        int m_failures = 0;
+
+        /**
+         * @brief Таймер повторной попытки подписки
+         */
+        QTimer m_retryTimer;
+    };
+}
+
+#endif // SUBSCRIPTIONCHANNEL_H
@@ -15,6 +15,7 @@
 */
 
 #include "SynchronizationManager.h"
+#include "ChunkedTransfer.h"
 #include "Sync.h"
 
 #include <DataLayer/DataStorageLayer/StorageFacade.h>
@@ -35,6 +36,8 @@
 
 using ManagementLayer::SynchronizationManager;
 using ManagementLayer::Sync;
+using ManagementLayer::ChunkedTransfer;
+using ManagementLayer::SubscriptionChannel;
 using DataStorageLayer::StorageFacade;
 using DataStorageLayer::SettingsStorage;
 
@@ -52,6 +55,7 @@ using DataStorageLayer::SettingsStorage;
 #include <DataLayer/DataStorageLayer/ScenarioStorage.h>
 
 #include <DataLayer/Database/Database.h>
+#include <DataLayer/Database/DatabaseHelper.h>
 
 #include <Domain/Scenario.h>
 #include <Domain/ScenarioChange.h>
@@ -63,12 +67,14 @@ using DataStorageLayer::SettingsStorage;
 
 #include <QEventLoop>
 #include <QHash>
-#include <QScopedPointer>
+#include <QSet>
 #include <QTimer>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
+#include <QtConcurrentRun>
 
 using ManagementLayer::ProjectsManager;
+using DatabaseLayer::DatabaseHelper;
 
 namespace {
     /**
@@ -163,6 +169,16 @@ namespace {
     const bool IS_ASYNC = true;
     const bool IS_SYNC = false;
 
+    /**
+     * @brief Количество повторных попыток передачи части данных
+     */
+    const int TRANSFER_MAX_RETRIES = 3;
+
+    /**
+     * @brief Задержка перед первой повторной попыткой передачи части данных в миллисекундах
+     */
+    const int TRANSFER_RETRY_DELAY = 1000;
+
     /**
      * @brief Код ошибки означающий работу в автономном режиме
      */
@@ -177,6 +193,101 @@ namespace {
     {
         return QDateTime::fromString(_date, "yyyy-MM-dd hh:mm:ss").toString("dd.MM.yyyy");
     }
+
+    /**
+     * @brief Считать изменения из ответа сервера
+     * @note Статус операции должен быть проверен заранее, функция не обращается к данным
+     *       приложения, поэтому может выполняться в отдельном потоке
+     */
+    QList<QHash<QString, QString> > readChanges(const QByteArray& _response)
+    {
+        QList<QHash<QString, QString> > changes;
+
+        QXmlStreamReader changesReader(_response);
+        //
+        // ... пропускаем всё до статуса операции
+        //
+        while (!changesReader.atEnd()) {
+            changesReader.readNext();
+            if (changesReader.name() == "status") {
+                break;
+            }
+        }
+
+        //
+        // ... считываем данные об изменениях
+        //
+        changesReader.readNextStartElement();
+        while (!changesReader.atEnd()
+               && changesReader.readNextStartElement()) {
+            //
+            // Изменения
+            //
+            while (changesReader.name() == "changes"
+                   && changesReader.readNextStartElement()) {
+                //
+                // Считываем каждое изменение
+                //
+                while (changesReader.name() == "change"
+                       && changesReader.readNextStartElement()) {
+                    //
+                    // Данные изменения
+                    //
+                    QHash<QString, QString> change;
+                    while (changesReader.name() != "change") {
+                        const QString key = changesReader.name().toString();
+                        const QString value = changesReader.readElementText();
+                        if (!value.isEmpty()) {
+                            change.insert(key, value);
+                        }
+
+                        //
+                        // ... переходим к следующему элементу
+                        //
+                        changesReader.readNextStartElement();
+                    }
+
+                    if (!change.isEmpty()) {
+                        changes.append(change);
+                    }
+                }
+            }
+        }
+
+        return changes;
+    }
+
+    /**
+     * @brief Считать изменения из нескольких ответов сервера
+     */
+    QList<QHash<QString, QString> > readAllChanges(const QList<QByteArray>& _responses)
+    {
+        QList<QHash<QString, QString> > changes;
+        foreach (const QByteArray& response, _responses) {
+            changes.append(readChanges(response));
+        }
+        return changes;
+    }
+
+    /**
+     * @brief Сохранить в БД и применить изменения данных
+     */
+    void storeAndApplyDataChanges(const QList<QHash<QString, QString> >& _changes)
+    {
+        QHash<QString, QString> changeValues;
+        DatabaseLayer::Database::transaction();
+        foreach (changeValues, _changes) {
+            DataStorageLayer::StorageFacade::databaseHistoryStorage()->storeAndApplyHistoryRecord(
+                changeValues.value(DBH_ID_KEY), changeValues.value(DBH_QUERY_KEY),
+                changeValues.value(DBH_QUERY_VALUES_KEY), changeValues.value(DBH_USERNAME_KEY), changeValues.value(DBH_DATETIME_KEY));
+        }
+        DatabaseLayer::Database::commit();
+
+        //
+        // Обновляем данные
+        //
+        DataStorageLayer::StorageFacade::refreshStorages();
+    }
 }
 
 SynchronizationManager::SynchronizationManager(QObject* _parent, QWidget* _parentView) :
@@ -197,6 +308,11 @@ bool SynchronizationManager::isLogged() const
     return !m_sessionKey.isEmpty();
 }
 
+bool SynchronizationManager::isFullSyncRunning() const
+{
+    return m_isFullSyncScenarioRequested || m_isFullSyncDataRequested || m_isFullSync;
+}
+
 bool SynchronizationManager::isSubscriptionActive() const
 {
     return m_isSubscriptionActive;
@@ -529,6 +645,7 @@ void SynchronizationManager::logout()
 
     m_sessionKey.clear();
     m_userEmail.clear();
+    m_subscriptionChannel.stop();
 
     //
     // Удаляем сохраненные значения, если они были
@@ -886,856 +1003,1070 @@ void SynchronizationManager::aboutFullSyncScenario()
 {
     if (isCanSync()) {
         //
-        // Запоминаем время синхронизации изменений сценария, в дальнейшем будем отправлять
-        // изменения произведённые с данного момента
-        //
-        m_lastChangesSyncDatetime = QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss");
-
-        //
-        // Получить список патчей проекта
-        //
-        NetworkRequest loader;
-        loader.setRequestMethod(NetworkRequest::Post);
-        loader.clearRequestAttributes();
-        loader.addRequestAttribute(KEY_SESSION_KEY, m_sessionKey);
-        loader.addRequestAttribute(KEY_PROJECT, ProjectsManager::currentProject().id());
-        QByteArray response = loader.loadSync(URL_SCENARIO_CHANGE_LIST);
-
-
-        QXmlStreamReader changesReader(response);
-        if (!isOperationSucceed(changesReader)) {
-            return;
-        }
-
-
+        // Если синхронизация уже выполняется, то полная синхронизация начнётся после её завершения
         //
-        // ... считываем изменения (uuid)
-        //
-        QList<QString> remoteChanges;
-        while (!changesReader.atEnd()) {
-            changesReader.readNextStartElement();
-            if (changesReader.name() == "change") {
-                const QString changeUuid = changesReader.attributes().value("id").toString();
-                if (!changeUuid.isEmpty()) {
-                    remoteChanges.append(changeUuid);
-                }
-            }
-        }
+        m_isFullSyncScenarioRequested = true;
+        continueWorkSync();
+    }
+}
 
+void SynchronizationManager::aboutWorkSyncScenario()
+{
+    updateSubscription();
 
+    if (isCanSync()) {
         //
-        // Сформируем список изменений сценария хранящихся локально
+        // Если синхронизация уже выполняется, то сценарий будет синхронизирован после её завершения
         //
-        QList<QString> localChanges = StorageFacade::scenarioChangeStorage()->uuids();
-
+        m_isWorkSyncScenarioRequested = true;
+        continueWorkSync();
+    }
+}
 
+void SynchronizationManager::aboutFullSyncData()
+{
+    if (isCanSync()) {
         //
-        // Отправить на сайт все изменения, которых там нет
+        // Если синхронизация уже выполняется, то полная синхронизация начнётся после её завершения
         //
-        {
-            QList<QString> changesForUpload;
-            foreach (const QString& changeUuid, localChanges) {
-                //
-                // ... отправлять нужно, если такого изменения нет на сайте
-                //
-                const bool needUpload = !remoteChanges.contains(changeUuid);
-
-                if (needUpload) {
-                    changesForUpload.append(changeUuid);
-                }
-            }
-            //
-            // ... отправляем
-            //
-            uploadScenarioChanges(changesForUpload);
-        }
+        m_isFullSyncDataRequested = true;
+        continueWorkSync();
+    }
+}
 
+void SynchronizationManager::aboutWorkSyncData()
+{
+    if (isCanSync()) {
         //
-        // Скачать все изменения, которых ещё нет
+        // Если синхронизация уже выполняется, то данные будут синхронизированы после её завершения
         //
-        {
-            QStringList changesForDownload;
-            foreach (const QString& changeUuid, remoteChanges) {
-                //
-                // ... сохранять нужно, если такого изменения нет в локальной БД
-                //
-                const bool needDownload = !localChanges.contains(changeUuid);
-
-                if (needDownload) {
-                    changesForDownload.append(changeUuid);
-                }
-            }
-            //
-            // ... скачиваем
-            //
-            const QList<QHash<QString, QString> > changes =
-                    downloadScenarioChanges(changesForDownload.join(";"));
-            //
-            // ... применять будет пачками
-            //
-            QList<QString> cleanPatches;
-            QList<QString> draftPatches;
-            QHash<QString, QString> change;
-            foreach (change, changes) {
-                if (!change.isEmpty()) {
-                    //
-                    // ... добавляем
-                    //
-                    auto* addedChange =
-                            DataStorageLayer::StorageFacade::scenarioChangeStorage()->append(
-                                change.value(SCENARIO_CHANGE_ID), change.value(SCENARIO_CHANGE_DATETIME),
-                                change.value(SCENARIO_CHANGE_USERNAME), change.value(SCENARIO_CHANGE_UNDO_PATCH),
-                                change.value(SCENARIO_CHANGE_REDO_PATCH), change.value(SCENARIO_CHANGE_IS_DRAFT).toInt());
-                    if (addedChange != nullptr) {
-                        if (change.value(SCENARIO_CHANGE_IS_DRAFT).toInt()) {
-                            draftPatches.append(change.value(SCENARIO_CHANGE_REDO_PATCH));
-                        } else {
-                            cleanPatches.append(change.value(SCENARIO_CHANGE_REDO_PATCH));
-                        }
-                    }
-                }
-            }
-            //
-            // ... применяем
-            //
-            if (!cleanPatches.isEmpty()) {
-                emit applyPatchesRequested(cleanPatches, IS_CLEAN);
-            }
-            if (!draftPatches.isEmpty()) {
-                emit applyPatchesRequested(draftPatches, IS_DRAFT);
-            }
-
-            //
-            // ... сохраняем
-            //
-            DataStorageLayer::StorageFacade::scenarioChangeStorage()->store();
-        }
+        m_isWorkSyncDataRequested = true;
+        continueWorkSync();
     }
 }
 
-void SynchronizationManager::aboutWorkSyncScenario()
+void SynchronizationManager::aboutUpdateCursors(int _cursorPosition, bool _isDraft)
 {
     if (isCanSync()) {
         //
-        // Защитимся от множественных выховов
+        // Если предыдущий запрос ещё не выполнен, отправим только последнюю позицию курсора
+        // после его завершения
         //
-        static bool s_isInWorkSync = false;
-        if (s_isInWorkSync) {
+        if (m_isCursorsLoading) {
+            m_pendingCursorPosition = _cursorPosition;
+            m_isPendingCursorInDraft = _isDraft;
             return;
         }
 
-        s_isInWorkSync = true;
-
         //
-        // Отправляем новые изменения
+        // Если курсоры соавторов приходят по подписке, то отправляем только изменившуюся позицию своего
         //
-        {
-            //
-            // Запоминаем время синхронизации изменений сценария
-            //
-            const QString prevChangesSyncDatetime = m_lastChangesSyncDatetime;
-            m_lastChangesSyncDatetime = QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss");
+        if (m_subscriptionChannel.isActive()
+            && m_lastSentCursorPosition == _cursorPosition
+            && m_isLastSentCursorInDraft == _isDraft) {
+            return;
+        }
 
-            //
-            // Отправляем
-            //
-            QList<QString> newChanges =
-                    StorageFacade::scenarioChangeStorage()->newUuids(prevChangesSyncDatetime);
-            const bool changesUploaded = uploadScenarioChanges(newChanges);
+        loadCursors(_cursorPosition, _isDraft);
+    }
+}
 
-            //
-            // Не обновляем время последней синхронизации, если изменения не были отправлены
-            //
-            if (changesUploaded == false) {
-                m_lastChangesSyncDatetime = prevChangesSyncDatetime;
-            }
-        }
+void SynchronizationManager::restartSession()
+{
+    //
+    // Переавторизуемся
+    //
+    autoLogin();
 
-        //
-        // Загружаем и применяем изменения от других пользователей за последние LAST_MINUTES минут
-        //
-        {
-            const int LAST_MINUTES = 2;
-
-            NetworkRequest loader;
-            loader.setRequestMethod(NetworkRequest::Post);
-            loader.clearRequestAttributes();
-            loader.addRequestAttribute(KEY_SESSION_KEY, m_sessionKey);
-            loader.addRequestAttribute(KEY_PROJECT, ProjectsManager::currentProject().id());
-            loader.addRequestAttribute(KEY_FROM_LAST_MINUTES, LAST_MINUTES);
-            QByteArray response = loader.loadSync(URL_SCENARIO_CHANGE_LIST);
-
-            QXmlStreamReader changesReader(response);
-            if (!isOperationSucceed(changesReader)) {
-                return;
-            }
+    //
+    // А если текущий проект - удаленный, то синхронизуем и его
+    //
+    if (ProjectsManager::currentProject().isRemote()) {
+        aboutFullSyncScenario();
+        aboutFullSyncData();
+    }
+}
 
+bool SynchronizationManager::isOperationSucceed(QXmlStreamReader& _responseReader)
+{
+    while (!_responseReader.atEnd()) {
+        _responseReader.readNext();
+        if (_responseReader.name().toString() == "status") {
             //
-            // ... считываем uuid'ы новых изменений
+            // Операция успешна
             //
-            QList<QString> remoteChanges;
-            while (!changesReader.atEnd()) {
-                changesReader.readNextStartElement();
-                if (changesReader.name() == "change") {
-                    const QString changeUuid = changesReader.attributes().value("id").toString();
-                    if (!changeUuid.isEmpty()) {
-                        remoteChanges.append(changeUuid);
-                    }
+            if (_responseReader.attributes().value("result").toString() == "true") {
+                return true;
+            } else {
+                //
+                // Попытаемся извлечь код ошибки
+                //
+                int errorCode = Sync::UnknownError;
+                if (_responseReader.attributes().hasAttribute("errorCode")) {
+                    errorCode = _responseReader.attributes().value("errorCode").toInt();
                 }
-            }
 
-            //
-            // ... скачиваем все изменения, которых ещё нет
-            //
-            QStringList changesForDownload;
-            foreach (const QString& changeUuid, remoteChanges) {
                 //
-                // ... сохранять нужно, если такого изменения нет
+                // Попытаемся извлечь текст ошибки
                 //
-                const bool needDownload =
-                        !DataStorageLayer::StorageFacade::scenarioChangeStorage()->contains(changeUuid);
-
-                if (needDownload) {
-                    changesForDownload.append(changeUuid);
-                }
-            }
-            //
-            // ... скачиваем
-            //
-            const QList<QHash<QString, QString> > changes = downloadScenarioChanges(changesForDownload.join(";"));
-            QHash<QString, QString> change;
-            foreach (change, changes) {
-                if (!change.isEmpty()) {
-                    //
-                    // ... сохраняем
-                    //
-                    auto* addedChange =
-                            StorageFacade::scenarioChangeStorage()->append(
-                                change.value(SCENARIO_CHANGE_ID), change.value(SCENARIO_CHANGE_DATETIME),
-                                change.value(SCENARIO_CHANGE_USERNAME), change.value(SCENARIO_CHANGE_UNDO_PATCH),
-                                change.value(SCENARIO_CHANGE_REDO_PATCH), change.value(SCENARIO_CHANGE_IS_DRAFT).toInt());
-                    if (addedChange != nullptr) {
-                        //
-                        // ... применяем
-                        //
-//                        qDebug() << "!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!";
-//                        qDebug() << change.value(SCENARIO_CHANGE_ID);
-                        emit applyPatchRequested(change.value(SCENARIO_CHANGE_REDO_PATCH),
-                                                 change.value(SCENARIO_CHANGE_IS_DRAFT).toInt());
-                    }
+                QString errorText = Sync::errorText(errorCode);
+                if (_responseReader.attributes().hasAttribute("error")) {
+                    errorText = _responseReader.attributes().value("error").toString();
                 }
+
+                //
+                // Скажем про ошибку
+                //
+                handleError(errorText, errorCode);
+                return false;
             }
         }
-
-        s_isInWorkSync = false;
     }
+    //
+    // Ничего не нашли про статус. Скорее всего пропал интернет
+    //
+    handleError(Sync::NetworkError);
+    //
+    // Не нужно устанавливать статус интернета здесь. Иначе, при смене не испустится сигнал
+    //
+
+    return false;
 }
 
-void SynchronizationManager::aboutFullSyncData()
+void SynchronizationManager::handleError(int _code)
 {
-    if (isCanSync()) {
-        //
-        // Запоминаем время синхронизации данных, в дальнейшем будем отправлять изменения
-        // произведённые с данного момента
-        //
-        m_lastDataSyncDatetime = QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss");
+    handleError(Sync::errorText(_code), _code);
+}
 
-        //
-        // Получить список всех изменений данных на сервере
-        //
-        NetworkRequest loader;
-        loader.setRequestMethod(NetworkRequest::Post);
-        loader.addRequestAttribute(KEY_SESSION_KEY, m_sessionKey);
-        loader.addRequestAttribute(KEY_PROJECT, ProjectsManager::currentProject().id());
-        QByteArray response = loader.loadSync(URL_SCENARIO_DATA_LIST);
-
-        QXmlStreamReader changesReader(response);
-        if (!isOperationSucceed(changesReader)) {
-            return;
+void SynchronizationManager::handleError(const QString &_error, int _code)
+{
+    switch (_code) {
+        case Sync::NetworkError:
+        case Sync::NoSessionKeyError:
+        case Sync::SessionClosedError:
+        case Sync::UnknownError: {
+            m_sessionKey = ::INCORRECT_SESSION_KEY;
+            m_subscriptionChannel.stop();
+            emit cursorsUpdated(QMap<QString, int>());
+            emit cursorsUpdated(QMap<QString, int>(), IS_DRAFT);
+            break;
         }
 
-        //
-        // ... считываем изменения (uuid)
-        //
-        QList<QString> remoteChanges;
-        changesReader.readNextStartElement();
-        changesReader.readNextStartElement(); // changes
-        while (!changesReader.atEnd()) {
-            changesReader.readNextStartElement();
-            if (changesReader.name() == "change") {
-                const QString changeUuid = changesReader.attributes().value("id").toString();
-                if (!changeUuid.isEmpty()) {
-                    remoteChanges.append(changeUuid);
-                }
-            }
-        }
-
-        //
-        // Сформируем список изменений сценария хранящихся локально
-        //
-        QList<QString> localChanges = StorageFacade::databaseHistoryStorage()->history(QString::null);
-
-        //
-        // Отправить на сайт все версии, которых на сайте нет
-        //
-        {
-            QList<QString> changesForUpload;
-            foreach (const QString& changeUuid, localChanges) {
-                //
-                // ... отправлять нужно, если такого изменения нет на сайте
-                //
-                const bool needUpload = !remoteChanges.contains(changeUuid);
-
-                if (needUpload) {
-                    changesForUpload.append(changeUuid);
-                }
-            }
-            //
-            // ... отправляем
-            //
-            uploadScenarioData(changesForUpload);
-        }
-
-
-        //
-        // Сохранить в локальной БД все изменения, которых в ней нет
-        //
-        {
-            QStringList changesForDownloadAndSave;
-            foreach (const QString& changeUuid, remoteChanges) {
-                //
-                // ... сохранять нужно, если такого изменения нет в локальной БД
-                //
-                bool needSave = !localChanges.contains(changeUuid);
-
-                if (needSave) {
-                    changesForDownloadAndSave.append(changeUuid);
-                }
-            }
-            //
-            // ... скачиваем и сохраняем
-            //
-            downloadAndSaveScenarioData(changesForDownloadAndSave.join(";"));
-        }
+        default: break;
     }
+
+    emit syncClosedWithError(_code, _error);
 }
 
-void SynchronizationManager::aboutWorkSyncData()
+bool SynchronizationManager::isCanSync() const
 {
-    static bool s_inWorkSyncData = false;
-    if (isCanSync() && !s_inWorkSyncData) {
-        s_inWorkSyncData = true;
+    return
+            m_isInternetConnectionActive
+            && ProjectsManager::currentProject().isRemote()
+            && ProjectsManager::currentProject().isSyncAvailable()
+            && !m_sessionKey.isEmpty()
+            && m_sessionKey != INCORRECT_SESSION_KEY;
+}
 
-        //
-        // Отправляем новые изменения
-        //
-        {
-            //
-            // Запоминаем время синхронизации изменений данных сценария
-            //
-            const QString prevDataSyncDatetime = m_lastDataSyncDatetime;
-            m_lastDataSyncDatetime = QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss");
+QString SynchronizationManager::scenarioChangesXml(const QList<QString>& _changesUuids) const
+{
+    QString changesXml;
+    QXmlStreamWriter xmlWriter(&changesXml);
+    xmlWriter.writeStartDocument();
+    xmlWriter.writeStartElement("changes");
+    //
+    // ... изменения вместе с патчами загружаем пачками, а не по одному
+    //
+    const int CHANGES_IN_PACKAGE = 100;
+    for (int changeIndex = 0; changeIndex < _changesUuids.size(); changeIndex += CHANGES_IN_PACKAGE) {
+        const QList<ScenarioChange> changes =
+                StorageFacade::scenarioChangeStorage()->changes(_changesUuids.mid(changeIndex, CHANGES_IN_PACKAGE));
+        foreach (const ScenarioChange& change, changes) {
+            xmlWriter.writeStartElement("change");
 
-            //
-            // Отправляем
-            //
-            QList<QString> newChanges =
-                    StorageFacade::databaseHistoryStorage()->history(prevDataSyncDatetime);
-            const bool dataUploaded = uploadScenarioData(newChanges);
+            xmlWriter.writeTextElement(SCENARIO_CHANGE_ID, change.uuid().toString());
 
-            //
-            // Не обновляем время последней синхронизации, если данные не были отправлены
-            //
-            if (dataUploaded == false) {
-                m_lastDataSyncDatetime = prevDataSyncDatetime;
-            }
-        }
+            xmlWriter.writeTextElement(SCENARIO_CHANGE_DATETIME, change.datetime().toString("yyyy-MM-dd hh:mm:ss"));
 
-        //
-        // Загружаем и применяем изменения от других пользователей за последние LAST_MINUTES минут
-        //
-        {
-            const int LAST_MINUTES = 2;
-
-            NetworkRequest loader;
-            loader.setRequestMethod(NetworkRequest::Post);
-            loader.clearRequestAttributes();
-            loader.addRequestAttribute(KEY_SESSION_KEY, m_sessionKey);
-            loader.addRequestAttribute(KEY_PROJECT, ProjectsManager::currentProject().id());
-            loader.addRequestAttribute(KEY_FROM_LAST_MINUTES, LAST_MINUTES);
-            QByteArray response = loader.loadSync(URL_SCENARIO_DATA_LIST);
-
-            QXmlStreamReader changesReader(response);
-            if (!isOperationSucceed(changesReader)) {
-                s_inWorkSyncData = false;
-                return;
-            }
+            xmlWriter.writeStartElement(SCENARIO_CHANGE_UNDO_PATCH);
+            xmlWriter.writeCDATA(DatabaseHelper::compressedToBase64(change.undoPatch()));
+            xmlWriter.writeEndElement();
 
-            //
-            // ... считываем uuid'ы новых изменений
-            //
-            QList<QString> remoteChanges;
-            while (!changesReader.atEnd()) {
-                changesReader.readNextStartElement();
-                if (changesReader.name() == "change") {
-                    const QString changeUuid = changesReader.attributes().value("id").toString();
-                    if (!changeUuid.isEmpty()) {
-                        remoteChanges.append(changeUuid);
-                    }
-                }
-            }
+            xmlWriter.writeStartElement(SCENARIO_CHANGE_REDO_PATCH);
+            xmlWriter.writeCDATA(DatabaseHelper::compressedToBase64(change.redoPatch()));
+            xmlWriter.writeEndElement();
 
-            //
-            // ... скачиваем все изменения, которых ещё нет
-            //
-            QStringList changesForDownload;
-            foreach (const QString& changeUuid, remoteChanges) {
-                //
-                // ... сохранять нужно, если такого изменения нет
-                //
-                const bool needDownload =
-                        !DataStorageLayer::StorageFacade::databaseHistoryStorage()->contains(changeUuid);
+            xmlWriter.writeTextElement(SCENARIO_CHANGE_IS_DRAFT, change.isDraft() ? "1" : "0");
 
-                if (needDownload) {
-                    changesForDownload.append(changeUuid);
-                }
-            }
-            //
-            // ... скачиваем и сохраняем
-            //
-            downloadAndSaveScenarioData(changesForDownload.join(";"));
+            xmlWriter.writeEndElement(); // change
         }
-
-        s_inWorkSyncData = false;
     }
+    xmlWriter.writeEndElement(); // changes
+    xmlWriter.writeEndDocument();
+
+    return changesXml;
 }
 
-void SynchronizationManager::aboutUpdateCursors(int _cursorPosition, bool _isDraft)
+QString SynchronizationManager::scenarioDataXml(const QList<QString>& _dataUuids, int _firstOrder) const
 {
-    if (isCanSync()) {
+    QString dataChangesXml;
+    QXmlStreamWriter xmlWriter(&dataChangesXml);
+    xmlWriter.writeStartDocument();
+    xmlWriter.writeStartElement("changes");
+    int order = _firstOrder;
+    foreach (const QString& dataUuid, _dataUuids) {
+        const QMap<QString, QString> historyRecord =
+                StorageFacade::databaseHistoryStorage()->historyRecord(dataUuid);
+
         //
-        // Загрузим позиции курсоров
+        // NOTE: Вынесено на уровень AbstractMapper::executeSql
+        // Нас интересуют изменения из всех таблиц, кроме сценария и истории изменений сценария,
+        // они синхронизируются самостоятельно
         //
-        NetworkRequest loader;
-        loader.setRequestMethod(NetworkRequest::Post);
-        loader.clearRequestAttributes();
-        loader.addRequestAttribute(KEY_SESSION_KEY, m_sessionKey);
-        loader.addRequestAttribute(KEY_PROJECT, ProjectsManager::currentProject().id());
-        loader.addRequestAttribute(KEY_CURSOR_POSITION, _cursorPosition);
-        loader.addRequestAttribute(KEY_SCENARIO_IS_DRAFT, _isDraft ? "1" : "0");
-        QByteArray response = loader.loadSync(URL_SCENARIO_CURSORS);
-
-        QXmlStreamReader cursorsReader(response);
-        if (!isOperationSucceed(cursorsReader)) {
-            return;
-        }
 
+        xmlWriter.writeStartElement("change");
         //
-        // ... считываем данные о курсорах
+        xmlWriter.writeTextElement(DBH_ID_KEY, historyRecord.value(DBH_ID_KEY));
         //
-        QMap<QString, int> cleanCursors;
-        QMap<QString, int> draftCursors;
-        cursorsReader.readNextStartElement();
-        while (!cursorsReader.atEnd()
-               && cursorsReader.readNextStartElement()) {
-            //
-            // Курсоры
-            //
-            while (cursorsReader.name() == "cursors"
-                   && cursorsReader.readNextStartElement()) {
-                //
-                // Считываем каждый курсор
-                //
-                while (cursorsReader.name() == "cursor") {
-                    const QString username = cursorsReader.attributes().value("username").toString();
-                    const int cursorPosition = cursorsReader.attributes().value("position").toInt();
-                    const bool isDraft = cursorsReader.attributes().value("is_draft").toInt();
+        xmlWriter.writeStartElement(DBH_QUERY_KEY);
+        xmlWriter.writeCDATA(historyRecord.value(DBH_QUERY_KEY));
+        xmlWriter.writeEndElement();
+        //
+        xmlWriter.writeStartElement(DBH_QUERY_VALUES_KEY);
+        xmlWriter.writeCDATA(historyRecord.value(DBH_QUERY_VALUES_KEY));
+        xmlWriter.writeEndElement();
+        //
+        xmlWriter.writeTextElement(DBH_USERNAME_KEY, historyRecord.value(DBH_USERNAME_KEY));
+        //
+        xmlWriter.writeTextElement(DBH_DATETIME_KEY, historyRecord.value(DBH_DATETIME_KEY));
+        //
+        xmlWriter.writeTextElement(DBH_ORDER_KEY, QString::number(order++));
+        //
+        xmlWriter.writeEndElement(); // change
+    }
+    xmlWriter.writeEndElement(); // changes
+    xmlWriter.writeEndDocument();
 
-                    QMap<QString, int>& cursors = isDraft ? draftCursors : cleanCursors;
-                    cursors.insert(username, cursorPosition);
+    return dataChangesXml;
+}
 
-                    //
-                    // ... переход к следующему курсору
-                    //
-                    cursorsReader.readNextStartElement();
-                    cursorsReader.readNextStartElement();
-                }
-            }
-        }
+void SynchronizationManager::continueWorkSync()
+{
+    //
+    // Пока предыдущая синхронизация не завершена, новая не начинается
+    //
+    if (m_workSyncState != WorkSyncIdle) {
+        return;
+    }
+
+    if (!isCanSync()) {
+        const bool isFullSyncCanceled = isFullSyncRunning();
+        m_isFullSyncScenarioRequested = false;
+        m_isFullSyncDataRequested = false;
+        m_isWorkSyncScenarioRequested = false;
+        m_isWorkSyncDataRequested = false;
 
         //
-        // Уведомляем об обновлении курсоров
+        // ... ожидающим полную синхронизацию сообщаем, что её не будет
         //
-        emit cursorsUpdated(cleanCursors);
-        emit cursorsUpdated(draftCursors, IS_DRAFT);
+        if (isFullSyncCanceled) {
+            emit fullSyncFinished();
+        }
+        return;
+    }
+
+    //
+    // Сценарий и данные синхронизируются по очереди, сначала полностью, если это запрошено
+    //
+    m_isFullSync = false;
+    if (m_isFullSyncScenarioRequested) {
+        m_isFullSyncScenarioRequested = false;
+        m_isFullSync = true;
+        m_workSyncTarget = WorkSyncScenario;
+    } else if (m_isFullSyncDataRequested) {
+        m_isFullSyncDataRequested = false;
+        m_isFullSync = true;
+        m_workSyncTarget = WorkSyncData;
+    } else if (m_isWorkSyncScenarioRequested) {
+        m_isWorkSyncScenarioRequested = false;
+        m_workSyncTarget = WorkSyncScenario;
+    } else if (m_isWorkSyncDataRequested) {
+        m_isWorkSyncDataRequested = false;
+        m_workSyncTarget = WorkSyncData;
+    } else {
+        return;
+    }
+
+    m_workSyncProjectId = ProjectsManager::currentProject().id();
+    if (m_isFullSync) {
+        requestFullSyncChangesList();
+    } else {
+        startWorkSyncUpload();
     }
 }
 
-void SynchronizationManager::restartSession()
+void SynchronizationManager::requestFullSyncChangesList()
 {
     //
-    // Переавторизуемся
+    // Запоминаем время синхронизации, в дальнейшем будем отправлять изменения,
+    // произведённые с данного момента
     //
-    autoLogin();
+    QString& lastSyncDatetime =
+            m_workSyncTarget == WorkSyncScenario ? m_lastChangesSyncDatetime : m_lastDataSyncDatetime;
+    m_prevWorkSyncDatetime = lastSyncDatetime;
+    lastSyncDatetime = QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss");
 
     //
-    // А если текущий проект - удаленный, то синхронизуем и его
+    // Получить список всех изменений проекта на сервере
     //
-    if (ProjectsManager::currentProject().isRemote()) {
-        aboutFullSyncScenario();
-        aboutFullSyncData();
-    }
+    m_workSyncState = WorkSyncDownloading;
+    ChunkedTransfer* transfer =
+            createWorkSyncTransfer(
+                m_workSyncTarget == WorkSyncScenario ? URL_SCENARIO_CHANGE_LIST : URL_SCENARIO_DATA_LIST);
+    transfer->addChunk(QString::null, QVariant());
+    transfer->start();
 }
 
-bool SynchronizationManager::isOperationSucceed(QXmlStreamReader& _responseReader)
+void SynchronizationManager::startFullSyncUpload(const QByteArray& _changesListResponse)
 {
-    while (!_responseReader.atEnd()) {
-        _responseReader.readNext();
-        if (_responseReader.name().toString() == "status") {
-            //
-            // Операция успешна
-            //
-            if (_responseReader.attributes().value("result").toString() == "true") {
-                return true;
-            } else {
-                //
-                // Попытаемся извлечь код ошибки
-                //
-                int errorCode = Sync::UnknownError;
-                if (_responseReader.attributes().hasAttribute("errorCode")) {
-                    errorCode = _responseReader.attributes().value("errorCode").toInt();
-                }
+    if (!isCanSync()) {
+        finishWorkSync();
+        return;
+    }
 
-                //
-                // Попытаемся извлечь текст ошибки
-                //
-                QString errorText = Sync::errorText(errorCode);
-                if (_responseReader.attributes().hasAttribute("error")) {
-                    errorText = _responseReader.attributes().value("error").toString();
-                }
+    //
+    // Если список получить не удалось, то ничего не отправлено, и время синхронизации не меняется
+    //
+    QXmlStreamReader changesReader(_changesListResponse);
+    if (!isOperationSucceed(changesReader)) {
+        const bool IS_UPLOADED = false;
+        updateWorkSyncDatetime(IS_UPLOADED);
+        finishWorkSync();
+        return;
+    }
 
-                //
-                // Скажем про ошибку
-                //
-                handleError(errorText, errorCode);
-                return false;
+    //
+    // ... считываем изменения (uuid)
+    //
+    m_fullSyncRemoteChanges.clear();
+    while (!changesReader.atEnd()) {
+        changesReader.readNextStartElement();
+        if (changesReader.name() == "change") {
+            const QString changeUuid = changesReader.attributes().value("id").toString();
+            if (!changeUuid.isEmpty()) {
+                m_fullSyncRemoteChanges.append(changeUuid);
             }
         }
     }
+
     //
-    // Ничего не нашли про статус. Скорее всего пропал интернет
+    // Сформируем список изменений, хранящихся локально
     //
-    handleError(Sync::NetworkError);
+    const QList<QString> localChanges =
+            m_workSyncTarget == WorkSyncScenario
+            ? StorageFacade::scenarioChangeStorage()->uuids()
+            : StorageFacade::databaseHistoryStorage()->history(QString::null);
+
     //
-    // Не нужно устанавливать статус интернета здесь. Иначе, при смене не испустится сигнал
+    // Отправить на сайт все изменения, которых там нет
+    //
+    const QSet<QString> remoteChangesSet = m_fullSyncRemoteChanges.toSet();
+    QList<QString> changesForUpload;
+    foreach (const QString& changeUuid, localChanges) {
+        if (!remoteChangesSet.contains(changeUuid)) {
+            changesForUpload.append(changeUuid);
+        }
+    }
+
     //
+    // ... если отправлять нечего, то на сервере есть все локальные изменения, запоминаем это,
+    //     чтобы историю до момента синхронизации можно было сжать, и переходим к загрузке
+    //
+    if (changesForUpload.isEmpty()) {
+        const bool IS_UPLOADED = true;
+        updateWorkSyncDatetime(IS_UPLOADED);
+        downloadFullSyncChanges();
+        return;
+    }
 
-    return false;
+    uploadWorkSyncChanges(changesForUpload);
 }
 
-void SynchronizationManager::handleError(int _code)
+void SynchronizationManager::downloadFullSyncChanges()
 {
-    handleError(Sync::errorText(_code), _code);
+    if (!isCanSync()) {
+        finishWorkSync();
+        return;
+    }
+
+    m_workSyncState = WorkSyncDownloading;
+
+    //
+    // Скачать все изменения, которых ещё нет в локальной БД
+    //
+    QList<QString> changesForDownload;
+    if (m_workSyncTarget == WorkSyncScenario) {
+        changesForDownload = StorageFacade::scenarioChangeStorage()->missingUuids(m_fullSyncRemoteChanges);
+    } else {
+        const QSet<QString> localChangesSet =
+                StorageFacade::databaseHistoryStorage()->history(QString::null).toSet();
+        foreach (const QString& changeUuid, m_fullSyncRemoteChanges) {
+            if (!localChangesSet.contains(changeUuid)) {
+                changesForDownload.append(changeUuid);
+            }
+        }
+    }
+    m_fullSyncRemoteChanges.clear();
+
+    loadWorkSyncChanges(changesForDownload);
 }
 
-void SynchronizationManager::handleError(const QString &_error, int _code)
+void SynchronizationManager::startWorkSyncUpload()
 {
-    switch (_code) {
-        case Sync::NetworkError:
-        case Sync::NoSessionKeyError:
-        case Sync::SessionClosedError:
-        case Sync::UnknownError: {
-            m_sessionKey = ::INCORRECT_SESSION_KEY;
-            emit cursorsUpdated(QMap<QString, int>());
-            emit cursorsUpdated(QMap<QString, int>(), IS_DRAFT);
-            break;
+    //
+    // Запоминаем время синхронизации
+    //
+    QString& lastSyncDatetime =
+            m_workSyncTarget == WorkSyncScenario ? m_lastChangesSyncDatetime : m_lastDataSyncDatetime;
+    m_prevWorkSyncDatetime = lastSyncDatetime;
+    lastSyncDatetime = QDateTime::currentDateTimeUtc().toString("yyyy-MM-dd hh:mm:ss");
+
+    //
+    // Формируем новые изменения, кроме тех, что уже были отправлены при предыдущих попытках
+    //
+    const QList<QString> allNewChanges =
+            m_workSyncTarget == WorkSyncScenario
+            ? StorageFacade::scenarioChangeStorage()->newUuids(m_prevWorkSyncDatetime)
+            : StorageFacade::databaseHistoryStorage()->history(m_prevWorkSyncDatetime);
+    const QSet<QString> uploadedChanges =
+            m_workSyncTarget == WorkSyncScenario
+            ? StorageFacade::scenarioChangeStorage()->uploadedUuids()
+            : StorageFacade::databaseHistoryStorage()->uploadedUuids();
+    QList<QString> newChanges;
+    foreach (const QString& changeUuid, allNewChanges) {
+        if (!uploadedChanges.contains(changeUuid)) {
+            newChanges.append(changeUuid);
         }
+    }
 
-        default: break;
+    //
+    // ... если отправлять нечего, то все изменения уже есть на сервере, сразу переходим
+    //     к загрузке изменений соавторов
+    //
+    if (newChanges.isEmpty()) {
+        const bool IS_UPLOADED = true;
+        updateWorkSyncDatetime(IS_UPLOADED);
+        requestWorkSyncChangesList();
+        return;
     }
 
-    emit syncClosedWithError(_code, _error);
+    //
+    // ... а если есть, отправляем их
+    //
+    uploadWorkSyncChanges(newChanges);
 }
 
-bool SynchronizationManager::isCanSync() const
+void SynchronizationManager::uploadWorkSyncChanges(const QList<QString>& _changesUuids)
 {
-    return
-            m_isInternetConnectionActive
-            && ProjectsManager::currentProject().isRemote()
-            && ProjectsManager::currentProject().isSyncAvailable()
-            && !m_sessionKey.isEmpty()
-            && m_sessionKey != INCORRECT_SESSION_KEY;
+    //
+    // Отправляем изменения частями
+    //
+    m_workSyncState = WorkSyncUploading;
+    m_workSyncUploadChunks.clear();
+    ChunkedTransfer* transfer =
+            createWorkSyncTransfer(
+                m_workSyncTarget == WorkSyncScenario ? URL_SCENARIO_CHANGE_SAVE : URL_SCENARIO_DATA_SAVE);
+    //
+    // ... сервер сохраняет изменения в порядке получения, а соавторы применяют их в порядке
+    //     сохранения, поэтому следующая часть отправляется только после подтверждения предыдущей,
+    //     окно из настроек ускоряет только загрузку изменений
+    //
+    transfer->setWindowSize(1);
+    const int chunkSize = transferChunkSize();
+    for (int changeIndex = 0; changeIndex < _changesUuids.size(); changeIndex += chunkSize) {
+        const QList<QString> chunkChanges = _changesUuids.mid(changeIndex, chunkSize);
+        m_workSyncUploadChunks.append(chunkChanges);
+        transfer->addChunk(KEY_CHANGES,
+            m_workSyncTarget == WorkSyncScenario
+            ? scenarioChangesXml(chunkChanges)
+            : scenarioDataXml(chunkChanges, changeIndex));
+    }
+    connect(transfer, &ChunkedTransfer::chunkTransferred,
+            this, &SynchronizationManager::aboutWorkSyncChunkUploaded);
+    transfer->start();
 }
 
-bool SynchronizationManager::uploadScenarioChanges(const QList<QString>& _changesUuids)
+void SynchronizationManager::updateWorkSyncDatetime(bool _isUploaded)
 {
-    bool changesUploaded = false;
+    QString& lastSyncDatetime =
+            m_workSyncTarget == WorkSyncScenario ? m_lastChangesSyncDatetime : m_lastDataSyncDatetime;
 
-    if (isCanSync()
-        && !_changesUuids.isEmpty()) {
-        //
-        // Сформировать xml для отправки
-        //
-        QString changesXml;
-        QXmlStreamWriter xmlWriter(&changesXml);
-        xmlWriter.writeStartDocument();
-        xmlWriter.writeStartElement("changes");
-        foreach (const QString& changeUuid, _changesUuids) {
-            const ScenarioChange change = StorageFacade::scenarioChangeStorage()->change(changeUuid);
+    //
+    // Не обновляем время последней синхронизации, если изменения не были отправлены
+    //
+    if (_isUploaded == false) {
+        lastSyncDatetime = m_prevWorkSyncDatetime;
+    }
+    //
+    // А если отправлены, то все изменения до времени последней синхронизации есть на сервере
+    //
+    else {
+        if (m_workSyncTarget == WorkSyncScenario) {
+            StorageFacade::scenarioChangeStorage()->setSyncedDatetime(lastSyncDatetime);
+        } else {
+            StorageFacade::databaseHistoryStorage()->setSyncedDatetime(lastSyncDatetime);
+        }
+    }
+}
 
-            xmlWriter.writeStartElement("change");
+void SynchronizationManager::requestWorkSyncChangesList()
+{
+    if (!isCanSync()) {
+        finishWorkSync();
+        return;
+    }
 
-            xmlWriter.writeTextElement(SCENARIO_CHANGE_ID, change.uuid().toString());
+    m_workSyncState = WorkSyncDownloading;
 
-            xmlWriter.writeTextElement(SCENARIO_CHANGE_DATETIME, change.datetime().toString("yyyy-MM-dd hh:mm:ss"));
+    //
+    // Если изменения соавторов приходят по подписке, то список запрашивать не нужно
+    //
+    const bool isChangesListNeeded =
+            m_workSyncTarget == WorkSyncScenario
+            ? m_isScenarioChangesListNeeded
+            : m_isDataChangesListNeeded;
+    if (m_subscriptionChannel.isActive()
+        && !isChangesListNeeded) {
+        downloadWorkSyncChanges(takePushedChanges());
+        return;
+    }
 
-            xmlWriter.writeStartElement(SCENARIO_CHANGE_UNDO_PATCH);
-            xmlWriter.writeCDATA(change.undoPatch());
-            xmlWriter.writeEndElement();
+    //
+    // В противном случае загружаем изменения от других пользователей за последние LAST_MINUTES минут
+    //
+    const int LAST_MINUTES = 2;
 
-            xmlWriter.writeStartElement(SCENARIO_CHANGE_REDO_PATCH);
-            xmlWriter.writeCDATA(change.redoPatch());
-            xmlWriter.writeEndElement();
+    ChunkedTransfer* transfer =
+            createWorkSyncTransfer(
+                m_workSyncTarget == WorkSyncScenario ? URL_SCENARIO_CHANGE_LIST : URL_SCENARIO_DATA_LIST);
+    transfer->addChunk(KEY_FROM_LAST_MINUTES, LAST_MINUTES);
+    transfer->start();
+}
 
-            xmlWriter.writeTextElement(SCENARIO_CHANGE_IS_DRAFT, change.isDraft() ? "1" : "0");
+void SynchronizationManager::requestWorkSyncChanges(const QByteArray& _changesListResponse)
+{
+    if (!isCanSync()) {
+        finishWorkSync();
+        return;
+    }
 
-            xmlWriter.writeEndElement(); // change
-        }
-        xmlWriter.writeEndElement(); // changes
-        xmlWriter.writeEndDocument();
+    QXmlStreamReader changesReader(_changesListResponse);
+    if (!isOperationSucceed(changesReader)) {
+        finishWorkSync();
+        return;
+    }
 
-        //
-        // Отправить данные
-        //
-        NetworkRequest loader;
-        loader.setRequestMethod(NetworkRequest::Post);
-        loader.clearRequestAttributes();
-        loader.addRequestAttribute(KEY_SESSION_KEY, m_sessionKey);
-        loader.addRequestAttribute(KEY_PROJECT, ProjectsManager::currentProject().id());
-        loader.addRequestAttribute(KEY_CHANGES, changesXml);
-        const QByteArray response = loader.loadSync(URL_SCENARIO_CHANGE_SAVE);
+    //
+    // ... список получен, дальше можно полагаться на подписку
+    //
+    if (m_workSyncTarget == WorkSyncScenario) {
+        m_isScenarioChangesListNeeded = false;
+    } else {
+        m_isDataChangesListNeeded = false;
+    }
+
+    //
+    // ... считываем uuid'ы новых изменений, добавляя к ним полученные по подписке
+    //
+    QList<QString> remoteChanges = takePushedChanges();
+    while (!changesReader.atEnd()) {
+        changesReader.readNextStartElement();
+        if (changesReader.name() == "change") {
+            const QString changeUuid = changesReader.attributes().value("id").toString();
+            if (!changeUuid.isEmpty()) {
+                remoteChanges.append(changeUuid);
+            }
+        }
+    }
+
+    downloadWorkSyncChanges(remoteChanges);
+}
+
+void SynchronizationManager::downloadWorkSyncChanges(const QList<QString>& _remoteChanges)
+{
+    //
+    // Определяем изменения, которых ещё нет
+    //
+    QList<QString> changesForDownload;
+    QSet<QString> checkedChanges;
+    foreach (const QString& changeUuid, _remoteChanges) {
+        if (checkedChanges.contains(changeUuid)) {
+            continue;
+        }
+        checkedChanges.insert(changeUuid);
+
+        const bool needDownload =
+                m_workSyncTarget == WorkSyncScenario
+                ? !StorageFacade::scenarioChangeStorage()->contains(changeUuid)
+                : !StorageFacade::databaseHistoryStorage()->contains(changeUuid);
+
+        if (needDownload) {
+            changesForDownload.append(changeUuid);
+        }
+    }
+
+    loadWorkSyncChanges(changesForDownload);
+}
+
+void SynchronizationManager::loadWorkSyncChanges(const QList<QString>& _changesUuids)
+{
+    if (_changesUuids.isEmpty()) {
+        finishWorkSync();
+        return;
+    }
+
+    //
+    // Скачиваем изменения частями
+    //
+    ChunkedTransfer* transfer =
+            createWorkSyncTransfer(
+                m_workSyncTarget == WorkSyncScenario ? URL_SCENARIO_CHANGE_LOAD : URL_SCENARIO_DATA_LOAD);
+    m_workSyncDownloadChunks.clear();
+    const int chunkSize = transferChunkSize();
+    for (int changeIndex = 0; changeIndex < _changesUuids.size(); changeIndex += chunkSize) {
+        const QList<QString> chunkChanges = _changesUuids.mid(changeIndex, chunkSize);
+        m_workSyncDownloadChunks.append(chunkChanges);
+        transfer->addChunk(KEY_CHANGES_IDS, QStringList(chunkChanges).join(";"));
+    }
+    transfer->start();
+}
+
+void SynchronizationManager::parseWorkSyncChanges(const QList<QByteArray>& _changesResponses)
+{
+    if (!isCanSync()) {
+        finishWorkSync();
+        return;
+    }
+
+    //
+    // Ответы есть только у подряд идущих частей с успешным статусом, остальные изменения
+    // будут загружены при следующей синхронизации
+    //
+    if (_changesResponses.isEmpty()) {
+        finishWorkSync();
+        return;
+    }
+
+    //
+    // Разбираем изменения в отдельном потоке, а применим их, когда разбор будет завершён
+    //
+    m_workSyncState = WorkSyncApplying;
+    m_workSyncChangesWatcher.setFuture(QtConcurrent::run(&::readAllChanges, _changesResponses));
+}
+
+void SynchronizationManager::finishWorkSync()
+{
+    m_workSyncState = WorkSyncIdle;
+    m_workSyncUrl.clear();
+
+    if (m_isFullSync) {
+        m_isFullSync = false;
+        m_fullSyncRemoteChanges.clear();
 
         //
-        // Изменения отправлены, если сервер это подтвердил
+        // Дальше изменения соавторов будем получать по подписке, если сервер её поддерживает
         //
-        changesUploaded = !response.isEmpty();
+        updateSubscription();
+
+        if (!m_isFullSyncScenarioRequested
+            && !m_isFullSyncDataRequested) {
+            emit fullSyncFinished();
+        }
     }
 
-    return changesUploaded;
+    //
+    // Если за время синхронизации она была запрошена снова, выполним её, когда вернёмся в цикл событий
+    //
+    if (m_isFullSyncScenarioRequested
+        || m_isFullSyncDataRequested
+        || m_isWorkSyncScenarioRequested
+        || m_isWorkSyncDataRequested) {
+        QTimer::singleShot(0, this, &SynchronizationManager::continueWorkSync);
+    }
 }
 
-QList<QHash<QString, QString> > SynchronizationManager::downloadScenarioChanges(const QString& _changesUuids)
+QList<QString> SynchronizationManager::takePushedChanges()
 {
-    QList<QHash<QString, QString> > changes;
+    QList<QString>& pushedChanges =
+            m_workSyncTarget == WorkSyncScenario ? m_pushedScenarioChanges : m_pushedDataChanges;
+    const QList<QString> result = pushedChanges;
+    pushedChanges.clear();
+    return result;
+}
 
+void SynchronizationManager::updateSubscription()
+{
+    if (isCanSync()) {
+        m_subscriptionChannel.start(m_sessionKey, ProjectsManager::currentProject().id());
+    } else {
+        m_subscriptionChannel.stop();
+    }
+}
+
+bool SynchronizationManager::isSubscriptionEventActual()
+{
     if (isCanSync()
-        && !_changesUuids.isEmpty()) {
-        //
-        // ... загружаем изменения
-        //
-        NetworkRequest loader;
-        loader.setRequestMethod(NetworkRequest::Post);
-        loader.clearRequestAttributes();
-        loader.addRequestAttribute(KEY_SESSION_KEY, m_sessionKey);
-        loader.addRequestAttribute(KEY_PROJECT, ProjectsManager::currentProject().id());
-        loader.addRequestAttribute(KEY_CHANGES_IDS, _changesUuids);
-        QByteArray response = loader.loadSync(URL_SCENARIO_CHANGE_LOAD);
-
-        QXmlStreamReader changesReader(response);
-        if (!isOperationSucceed(changesReader)) {
-            return changes;
+        && m_subscriptionChannel.projectId() == ProjectsManager::currentProject().id()) {
+        return true;
+    }
+
+    //
+    // Если проект сменился, то переподпишемся на события нового
+    //
+    updateSubscription();
+    return false;
+}
+
+ChunkedTransfer* SynchronizationManager::createTransfer(const QUrl& _url)
+{
+    ChunkedTransfer* transfer = new ChunkedTransfer(_url, this);
+    transfer->setWindowSize(
+        StorageFacade::settingsStorage()->value(
+            "application/sync-transfer-window", SettingsStorage::ApplicationSettings).toInt());
+    transfer->setMaxRetries(TRANSFER_MAX_RETRIES);
+    transfer->setRetryDelay(TRANSFER_RETRY_DELAY);
+    transfer->setPriority(NetworkRequest::BulkPriority);
+    transfer->addRequestAttribute(KEY_SESSION_KEY, m_sessionKey);
+    transfer->addRequestAttribute(KEY_PROJECT, ProjectsManager::currentProject().id());
+    //
+    // Часть считается переданной, только если сервер ответил успешным статусом, иначе по ней
+    // сдвинулось бы время синхронизации и сжатие удалило бы не полученные сервером изменения
+    //
+    transfer->setResponseValidator([this] (const QByteArray& _response) {
+        QXmlStreamReader responseReader(_response);
+        return isOperationSucceed(responseReader);
+    });
+    return transfer;
+}
+
+int SynchronizationManager::transferChunkSize() const
+{
+    return
+            qMax(1, StorageFacade::settingsStorage()->value(
+                     "application/sync-transfer-chunk-size", SettingsStorage::ApplicationSettings).toInt());
+}
+
+ChunkedTransfer* SynchronizationManager::createWorkSyncTransfer(const QUrl& _url)
+{
+    ChunkedTransfer* transfer = createTransfer(_url);
+    //
+    // Изменения, сделанные во время работы, небольшие и нужны соавторам как можно скорее,
+    // а при полной синхронизации передаётся вся история, поэтому она не вытесняет другие запросы
+    //
+    if (!m_isFullSync) {
+        transfer->setPriority(NetworkRequest::SyncPriority);
+    }
+    connect(transfer, &ChunkedTransfer::finished,
+            this, &SynchronizationManager::aboutWorkSyncTransferFinished);
+    connect(transfer, &ChunkedTransfer::finished, transfer, &ChunkedTransfer::deleteLater);
+
+    m_workSyncUrl = _url;
+    m_workSyncTransfer = transfer;
+    return transfer;
+}
+
+void SynchronizationManager::loadCursors(int _cursorPosition, bool _isDraft)
+{
+    m_isCursorsLoading = true;
+    m_lastSentCursorPosition = _cursorPosition;
+    m_isLastSentCursorInDraft = _isDraft;
+
+    NetworkRequest* loader = new NetworkRequest(this);
+    loader->setRequestMethod(NetworkRequest::Post);
+    loader->setPriority(NetworkRequest::InteractivePriority);
+    loader->addRequestAttribute(KEY_SESSION_KEY, m_sessionKey);
+    loader->addRequestAttribute(KEY_PROJECT, ProjectsManager::currentProject().id());
+    loader->addRequestAttribute(KEY_CURSOR_POSITION, _cursorPosition);
+    loader->addRequestAttribute(KEY_SCENARIO_IS_DRAFT, _isDraft ? "1" : "0");
+    connect(loader, &NetworkRequest::downloadComplete, this, &SynchronizationManager::aboutCursorsLoaded);
+    connect(loader, &NetworkRequest::finished, this, &SynchronizationManager::aboutCursorsRequestFinished);
+    connect(loader, &NetworkRequest::finished, loader, &NetworkRequest::deleteLater);
+    loader->loadAsync(URL_SCENARIO_CURSORS);
+}
+
+void SynchronizationManager::aboutWorkSyncChunkUploaded(int _index)
+{
+    //
+    // Запоминаем отправленные изменения, чтобы при повторной попытке не отправлять их снова
+    //
+    if (m_workSyncTransfer != sender()
+        || _index >= m_workSyncUploadChunks.size()) {
+        return;
+    }
+
+    if (m_workSyncTarget == WorkSyncScenario) {
+        StorageFacade::scenarioChangeStorage()->addUploadedUuids(m_workSyncUploadChunks.at(_index));
+    } else {
+        StorageFacade::databaseHistoryStorage()->addUploadedUuids(m_workSyncUploadChunks.at(_index));
+    }
+}
+
+void SynchronizationManager::aboutWorkSyncTransferFinished()
+{
+    ChunkedTransfer* transfer = qobject_cast<ChunkedTransfer*>(sender());
+    if (transfer == nullptr
+        || transfer != m_workSyncTransfer) {
+        return;
+    }
+    m_workSyncTransfer = nullptr;
+
+    //
+    // Если за время передачи был открыт другой проект, то результат уже не актуален
+    //
+    if (ProjectsManager::currentProject().id() != m_workSyncProjectId) {
+        finishWorkSync();
+        return;
+    }
+
+    switch (m_workSyncState) {
+        case WorkSyncUploading: {
+            m_workSyncUploadChunks.clear();
+            updateWorkSyncDatetime(transfer->isSucceed());
+            if (m_isFullSync) {
+                downloadFullSyncChanges();
+            } else {
+                requestWorkSyncChangesList();
+            }
+            break;
         }
 
-        //
-        // ... считываем данные об изменениях
-        //
-        changesReader.readNextStartElement();
-        while (!changesReader.atEnd()
-               && changesReader.readNextStartElement()) {
-            //
-            // Изменения
-            //
-            while (changesReader.name() == "changes"
-                   && changesReader.readNextStartElement()) {
-                //
-                // Считываем каждое изменение
-                //
-                while (changesReader.name() == "change"
-                       && changesReader.readNextStartElement()) {
+        case WorkSyncDownloading: {
+            if (m_workSyncUrl == URL_SCENARIO_CHANGE_LIST
+                || m_workSyncUrl == URL_SCENARIO_DATA_LIST) {
+                if (!transfer->isSucceed()) {
                     //
-                    // Данные изменения
+                    // ... при полной синхронизации до отправки изменений дело не дошло
                     //
-                    QHash<QString, QString> change;
-                    while (changesReader.name() != "change") {
-                        const QString key = changesReader.name().toString();
-                        const QString value = changesReader.readElementText();
-                        if (!value.isEmpty()) {
-                            change.insert(key, value);
-                        }
-
-                        //
-                        // ... переходим к следующему элементу
-                        //
-                        changesReader.readNextStartElement();
+                    if (m_isFullSync) {
+                        const bool IS_UPLOADED = false;
+                        updateWorkSyncDatetime(IS_UPLOADED);
                     }
-
-                    if (!change.isEmpty()) {
-                        changes.append(change);
+                    finishWorkSync();
+                } else if (m_isFullSync) {
+                    startFullSyncUpload(transfer->responses().first());
+                } else {
+                    requestWorkSyncChanges(transfer->responses().first());
+                }
+            } else {
+                //
+                // Изменения из частей, которые загрузить не удалось, возвращаем к полученным
+                // по подписке, чтобы загрузить их при следующей синхронизации, а при полной
+                // синхронизации они будут загружены при следующей полной
+                //
+                if (!m_isFullSync) {
+                    QList<QString>& pushedChanges =
+                            m_workSyncTarget == WorkSyncScenario ? m_pushedScenarioChanges : m_pushedDataChanges;
+                    for (int chunkIndex = transfer->responses().size();
+                         chunkIndex < m_workSyncDownloadChunks.size();
+                         ++chunkIndex) {
+                        pushedChanges.append(m_workSyncDownloadChunks.at(chunkIndex));
                     }
                 }
+                m_workSyncDownloadChunks.clear();
+
+                parseWorkSyncChanges(transfer->responses());
             }
+            break;
         }
-    }
 
-    return changes;
+        default: {
+            finishWorkSync();
+            break;
+        }
+    }
 }
 
-bool SynchronizationManager::uploadScenarioData(const QList<QString>& _dataUuids)
+void SynchronizationManager::aboutWorkSyncChangesParsed()
 {
-    bool dataUploaded = false;
+    //
+    // Если за время разбора проект был закрыт, то изменения уже не нужны
+    //
+    if (!isCanSync()
+        || ProjectsManager::currentProject().id() != m_workSyncProjectId) {
+        finishWorkSync();
+        return;
+    }
 
-    if (isCanSync()
-        && !_dataUuids.isEmpty()) {
+    const QList<QHash<QString, QString> > changes = m_workSyncChangesWatcher.result();
+    if (m_workSyncTarget == WorkSyncScenario) {
         //
-        // Сформировать xml для отправки
+        // ... применять будем пачками
         //
-        QString dataChangesXml;
-        QXmlStreamWriter xmlWriter(&dataChangesXml);
-        xmlWriter.writeStartDocument();
-        xmlWriter.writeStartElement("changes");
-        int order = 0;
-        foreach (const QString& dataUuid, _dataUuids) {
-            const QMap<QString, QString> historyRecord =
-                    StorageFacade::databaseHistoryStorage()->historyRecord(dataUuid);
-
-            //
-            // NOTE: Вынесено на уровень AbstractMapper::executeSql
-            // Нас интересуют изменения из всех таблиц, кроме сценария и истории изменений сценария,
-            // они синхронизируются самостоятельно
-            //
-
-            xmlWriter.writeStartElement("change");
-            //
-            xmlWriter.writeTextElement(DBH_ID_KEY, historyRecord.value(DBH_ID_KEY));
-            //
-            xmlWriter.writeStartElement(DBH_QUERY_KEY);
-            xmlWriter.writeCDATA(historyRecord.value(DBH_QUERY_KEY));
-            xmlWriter.writeEndElement();
-            //
-            xmlWriter.writeStartElement(DBH_QUERY_VALUES_KEY);
-            xmlWriter.writeCDATA(historyRecord.value(DBH_QUERY_VALUES_KEY));
-            xmlWriter.writeEndElement();
-            //
-            xmlWriter.writeTextElement(DBH_USERNAME_KEY, historyRecord.value(DBH_USERNAME_KEY));
-            //
-            xmlWriter.writeTextElement(DBH_DATETIME_KEY, historyRecord.value(DBH_DATETIME_KEY));
-            //
-            xmlWriter.writeTextElement(DBH_ORDER_KEY, QString::number(order++));
-            //
-            xmlWriter.writeEndElement(); // change
+        QList<QByteArray> cleanPatches;
+        QList<QByteArray> draftPatches;
+        QHash<QString, QString> change;
+        foreach (change, changes) {
+            if (!change.isEmpty()) {
+                //
+                // ... сохраняем
+                //
+                auto* addedChange =
+                        StorageFacade::scenarioChangeStorage()->append(
+                            change.value(SCENARIO_CHANGE_ID), change.value(SCENARIO_CHANGE_DATETIME),
+                            change.value(SCENARIO_CHANGE_USERNAME),
+                            DatabaseHelper::compressedFromBase64(change.value(SCENARIO_CHANGE_UNDO_PATCH)),
+                            DatabaseHelper::compressedFromBase64(change.value(SCENARIO_CHANGE_REDO_PATCH)),
+                            change.value(SCENARIO_CHANGE_IS_DRAFT).toInt());
+                if (addedChange != nullptr) {
+                    if (addedChange->isDraft()) {
+                        draftPatches.append(addedChange->redoPatch());
+                    } else {
+                        cleanPatches.append(addedChange->redoPatch());
+                    }
+                }
+            }
         }
-        xmlWriter.writeEndElement(); // changes
-        xmlWriter.writeEndDocument();
 
         //
-        // Отправить данные
+        // ... применяем
         //
-        NetworkRequest loader;
-        loader.setRequestMethod(NetworkRequest::Post);
-        loader.clearRequestAttributes();
-        loader.addRequestAttribute(KEY_SESSION_KEY, m_sessionKey);
-        loader.addRequestAttribute(KEY_PROJECT, ProjectsManager::currentProject().id());
-        loader.addRequestAttribute(KEY_CHANGES, dataChangesXml);
-        const QByteArray response = loader.loadSync(URL_SCENARIO_DATA_SAVE);
+        if (!cleanPatches.isEmpty()) {
+            emit applyPatchesRequested(cleanPatches, IS_CLEAN);
+        }
+        if (!draftPatches.isEmpty()) {
+            emit applyPatchesRequested(draftPatches, IS_DRAFT);
+        }
 
         //
-        // Данные отправлены, если сервер это подтвердил
+        // ... полученную при полной синхронизации историю сразу сохраняем
         //
-        dataUploaded = !response.isEmpty();
+        if (m_isFullSync) {
+            StorageFacade::scenarioChangeStorage()->store();
+        }
+    } else {
+        //
+        // ... пропускаем изменения, которые уже были применены и удалены из истории при её сжатии
+        //
+        const QString compactedDatetime = StorageFacade::databaseHistoryStorage()->compactedDatetime();
+        QList<QHash<QString, QString> > dataChanges;
+        QHash<QString, QString> change;
+        foreach (change, changes) {
+            if (change.value(DBH_DATETIME_KEY) >= compactedDatetime) {
+                dataChanges.append(change);
+            }
+        }
+        ::storeAndApplyDataChanges(dataChanges);
     }
 
-    return dataUploaded;
+    finishWorkSync();
 }
 
-void SynchronizationManager::downloadAndSaveScenarioData(const QString& _dataUuids)
+void SynchronizationManager::aboutSubscriptionActiveChanged(bool _isActive)
 {
-    if (isCanSync()
-        && !_dataUuids.isEmpty()) {
-        //
-        // ... загружаем изменения
-        //
-        NetworkRequest loader;
-        loader.setRequestMethod(NetworkRequest::Post);
-        loader.clearRequestAttributes();
-        loader.addRequestAttribute(KEY_SESSION_KEY, m_sessionKey);
-        loader.addRequestAttribute(KEY_PROJECT, ProjectsManager::currentProject().id());
-        loader.addRequestAttribute(KEY_CHANGES_IDS, _dataUuids);
-        QByteArray response = loader.loadSync(URL_SCENARIO_DATA_LOAD);
-
-        QXmlStreamReader changesReader(response);
-        if (!isOperationSucceed(changesReader)) {
-            return;
-        }
+    //
+    // После активации подписки запросим списки изменений, чтобы не пропустить сделанные до неё
+    //
+    if (_isActive) {
+        m_isScenarioChangesListNeeded = true;
+        m_isDataChangesListNeeded = true;
+    }
+    //
+    // А после деактивации вернёмся к опросу изменений и курсоров
+    //
+    else {
+        m_pushedScenarioChanges.clear();
+        m_pushedDataChanges.clear();
+        m_lastSentCursorPosition = -1;
+    }
+}
+
+void SynchronizationManager::aboutScenarioChangesPushed(const QList<QString>& _changesUuids)
+{
+    if (isSubscriptionEventActual()) {
+        m_pushedScenarioChanges.append(_changesUuids);
+        aboutWorkSyncScenario();
+    }
+}
+
+void SynchronizationManager::aboutDataChangesPushed(const QList<QString>& _changesUuids)
+{
+    if (isSubscriptionEventActual()) {
+        m_pushedDataChanges.append(_changesUuids);
+        aboutWorkSyncData();
+    }
+}
 
+void SynchronizationManager::aboutCursorsPushed(const QMap<QString, int>& _cursors, bool _isDraft)
+{
+    if (isSubscriptionEventActual()) {
+        emit cursorsUpdated(_cursors, _isDraft);
+    }
+}
+
+void SynchronizationManager::aboutCursorsLoaded(const QByteArray& _response)
+{
+    if (!isCanSync()) {
+        return;
+    }
+
+    QXmlStreamReader cursorsReader(_response);
+    if (!isOperationSucceed(cursorsReader)) {
+        return;
+    }
+
+    //
+    // ... считываем данные о курсорах
+    //
+    QMap<QString, int> cleanCursors;
+    QMap<QString, int> draftCursors;
+    cursorsReader.readNextStartElement();
+    while (!cursorsReader.atEnd()
+           && cursorsReader.readNextStartElement()) {
         //
-        // ... считываем данные об изменениях
+        // Курсоры
         //
-        QList<QHash<QString, QString>> changes;
-        changesReader.readNextStartElement();
-        while (!changesReader.atEnd()
-               && changesReader.readNextStartElement()) {
+        while (cursorsReader.name() == "cursors"
+               && cursorsReader.readNextStartElement()) {
             //
-            // Изменения
+            // Считываем каждый курсор
             //
-            while (changesReader.name() == "changes"
-                   && changesReader.readNextStartElement()) {
-                //
-                // Считываем каждое изменение
-                //
-                while (changesReader.name() == "change"
-                       && changesReader.readNextStartElement()) {
-                    //
-                    // Данные изменения
-                    //
-                    QHash<QString, QString> change;
-                    while (changesReader.name() != "change") {
-                        const QString key = changesReader.name().toString();
-                        const QString value = changesReader.readElementText();
-                        if (!value.isEmpty()) {
-                            change.insert(key, value);
-                        }
+            while (cursorsReader.name() == "cursor") {
+                const QString username = cursorsReader.attributes().value("username").toString();
+                const int cursorPosition = cursorsReader.attributes().value("position").toInt();
+                const bool isDraft = cursorsReader.attributes().value("is_draft").toInt();
 
-                        //
-                        // ... переходим к следующему элементу
-                        //
-                        changesReader.readNextStartElement();
-                    }
+                QMap<QString, int>& cursors = isDraft ? draftCursors : cleanCursors;
+                cursors.insert(username, cursorPosition);
 
-                    if (!change.isEmpty()) {
-                        changes.append(change);
-                    }
-                }
+                //
+                // ... переход к следующему курсору
+                //
+                cursorsReader.readNextStartElement();
+                cursorsReader.readNextStartElement();
             }
         }
+    }
 
+    //
+    // Уведомляем об обновлении курсоров
+    //
+    emit cursorsUpdated(cleanCursors);
+    emit cursorsUpdated(draftCursors, IS_DRAFT);
+}
 
-        //
-        // Применяем изменения
-        //
-        QHash<QString, QString> changeValues;
-        DatabaseLayer::Database::transaction();
-        foreach (changeValues, changes) {
-            DataStorageLayer::StorageFacade::databaseHistoryStorage()->storeAndApplyHistoryRecord(
-                changeValues.value(DBH_ID_KEY), changeValues.value(DBH_QUERY_KEY),
-                changeValues.value(DBH_QUERY_VALUES_KEY), changeValues.value(DBH_USERNAME_KEY), changeValues.value(DBH_DATETIME_KEY));
-        }
-        DatabaseLayer::Database::commit();
-
+void SynchronizationManager::aboutCursorsRequestFinished()
+{
+    m_isCursorsLoading = false;
 
-        //
-        // Обновляем данные
-        //
-        DataStorageLayer::StorageFacade::refreshStorages();
+    //
+    // Если за время запроса курсор сместился, отправим его последнюю позицию
+    //
+    if (m_pendingCursorPosition >= 0) {
+        const int cursorPosition = m_pendingCursorPosition;
+        m_pendingCursorPosition = -1;
+        if (isCanSync()) {
+            loadCursors(cursorPosition, m_isPendingCursorInDraft);
+        }
     }
 }
 
@@ -1776,6 +2107,7 @@ void SynchronizationManager::checkNetworkState()
     //
     NetworkRequest loader;
     loader.setLoadingTimeout(2000);
+    loader.setPriority(NetworkRequest::InteractivePriority);
     int leavedTries = 3;
     while (leavedTries-- > 0) {
         QByteArray response = loader.loadSync(URL_CHECK_NETWORK_STATE);
@@ -1820,4 +2152,15 @@ void SynchronizationManager::checkNetworkState()
 void SynchronizationManager::initConnections()
 {
     connect(this, &SynchronizationManager::loginAccepted, this, &SynchronizationManager::loadProjects);
+    connect(&m_workSyncChangesWatcher, &QFutureWatcherBase::finished,
+            this, &SynchronizationManager::aboutWorkSyncChangesParsed);
+
+    connect(&m_subscriptionChannel, &SubscriptionChannel::activeChanged,
+            this, &SynchronizationManager::aboutSubscriptionActiveChanged);
+    connect(&m_subscriptionChannel, &SubscriptionChannel::scenarioChangesAvailable,
+            this, &SynchronizationManager::aboutScenarioChangesPushed);
+    connect(&m_subscriptionChannel, &SubscriptionChannel::dataChangesAvailable,
+            this, &SynchronizationManager::aboutDataChangesPushed);
+    connect(&m_subscriptionChannel, &SubscriptionChannel::cursorsUpdated,
+            this, &SynchronizationManager::aboutCursorsPushed);
 }
@@ -17,13 +17,20 @@
 #ifndef SYNCHRONIZATIONMANAGER_H
 #define SYNCHRONIZATIONMANAGER_H
 
+#include "SubscriptionChannel.h"
+
+#include <QFutureWatcher>
+#include <QHash>
 #include <QObject>
+#include <QUrl>
 
 class QXmlStreamReader;
 
 
 namespace ManagementLayer
 {
+    class ChunkedTransfer;
+
     /**
      *  @brief Управляющий синхронизацией
      */
@@ -44,6 +51,11 @@ namespace ManagementLayer
          */
         bool isLogged() const;
 
+        /**
+         * @brief Выполняется ли, или ожидает выполнения полная синхронизация
+         */
+        bool isFullSyncRunning() const;
+
         //
         // Методы работы с аккаунтом
         //
@@ -145,6 +157,7 @@ namespace ManagementLayer
 
         /**
          * @brief Полная синхронизация сценария
+         * @note Выполняется асинхронно, по завершении испускается сигнал fullSyncFinished
          */
         void aboutFullSyncScenario();
 
@@ -155,6 +168,7 @@ namespace ManagementLayer
 
         /**
          * @brief Полная синхронизация данных
+         * @note Выполняется асинхронно, по завершении испускается сигнал fullSyncFinished
          */
         void aboutFullSyncData();
 
@@ -230,13 +244,18 @@ namespace ManagementLayer
         //
 
         /**
-         * @brief Необходимо применить патч
+         * @brief Необходимо применить сжатый патч
          */
         /** @{ */
-        void applyPatchRequested(const QString& _patch, bool _isDraft);
-        void applyPatchesRequested(const QList<QString>& _patch, bool _isDraft);
+        void applyPatchRequested(const QByteArray& _patch, bool _isDraft);
+        void applyPatchesRequested(const QList<QByteArray>& _patch, bool _isDraft);
         /** @} */
 
+        /**
+         * @brief Завершена запрошенная полная синхронизация сценария и данных
+         */
+        void fullSyncFinished();
+
         /**
          * @brief Получены новые позиции курсоров пользователей
          */
@@ -247,6 +266,46 @@ namespace ManagementLayer
          */
         void networkStatusChanged(bool _isActive);
 
+    private slots:
+        /**
+         * @brief Часть изменений отправлена на сервер во время работы
+         */
+        void aboutWorkSyncChunkUploaded(int _index);
+
+        /**
+         * @brief Завершена передача данных синхронизации во время работы
+         */
+        void aboutWorkSyncTransferFinished();
+
+        /**
+         * @brief Загруженные изменения разобраны и готовы к применению
+         */
+        void aboutWorkSyncChangesParsed();
+
+        /**
+         * @brief Загружены позиции курсоров
+         */
+        void aboutCursorsLoaded(const QByteArray& _response);
+
+        /**
+         * @brief Завершён запрос позиций курсоров
+         */
+        void aboutCursorsRequestFinished();
+
+        /**
+         * @brief Изменилась активность канала подписки
+         */
+        void aboutSubscriptionActiveChanged(bool _isActive);
+
+        /**
+         * @brief По подписке получены события проекта
+         */
+        /** @{ */
+        void aboutScenarioChangesPushed(const QList<QString>& _changesUuids);
+        void aboutDataChangesPushed(const QList<QString>& _changesUuids);
+        void aboutCursorsPushed(const QMap<QString, int>& _cursors, bool _isDraft);
+        /** @} */
+
     private:
         /**
          * @brief Проверка, что статус ответа - ок
@@ -271,26 +330,125 @@ namespace ManagementLayer
         bool isCanSync() const;
 
         /**
-         * @brief Отправить изменения сценария на сервер
-         * @return Удалось ли отправить данные
+         * @brief Сформировать xml изменений сценария для отправки на сервер
+         */
+        QString scenarioChangesXml(const QList<QString>& _changesUuids) const;
+
+        /**
+         * @brief Сформировать xml изменений данных для отправки на сервер
+         * @param _firstOrder порядковый номер первого изменения
+         */
+        QString scenarioDataXml(const QList<QString>& _dataUuids, int _firstOrder = 0) const;
+
+        /**
+         * @brief Создать передачу данных частями с настройками из параметров приложения
+         */
+        ChunkedTransfer* createTransfer(const QUrl& _url);
+
+        /**
+         * @brief Количество изменений в одной части передаваемых данных
+         */
+        int transferChunkSize() const;
+
+        //
+        // Асинхронная синхронизация во время работы
+        //
+        // Все запросы выполняются в потоках очереди загрузчиков, а разбор загруженных изменений
+        // в отдельном потоке, так что поток интерфейса не блокируется на время синхронизации.
+        // Полная синхронизация проходит те же этапы, поэтому одновременно с синхронизацией
+        // во время работы не выполняется и не вклинивается в неё
+        //
+
+        /**
+         * @brief Начать синхронизацию сценария, или данных, если она запрошена и ничего не выполняется
+         * @note Запрошенная полная синхронизация выполняется в первую очередь
+         */
+        void continueWorkSync();
+
+        /**
+         * @brief Запросить список всех изменений проекта на сервере для полной синхронизации
+         */
+        void requestFullSyncChangesList();
+
+        /**
+         * @brief Отправить на сервер изменения, которых нет в загруженном списке
+         */
+        void startFullSyncUpload(const QByteArray& _changesListResponse);
+
+        /**
+         * @brief Скачать изменения из списка сервера, которых ещё нет локально
+         */
+        void downloadFullSyncChanges();
+
+        /**
+         * @brief Отправить новые изменения на сервер
+         */
+        void startWorkSyncUpload();
+
+        /**
+         * @brief Отправить заданные изменения на сервер частями
          */
-        bool uploadScenarioChanges(const QList<QString>& _changesUuids);
+        void uploadWorkSyncChanges(const QList<QString>& _changesUuids);
 
         /**
-         * @brief Скачать изменения с сервера
+         * @brief Обновить время последней синхронизации по результату отправки изменений
          */
-        QList<QHash<QString, QString> > downloadScenarioChanges(const QString& _changesUuids);
+        void updateWorkSyncDatetime(bool _isUploaded);
 
         /**
-         * @brief Отправить изменения данных на сервер
-         * @return Удалось ли отправить данные
+         * @brief Запросить список изменений соавторов за последние минуты
          */
-        bool uploadScenarioData(const QList<QString>& _dataUuids);
+        void requestWorkSyncChangesList();
 
         /**
-         * @brief Скачать и сохранить в БД изменения с сервера
+         * @brief Запросить изменения из загруженного списка, которых ещё нет локально
          */
-        void downloadAndSaveScenarioData(const QString& _dataUuids);
+        void requestWorkSyncChanges(const QByteArray& _changesListResponse);
+
+        /**
+         * @brief Скачать изменения, которых ещё нет локально
+         */
+        void downloadWorkSyncChanges(const QList<QString>& _remoteChanges);
+
+        /**
+         * @brief Скачать заданные изменения частями
+         */
+        void loadWorkSyncChanges(const QList<QString>& _changesUuids);
+
+        /**
+         * @brief Забрать uuid'ы изменений синхронизируемого типа, полученные по подписке
+         */
+        QList<QString> takePushedChanges();
+
+        /**
+         * @brief Подписаться на события текущего проекта, или отписаться, если синхронизация невозможна
+         */
+        void updateSubscription();
+
+        /**
+         * @brief Относятся ли полученные по подписке события к текущему проекту
+         */
+        bool isSubscriptionEventActual();
+
+        /**
+         * @brief Запустить разбор загруженных изменений в отдельном потоке
+         */
+        void parseWorkSyncChanges(const QList<QByteArray>& _changesResponses);
+
+        /**
+         * @brief Завершить текущий этап синхронизации и перейти к следующему запрошенному
+         */
+        void finishWorkSync();
+
+        /**
+         * @brief Создать передачу данных для синхронизации во время работы
+         */
+        ChunkedTransfer* createWorkSyncTransfer(const QUrl& _url);
+
+        /**
+         * @brief Отправить позицию курсора и запросить курсоры соавторов
+         */
+        void loadCursors(int _cursorPosition, bool _isDraft);
 
         /**
          * @brief Проверка статуса соединения с интернетом
@@ -337,6 +495,138 @@ namespace ManagementLayer
          */
         QString m_lastDataSyncDatetime;
 
+        /**
+         * @brief Состояние синхронизации во время работы
+         */
+        enum WorkSyncState {
+            WorkSyncIdle,
+            WorkSyncUploading,
+            WorkSyncDownloading,
+            WorkSyncApplying
+        };
+
+        /**
+         * @brief Что синхронизируется во время работы
+         */
+        enum WorkSyncTarget {
+            WorkSyncScenario,
+            WorkSyncData
+        };
+
+        /**
+         * @brief Текущее состояние синхронизации во время работы
+         */
+        WorkSyncState m_workSyncState = WorkSyncIdle;
+
+        /**
+         * @brief Что синхронизируется в данный момент
+         */
+        WorkSyncTarget m_workSyncTarget = WorkSyncScenario;
+
+        /**
+         * @brief Запрошена ли синхронизация сценария
+         */
+        bool m_isWorkSyncScenarioRequested = false;
+
+        /**
+         * @brief Запрошена ли синхронизация данных
+         */
+        bool m_isWorkSyncDataRequested = false;
+
+        /**
+         * @brief Запрошена ли полная синхронизация сценария и данных
+         */
+        /** @{ */
+        bool m_isFullSyncScenarioRequested = false;
+        bool m_isFullSyncDataRequested = false;
+        /** @} */
+
+        /**
+         * @brief Является ли выполняемая синхронизация полной
+         */
+        bool m_isFullSync = false;
+
+        /**
+         * @brief Uuid'ы всех изменений на сервере, загруженные при полной синхронизации
+         */
+        QList<QString> m_fullSyncRemoteChanges;
+
+        /**
+         * @brief Проект, для которого выполняется синхронизация
+         */
+        int m_workSyncProjectId = 0;
+
+        /**
+         * @brief Время предыдущей синхронизации, восстанавливается, если изменения не удалось отправить
+         */
+        QString m_prevWorkSyncDatetime;
+
+        /**
+         * @brief Адрес выполняемого запроса синхронизации
+         */
+        QUrl m_workSyncUrl;
+
+        /**
+         * @brief Выполняемая передача данных синхронизации
+         */
+        ChunkedTransfer* m_workSyncTransfer = nullptr;
+
+        /**
+         * @brief Uuid'ы изменений в каждой из отправляемых частей
+         */
+        QList<QList<QString> > m_workSyncUploadChunks;
+
+        /**
+         * @brief Uuid'ы изменений в каждой из загружаемых частей
+         */
+        QList<QList<QString> > m_workSyncDownloadChunks;
+
+        /**
+         * @brief Наблюдатель за разбором загруженных изменений
+         */
+        QFutureWatcher<QList<QHash<QString, QString> > > m_workSyncChangesWatcher;
+
+        /**
+         * @brief Канал подписки на события проекта
+         */
+        SubscriptionChannel m_subscriptionChannel;
+
+        /**
+         * @brief Uuid'ы изменений сценария и данных, полученные по подписке, но ещё не обработанные
+         */
+        /** @{ */
+        QList<QString> m_pushedScenarioChanges;
+        QList<QString> m_pushedDataChanges;
+        /** @} */
+
+        /**
+         * @brief Нужно ли запросить список изменений, а не полагаться на подписку
+         * @note Список запрашивается после активации подписки, чтобы не пропустить изменения,
+         *       сделанные пока она была неактивна
+         */
+        /** @{ */
+        bool m_isScenarioChangesListNeeded = true;
+        bool m_isDataChangesListNeeded = true;
+        /** @} */
+
+        /**
+         * @brief Последняя отправленная позиция курсора
+         */
+        int m_lastSentCursorPosition = -1;
+        bool m_isLastSentCursorInDraft = false;
+
+        /**
+         * @brief Выполняется ли запрос позиций курсоров
+         */
+        bool m_isCursorsLoading = false;
+
+        /**
+         * @brief Позиция курсора, которую нужно отправить после завершения текущего запроса
+         * @note Отрицательное значение означает, что отправлять нечего
+         */
+        int m_pendingCursorPosition = -1;
+        bool m_isPendingCursorInDraft = false;
+
         /**
          * @brief Статус интернета. Неопределенный, отсутствует подключение,
          * присутствует подключение
@@ -153,7 +153,7 @@ void PrepareHandler::handleOther(QKeyEvent* _event)
 	QTextCursor topCursor(editor()->document());
 	topCursor.setPosition(qMin(cursor.selectionStart(), cursor.selectionEnd()));
 	ScenarioBlockStyle topStyle =
-			ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::forBlock(topCursor.block()));
+			ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::forBlock(topCursor.block()));
 
 	//
 	// Получим стиль последнего блока в выделении
@@ -161,7 +161,7 @@ void PrepareHandler::handleOther(QKeyEvent* _event)
 	QTextCursor bottomCursor(editor()->document());
 	bottomCursor.setPosition(qMax(cursor.selectionStart(), cursor.selectionEnd()));
 	ScenarioBlockStyle bottomStyle =
-			ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::forBlock(bottomCursor.block()));
+			ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::forBlock(bottomCursor.block()));
 
 	if (!_event->text().isEmpty()) {
 		//
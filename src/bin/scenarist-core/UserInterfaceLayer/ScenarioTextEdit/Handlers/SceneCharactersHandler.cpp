@@ -39,7 +39,7 @@ void SceneCharactersHandler::handleEnter(QKeyEvent*)
 	// ... текст после курсора
 	QString cursorForwardText = currentBlock.text().mid(cursor.positionInBlock());
 	// ... префикс и постфикс стиля
-	ScenarioBlockStyle style = ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::SceneCharacters);
+	ScenarioBlockStyle style = ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::SceneCharacters);
 	QString stylePrefix = style.prefix();
 	QString stylePostfix = style.postfix();
 
@@ -148,7 +148,7 @@ void SceneCharactersHandler::handleOther(QKeyEvent*)
 		cursorBackwardTextToComma = cursorBackwardTextToComma.split(", ").last();
 	}
 	// ... уберём префикс
-	ScenarioBlockStyle style = ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::SceneCharacters);
+	ScenarioBlockStyle style = ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::SceneCharacters);
 	QString stylePrefix = style.prefix();
 	if (!stylePrefix.isEmpty()
 		&& cursorBackwardTextToComma.startsWith(stylePrefix)) {
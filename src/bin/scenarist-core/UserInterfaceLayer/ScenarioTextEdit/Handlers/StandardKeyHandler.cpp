@@ -391,23 +391,23 @@ void StandardKeyHandler::removeCharacters(bool _backward)
 	//
 	// ... начала
 	//
-	ScenarioBlockStyle topStyle = ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::Undefined);
+	ScenarioBlockStyle topStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::Undefined);
 	QTextBlock topBlock;
 	{
 		QTextCursor topCursor(editor()->document());
 		topCursor.setPosition(topCursorPosition);
-		topStyle = ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::forBlock(topCursor.block()));
+		topStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::forBlock(topCursor.block()));
 		topBlock = topCursor.block();
 	}
 	//
 	// ... и конца
 	//
-	ScenarioBlockStyle bottomStyle = ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::Undefined);
+	ScenarioBlockStyle bottomStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::Undefined);
 	QTextBlock bottomBlock;
 	{
 		QTextCursor bottomCursor(editor()->document());
 		bottomCursor.setPosition(bottomCursorPosition);
-		bottomStyle = ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::forBlock(bottomCursor.block()));
+		bottomStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::forBlock(bottomCursor.block()));
 		bottomBlock = bottomCursor.block();
 
 
@@ -430,7 +430,7 @@ void StandardKeyHandler::removeCharacters(bool _backward)
 			while (topBlock == topCursor.block()
 				   && !topCursor.atStart()) {
 				topCursor.movePosition(QTextCursor::PreviousCharacter);
-				topStyle = ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::forBlock(topCursor.block()));
+				topStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::forBlock(topCursor.block()));
 			}
 
 			topCursorPosition = topCursor.position();
@@ -447,7 +447,7 @@ void StandardKeyHandler::removeCharacters(bool _backward)
 			while (bottomBlock == bottomCursor.block()
 				   && !bottomCursor.atEnd()) {
 				bottomCursor.movePosition(QTextCursor::NextCharacter);
-				bottomStyle = ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::forBlock(bottomCursor.block()));
+				bottomStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::forBlock(bottomCursor.block()));
 			}
 
 			bottomCursorPosition = bottomCursor.position();
@@ -228,8 +228,8 @@ void ScenarioTextEdit::changeScenarioBlockType(ScenarioBlockStyle::Type _blockTy
             //
             // Определим стили
             //
-            ScenarioBlockStyle oldStyle = ScenarioTemplateFacade::getTemplate().blockStyle(scenarioBlockType());
-            ScenarioBlockStyle newStyle = ScenarioTemplateFacade::getTemplate().blockStyle(_blockType);
+            ScenarioBlockStyle oldStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(scenarioBlockType());
+            ScenarioBlockStyle newStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(_blockType);
 
             //
             // Если необходимо сменить группирующий стиль на аналогичный
@@ -270,7 +270,7 @@ void ScenarioTextEdit::applyScenarioTypeToBlockText(ScenarioBlockStyle::Type _bl
     QTextCursor cursor = textCursor();
     cursor.beginEditBlock();
 
-    ScenarioBlockStyle newBlockStyle = ScenarioTemplateFacade::getTemplate().blockStyle(_blockType);
+    ScenarioBlockStyle newBlockStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(_blockType);
 
     //
     // Обновим стили
@@ -1102,7 +1102,7 @@ void ScenarioTextEdit::aboutLoadEditorState()
 void ScenarioTextEdit::cleanScenarioTypeFromBlock()
 {
     QTextCursor cursor = textCursor();
-    ScenarioBlockStyle oldBlockStyle = ScenarioTemplateFacade::getTemplate().blockStyle(scenarioBlockType());
+    ScenarioBlockStyle oldBlockStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(scenarioBlockType());
 
     //
     // Удалить завершающий блок группы сцен
@@ -1216,7 +1216,7 @@ void ScenarioTextEdit::applyScenarioTypeToBlock(ScenarioBlockStyle::Type _blockT
     QTextCursor cursor = textCursor();
     cursor.beginEditBlock();
 
-    ScenarioBlockStyle newBlockStyle = ScenarioTemplateFacade::getTemplate().blockStyle(_blockType);
+    ScenarioBlockStyle newBlockStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(_blockType);
 
     //
     // Обновим стили
@@ -1293,7 +1293,7 @@ void ScenarioTextEdit::applyScenarioTypeToBlock(ScenarioBlockStyle::Type _blockT
     // Вставим заголовок, если необходимо
     //
     if (newBlockStyle.hasHeader()) {
-        ScenarioBlockStyle headerStyle = ScenarioTemplateFacade::getTemplate().blockStyle(newBlockStyle.headerType());
+        ScenarioBlockStyle headerStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(newBlockStyle.headerType());
 
         cursor.movePosition(QTextCursor::StartOfBlock);
         cursor.insertBlock();
@@ -1309,7 +1309,7 @@ void ScenarioTextEdit::applyScenarioTypeToBlock(ScenarioBlockStyle::Type _blockT
     // Для заголовка группы нужно создать завершение, захватив всё содержимое сцены
     //
     if (newBlockStyle.isEmbeddableHeader()) {
-        ScenarioBlockStyle footerStyle = ScenarioTemplateFacade::getTemplate().blockStyle(newBlockStyle.embeddableFooter());
+        ScenarioBlockStyle footerStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(newBlockStyle.embeddableFooter());
 
         //
         // Запомним позицию курсора
@@ -1359,9 +1359,9 @@ void ScenarioTextEdit::applyScenarioTypeToBlock(ScenarioBlockStyle::Type _blockT
 
 void ScenarioTextEdit::applyScenarioGroupTypeToGroupBlock(ScenarioBlockStyle::Type _blockType)
 {
-    ScenarioBlockStyle oldBlockStyle = ScenarioTemplateFacade::getTemplate().blockStyle(scenarioBlockType());
-    ScenarioBlockStyle newBlockHeaderStyle = ScenarioTemplateFacade::getTemplate().blockStyle(_blockType);
-    ScenarioBlockStyle newBlockFooterStyle = ScenarioTemplateFacade::getTemplate().blockStyle(newBlockHeaderStyle.embeddableFooter());
+    ScenarioBlockStyle oldBlockStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(scenarioBlockType());
+    ScenarioBlockStyle newBlockHeaderStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(_blockType);
+    ScenarioBlockStyle newBlockFooterStyle = ScenarioTemplateFacade::sharedTemplate()->blockStyle(newBlockHeaderStyle.embeddableFooter());
 
     //
     // Сменим стиль заголовочного блока
@@ -365,7 +365,13 @@ SOURCES += \
     scenarist-core/3rd_party/Widgets/WAF/StackedWidgetAnimation/StackedWidgetAnimation.cpp \
     scenarist-core/3rd_party/Widgets/WAF/Animation/Expand/ExpandAnimator.cpp \
     scenarist-core/3rd_party/Widgets/WAF/Animation/Expand/ExpandDecorator.cpp \
-    scenarist-core/ManagementLayer/Synchronization/SynchronizationManager.cpp
+    scenarist-core/ManagementLayer/Synchronization/ChunkedTransfer.cpp \
+    scenarist-core/ManagementLayer/Synchronization/SubscriptionChannel.cpp \
+    scenarist-core/ManagementLayer/Synchronization/SynchronizationManager.cpp \
+    scenarist-core/BusinessLayer/ScenarioDocument/ScenarioXmlChecksum.cpp \
+    scenarist-core/BusinessLayer/ScenarioDocument/ScenarioModelItemsIndex.cpp \
+    scenarist-core/DataLayer/Database/DatabaseWriter.cpp \
+    scenarist-core/Domain/LazyPixmap.cpp
 
 HEADERS += \
     scenarist-desktop/ManagementLayer/ApplicationManager.h \
@@ -630,7 +636,9 @@ HEADERS += \
     scenarist-desktop/UserInterfaceLayer/Project/ShareDialog.h \
     scenarist-core/3rd_party/Helpers/Validators.h \
     scenarist-desktop/UserInterfaceLayer/StartUp/CrashReportDialog.h \
+    scenarist-core/ManagementLayer/Synchronization/ChunkedTransfer.h \
     scenarist-core/ManagementLayer/Synchronization/Sync.h \
+    scenarist-core/ManagementLayer/Synchronization/SubscriptionChannel.h \
     scenarist-core/3rd_party/Widgets/WAF/Animation/CircleFill/CircleFillAnimator.h \
     scenarist-core/3rd_party/Widgets/WAF/Animation/CircleFill/CircleFillDecorator.h \
     scenarist-core/3rd_party/Widgets/WAF/Animation/SideSlide/SideSlideAnimator.h \
@@ -651,7 +659,11 @@ HEADERS += \
     scenarist-core/3rd_party/Widgets/WAF/Animation/Expand/ExpandAnimator.h \
     scenarist-core/3rd_party/Widgets/WAF/Animation/Expand/ExpandDecorator.h \
     scenarist-core/3rd_party/Widgets/WAF/AbstractAnimator.h \
-    scenarist-core/ManagementLayer/Synchronization/SynchronizationManager.h
+    scenarist-core/ManagementLayer/Synchronization/SynchronizationManager.h \
+    scenarist-core/BusinessLayer/ScenarioDocument/ScenarioXmlChecksum.h \
+    scenarist-core/BusinessLayer/ScenarioDocument/ScenarioModelItemsIndex.h \
+    scenarist-core/DataLayer/Database/DatabaseWriter.h \
+    scenarist-core/Domain/LazyPixmap.h
 
 FORMS += \
     scenarist-desktop/UserInterfaceLayer/StartUp/StartUpView.ui \
@@ -23,6 +23,7 @@
 #include <Domain/ScenarioChange.h>
 
 #include <DataLayer/Database/Database.h>
+#include <DataLayer/Database/DatabaseWriter.h>
 #include <DataLayer/DataStorageLayer/DatabaseHistoryStorage.h>
 #include <DataLayer/DataStorageLayer/ScenarioChangeStorage.h>
 #include <DataLayer/DataStorageLayer/SettingsStorage.h>
@@ -39,6 +40,7 @@
 
 #include <QApplication>
 #include <QComboBox>
+#include <QDateTime>
 #include <QDesktopServices>
 #include <QFileDialog>
 #include <QLabel>
@@ -68,8 +70,8 @@ namespace {
      * @brief Номера пунктов меню
      */
     /** @{ */
-    const int PRINT_PREVIEW_MENU_INDEX = 7;
-    const int TWO_PANEL_MODE_MENU_INDEX = 9;
+    const int PRINT_PREVIEW_MENU_INDEX = 8;
+    const int TWO_PANEL_MODE_MENU_INDEX = 10;
     /** @} */
 
     /**
@@ -102,6 +104,16 @@ namespace {
      */
     const bool SYNC_UNAVAILABLE = false;
 
+    /**
+     * @brief Количество дней, за которые история изменений не сжимается
+     */
+    const int KEEP_HISTORY_DAYS = 30;
+
+    /**
+     * @brief Время бездействия пользователя, после которого сжимается история изменений проекта
+     */
+    const int COMPACT_IDLE_TIMEOUT = 10 * 60 * 1000; // 10 минут
+
     /**
      * @brief Неактивные при старте действия
      */
@@ -190,8 +202,12 @@ ApplicationManager::ApplicationManager(QObject *parent) :
     m_settingsManager(new SettingsManager(this, m_view)),
     m_importManager(new ImportManager(this, m_view)),
     m_exportManager(new ExportManager(this, m_view)),
-    m_synchronizationManager(new SynchronizationManager(this, m_view))
+    m_synchronizationManager(new SynchronizationManager(this, m_view)),
+    m_projectLoadingProgress(nullptr)
 {
+    m_compactTimer.setSingleShot(true);
+    m_compactTimer.setInterval(COMPACT_IDLE_TIMEOUT);
+
     initView();
     initConnections();
 
@@ -205,6 +221,11 @@ ApplicationManager::ApplicationManager(QObject *parent) :
 
 ApplicationManager::~ApplicationManager()
 {
+    //
+    // Поток записи останавливаем, пока приложение и драйвер базы данных ещё доступны
+    //
+    DatabaseLayer::DatabaseWriter::instance()->shutdown();
+
     delete m_view;
     m_view = 0;
 }
@@ -326,13 +347,7 @@ void ApplicationManager::createNewLocalProject(const QString& _filePath, const Q
             //
             // ... перейдём к редактированию
             //
-            goToEditCurrentProject();
-            //
-            // ... и импортируем, если надо
-            //
-            if (!_importFilePath.isEmpty()) {
-                m_importManager->importScenario(m_scenarioManager->scenario(), _importFilePath);
-            }
+            goToEditCurrentProject(_importFilePath);
         }
         //
         // Если невозможно записать в файл, предупреждаем пользователя и отваливаемся
@@ -383,13 +398,7 @@ void ApplicationManager::createNewRemoteProject(const QString& _projectName, con
         //
         // ... перейдём к редактированию
         //
-        goToEditCurrentProject();
-        //
-        // ... и импортируем, если надо
-        //
-        if (!_importFilePath.isEmpty()) {
-            m_importManager->importScenario(m_scenarioManager->scenario(), _importFilePath);
-        }
+        goToEditCurrentProject(_importFilePath);
     }
     //
     // Если переключиться не удалось, сообщаем пользователю об ошибке
@@ -441,6 +450,17 @@ void ApplicationManager::aboutSaveAs()
         // ... если сохраняем в новый файл
         //
         else {
+            //
+            // ... копировать файл можно только когда в него записаны все изменения
+            //
+            if (!DatabaseLayer::DatabaseWriter::instance()->waitForFinished()) {
+                QLightBoxMessage::critical(m_view, tr("Saving error"),
+                    tr("Can't write you changes to project. There is some internal database error: %1 "
+                       "Please check that file is exists and you have permissions to write in it.")
+                    .arg(DatabaseLayer::DatabaseWriter::instance()->lastError()));
+                return;
+            }
+
             //
             // ... если файл существовал, удалим его для удаления данных в нём
             //
@@ -449,8 +469,9 @@ void ApplicationManager::aboutSaveAs()
             }
 
             //
-            // ... скопируем текущую базу в указанный файл
+            // ... скопируем текущую базу в указанный файл, предварительно перенеся в неё журнал
             //
+            DatabaseLayer::Database::checkpoint();
             if (QFile::copy(ProjectsManager::currentProject().path(), saveAsProjectFileName)) {
                 //
                 // ... отключаем индикатор соединения, если мы работали с облаком
@@ -498,12 +519,7 @@ void ApplicationManager::aboutSave()
         //
         // Управляющие должны сохранить несохранённые данные
         //
-        DatabaseLayer::Database::transaction();
-        m_researchManager->saveResearch();
-        m_scenarioManager->saveCurrentProject();
-        m_charactersManager->saveCharacters();
-        m_locationsManager->saveLocations();
-        DatabaseLayer::Database::commit();
+        saveProjectChanges();
 
         //
         // Обновим информацию о последнем изменении
@@ -522,6 +538,7 @@ void ApplicationManager::aboutSave()
             //
             // Если необходимо создадим резервную копию закрываемого файла
             //
+            DatabaseLayer::Database::checkpoint();
             QtConcurrent::run(&m_backupHelper, &BackupHelper::saveBackup, ProjectsManager::currentProject().path());
         }
         //
@@ -545,6 +562,7 @@ void ApplicationManager::aboutSave()
                 // ... пробуем повторно открыть базу данных и записать в неё изменения
                 //
                 if (messageResult == QDialogButtonBox::Yes) {
+                    DatabaseLayer::DatabaseWriter::instance()->retry();
                     DatabaseLayer::Database::setCurrentFile(DatabaseLayer::Database::currentFile());
                     aboutSave();
                 }
@@ -566,6 +584,7 @@ void ApplicationManager::aboutSave()
                 // ... пробуем повторно сохранить изменения в базу данных
                 //
                 if (messageResult == QDialogButtonBox::Yes) {
+                    DatabaseLayer::DatabaseWriter::instance()->retry();
                     aboutSave();
                 }
             }
@@ -581,6 +600,151 @@ void ApplicationManager::aboutSave()
     }
 }
 
+void ApplicationManager::aboutAutosave()
+{
+    //
+    // Если какие-то данные изменены
+    //
+    if (m_view->isWindowModified()) {
+        //
+        // Управляющие формируют снимок несохранённых данных, а в файл он записывается
+        // в потоке записи, о результате которой будет сообщено сигналом
+        //
+        DatabaseLayer::DatabaseWriter::instance()->beginSnapshot();
+        saveProjectChanges();
+        DatabaseLayer::DatabaseWriter::instance()->commitSnapshot();
+
+        //
+        // Изменения, сделанные пока идёт запись, попадут уже в следующий снимок
+        //
+        ::updateWindowModified(m_view, false);
+    }
+    //
+    // Для проекта из облака синхронизируем данные
+    //
+    else if (m_projectsManager->currentProject().isRemote()) {
+        m_synchronizationManager->aboutWorkSyncScenario();
+        m_synchronizationManager->aboutWorkSyncData();
+    }
+}
+
+void ApplicationManager::aboutBackgroundSaveFinished()
+{
+    //
+    // Обновим информацию о последнем изменении
+    //
+    aboutUpdateLastChangeInfo();
+
+    //
+    // Если необходимо создадим резервную копию файла, журнал в него уже перенесён потоком записи
+    //
+    QtConcurrent::run(&m_backupHelper, &BackupHelper::saveBackup, ProjectsManager::currentProject().path());
+
+    //
+    // Для проекта из облака синхронизируем данные, когда они уже записаны в файл
+    //
+    if (m_projectsManager->currentProject().isRemote()) {
+        m_synchronizationManager->aboutWorkSyncScenario();
+        m_synchronizationManager->aboutWorkSyncData();
+    }
+}
+
+void ApplicationManager::aboutBackgroundSaveFailed(const QString& _error)
+{
+    //
+    // Данные не сохранены
+    //
+    DatabaseLayer::Database::setLastError(_error);
+    ::updateWindowModified(m_view, true);
+
+    QDialogButtonBox::StandardButton messageResult = QDialogButtonBox::No;
+    //
+    // Если файл, в который мы пробуем сохранять изменения существует
+    //
+    if (QFile::exists(DatabaseLayer::Database::currentFile())) {
+        //
+        // ... то у нас случилась какая-то внутренняя ошибка базы данных
+        //
+        messageResult =
+                QLightBoxMessage::critical(m_view, tr("Saving error"),
+                                           tr("Can't write you changes to project. There is some internal database error: %1 "
+                                              "Please check that file is exists and you have permissions to write in it. Retry to save?")
+                                           .arg(_error),
+                                           QDialogButtonBox::Yes | QDialogButtonBox::No, QDialogButtonBox::Yes);
+    }
+    //
+    // Файла с базой данных не найдено
+    //
+    else {
+        //
+        // ... возможно файл был на флешке, а она отошла, или файл был переименован во время работы программы
+        //
+        messageResult =
+                QLightBoxMessage::critical(m_view, tr("Saving error"),
+                    tr("Can't write you changes to project located at <b>%1</b> becourse file isn't exist. "
+                       "Please move file back and retry to save. Retry to save?")
+                        .arg(DatabaseLayer::Database::currentFile()),
+                    QDialogButtonBox::Yes | QDialogButtonBox::No, QDialogButtonBox::Yes);
+    }
+
+    //
+    // ... пробуем повторно записать снимок, или отказываемся от него
+    //
+    if (messageResult == QDialogButtonBox::Yes) {
+        DatabaseLayer::DatabaseWriter::instance()->retry();
+    } else {
+        DatabaseLayer::DatabaseWriter::instance()->discardFailed();
+    }
+}
+
+void ApplicationManager::aboutFullSyncFinished()
+{
+    //
+    // Полная синхронизация выполняется и при перезапуске сессии, но загрузку продолжаем,
+    // только если проект ожидает её завершения
+    //
+    if (m_projectLoadingProgress != nullptr
+        && isProjectLoaded()) {
+        finishEditCurrentProject();
+    }
+}
+
+void ApplicationManager::aboutCompactProject()
+{
+    if (isProjectLoaded()) {
+        QLightBoxProgress progress(m_view);
+        progress.showProgress(tr("Compacting Project"), tr("Please wait. Compacting can take few minutes."));
+
+        compactProject();
+
+        //
+        // Пересобираем файл даже если история не сжималась, чтобы освободить место,
+        // оставшееся от удалённых данных
+        //
+        DatabaseLayer::DatabaseWriter::instance()->vacuum();
+        DatabaseLayer::DatabaseWriter::instance()->waitForFinished();
+
+        progress.finish();
+    }
+}
+
+void ApplicationManager::aboutCompactProjectOnIdle()
+{
+    //
+    // Сжимаем историю только когда все изменения записаны в файл
+    //
+    if (isProjectLoaded()
+        && !m_view->isWindowModified()
+        && !DatabaseLayer::DatabaseWriter::instance()->isBusy()) {
+        //
+        // ... файл пересобирается в потоке записи, чтобы не блокировать интерфейс
+        //
+        if (compactProject() > 0) {
+            DatabaseLayer::DatabaseWriter::instance()->vacuum();
+        }
+    }
+}
+
 void ApplicationManager::saveCurrentProjectSettings(const QString& _projectPath)
 {
     //
@@ -1146,6 +1310,11 @@ void ApplicationManager::aboutProjectChanged()
     if (isProjectLoaded()) {
         ::updateWindowModified(m_view, true);
         m_statisticsManager->scenarioTextChanged();
+
+        //
+        // Откладываем сжатие истории, пока пользователь работает с проектом
+        //
+        m_compactTimer.start();
     }
 }
 
@@ -1352,16 +1521,43 @@ bool ApplicationManager::saveIfNeeded()
         }
     }
 
+    //
+    // Если запись изменений в фоне приостановлена из-за ошибки, то проект можно закрыть, только
+    // когда пользователь повторит запись, или откажется от неё
+    //
+    while (success
+           && !DatabaseLayer::DatabaseWriter::instance()->waitForFinished()) {
+        const QDialogButtonBox::StandardButton messageResult =
+                QLightBoxMessage::critical(m_view, tr("Saving error"),
+                                           tr("Can't write you changes to project. There is some internal database error: %1 "
+                                              "Please check that file is exists and you have permissions to write in it. Retry to save?")
+                                           .arg(DatabaseLayer::DatabaseWriter::instance()->lastError()),
+                                           QDialogButtonBox::Cancel | QDialogButtonBox::Yes | QDialogButtonBox::No,
+                                           QDialogButtonBox::Yes);
+        if (messageResult == QDialogButtonBox::Yes) {
+            DatabaseLayer::DatabaseWriter::instance()->retry();
+        } else if (messageResult == QDialogButtonBox::No) {
+            DatabaseLayer::DatabaseWriter::instance()->discardFailed();
+        } else {
+            success = false;
+        }
+    }
+
     return success;
 }
 
-void ApplicationManager::goToEditCurrentProject()
+void ApplicationManager::goToEditCurrentProject(const QString& _importFilePath)
 {
     //
-    // Покажем уведомление пользователю
+    // Импортировать сценарий можно только после загрузки проекта, поэтому запомним, откуда
     //
-    QLightBoxProgress progress(m_view);
-    progress.showProgress(tr("Loading Scenario"), tr("Please wait. Loading can take few minutes."));
+    m_pendingImportFilePath = _importFilePath;
+
+    //
+    // Покажем уведомление пользователю, оно будет закрыто после загрузки всех данных проекта
+    //
+    m_projectLoadingProgress = new QLightBoxProgress(m_view);
+    m_projectLoadingProgress->showProgress(tr("Loading Scenario"), tr("Please wait. Loading can take few minutes."));
 
     //
     // Установим заголовок
@@ -1397,14 +1593,23 @@ void ApplicationManager::goToEditCurrentProject()
     m_scenarioManager->loadCurrentProject();
 
     //
-    // Синхронизируем проекты из облака
+    // Синхронизируем проекты из облака, синхронизация выполняется асинхронно, поэтому
+    // загрузку продолжим, когда она будет завершена
     //
     if (m_projectsManager->currentProject().isRemote()) {
-        progress.setProgressText(QString::null, tr("Sync scenario with cloud service."));
+        m_projectLoadingProgress->setProgressText(QString::null, tr("Sync scenario with cloud service."));
         m_synchronizationManager->aboutFullSyncScenario();
         m_synchronizationManager->aboutFullSyncData();
+        if (m_synchronizationManager->isFullSyncRunning()) {
+            return;
+        }
     }
 
+    finishEditCurrentProject();
+}
+
+void ApplicationManager::finishEditCurrentProject()
+{
     //
     // Загрузить данные из файла
     // Делать это нужно после того, как все данные синхронизировались
@@ -1446,15 +1651,45 @@ void ApplicationManager::goToEditCurrentProject()
     //
     aboutUpdateLastChangeInfo();
 
+    //
+    // Сожмём историю изменений, когда пользователь перестанет работать с проектом
+    //
+    m_compactTimer.start();
+
     //
     // Закроем уведомление
     //
-    progress.finish();
+    m_projectLoadingProgress->finish();
+    m_projectLoadingProgress->deleteLater();
+    m_projectLoadingProgress = nullptr;
+
+    //
+    // Импортируем сценарий, если надо, после запуска обработки изменений, чтобы импортированный
+    // текст попал в историю изменений и был отправлен в облако
+    //
+    if (!m_pendingImportFilePath.isEmpty()) {
+        const QString importFilePath = m_pendingImportFilePath;
+        m_pendingImportFilePath.clear();
+        m_importManager->importScenario(m_scenarioManager->scenario(), importFilePath);
+    }
 }
 
 void ApplicationManager::closeCurrentProject()
 {
+    m_pendingImportFilePath.clear();
+
     if (isProjectLoaded()) {
+        m_compactTimer.stop();
+
+        //
+        // Если проект закрывается, не дождавшись синхронизации, то продолжать его загрузку уже не нужно
+        //
+        if (m_projectLoadingProgress != nullptr) {
+            m_projectLoadingProgress->finish();
+            m_projectLoadingProgress->deleteLater();
+            m_projectLoadingProgress = nullptr;
+        }
+
         //
         // Сохраним настройки закрываемого проекта
         //
@@ -1628,8 +1863,10 @@ QMenu* ApplicationManager::createMenu()
     QAction* saveProject = menu->addAction(tr("Save"));
     saveProject->setShortcut(QKeySequence::Save);
     QAction* saveProjectAs = menu->addAction(tr("Save As..."));
+    QAction* compactProject = menu->addAction(tr("Compact Project"));
     g_disableOnStartActions << saveProject;
     g_disableOnStartActions << saveProjectAs;
+    g_disableOnStartActions << compactProject;
 
     menu->addSeparator();
     // ... импорт
@@ -1655,6 +1892,7 @@ QMenu* ApplicationManager::createMenu()
     connect(openProject, SIGNAL(triggered()), this, SLOT(aboutLoad()));
     connect(saveProject, SIGNAL(triggered()), this, SLOT(aboutSave()));
     connect(saveProjectAs, SIGNAL(triggered()), this, SLOT(aboutSaveAs()));
+    connect(compactProject, SIGNAL(triggered()), this, SLOT(aboutCompactProject()));
     connect(import, SIGNAL(triggered()), this, SLOT(aboutImport()));
     connect(exportTo, SIGNAL(triggered()), this, SLOT(aboutExport()));
     connect(printPreview, SIGNAL(triggered()), this, SLOT(aboutPrintPreview()));
@@ -1671,10 +1909,64 @@ QMenu* ApplicationManager::createMenu()
     return menu;
 }
 
+void ApplicationManager::saveProjectChanges()
+{
+    DatabaseLayer::Database::transaction();
+    m_researchManager->saveResearch();
+    m_scenarioManager->saveCurrentProject();
+    m_charactersManager->saveCharacters();
+    m_locationsManager->saveLocations();
+    DatabaseLayer::Database::commit();
+}
+
+int ApplicationManager::compactProject()
+{
+    //
+    // Дожидаемся записи изменений, чтобы работать с данными, которые уже есть в файле,
+    // а если запись приостановлена из-за ошибки, то ничего не сжимаем
+    //
+    if (!DatabaseLayer::DatabaseWriter::instance()->waitForFinished()) {
+        return 0;
+    }
+
+    //
+    // История за последние дни сохраняется целиком
+    //
+    const QString keepHistoryFrom =
+            QDateTime::currentDateTimeUtc().addDays(-KEEP_HISTORY_DAYS).toString("yyyy-MM-dd hh:mm:ss");
+    QString compactChangesTo = keepHistoryFrom;
+    QString compactDataTo = keepHistoryFrom;
+
+    //
+    // У проекта из облака сжимаются только те изменения, которые уже есть на сервере,
+    // т.к. соавторы могут их ещё не получить
+    //
+    if (m_projectsManager->currentProject().isRemote()) {
+        compactChangesTo =
+                qMin(compactChangesTo, DataStorageLayer::StorageFacade::scenarioChangeStorage()->syncedDatetime());
+        compactDataTo =
+                qMin(compactDataTo, DataStorageLayer::StorageFacade::databaseHistoryStorage()->syncedDatetime());
+    }
+
+    DatabaseLayer::Database::transaction();
+    int compacted = DataStorageLayer::StorageFacade::scenarioChangeStorage()->compact(compactChangesTo);
+    compacted += DataStorageLayer::StorageFacade::databaseHistoryStorage()->compact(compactDataTo);
+    DatabaseLayer::Database::commit();
+
+    return compacted;
+}
+
 void ApplicationManager::initConnections()
 {
     connect(m_view, SIGNAL(wantToClose()), this, SLOT(aboutExit()));
 
+    connect(DatabaseLayer::DatabaseWriter::instance(), SIGNAL(snapshotWritten()),
+            this, SLOT(aboutBackgroundSaveFinished()));
+    connect(DatabaseLayer::DatabaseWriter::instance(), SIGNAL(snapshotFailed(QString)),
+            this, SLOT(aboutBackgroundSaveFailed(QString)));
+
+    connect(&m_compactTimer, SIGNAL(timeout()), this, SLOT(aboutCompactProjectOnIdle()));
+
     connect(m_menu, SIGNAL(clicked()), m_menu, SLOT(showMenu()));
     connect(m_tabs, &SideTabBar::currentChanged, this, &ApplicationManager::currentTabIndexChanged);
     connect(m_tabsSecondary, &SideTabBar::currentChanged, this, &ApplicationManager::currentTabIndexChanged);
@@ -1763,10 +2055,11 @@ void ApplicationManager::initConnections()
     connect(m_locationsManager, SIGNAL(locationChanged()), this, SLOT(aboutProjectChanged()));
     connect(m_exportManager, SIGNAL(scenarioTitleListDataChanged()), this, SLOT(aboutProjectChanged()));
 
-    connect(m_synchronizationManager, SIGNAL(applyPatchRequested(QString,bool)),
-            m_scenarioManager, SLOT(aboutApplyPatch(QString,bool)));
-    connect(m_synchronizationManager, SIGNAL(applyPatchesRequested(QList<QString>,bool)),
-            m_scenarioManager, SLOT(aboutApplyPatches(QList<QString>,bool)));
+    connect(m_synchronizationManager, SIGNAL(applyPatchRequested(QByteArray,bool)),
+            m_scenarioManager, SLOT(aboutApplyPatch(QByteArray,bool)));
+    connect(m_synchronizationManager, SIGNAL(applyPatchesRequested(QList<QByteArray>,bool)),
+            m_scenarioManager, SLOT(aboutApplyPatches(QList<QByteArray>,bool)));
+    connect(m_synchronizationManager, SIGNAL(fullSyncFinished()), this, SLOT(aboutFullSyncFinished()));
     connect(m_synchronizationManager, SIGNAL(cursorsUpdated(QMap<QString,int>,bool)),
             m_scenarioManager, SLOT(aboutCursorsUpdated(QMap<QString,int>,bool)));
     connect(m_synchronizationManager, SIGNAL(syncClosedWithError(int,QString)),
@@ -1925,7 +2218,7 @@ void ApplicationManager::reloadApplicationSettings()
     m_autosaveTimer.stop();
     m_autosaveTimer.disconnect();
     if (autosave) {
-        connect(&m_autosaveTimer, SIGNAL(timeout()), this, SLOT(aboutSave()));
+        connect(&m_autosaveTimer, SIGNAL(timeout()), this, SLOT(aboutAutosave()));
         m_autosaveTimer.start(autosaveInterval * 60 * 1000); // Переводим минуты в миллисекунды
     }
 
@@ -1944,6 +2237,26 @@ void ApplicationManager::reloadApplicationSettings()
     m_backupHelper.setIsActive(saveBackups);
     m_backupHelper.setBackupDir(saveBackupsFolder);
 
+    //
+    // Параметры соединений с базой данных, применяются к открываемым после этого проектам
+    //
+    const bool databaseDurableWrites =
+            DataStorageLayer::StorageFacade::settingsStorage()->value(
+                "application/database-durable-writes",
+                DataStorageLayer::SettingsStorage::ApplicationSettings)
+            .toInt();
+    const int databaseCacheSize =
+            DataStorageLayer::StorageFacade::settingsStorage()->value(
+                "application/database-cache-size",
+                DataStorageLayer::SettingsStorage::ApplicationSettings)
+            .toInt();
+    const int databaseMmapSize =
+            DataStorageLayer::StorageFacade::settingsStorage()->value(
+                "application/database-mmap-size",
+                DataStorageLayer::SettingsStorage::ApplicationSettings)
+            .toInt();
+    DatabaseLayer::Database::setConnectionSettings(databaseDurableWrites, databaseCacheSize, databaseMmapSize);
+
     //
     // Разделение экрана на две панели
     //
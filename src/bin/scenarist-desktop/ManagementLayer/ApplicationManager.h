@@ -7,6 +7,7 @@
 #include <QTimer>
 
 class SideTabBar;
+class QLightBoxProgress;
 class QLabel;
 class QSplitter;
 class QStackedWidget;
@@ -79,6 +80,37 @@ namespace ManagementLayer
 		 */
 		void aboutSave();
 
+		/**
+		 * @brief Сохранить в файл в фоне
+		 * @note Несохранённые данные собираются в снимок, который записывается в потоке записи БД
+		 */
+		void aboutAutosave();
+
+		/**
+		 * @brief Фоновое сохранение завершено
+		 */
+		void aboutBackgroundSaveFinished();
+
+		/**
+		 * @brief Фоновое сохранение завершилось с ошибкой
+		 */
+		void aboutBackgroundSaveFailed(const QString& _error);
+
+		/**
+		 * @brief Завершена полная синхронизация, можно продолжить загрузку проекта
+		 */
+		void aboutFullSyncFinished();
+
+		/**
+		 * @brief Сжать историю изменений текущего проекта и пересобрать его файл
+		 */
+		void aboutCompactProject();
+
+		/**
+		 * @brief Сжать историю изменений текущего проекта, если пользователь с ним не работает
+		 */
+		void aboutCompactProjectOnIdle();
+
 		/**
 		 * @brief Сохранить настройки текущего проекта
 		 */
@@ -223,8 +255,15 @@ namespace ManagementLayer
 
 		/**
 		 * @brief Настроить текущий проект для редактирования
+		 * @param _importFilePath - файл, из которого нужно импортировать сценарий после загрузки проекта
+		 * @note Проект из облака настраивается до конца после его полной синхронизации
 		 */
-		void goToEditCurrentProject();
+		void goToEditCurrentProject(const QString& _importFilePath = QString::null);
+
+		/**
+		 * @brief Загрузить данные текущего проекта и завершить его настройку для редактирования
+		 */
+		void finishEditCurrentProject();
 
 		/**
 		 * @brief Закрыть текущий проект
@@ -252,6 +291,17 @@ namespace ManagementLayer
 		 */
 		void initConnections();
 
+		/**
+		 * @brief Сохранить несохранённые данные всех управляющих
+		 */
+		void saveProjectChanges();
+
+		/**
+		 * @brief Сжать историю изменений текущего проекта
+		 * @return Количество сжатых изменений
+		 */
+		int compactProject();
+
 		/**
 		 * @brief Настроить внешний вид
 		 */
@@ -368,10 +418,25 @@ namespace ManagementLayer
 		 */
 		QTimer m_autosaveTimer;
 
+		/**
+		 * @brief Таймер сжатия истории изменений при бездействии пользователя
+		 */
+		QTimer m_compactTimer;
+
 		/**
 		 * @brief Помощник резервного копирования
 		 */
 		BackupHelper m_backupHelper;
+
+		/**
+		 * @brief Уведомление о загрузке проекта, показываемое на время его полной синхронизации
+		 */
+		QLightBoxProgress* m_projectLoadingProgress;
+
+		/**
+		 * @brief Файл, из которого нужно импортировать сценарий после загрузки проекта
+		 */
+		QString m_pendingImportFilePath;
 	};
 }
 
@@ -139,13 +139,7 @@ void ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, i
 			//
 			// Добавить новых
 			//
-			DatabaseLayer::Database::transaction();
-			foreach (const QString& character, characters) {
-				if (!DataStorageLayer::StorageFacade::characterStorage()->hasCharacter(character)) {
-					DataStorageLayer::StorageFacade::characterStorage()->storeCharacter(character);
-				}
-			}
-			DatabaseLayer::Database::commit();
+			DataStorageLayer::StorageFacade::characterStorage()->storeCharacters(characters.toList());
 		}
 
 		//
@@ -178,13 +172,7 @@ void ImportManager::importScenario(BusinessLogic::ScenarioDocument* _scenario, i
 			//
 			// Добавить новых
 			//
-			DatabaseLayer::Database::transaction();
-			foreach (const QString& location, locations) {
-				if (!DataStorageLayer::StorageFacade::locationStorage()->hasLocation(location)) {
-					DataStorageLayer::StorageFacade::locationStorage()->storeLocation(location);
-				}
-			}
-			DatabaseLayer::Database::commit();
+			DataStorageLayer::StorageFacade::locationStorage()->storeLocations(locations.toList());
 		}
 	}
 }
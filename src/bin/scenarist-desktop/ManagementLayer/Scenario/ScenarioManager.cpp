@@ -30,6 +30,7 @@
 #include <3rd_party/Helpers/ShortcutHelper.h>
 #include <3rd_party/Widgets/FlatButton/FlatButton.h>
 #include <3rd_party/Widgets/QLightBoxWidget/qlightboxmessage.h>
+#include <3rd_party/Widgets/QLightBoxWidget/qlightboxprogress.h>
 #include <3rd_party/Widgets/TabBar/TabBar.h>
 
 #include <QApplication>
@@ -51,6 +52,7 @@ using ManagementLayer::ScenarioSceneDescriptionManager;
 using ManagementLayer::ScenarioDataEditManager;
 using ManagementLayer::ScenarioTextEditManager;
 using BusinessLogic::ScenarioDocument;
+using BusinessLogic::ScenarioTextDocument;
 using BusinessLogic::ScenarioBlockStyle;
 
 namespace {
@@ -196,7 +198,7 @@ namespace {
         do {
             cursor.movePosition(QTextCursor::StartOfBlock);
             ScenarioBlockStyle blockStyle =
-                BusinessLogic::ScenarioTemplateFacade::getTemplate().blockStyle(cursor.block());
+                BusinessLogic::ScenarioTemplateFacade::sharedTemplate()->blockStyle(cursor.block());
             //
             // Если в блоке есть выделения, обновляем цвет только тех частей, которые не входят в выделения
             //
@@ -508,13 +510,7 @@ void ScenarioManager::aboutRefreshCharacters()
         //
         // Добавить новых
         //
-        DatabaseLayer::Database::transaction();
-        foreach (const QString& character, characters) {
-            if (!DataStorageLayer::StorageFacade::characterStorage()->hasCharacter(character)) {
-                DataStorageLayer::StorageFacade::characterStorage()->storeCharacter(character);
-            }
-        }
-        DatabaseLayer::Database::commit();
+        DataStorageLayer::StorageFacade::characterStorage()->storeCharacters(characters.toList());
     }
 }
 
@@ -576,17 +572,11 @@ void ScenarioManager::aboutRefreshLocations()
         //
         // Добавить новых
         //
-        DatabaseLayer::Database::transaction();
-        foreach (const QString& location, locations) {
-            if (!DataStorageLayer::StorageFacade::locationStorage()->hasLocation(location)) {
-                DataStorageLayer::StorageFacade::locationStorage()->storeLocation(location);
-            }
-        }
-        DatabaseLayer::Database::commit();
+        DataStorageLayer::StorageFacade::locationStorage()->storeLocations(locations.toList());
     }
 }
 
-void ScenarioManager::aboutApplyPatch(const QString& _patch, bool _isDraft)
+void ScenarioManager::aboutApplyPatch(const QByteArray& _patch, bool _isDraft)
 {
     if (_isDraft) {
         m_scenarioDraft->document()->applyPatch(_patch);
@@ -595,13 +585,19 @@ void ScenarioManager::aboutApplyPatch(const QString& _patch, bool _isDraft)
     }
 }
 
-void ScenarioManager::aboutApplyPatches(const QList<QString>& _patches, bool _isDraft)
+void ScenarioManager::aboutApplyPatches(const QList<QByteArray>& _patches, bool _isDraft)
 {
-    if (_isDraft) {
-        m_scenarioDraft->document()->applyPatches(_patches);
-    } else {
-        m_scenario->document()->applyPatches(_patches);
-    }
+    ScenarioTextDocument* document = _isDraft ? m_scenarioDraft->document() : m_scenario->document();
+
+    //
+    // Отображаем ход применения патчей
+    //
+    const QMetaObject::Connection progressConnection =
+        connect(document, &ScenarioTextDocument::patchesApplyProgress, [] (int _applied, int _total) {
+            QLightBoxProgress::setProgressValue(_applied * 100 / _total);
+        });
+    document->applyPatches(_patches);
+    disconnect(progressConnection);
 }
 
 void ScenarioManager::aboutCursorsUpdated(const QMap<QString, int>& _cursors, bool _isDraft)
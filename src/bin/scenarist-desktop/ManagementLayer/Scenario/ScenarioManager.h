@@ -143,8 +143,8 @@ namespace ManagementLayer
          * @brief Применить патч к сценарию
          */
         /** @{ */
-        void aboutApplyPatch(const QString& _patch, bool _isDraft);
-        void aboutApplyPatches(const QList<QString>& _patches, bool _isDraft);
+        void aboutApplyPatch(const QByteArray& _patch, bool _isDraft);
+        void aboutApplyPatches(const QList<QByteArray>& _patches, bool _isDraft);
         /** @} */
 
         /**
@@ -648,7 +648,7 @@ void SettingsManager::templateLibrarySavePressed(const QModelIndex& _templateInd
 		if (!templateFilePath.endsWith(SCENARIO_TEMPLATE_FILE_EXTENSION)) {
 			templateFilePath += "." + SCENARIO_TEMPLATE_FILE_EXTENSION;
 		}
-		ScenarioTemplateFacade::getTemplate(templateToSaveName).saveToFile(templateFilePath);
+		ScenarioTemplateFacade::sharedTemplate(templateToSaveName)->saveToFile(templateFilePath);
 	}
 
 	//
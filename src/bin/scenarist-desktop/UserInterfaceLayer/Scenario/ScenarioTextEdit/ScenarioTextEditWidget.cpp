@@ -122,9 +122,9 @@ void ScenarioTextEditWidget::setUsePageView(bool _use)
     QMarginsF pageMargins(15, 5, 5, 5);
     Qt::Alignment pageNumbersAlign;
     if (_use) {
-        m_editor->setPageFormat(ScenarioTemplateFacade::getTemplate().pageSizeId());
-        pageMargins = ScenarioTemplateFacade::getTemplate().pageMargins();
-        pageNumbersAlign = ScenarioTemplateFacade::getTemplate().numberingAlignment();
+        m_editor->setPageFormat(ScenarioTemplateFacade::sharedTemplate()->pageSizeId());
+        pageMargins = ScenarioTemplateFacade::sharedTemplate()->pageMargins();
+        pageNumbersAlign = ScenarioTemplateFacade::sharedTemplate()->numberingAlignment();
     }
 
     m_editor->setUsePageMode(_use);
@@ -135,7 +135,7 @@ void ScenarioTextEditWidget::setUsePageView(bool _use)
     // В дополнение установим шрифт по умолчанию для документа (шрифтом будет рисоваться нумерация)
     //
     m_editor->document()->setDefaultFont(
-        ScenarioTemplateFacade::getTemplate().blockStyle(ScenarioBlockStyle::Action).font());
+        ScenarioTemplateFacade::sharedTemplate()->blockStyle(ScenarioBlockStyle::Action).font());
 }
 
 void ScenarioTextEditWidget::setUseSpellChecker(bool _use)
@@ -266,8 +266,8 @@ void ScenarioTextEditWidget::addItem(int _position, int _type, const QString& _h
     //
     // Если это группирующий блок, то вставим и закрывающий текст
     //
-    if (ScenarioTemplateFacade::getTemplate().blockStyle(type).isEmbeddableHeader()) {
-        ScenarioBlockStyle::Type footerType = ScenarioTemplateFacade::getTemplate().blockStyle(type).embeddableFooter();
+    if (ScenarioTemplateFacade::sharedTemplate()->blockStyle(type).isEmbeddableHeader()) {
+        ScenarioBlockStyle::Type footerType = ScenarioTemplateFacade::sharedTemplate()->blockStyle(type).embeddableFooter();
         cursor = m_editor->textCursor();
         //
         // Но сначала дойдём до подготовленного заранее закрывающего блока
@@ -589,7 +589,7 @@ void ScenarioTextEditWidget::initView()
     m_duration->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
 
     m_editor->setObjectName("scenarioEditor");
-    m_editor->setPageFormat(ScenarioTemplateFacade::getTemplate().pageSizeId());
+    m_editor->setPageFormat(ScenarioTemplateFacade::sharedTemplate()->pageSizeId());
 
     m_searchLine->setEditor(m_editor);
     m_searchLine->hide();
@@ -19,8 +19,18 @@
 #include "WebRequest_p.h"
 #include "NetworkRequestPrivate_p.h"
 
+namespace {
+    /**
+     * @brief Количество WebLoader'ов, которые не занимаются под запросы с приоритетом BulkPriority и ниже,
+     *        чтобы большие и фоновые загрузки не задерживали срочные запросы
+     */
+    const int RESERVED_LOADERS_COUNT = 1;
+}
+
 NetworkQueue::NetworkQueue()
 {
+    qRegisterMetaType<NetworkTimings>();
+
     //
     // В нужном количестве создадим WebLoader'ы
     // И сразу же соединим их со слотом данного класса, обозначающим завершение
@@ -38,34 +48,63 @@ NetworkQueue* NetworkQueue::getInstance() {
 }
 
 void NetworkQueue::put(NetworkRequestPrivate* _request) {
+    //
+    // Отменим устаревшие запросы, которые замещает пришедший
+    //
+    if (!_request->m_supersedeKey.isEmpty()) {
+        supersede(_request->m_supersedeKey);
+    }
+
     //
     // Положим в очередь пришедший запрос
     //
-    m_queue.push_back(_request);
+    m_queue[_request->m_priority].push_back(_request);
     m_inQueue.insert(_request);
+    _request->m_queuedTimer.start();
 
     //
     // В случае, если есть свободный WebLoader
-    // Извлечем пришедший запрос из очереди и начнем выполнять его
+    // Извлечем из очереди самый приоритетный запрос и начнем выполнять его
     //
     if (!m_freeLoaders.empty()) {
         pop();
     }
 }
 
+NetworkQueueStatistics NetworkQueue::statistics() const
+{
+    NetworkQueueStatistics result = m_statistics;
+    result.active = m_busyLoaders.size();
+    result.freeLoaders = m_freeLoaders.size();
+    for (auto iter = m_queue.begin(); iter != m_queue.end(); ++iter) {
+        result.priorities[iter.key()].queued = iter.value().size();
+    }
+    return result;
+}
+
 void NetworkQueue::pop() {
     //
-    // Извлечем свободный WebLoader
+    // Извлечем запрос на обработку
+    //
+    NetworkRequestPrivate *request = takeNextRequest();
+    if (request == 0) {
+        return;
+    }
+    m_inQueue.remove(request);
+
     //
-    WebLoader* loader = m_freeLoaders.front();
-    m_freeLoaders.pop_front();
+    // Учтём время ожидания в очереди
+    //
+    NetworkPriorityStatistics& statistics = m_statistics.priorities[request->m_priority];
+    const qint64 wait = request->m_queuedTimer.elapsed();
+    ++statistics.dispatched;
+    statistics.totalWait += wait;
+    statistics.maxWait = qMax(statistics.maxWait, wait);
 
     //
-    // Извлечем первый запрос на обработку
+    // Извлечем свободный WebLoader
     //
-    NetworkRequestPrivate *request = m_queue.front();
-    m_queue.pop_front();
-    m_inQueue.remove(request);
+    WebLoader* loader = takeFreeLoader(request);
 
     //
     // Настроим WebLoader на запрос
@@ -84,6 +123,7 @@ void NetworkQueue::pop() {
             request, &NetworkRequestPrivate::downloadProgress);
     connect(loader, &WebLoader::error, request, &NetworkRequestPrivate::error);
     connect(loader, &WebLoader::errorDetails, request, &NetworkRequestPrivate::errorDetails);
+    connect(loader, &WebLoader::timings, request, &NetworkRequestPrivate::timings);
 
     //
     // Загружаем!
@@ -97,7 +137,7 @@ void NetworkQueue::stop(NetworkRequestPrivate* _internal) {
         // Либо запрос еще в очереди
         // Тогда его нужно оттуда удалить
         //
-        m_queue.removeAll(_internal);
+        m_queue[_internal->m_priority].removeAll(_internal);
         m_inQueue.remove(_internal);
     }
     else {
@@ -153,6 +193,82 @@ void NetworkQueue::disconnectLoaderRequest(WebLoader* _loader,
             _request, &NetworkRequestPrivate::downloadProgress);
     disconnect(_loader, &WebLoader::error, _request, &NetworkRequestPrivate::error);
     disconnect(_loader, &WebLoader::errorDetails, _request, &NetworkRequestPrivate::errorDetails);
+    disconnect(_loader, &WebLoader::timings, _request, &NetworkRequestPrivate::timings);
+}
+
+NetworkRequestPrivate* NetworkQueue::takeNextRequest()
+{
+    for (auto iter = m_queue.begin(); iter != m_queue.end(); ++iter) {
+        if (iter.value().isEmpty()) {
+            continue;
+        }
+
+        //
+        // Большие и фоновые запросы не занимают зарезервированные WebLoader'ы,
+        // а поскольку очереди упорядочены по приоритету, то дальше искать незачем
+        //
+        if (iter.key() >= NetworkRequest::BulkPriority
+            && m_freeLoaders.size() <= RESERVED_LOADERS_COUNT) {
+            break;
+        }
+
+        return iter.value().takeFirst();
+    }
+
+    return 0;
+}
+
+void NetworkQueue::supersede(const QString& _key)
+{
+    //
+    // Сначала извлекаем все устаревшие запросы из очереди, а уже затем уведомляем о их завершении,
+    // т.к. в обработчиках могут ставиться новые запросы
+    //
+    QList<NetworkRequestPrivate*> superseded;
+    for (auto iter = m_queue.begin(); iter != m_queue.end(); ++iter) {
+        QList<NetworkRequestPrivate*>& queue = iter.value();
+        for (int index = queue.size() - 1; index >= 0; --index) {
+            if (queue.at(index)->m_supersedeKey == _key) {
+                superseded.prepend(queue.takeAt(index));
+            }
+        }
+    }
+
+    foreach (NetworkRequestPrivate* request, superseded) {
+        m_inQueue.remove(request);
+        ++m_statistics.priorities[request->m_priority].superseded;
+    }
+
+    foreach (NetworkRequestPrivate* request, superseded) {
+        emit request->error(tr("Request was superseded by a newer one"), request->m_request->urlToLoad());
+        request->done();
+    }
+}
+
+WebLoader* NetworkQueue::takeFreeLoader(NetworkRequestPrivate* _request)
+{
+    const QString host = _request->m_request->urlToLoad().host();
+    WebLoader* loader = 0;
+
+    //
+    // Ищем загрузчик, у которого уже может быть открыто соединение с нужным хостом
+    //
+    for (int index = m_freeLoaders.size() - 1; index >= 0; --index) {
+        if (m_loaderHosts.value(m_freeLoaders.at(index)) == host) {
+            loader = m_freeLoaders.takeAt(index);
+            break;
+        }
+    }
+
+    //
+    // ... а если такого нет, то берём освободившийся последним
+    //
+    if (loader == 0) {
+        loader = m_freeLoaders.takeLast();
+    }
+
+    m_loaderHosts.insert(loader, host);
+    return loader;
 }
 
 void NetworkQueue::downloadComplete()
@@ -180,7 +296,7 @@ void NetworkQueue::downloadComplete()
     //
     //Смотрим, надо ли что еще выполнить из очереди
     //
-    if (!m_queue.empty()) {
+    if (!m_inQueue.empty()) {
         pop();
     }
 }
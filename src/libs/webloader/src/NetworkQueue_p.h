@@ -20,6 +20,9 @@
 #include <QObject>
 #include <QSet>
 #include <QMap>
+#include <QHash>
+
+#include "NetworkRequest.h"
 
 class WebLoader;
 class NetworkRequestPrivate;
@@ -49,6 +52,11 @@ public:
      */
     void stop(NetworkRequestPrivate*);
 
+    /*!
+     * \brief Метод, возвращающий счётчики очереди для диагностики
+     */
+    NetworkQueueStatistics statistics() const;
+
 signals:
     /*!
      * \brief Прогресс отправки запроса на сервер
@@ -92,6 +100,24 @@ private:
      */
     void pop();
 
+    /*!
+     * \brief Извлечение из очереди запроса с наибольшим приоритетом,
+     * который можно выполнить при текущем количестве свободных WebLoader'ов
+     */
+    NetworkRequestPrivate* takeNextRequest();
+
+    /*!
+     * \brief Отмена ожидающих в очереди запросов с заданным ключом замещения
+     */
+    void supersede(const QString& _key);
+
+    /*!
+     * \brief Извлечение свободного WebLoader'а для запроса
+     * Предпочтение отдаётся загрузчику, который последним работал с тем же хостом,
+     * чтобы переиспользовать открытое им соединение
+     */
+    WebLoader* takeFreeLoader(NetworkRequestPrivate* _request);
+
     /*!
      * \brief Настройка параметров для WebLoader'а
      */
@@ -104,9 +130,9 @@ private:
     void disconnectLoaderRequest(WebLoader* _loader, NetworkRequestPrivate* _request);
 
     /*!
-     * \brief Очередь запросов
+     * \brief Очереди запросов по приоритетам
      */
-    QList<NetworkRequestPrivate*> m_queue;
+    QMap<NetworkRequest::Priority, QList<NetworkRequestPrivate*> > m_queue;
 
     /*!
      * \brief Множество, содержащее запросы в очереди
@@ -121,8 +147,20 @@ private:
 
     /*!
      * \brief Список свободных WebLoader'ов
+     * В конце списка находятся загрузчики, освободившиеся последними
      */
     QList<WebLoader*> m_freeLoaders;
+
+    /*!
+     * \brief Хосты, с которыми последний раз работали WebLoader'ы
+     * Каждый загрузчик держит свой QNetworkAccessManager, а вместе с ним и открытые соединения
+     */
+    QHash<WebLoader*, QString> m_loaderHosts;
+
+    /*!
+     * \brief Накопленные счётчики очереди
+     */
+    NetworkQueueStatistics m_statistics;
 };
 
 #endif // NETWORKQUEUE_H
@@ -20,8 +20,35 @@
 #include "WebLoader_p.h"
 #include "WebRequest_p.h"
 
+NetworkTimings::NetworkTimings() :
+    connection(-1),
+    firstByte(-1),
+    transfer(-1),
+    total(-1),
+    bytesSent(0),
+    bytesReceived(0),
+    isRequestCompressed(false)
+{
+}
+
+NetworkPriorityStatistics::NetworkPriorityStatistics() :
+    queued(0),
+    dispatched(0),
+    superseded(0),
+    totalWait(0),
+    maxWait(0)
+{
+}
+
+NetworkQueueStatistics::NetworkQueueStatistics() :
+    active(0),
+    freeLoaders(0)
+{
+}
+
 NetworkRequestPrivate::NetworkRequestPrivate(QObject* _parent, QNetworkCookieJar* _jar)
-    : QObject(_parent), m_cookieJar(_jar), m_loadingTimeout(20000), m_request(new WebRequest())
+    : QObject(_parent), m_cookieJar(_jar), m_loadingTimeout(20000),
+      m_priority(NetworkRequest::SyncPriority), m_request(new WebRequest())
 
 {
 
@@ -54,6 +81,8 @@ NetworkRequest::NetworkRequest(QObject* _parent, QNetworkCookieJar* _jar)
             this, &NetworkRequest::slotErrorDetails);
     connect(m_internal, &NetworkRequestPrivate::finished,
             this, &NetworkRequest::finished);
+    connect(m_internal, &NetworkRequestPrivate::timings,
+            this, &NetworkRequest::timings);
 
 }
 
@@ -95,6 +124,28 @@ int NetworkRequest::getLoadingTimeout() const
     return m_internal->m_loadingTimeout;
 }
 
+void NetworkRequest::setPriority(NetworkRequest::Priority _priority)
+{
+    stop();
+    m_internal->m_priority = _priority;
+}
+
+NetworkRequest::Priority NetworkRequest::getPriority() const
+{
+    return m_internal->m_priority;
+}
+
+void NetworkRequest::setSupersedeKey(const QString& _key)
+{
+    stop();
+    m_internal->m_supersedeKey = _key;
+}
+
+QString NetworkRequest::getSupersedeKey() const
+{
+    return m_internal->m_supersedeKey;
+}
+
 void NetworkRequest::clearRequestAttributes()
 {
     stop();
@@ -205,3 +256,8 @@ QString NetworkRequest::lastErrorDetails() const
 {
     return m_lastErrorDetails;
 }
+
+NetworkQueueStatistics NetworkRequest::queueStatistics()
+{
+    return NetworkQueue::getInstance()->statistics();
+}
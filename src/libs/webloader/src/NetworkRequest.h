@@ -27,6 +27,86 @@ class NetworkRequestPrivate;
 class WebRequest;
 class QNetworkCookieJar;
 
+/*!
+ * \brief Замеры времени выполнения запроса
+ * Все интервалы в миллисекундах, -1 если этап замерить не удалось
+ */
+struct WEBLOADER_EXPORT NetworkTimings
+{
+    NetworkTimings();
+
+    /*!
+     * \brief Установка соединения (поиск адреса, подключение и рукопожатие TLS)
+     * QNetworkAccessManager не сообщает об отдельных этапах подключения, поэтому
+     * они замеряются вместе и только для новых защищённых соединений
+     */
+    qint64 connection;
+
+    /*!
+     * \brief Время от отправки запроса до получения заголовков ответа (TTFB)
+     */
+    qint64 firstByte;
+
+    /*!
+     * \brief Время от получения заголовков до окончания загрузки тела ответа
+     */
+    qint64 transfer;
+
+    /*!
+     * \brief Общее время выполнения запроса, включая перенаправления
+     */
+    qint64 total;
+
+    /*!
+     * \brief Объём отправленного тела запроса (после сжатия)
+     */
+    qint64 bytesSent;
+
+    /*!
+     * \brief Объём полученных данных
+     */
+    qint64 bytesReceived;
+
+    /*!
+     * \brief Было ли тело запроса отправлено сжатым
+     */
+    bool isRequestCompressed;
+};
+
+Q_DECLARE_METATYPE(NetworkTimings)
+
+/*!
+ * \brief Счётчики очереди запросов одного приоритета
+ * Время в миллисекундах
+ */
+struct WEBLOADER_EXPORT NetworkPriorityStatistics
+{
+    NetworkPriorityStatistics();
+
+    /*!
+     * \brief Количество запросов, ожидающих в очереди
+     */
+    int queued;
+
+    /*!
+     * \brief Количество запросов, переданных на выполнение
+     */
+    qint64 dispatched;
+
+    /*!
+     * \brief Количество запросов, отменённых более новыми
+     */
+    qint64 superseded;
+
+    /*!
+     * \brief Суммарное и максимальное время ожидания в очереди запросов, переданных на выполнение
+     */
+    qint64 totalWait;
+    qint64 maxWait;
+};
+
+struct NetworkQueueStatistics;
+
 /*!
  * \brief Пользовательский класс для создания GET и POST запросов
  */
@@ -45,6 +125,16 @@ public:
         Post
     };
 
+    /*!
+    \enum Приоритет запроса в очереди
+    */
+    enum Priority {
+        InteractivePriority, /*!< Результата запроса ждёт пользователь */
+        SyncPriority, /*!< Обычные запросы, используется по-умолчанию */
+        BulkPriority, /*!< Передача больших объёмов данных */
+        BackgroundPriority /*!< Фоновые запросы, например ожидание событий сервера */
+    };
+
     explicit NetworkRequest(QObject* _parent = 0, QNetworkCookieJar* _jar = 0);
     virtual ~NetworkRequest();
 
@@ -78,6 +168,30 @@ public:
      */
     int getLoadingTimeout() const;
 
+    /*!
+     * \brief Установка приоритета запроса
+     * Запросы с большим приоритетом извлекаются из очереди раньше, а под запросы
+     * с приоритетом BulkPriority и ниже не занимается последний свободный загрузчик
+     */
+    void setPriority(Priority _priority);
+
+    /*!
+     * \brief Получение приоритета запроса
+     */
+    Priority getPriority() const;
+
+    /*!
+     * \brief Установка ключа замещения
+     * Если в очередь ставится запрос с непустым ключом, то ожидающие в очереди запросы
+     * с тем же ключом отменяются как устаревшие
+     */
+    void setSupersedeKey(const QString& _key);
+
+    /*!
+     * \brief Получение ключа замещения
+     */
+    QString getSupersedeKey() const;
+
     /*!
      * \brief Очистить все старые атрибуты запроса
      */
@@ -107,6 +221,13 @@ public:
     QByteArray loadSync(const QString& _urlToLoad, const QUrl& _referer = QUrl());
     QByteArray loadSync(const QUrl& _urlToLoad, const QUrl& _referer = QUrl());
 
+    /*!
+     * \brief Остановка выполнения запроса, связанного с текущим объектом
+     * и удаление запросов, ожидающих в очереди, связанных с текущим объектом
+     * Если запрос уже выполнялся, то испускается сигнал finished
+     */
+    void stop();
+
     /*!
      * \brief Получение загруженного URL
      */
@@ -118,6 +239,11 @@ public:
     QString lastError() const;
     QString lastErrorDetails() const;
 
+    /*!
+     * \brief Получение счётчиков очереди запросов для диагностики
+     */
+    static NetworkQueueStatistics queueStatistics();
+
 signals:
     /*!
      * \brief Прогресс отправки запроса на сервер
@@ -135,6 +261,12 @@ signals:
     void downloadComplete(QByteArray, QUrl);
     void finished();
 
+    /*!
+     * \brief Замеры времени выполнения запроса
+     * Испускается перед downloadComplete
+     */
+    void timings(NetworkTimings, QUrl);
+
     /*!
      * \brief Сигнал об ошибке
      */
@@ -158,12 +290,6 @@ private:
     QString m_lastError;
     QString m_lastErrorDetails;
 
-    /*!
-     * \brief Остановка выполнения запроса, связанного с текущим объектом
-     * и удаление запросов, ожидающих в очереди, связанных с текущим объектом
-     */
-    void stop();
-
 private slots:
     /*!
      * \brief Данные загружены. Используется при синхронной загрузке
@@ -177,4 +303,27 @@ private slots:
     void slotErrorDetails(const QString&);
 };
 
+/*!
+ * \brief Счётчики очереди запросов
+ */
+struct WEBLOADER_EXPORT NetworkQueueStatistics
+{
+    NetworkQueueStatistics();
+
+    /*!
+     * \brief Количество выполняющихся запросов
+     */
+    int active;
+
+    /*!
+     * \brief Количество свободных загрузчиков
+     */
+    int freeLoaders;
+
+    /*!
+     * \brief Счётчики по приоритетам, индекс соответствует NetworkRequest::Priority
+     */
+    NetworkPriorityStatistics priorities[NetworkRequest::BackgroundPriority + 1];
+};
+
 #endif // NETWORKREQUEST_H
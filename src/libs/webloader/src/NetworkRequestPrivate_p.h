@@ -17,6 +17,7 @@
 #ifndef NETWORKREQUESTPRIVATE_H
 #define NETWORKREQUESTPRIVATE_H
 
+#include <QElapsedTimer>
 #include <QObject>
 
 #include "NetworkRequest.h"
@@ -41,8 +42,15 @@ public:
     QNetworkCookieJar* m_cookieJar;
     NetworkRequest::RequestMethod m_method;
     int m_loadingTimeout;
+    NetworkRequest::Priority m_priority;
+    QString m_supersedeKey;
     WebRequest* m_request;
 
+    /*!
+     * \brief Время ожидания в очереди
+     */
+    QElapsedTimer m_queuedTimer;
+
     void done();
 
 signals:
@@ -62,6 +70,11 @@ signals:
     void downloadComplete(QByteArray, QUrl);
     void finished();
 
+    /*!
+     * \brief Замеры времени выполнения запроса
+     */
+    void timings(NetworkTimings, QUrl);
+
     /*!
      * \brief Сигнал об ошибке
      */
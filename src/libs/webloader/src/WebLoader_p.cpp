@@ -24,7 +24,10 @@
 #include <QtNetwork/QNetworkReply>
 #include <QtNetwork/QHttpMultiPart>
 #include <QtCore/QTimer>
+#include <QElapsedTimer>
 #include <QEventLoop>
+#include <QHash>
+#include <QMutex>
 #include <QPointer>
 
 namespace {
@@ -35,6 +38,108 @@ namespace {
 	 */
 	const int POSSIBLE_RECIEVED_MAX_FILE_SIZE = 120000;
 
+	/**
+	 * @brief Минимальный размер тела запроса, начиная с которого его имеет смысл сжимать
+	 */
+	const int MIN_COMPRESSED_REQUEST_SIZE = 1024;
+
+	/**
+	 * @brief Заголовки и коды для согласования сжатия тела запроса (RFC 7694)
+	 */
+	const QByteArray ACCEPT_ENCODING_HEADER = "Accept-Encoding";
+	const QByteArray CONTENT_ENCODING_HEADER = "Content-Encoding";
+	const QByteArray GZIP_ENCODING = "gzip";
+	const QByteArray DEFLATE_ENCODING = "deflate";
+	const int UNSUPPORTED_MEDIA_TYPE_STATUS = 415;
+
+	/**
+	 * @brief Способы сжатия тел запросов, которые принимают хосты
+	 * @note Общие для всех загрузчиков, поэтому доступ защищается мьютексом
+	 */
+	static QMutex s_requestEncodingsMutex;
+	static QHash<QString, QByteArray>& requestEncodings() {
+		static QHash<QString, QByteArray> s_requestEncodings;
+		return s_requestEncodings;
+	}
+
+	/**
+	 * @brief Получить способ сжатия тела запроса, который принимает хост
+	 */
+	static QByteArray requestEncoding(const QString& _host) {
+		QMutexLocker locker(&s_requestEncodingsMutex);
+		return requestEncodings().value(_host);
+	}
+
+	/**
+	 * @brief Запомнить способ сжатия тела запроса, который принимает хост,
+	 *		  пустой способ означает, что хост сжатые запросы не принимает
+	 */
+	static void setRequestEncoding(const QString& _host, const QByteArray& _encoding) {
+		QMutexLocker locker(&s_requestEncodingsMutex);
+		if (_encoding.isEmpty()) {
+			requestEncodings().remove(_host);
+		} else {
+			requestEncodings().insert(_host, _encoding);
+		}
+	}
+
+	/**
+	 * @brief Выбрать способ сжатия из заголовка Accept-Encoding ответа сервера
+	 */
+	static QByteArray preferredEncoding(const QByteArray& _acceptEncoding) {
+		QByteArray result;
+		foreach (const QByteArray& encoding, _acceptEncoding.toLower().split(',')) {
+			const QByteArray coding = encoding.split(';').first().trimmed();
+			if (coding == GZIP_ENCODING) {
+				result = GZIP_ENCODING;
+				break;
+			} else if (coding == DEFLATE_ENCODING) {
+				result = DEFLATE_ENCODING;
+			}
+		}
+		return result;
+	}
+
+	/**
+	 * @brief Контрольная сумма CRC-32 для формата gzip
+	 */
+	static quint32 crc32(const QByteArray& _data) {
+		quint32 crc = 0xFFFFFFFF;
+		for (int index = 0; index < _data.size(); ++index) {
+			crc ^= static_cast<quint8>(_data.at(index));
+			for (int bit = 0; bit < 8; ++bit) {
+				crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+			}
+		}
+		return ~crc;
+	}
+
+	/**
+	 * @brief Сжать данные в заданном формате
+	 * @note qCompress формирует поток zlib, предваряя его четырьмя байтами с размером исходных данных,
+	 *		 поток zlib и есть формат deflate протокола HTTP, а для gzip из него извлекаются сырые данные
+	 */
+	static QByteArray compress(const QByteArray& _data, const QByteArray& _encoding) {
+		const QByteArray zlibData = qCompress(_data).mid(4);
+		if (_encoding == DEFLATE_ENCODING) {
+			return zlibData;
+		}
+
+		const int ZLIB_HEADER_SIZE = 2;
+		const int ZLIB_CHECKSUM_SIZE = 4;
+		QByteArray result("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+		result.append(zlibData.mid(ZLIB_HEADER_SIZE, zlibData.size() - ZLIB_HEADER_SIZE - ZLIB_CHECKSUM_SIZE));
+		const quint32 checksum = crc32(_data);
+		const quint32 size = static_cast<quint32>(_data.size());
+		for (int byte = 0; byte < 4; ++byte) {
+			result.append(static_cast<char>((checksum >> (byte * 8)) & 0xFF));
+		}
+		for (int byte = 0; byte < 4; ++byte) {
+			result.append(static_cast<char>((size >> (byte * 8)) & 0xFF));
+		}
+		return result;
+	}
+
 	/**
 	 * @brief Преобразовать ошибку в читаемый вид
 	 */
@@ -91,6 +196,7 @@ WebLoader::WebLoader(QObject* _parent, QNetworkCookieJar* _jar) :
 	m_request(new WebRequest),
 	m_requestMethod(NetworkRequest::Undefined),
 	m_isNeedRedirect(true),
+	m_isRequestCompressed(false),
 	m_loadingTimeout(20000)
 {
 }
@@ -143,6 +249,17 @@ void WebLoader::run()
 	initNetworkManager();
 
 	m_initUrl = m_request->urlToLoad();
+	m_downloadedData.clear();
+	m_timings = NetworkTimings();
+
+	//
+	// Замеры времени производятся в потоке загрузчика, чтобы на них не влияла загруженность
+	// потока, в котором живёт сам объект загрузчика
+	//
+	QElapsedTimer totalTimer;
+	totalTimer.start();
+	QElapsedTimer stageTimer;
+	qint64 headersReceivedAt = -1;
 
 	do
 	{
@@ -151,25 +268,70 @@ void WebLoader::run()
 		emit downloadProgress(0, m_initUrl);
 
 		QPointer<QNetworkReply> reply = 0;
+		m_timings.connection = -1;
+		m_timings.firstByte = -1;
+		m_timings.transfer = -1;
+		headersReceivedAt = -1;
+		stageTimer.start();
 
 		switch (m_requestMethod) {
 
 			default:
 			case NetworkRequest::Get: {
 				const QNetworkRequest request = this->m_request->networkRequest();
+				m_isRequestCompressed = false;
+				m_timings.bytesSent = 0;
 				reply = m_networkManager->get(request);
 				break;
 			}
 
 			case NetworkRequest::Post: {
-				const QNetworkRequest networkRequest = m_request->networkRequest(true);
-				const QByteArray data = m_request->multiPartData();
+				QNetworkRequest networkRequest = m_request->networkRequest(true);
+				QByteArray data = m_request->multiPartData();
+
+				//
+				// Сжимаем тело запроса, если сервер сообщил, что принимает сжатые данные
+				//
+				m_isRequestCompressed = false;
+				const QByteArray encoding = ::requestEncoding(m_request->urlToLoad().host());
+				if (!encoding.isEmpty()
+					&& data.size() >= MIN_COMPRESSED_REQUEST_SIZE) {
+					const QByteArray compressedData = ::compress(data, encoding);
+					if (compressedData.size() < data.size()) {
+						data = compressedData;
+						networkRequest.setRawHeader(CONTENT_ENCODING_HEADER, encoding);
+						networkRequest.setHeader(QNetworkRequest::ContentLengthHeader, data.size());
+						m_isRequestCompressed = true;
+					}
+				}
+				m_timings.bytesSent = data.size();
+
 				reply = m_networkManager->post(networkRequest, data);
 				break;
 			}
 
 		} // switch
 
+		//
+		// Замеры этапов выполнения запроса
+		//
+		connect(reply.data(), &QNetworkReply::encrypted, reply.data(), [this, &stageTimer] {
+			if (m_timings.connection == -1) {
+				m_timings.connection = stageTimer.elapsed();
+			}
+		});
+		connect(reply.data(), &QNetworkReply::metaDataChanged, reply.data(), [this, &stageTimer, &headersReceivedAt] {
+			if (headersReceivedAt == -1) {
+				headersReceivedAt = stageTimer.elapsed();
+				m_timings.firstByte = headersReceivedAt;
+			}
+		});
+		connect(reply.data(), &QNetworkReply::finished, reply.data(), [this, &stageTimer, &headersReceivedAt] {
+			if (headersReceivedAt != -1) {
+				m_timings.transfer = stageTimer.elapsed() - headersReceivedAt;
+			}
+		});
+
 		connect(reply.data(), &QNetworkReply::uploadProgress,
 				this, static_cast<void (WebLoader::*)(qint64, qint64)>(&WebLoader::uploadProgress));
 		connect(reply.data(), &QNetworkReply::downloadProgress,
@@ -215,6 +377,11 @@ void WebLoader::run()
 
 	} while (m_isNeedRedirect);
 
+	m_timings.total = totalTimer.elapsed();
+	m_timings.bytesReceived = m_downloadedData.size();
+	m_timings.isRequestCompressed = m_isRequestCompressed;
+	emit timings(m_timings, m_initUrl);
+
 	emit downloadComplete(m_downloadedData, m_initUrl);
 }
 
@@ -248,8 +415,25 @@ void WebLoader::downloadComplete(QNetworkReply* _reply)
 {
 	//! Завершена загрузка страницы [m_request->url()]
 
+	//
+	// Запоминаем, принимает ли сервер сжатые тела запросов
+	//
+	const QString host = m_request->urlToLoad().host();
+	const QByteArray acceptEncoding = _reply->rawHeader(ACCEPT_ENCODING_HEADER);
+	if (!acceptEncoding.isEmpty()) {
+		::setRequestEncoding(host, ::preferredEncoding(acceptEncoding));
+	}
+
+	// отказался ли сервер принимать сжатый запрос?
+	if (m_isRequestCompressed
+		&& _reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == UNSUPPORTED_MEDIA_TYPE_STATUS) {
+		//! Повторяем запрос без сжатия
+		::setRequestEncoding(host, QByteArray());
+		_reply->deleteLater();
+		m_isNeedRedirect = true;
+	}
 	// требуется ли редирект?
-	if (!_reply->header(QNetworkRequest::LocationHeader).isNull()) {
+	else if (!_reply->header(QNetworkRequest::LocationHeader).isNull()) {
 		//! Осуществляется редирект по ссылке [redirectUrl]
 		// Referer'ом становится ссылка по хоторой был осуществлен запрос
 		QUrl refererUrl = m_request->urlToLoad();
@@ -276,6 +460,16 @@ void WebLoader::downloadComplete(QNetworkReply* _reply)
 
 void WebLoader::downloadError(QNetworkReply::NetworkError _networkError)
 {
+	//
+	// Отказ принять сжатый запрос не считаем ошибкой, т.к. запрос будет повторён без сжатия
+	//
+	QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+	if (m_isRequestCompressed
+		&& reply != 0
+		&& reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == UNSUPPORTED_MEDIA_TYPE_STATUS) {
+		return;
+	}
+
 	switch (_networkError) {
 
 		case QNetworkReply::NoError:
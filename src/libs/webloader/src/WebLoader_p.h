@@ -89,6 +89,11 @@ signals:
       */
     void downloadComplete(QByteArray, QUrl);
 
+    /*!
+      \brief Замеры времени выполнения запроса
+      */
+    void timings(NetworkTimings, QUrl);
+
     /*!
       \brief Сигнал об ошибке
 	  */
@@ -150,6 +155,16 @@ private:
 	bool m_isNeedRedirect;
     QUrl m_initUrl;
 
+    /**
+     * @brief Было ли сжато тело текущего запроса
+     */
+    bool m_isRequestCompressed;
+
+    /**
+     * @brief Замеры времени выполнения текущего запроса
+     */
+    NetworkTimings m_timings;
+
     /**
      * @brief Таймаут загрузки ссылки
      */
@@ -132,6 +132,8 @@ QNetworkRequest WebRequest::networkRequest(bool _addContentHeaders)
         request.setRawHeader(REFERER_HEADER, urlReferer().toString().toUtf8().data());
 	// ContentType по-умолчанию
     request.setHeader(QNetworkRequest::ContentTypeHeader, CONTENT_TYPE_DEFAULT);
+    // Accept-Encoding не задаём, в этом случае QNetworkAccessManager сам запрашивает
+    // ответ в формате gzip или deflate и прозрачно распаковывает его
 
     if (_addContentHeaders) {
         // ContentType
@@ -0,0 +1,10 @@
+TARGET = DatabaseHelperTest
+TEMPLATE = app
+
+include(../tests.pri)
+
+HEADERS += \
+    $$SCENARIST_CORE/DataLayer/Database/DatabaseHelper.h
+
+SOURCES += \
+    DatabaseHelperTest.cpp
@@ -0,0 +1,193 @@
+#include <DataLayer/Database/DatabaseHelper.h>
+
+#include <QList>
+#include <QStringList>
+#include <QVariant>
+#include <QtTest>
+
+using DatabaseLayer::DatabaseHelper;
+
+namespace {
+    /**
+     * @brief Количество изменений в тестовом проекте
+     */
+    const int SAMPLE_CHANGES_COUNT = 2000;
+
+    /**
+     * @brief Сформировать патч изменения сценария, похожий на те, что сохраняются в проекте
+     */
+    static QString samplePatch(int _index) {
+        const int position = _index * 137;
+        return
+                QString("@@ -%1,24 +%1,61 @@\n"
+                        " <action>\\n<v><![CDATA[\n"
+                        "+%2 enters the room and looks around. Scene number %3\n"
+                        " ]]></v>\\n</action>\\n\n"
+                        "@@ -%4,18 +%5,34 @@\n"
+                        " <character>\\n<v><![CDATA[\n"
+                        "-OLD NAME\n"
+                        "+CHARACTER %3\n"
+                        " ]]></v>\\n</character>\\n\n")
+                .arg(position)
+                .arg(_index % 2 == 0 ? "John" : "Mary")
+                .arg(_index)
+                .arg(position + 240)
+                .arg(position + 277);
+    }
+
+    /**
+     * @brief Сформировать патчи тестового проекта
+     */
+    static QStringList samplePatches() {
+        QStringList patches;
+        for (int index = 0; index < SAMPLE_CHANGES_COUNT; ++index) {
+            patches.append(samplePatch(index));
+        }
+        return patches;
+    }
+
+    /**
+     * @brief Подготовить патчи к сохранению в БД
+     */
+    static QList<QVariant> storedPatches(const QStringList& _patches, bool _isBinary) {
+        QList<QVariant> stored;
+        foreach (const QString& patch, _patches) {
+            stored.append(DatabaseHelper::compressedToStorage(DatabaseHelper::compressRaw(patch), _isBinary));
+        }
+        return stored;
+    }
+
+    /**
+     * @brief Объём, занимаемый значением в БД
+     */
+    static int storedSize(const QVariant& _value) {
+        return _value.type() == QVariant::ByteArray ? _value.toByteArray().size() : _value.toString().toUtf8().size();
+    }
+}
+
+
+/**
+ * @brief Тесты хранения сжатых патчей в БД
+ */
+class DatabaseHelperTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Патчи читаются из БД такими же, какими были сохранены, в обоих форматах
+     */
+    void storageRoundTrip();
+
+    /**
+     * @brief В двоичном виде патчи занимают меньше места, чем в base64
+     */
+    void binaryStorageIsSmaller();
+
+    /**
+     * @brief Замер: сохранение патчей в прежнем виде, в base64
+     */
+    void benchmarkLegacyEncode();
+
+    /**
+     * @brief Замер: сохранение патчей в двоичном виде
+     */
+    void benchmarkBinaryEncode();
+
+    /**
+     * @brief Замер: чтение патчей, сохранённых в base64
+     */
+    void benchmarkLegacyDecode();
+
+    /**
+     * @brief Замер: чтение патчей, сохранённых в двоичном виде
+     */
+    void benchmarkBinaryDecode();
+};
+
+void DatabaseHelperTest::storageRoundTrip()
+{
+    const QStringList patches = samplePatches();
+    foreach (bool isBinary, QList<bool>() << false << true) {
+        const QList<QVariant> stored = storedPatches(patches, isBinary);
+        for (int index = 0; index < patches.size(); ++index) {
+            const QVariant& value = stored.at(index);
+            QCOMPARE(value.type() == QVariant::ByteArray, isBinary);
+            QCOMPARE(DatabaseHelper::uncompressRaw(DatabaseHelper::compressedFromStorage(value)), patches.at(index));
+        }
+    }
+}
+
+void DatabaseHelperTest::binaryStorageIsSmaller()
+{
+    const QStringList patches = samplePatches();
+    int sourceSize = 0;
+    foreach (const QString& patch, patches) {
+        sourceSize += patch.toUtf8().size();
+    }
+    int legacySize = 0;
+    foreach (const QVariant& value, storedPatches(patches, false)) {
+        legacySize += storedSize(value);
+    }
+    int binarySize = 0;
+    foreach (const QVariant& value, storedPatches(patches, true)) {
+        binarySize += storedSize(value);
+    }
+
+    qDebug("Source: %d bytes, base64: %d bytes (%.2f), binary: %d bytes (%.2f)",
+           sourceSize,
+           legacySize, static_cast<double>(legacySize) / sourceSize,
+           binarySize, static_cast<double>(binarySize) / sourceSize);
+
+    QVERIFY(binarySize < legacySize);
+}
+
+void DatabaseHelperTest::benchmarkLegacyEncode()
+{
+    const QStringList patches = samplePatches();
+    QList<QVariant> stored;
+    QBENCHMARK {
+        stored = storedPatches(patches, false);
+    }
+    QCOMPARE(stored.size(), patches.size());
+}
+
+void DatabaseHelperTest::benchmarkBinaryEncode()
+{
+    const QStringList patches = samplePatches();
+    QList<QVariant> stored;
+    QBENCHMARK {
+        stored = storedPatches(patches, true);
+    }
+    QCOMPARE(stored.size(), patches.size());
+}
+
+void DatabaseHelperTest::benchmarkLegacyDecode()
+{
+    const QList<QVariant> stored = storedPatches(samplePatches(), false);
+    int decodedSize = 0;
+    QBENCHMARK {
+        decodedSize = 0;
+        foreach (const QVariant& value, stored) {
+            decodedSize += DatabaseHelper::uncompressRaw(DatabaseHelper::compressedFromStorage(value)).size();
+        }
+    }
+    QVERIFY(decodedSize > 0);
+}
+
+void DatabaseHelperTest::benchmarkBinaryDecode()
+{
+    const QList<QVariant> stored = storedPatches(samplePatches(), true);
+    int decodedSize = 0;
+    QBENCHMARK {
+        decodedSize = 0;
+        foreach (const QVariant& value, stored) {
+            decodedSize += DatabaseHelper::uncompressRaw(DatabaseHelper::compressedFromStorage(value)).size();
+        }
+    }
+    QVERIFY(decodedSize > 0);
+}
+
+QTEST_APPLESS_MAIN(DatabaseHelperTest)
+
+#include "DatabaseHelperTest.moc"
@@ -0,0 +1,9 @@
+TARGET = DatabaseIndexesTest
+TEMPLATE = app
+
+include(../tests.pri)
+
+QT += sql
+
+SOURCES += \
+    DatabaseIndexesTest.cpp
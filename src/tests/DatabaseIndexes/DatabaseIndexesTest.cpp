@@ -0,0 +1,310 @@
+#include <QDateTime>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QUuid>
+#include <QtTest>
+
+namespace {
+    /**
+     * @brief Количество записей в таблицах изменений и истории
+     */
+    const int ROWS_COUNT = 40000;
+
+    /**
+     * @brief Количество uuid'ов, проверяемых за одну синхронизацию
+     */
+    const int CHECKED_UUIDS_COUNT = 1000;
+
+    /**
+     * @brief Количество записей истории, выбираемых за одну синхронизацию
+     */
+    const int RECENT_HISTORY_COUNT = 400;
+
+    /**
+     * @brief Формат даты изменений
+     */
+    const QString DATETIME_FORMAT = "yyyy-MM-dd hh:mm:ss";
+
+    /**
+     * @brief Индексы, создаваемые в Database::createIndexes
+     */
+    const QStringList INDEXES =
+            QStringList()
+            << "CREATE UNIQUE INDEX IF NOT EXISTS scenario_changes_uuid_index "
+               "ON scenario_changes (uuid)"
+            << "CREATE INDEX IF NOT EXISTS scenario_changes_datetime_username_index "
+               "ON scenario_changes (datetime, username)"
+            << "CREATE INDEX IF NOT EXISTS database_history_datetime_index "
+               "ON _database_history (datetime)";
+
+    /**
+     * @brief Дата изменения с заданным номером
+     */
+    static QString changeDatetime(int _index) {
+        return QDateTime(QDate(2017, 1, 1), QTime(0, 0)).addSecs(_index * 60).toString(DATETIME_FORMAT);
+    }
+
+    /**
+     * @brief Uuid изменения с заданным номером
+     */
+    static QString changeUuid(int _index) {
+        return QUuid::createUuidV5(QUuid(), QString::number(_index)).toString();
+    }
+}
+
+
+/**
+ * @brief Замеры поиска изменений при синхронизации с индексами и без них
+ *
+ * Таблицы и запросы повторяют используемые в ScenarioChangeMapper и DatabaseHistoryMapper,
+ * база данных создаётся в памяти, чтобы замер не зависел от диска
+ */
+class DatabaseIndexesTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Запросы синхронизации выполняются по индексам
+     */
+    void queriesUseIndexes();
+
+    /**
+     * @brief Замер: проверка наличия изменения по uuid
+     */
+    void benchmarkContainsUuid_data();
+    void benchmarkContainsUuid();
+
+    /**
+     * @brief Замер: поиск отсутствующих изменений из списка
+     */
+    void benchmarkMissingUuids_data();
+    void benchmarkMissingUuids();
+
+    /**
+     * @brief Замер: выборка истории изменений начиная с заданной даты
+     */
+    void benchmarkHistory_data();
+    void benchmarkHistory();
+
+private:
+    /**
+     * @brief Заполнить столбцы данных замера
+     */
+    static void addIndexedColumn();
+
+    /**
+     * @brief Создать заполненную базу данных
+     */
+    static QSqlDatabase createDatabase(bool _isIndexed);
+};
+
+void DatabaseIndexesTest::queriesUseIndexes()
+{
+    {
+        QSqlDatabase database = createDatabase(true);
+        QSqlQuery query(database);
+
+        QVERIFY(query.exec("EXPLAIN QUERY PLAN SELECT COUNT(id) FROM scenario_changes WHERE uuid = 'uuid'"));
+        QVERIFY(query.next());
+        QVERIFY(query.value("detail").toString().contains("scenario_changes_uuid_index"));
+
+        QVERIFY(query.exec("EXPLAIN QUERY PLAN SELECT id FROM _database_history WHERE datetime >= '2017'"));
+        QVERIFY(query.next());
+        QVERIFY(query.value("detail").toString().contains("database_history_datetime_index"));
+    }
+    QSqlDatabase::removeDatabase(QSqlDatabase::defaultConnection);
+}
+
+void DatabaseIndexesTest::benchmarkContainsUuid_data()
+{
+    addIndexedColumn();
+}
+
+void DatabaseIndexesTest::benchmarkContainsUuid()
+{
+    QFETCH(bool, isIndexed);
+
+    {
+        QSqlDatabase database = createDatabase(isIndexed);
+        //
+        // Половина проверяемых изменений есть в базе, половины нет
+        //
+        QStringList checkedUuids;
+        for (int index = 0; index < CHECKED_UUIDS_COUNT; ++index) {
+            checkedUuids.append(changeUuid(index % 2 == 0 ? index : ROWS_COUNT + index));
+        }
+
+        QSqlQuery checker(database);
+        checker.prepare("SELECT COUNT(id) FROM scenario_changes WHERE uuid = ?");
+
+        int found = 0;
+        QBENCHMARK {
+            found = 0;
+            foreach (const QString& uuid, checkedUuids) {
+                checker.addBindValue(uuid);
+                checker.exec();
+                checker.next();
+                found += checker.value(0).toInt();
+            }
+        }
+        QCOMPARE(found, CHECKED_UUIDS_COUNT / 2);
+    }
+    QSqlDatabase::removeDatabase(QSqlDatabase::defaultConnection);
+}
+
+void DatabaseIndexesTest::benchmarkMissingUuids_data()
+{
+    addIndexedColumn();
+}
+
+void DatabaseIndexesTest::benchmarkMissingUuids()
+{
+    QFETCH(bool, isIndexed);
+
+    {
+        QSqlDatabase database = createDatabase(isIndexed);
+        QVariantList values;
+        for (int index = 0; index < CHECKED_UUIDS_COUNT; ++index) {
+            values.append(changeUuid(ROWS_COUNT - CHECKED_UUIDS_COUNT / 2 + index));
+        }
+
+        int missing = 0;
+        QBENCHMARK {
+            database.transaction();
+            QSqlQuery query(database);
+            query.exec("CREATE TEMP TABLE IF NOT EXISTS _checked_uuids "
+                       "(uuid TEXT PRIMARY KEY ON CONFLICT IGNORE)");
+            query.exec("DELETE FROM _checked_uuids");
+            query.prepare("INSERT INTO _checked_uuids (uuid) VALUES(?)");
+            query.addBindValue(values);
+            query.execBatch();
+
+            query.exec("SELECT checked.uuid FROM _checked_uuids AS checked "
+                       "WHERE NOT EXISTS (SELECT 1 FROM scenario_changes AS changes "
+                       "WHERE changes.uuid = checked.uuid)");
+            missing = 0;
+            while (query.next()) {
+                ++missing;
+            }
+
+            query.exec("DELETE FROM _checked_uuids");
+            database.commit();
+        }
+        QCOMPARE(missing, CHECKED_UUIDS_COUNT / 2);
+    }
+    QSqlDatabase::removeDatabase(QSqlDatabase::defaultConnection);
+}
+
+void DatabaseIndexesTest::benchmarkHistory_data()
+{
+    addIndexedColumn();
+}
+
+void DatabaseIndexesTest::benchmarkHistory()
+{
+    QFETCH(bool, isIndexed);
+
+    {
+        QSqlDatabase database = createDatabase(isIndexed);
+        const QString fromDatetime = changeDatetime(ROWS_COUNT - RECENT_HISTORY_COUNT);
+
+        int loaded = 0;
+        QBENCHMARK {
+            QSqlQuery loader(database);
+            loader.exec(QString("SELECT id FROM _database_history WHERE datetime >= '%1'").arg(fromDatetime));
+            loaded = 0;
+            while (loader.next()) {
+                ++loaded;
+            }
+        }
+        QCOMPARE(loaded, RECENT_HISTORY_COUNT);
+    }
+    QSqlDatabase::removeDatabase(QSqlDatabase::defaultConnection);
+}
+
+void DatabaseIndexesTest::addIndexedColumn()
+{
+    QTest::addColumn<bool>("isIndexed");
+    QTest::newRow("without indexes") << false;
+    QTest::newRow("with indexes") << true;
+}
+
+QSqlDatabase DatabaseIndexesTest::createDatabase(bool _isIndexed)
+{
+    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE");
+    database.setDatabaseName(":memory:");
+    database.open();
+
+    QSqlQuery creator(database);
+    creator.exec("CREATE TABLE scenario_changes "
+                 "("
+                 "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                 "uuid TEXT NOT NULL, "
+                 "datetime TEXT NOT NULL, "
+                 "username TEXT NOT NULL, "
+                 "undo_patch TEXT NOT NULL, "
+                 "redo_patch TEXT NOT NULL, "
+                 "is_draft INTEGER NOT NULL DEFAULT(0) "
+                 ")");
+    creator.exec("CREATE TABLE _database_history "
+                 "( "
+                 "id TEXT PRIMARY KEY, "
+                 "query TEXT NOT NULL, "
+                 "query_values TEXT NOT NULL, "
+                 "username TEXT NOT NULL, "
+                 "datetime TEXT NOT NULL "
+                 ")");
+
+    //
+    // Заполняем таблицы, в истории запросы хранятся в случайном порядке дат,
+    // как после синхронизации с соавторами
+    //
+    QVariantList uuids;
+    QVariantList datetimes;
+    QVariantList usernames;
+    QVariantList patches;
+    QVariantList historyUuids;
+    QVariantList historyDatetimes;
+    for (int index = 0; index < ROWS_COUNT; ++index) {
+        uuids.append(changeUuid(index));
+        datetimes.append(changeDatetime(index));
+        usernames.append(index % 3 == 0 ? "first@example.com" : "second@example.com");
+        patches.append("eJzLSM3JyVcozy/KSQEAGgQEXQ==");
+        historyUuids.append(QUuid::createUuid().toString());
+        historyDatetimes.append(changeDatetime((index * 7919) % ROWS_COUNT));
+    }
+
+    database.transaction();
+    creator.prepare("INSERT INTO scenario_changes (uuid, datetime, username, undo_patch, redo_patch) "
+                    "VALUES(?, ?, ?, ?, ?)");
+    creator.addBindValue(uuids);
+    creator.addBindValue(datetimes);
+    creator.addBindValue(usernames);
+    creator.addBindValue(patches);
+    creator.addBindValue(patches);
+    creator.execBatch();
+
+    creator.prepare("INSERT INTO _database_history (id, query, query_values, username, datetime) "
+                    "VALUES(?, ?, ?, ?, ?)");
+    creator.addBindValue(historyUuids);
+    creator.addBindValue(patches);
+    creator.addBindValue(patches);
+    creator.addBindValue(usernames);
+    creator.addBindValue(historyDatetimes);
+    creator.execBatch();
+
+    if (_isIndexed) {
+        foreach (const QString& index, INDEXES) {
+            creator.exec(index);
+        }
+    }
+    database.commit();
+
+    return database;
+}
+
+QTEST_GUILESS_MAIN(DatabaseIndexesTest)
+
+#include "DatabaseIndexesTest.moc"
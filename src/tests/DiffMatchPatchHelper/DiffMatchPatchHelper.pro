@@ -0,0 +1,17 @@
+TARGET = DiffMatchPatchHelperTest
+TEMPLATE = app
+
+include(../tests.pri)
+
+#
+# Вспомогательные функции работы с текстом используют QTextDocument
+#
+QT += gui
+
+HEADERS += \
+    $$SCENARIST_CORE/3rd_party/Helpers/DiffMatchPatch.h \
+    $$SCENARIST_CORE/3rd_party/Helpers/DiffMatchPatchHelper.h
+
+SOURCES += \
+    $$SCENARIST_CORE/3rd_party/Helpers/DiffMatchPatch.cpp \
+    DiffMatchPatchHelperTest.cpp
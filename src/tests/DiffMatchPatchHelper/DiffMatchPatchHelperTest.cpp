@@ -0,0 +1,247 @@
+#include <3rd_party/Helpers/DiffMatchPatchHelper.h>
+
+#include <QStringList>
+#include <QVector>
+#include <QtTest>
+
+namespace {
+    /**
+     * @brief Количество случайных правок в тестах
+     */
+    const int RANDOM_EDITS_COUNT = 300;
+
+    /**
+     * @brief Количество блоков в исходном тексте
+     */
+    const int BLOCKS_COUNT = 200;
+
+    /**
+     * @brief Получить случайное число в диапазоне [0, _max)
+     */
+    static int random(int _max) {
+        return _max > 0 ? qrand() % _max : 0;
+    }
+
+    /**
+     * @brief Сформировать случайный текст блока
+     * @note Словарь небольшой, чтобы в тексте было много повторов, как в настоящих сценариях,
+     *		 и поиску места применения патча было в чём ошибиться
+     */
+    static QString randomText() {
+        static const QStringList s_words =
+                QStringList() << "INT." << "EXT." << "day" << "night" << "he" << "she" << "says"
+                              << "looks" << "at" << "the" << "door" << "window" << "and" << "smiles"
+                              << "день" << "&" << "<" << ">";
+        QStringList words;
+        const int wordsCount = 1 + random(12);
+        for (int index = 0; index < wordsCount; ++index) {
+            words.append(s_words.at(random(s_words.size())));
+        }
+        return words.join(" ");
+    }
+
+    /**
+     * @brief Сформировать xml блока сценария
+     */
+    static QString blockXml(const QString& _type, const QString& _text) {
+        return
+                QString("<%1>\n<v><![CDATA[%2]]></v>\n</%1>\n")
+                .arg(_type, TextEditHelper::toHtmlEscaped(_text));
+    }
+
+    /**
+     * @brief Сформировать случайный блок сценария
+     */
+    static QString randomBlockXml() {
+        static const QStringList s_types =
+                QStringList() << "scene_heading" << "action" << "character" << "parenthetical" << "dialog";
+        return blockXml(s_types.at(random(s_types.size())), randomText());
+    }
+
+    /**
+     * @brief Внести случайную правку в несколько соседних блоков
+     */
+    static QVector<QString> randomEdit(const QVector<QString>& _blocks) {
+        QVector<QString> result = _blocks;
+        const int editsCount = 1 + random(3);
+        const int firstBlock = random(result.size());
+        for (int edit = 0; edit < editsCount; ++edit) {
+            const int block = qMin(firstBlock + edit, result.size() - 1);
+            switch (random(4)) {
+                case 0: {
+                    result.insert(block, randomBlockXml());
+                    break;
+                }
+
+                case 1: {
+                    if (result.size() > 1) {
+                        result.remove(block);
+                    }
+                    break;
+                }
+
+                default: {
+                    result[block] = randomBlockXml();
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Собрать текст из блоков
+     */
+    static QString joined(const QVector<QString>& _blocks) {
+        QString result;
+        foreach (const QString& block, _blocks) {
+            result.append(block);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Применить патч только к затрагиваемым блокам, так же как это делает ScenarioTextDocument
+     * @return Удалось ли применить патч к диапазону блоков
+     */
+    static bool applyPatchToBlocks(const QVector<QString>& _blocks, const QString& _patch, QString& _result) {
+        QVector<int> blocksPlainLengths;
+        foreach (const QString& block, _blocks) {
+            blocksPlainLengths.append(DiffMatchPatchHelper::plainLength(block));
+        }
+
+        int fromBlock = -1, toBlock = -1, plainOffset = 0;
+        if (!DiffMatchPatchHelper::patchBlocksRange(_patch, blocksPlainLengths, fromBlock, toBlock, plainOffset)) {
+            return false;
+        }
+
+        QString xml;
+        for (int block = fromBlock; block <= toBlock; ++block) {
+            xml.append(_blocks.at(block));
+        }
+        bool isApplied = false;
+        const QString newXml = DiffMatchPatchHelper::applyPatchXml(xml, _patch, plainOffset, isApplied);
+        if (!isApplied) {
+            return false;
+        }
+
+        _result = joined(_blocks.mid(0, fromBlock)) + newXml + joined(_blocks.mid(toBlock + 1));
+        return true;
+    }
+}
+
+
+/**
+ * @brief Тесты применения патчей к фрагменту текста
+ */
+class DiffMatchPatchHelperTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    /**
+     * @brief Патч к тому же тексту, из которого он сформирован, применяется к блокам так же, как ко всему тексту
+     */
+    void blocksPatchEqualsDocumentPatch();
+
+    /**
+     * @brief Патч соавтора к тексту с другими правками применяется к блокам так же, как ко всему тексту
+     */
+    void concurrentPatchEqualsDocumentPatch();
+
+    /**
+     * @brief Патч, сформированный для фрагмента со смещением, равен патчу для всего текста
+     */
+    void fragmentPatchEqualsDocumentPatch();
+
+private:
+    /**
+     * @brief Случайный исходный текст
+     */
+    QVector<QString> randomBlocks() const;
+};
+
+void DiffMatchPatchHelperTest::init()
+{
+    qsrand(20170315);
+}
+
+void DiffMatchPatchHelperTest::blocksPatchEqualsDocumentPatch()
+{
+    QVector<QString> blocks = randomBlocks();
+    for (int edit = 0; edit < RANDOM_EDITS_COUNT; ++edit) {
+        const QVector<QString> editedBlocks = randomEdit(blocks);
+        const QString xml = joined(blocks);
+        const QString patch = DiffMatchPatchHelper::makePatchXml(xml, joined(editedBlocks));
+        const QString expectedXml = DiffMatchPatchHelper::applyPatchXml(xml, patch);
+
+        QString blocksXml;
+        QVERIFY(applyPatchToBlocks(blocks, patch, blocksXml));
+        QCOMPARE(blocksXml, expectedXml);
+        QCOMPARE(blocksXml, joined(editedBlocks));
+
+        blocks = editedBlocks;
+    }
+}
+
+void DiffMatchPatchHelperTest::concurrentPatchEqualsDocumentPatch()
+{
+    int appliedToBlocks = 0;
+    for (int edit = 0; edit < RANDOM_EDITS_COUNT; ++edit) {
+        const QVector<QString> blocks = randomBlocks();
+        const QString patch = DiffMatchPatchHelper::makePatchXml(joined(blocks), joined(randomEdit(blocks)));
+
+        //
+        // Текст, к которому применяется патч, уже изменён другим автором
+        //
+        const QVector<QString> localBlocks = randomEdit(blocks);
+        const QString expectedXml = DiffMatchPatchHelper::applyPatchXml(joined(localBlocks), patch);
+
+        //
+        // Если к блокам применить не удалось, то документ применяет патч целиком,
+        // а если удалось, то результат должен совпасть с применением ко всему тексту
+        //
+        QString blocksXml;
+        if (applyPatchToBlocks(localBlocks, patch, blocksXml)) {
+            QCOMPARE(blocksXml, expectedXml);
+            ++appliedToBlocks;
+        }
+    }
+    QVERIFY(appliedToBlocks > 0);
+}
+
+void DiffMatchPatchHelperTest::fragmentPatchEqualsDocumentPatch()
+{
+    QVector<QString> blocks = randomBlocks();
+    for (int edit = 0; edit < RANDOM_EDITS_COUNT; ++edit) {
+        const int block = random(blocks.size());
+        QVector<QString> editedBlocks = blocks;
+        editedBlocks[block] = randomBlockXml();
+
+        int plainOffset = 0;
+        foreach (const QString& previousBlock, blocks.mid(0, block)) {
+            plainOffset += DiffMatchPatchHelper::plainLength(previousBlock);
+        }
+        const QString fragmentPatch =
+                DiffMatchPatchHelper::makePatchXml(blocks.at(block), editedBlocks.at(block), plainOffset);
+
+        QCOMPARE(DiffMatchPatchHelper::applyPatchXml(joined(blocks), fragmentPatch), joined(editedBlocks));
+
+        blocks = editedBlocks;
+    }
+}
+
+QVector<QString> DiffMatchPatchHelperTest::randomBlocks() const
+{
+    QVector<QString> blocks;
+    for (int block = 0; block < BLOCKS_COUNT; ++block) {
+        blocks.append(randomBlockXml());
+    }
+    return blocks;
+}
+
+QTEST_APPLESS_MAIN(DiffMatchPatchHelperTest)
+
+#include "DiffMatchPatchHelperTest.moc"
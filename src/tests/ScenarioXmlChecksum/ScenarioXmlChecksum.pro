@@ -0,0 +1,11 @@
+TARGET = ScenarioXmlChecksumTest
+TEMPLATE = app
+
+include(../tests.pri)
+
+HEADERS += \
+    $$SCENARIST_CORE/BusinessLayer/ScenarioDocument/ScenarioXmlChecksum.h
+
+SOURCES += \
+    $$SCENARIST_CORE/BusinessLayer/ScenarioDocument/ScenarioXmlChecksum.cpp \
+    ScenarioXmlChecksumTest.cpp
@@ -0,0 +1,155 @@
+#include <BusinessLayer/ScenarioDocument/ScenarioXmlChecksum.h>
+
+#include <QCryptographicHash>
+#include <QStringList>
+#include <QVector>
+#include <QtTest>
+
+using BusinessLogic::ScenarioXmlChecksum;
+
+namespace {
+    /**
+     * @brief Основание полиномиальной суммы, должно совпадать с используемым в ScenarioXmlChecksum
+     */
+    const quint64 CHECKSUM_BASE = 0x100000001B3ULL * 2 + 1;
+
+    /**
+     * @brief Количество блоков сценария в замерах производительности
+     */
+    const int BENCHMARK_BLOCKS_COUNT = 10000;
+
+    /**
+     * @brief Рассчитать сумму последовательности блоков напрямую
+     */
+    static quint64 bruteForceChecksum(const QVector<quint64>& _checksums) {
+        quint64 result = 0;
+        foreach (quint64 checksum, _checksums) {
+            result = result * CHECKSUM_BASE + checksum;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Сформировать xml блока сценария
+     */
+    static QString blockXml(int _index) {
+        return
+                QString("<action>\n<v><![CDATA[Block number %1 with some action text in it]]></v>\n</action>\n")
+                .arg(_index);
+    }
+}
+
+
+/**
+ * @brief Тесты контрольной суммы xml сценария
+ */
+class ScenarioXmlChecksumTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Сумма дерева совпадает с суммой, рассчитанной напрямую, при случайных изменениях
+     */
+    void randomEditsMatchBruteForce();
+
+    /**
+     * @brief Сумма не зависит от того, в каком порядке строилось дерево
+     */
+    void sameSequenceSameChecksum();
+
+    /**
+     * @brief Замер: изменение блока и получение суммы сценария
+     */
+    void benchmarkIncrementalUpdate();
+
+    /**
+     * @brief Замер: прежний способ, MD5 от xml всего сценария
+     */
+    void benchmarkWholeDocumentMd5();
+};
+
+void ScenarioXmlChecksumTest::randomEditsMatchBruteForce()
+{
+    qsrand(42);
+
+    ScenarioXmlChecksum tree;
+    QVector<quint64> checksums;
+    for (int step = 0; step < 5000; ++step) {
+        const int operation = qrand() % 3;
+        if (operation == 0 || checksums.isEmpty()) {
+            const int index = checksums.isEmpty() ? 0 : qrand() % (checksums.size() + 1);
+            const int count = 1 + qrand() % 3;
+            const quint64 checksum = ScenarioXmlChecksum::blockChecksum(blockXml(qrand()));
+            tree.insert(index, count, checksum);
+            checksums.insert(index, count, checksum);
+        } else if (operation == 1) {
+            const int index = qrand() % checksums.size();
+            const int count = qMin(1 + qrand() % 3, checksums.size() - index);
+            tree.remove(index, count);
+            checksums.remove(index, count);
+        } else {
+            const int index = qrand() % checksums.size();
+            const quint64 checksum = ScenarioXmlChecksum::blockChecksum(blockXml(qrand()));
+            tree.update(index, checksum);
+            checksums[index] = checksum;
+        }
+
+        QCOMPARE(tree.size(), checksums.size());
+        QCOMPARE(tree.value(), bruteForceChecksum(checksums));
+    }
+}
+
+void ScenarioXmlChecksumTest::sameSequenceSameChecksum()
+{
+    ScenarioXmlChecksum appended;
+    ScenarioXmlChecksum prepended;
+    for (int index = 0; index < 100; ++index) {
+        appended.insert(index, 1, ScenarioXmlChecksum::blockChecksum(blockXml(index)));
+        prepended.insert(0, 1, ScenarioXmlChecksum::blockChecksum(blockXml(99 - index)));
+    }
+    QCOMPARE(appended.value(), prepended.value());
+
+    appended.update(50, ScenarioXmlChecksum::blockChecksum(blockXml(-1)));
+    QVERIFY(appended.value() != prepended.value());
+}
+
+void ScenarioXmlChecksumTest::benchmarkIncrementalUpdate()
+{
+    ScenarioXmlChecksum tree;
+    for (int index = 0; index < BENCHMARK_BLOCKS_COUNT; ++index) {
+        tree.insert(index, 1, ScenarioXmlChecksum::blockChecksum(blockXml(index)));
+    }
+
+    int edit = 0;
+    quint64 checksum = 0;
+    QBENCHMARK {
+        const int index = (edit * 7919) % BENCHMARK_BLOCKS_COUNT;
+        tree.update(index, ScenarioXmlChecksum::blockChecksum(blockXml(BENCHMARK_BLOCKS_COUNT + edit)));
+        checksum = tree.value();
+        ++edit;
+    }
+    Q_UNUSED(checksum);
+}
+
+void ScenarioXmlChecksumTest::benchmarkWholeDocumentMd5()
+{
+    QStringList blocks;
+    for (int index = 0; index < BENCHMARK_BLOCKS_COUNT; ++index) {
+        blocks.append(blockXml(index));
+    }
+
+    int edit = 0;
+    QByteArray checksum;
+    QBENCHMARK {
+        const int index = (edit * 7919) % BENCHMARK_BLOCKS_COUNT;
+        blocks[index] = blockXml(BENCHMARK_BLOCKS_COUNT + edit);
+        checksum = QCryptographicHash::hash(blocks.join(QString()).toUtf8(), QCryptographicHash::Md5);
+        ++edit;
+    }
+    Q_UNUSED(checksum);
+}
+
+QTEST_APPLESS_MAIN(ScenarioXmlChecksumTest)
+
+#include "ScenarioXmlChecksumTest.moc"
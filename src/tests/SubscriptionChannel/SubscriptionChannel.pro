@@ -0,0 +1,21 @@
+TARGET = SubscriptionChannelTest
+TEMPLATE = app
+
+include(../tests.pri)
+
+#
+# Канал подписки работает через WebLoader, а тест поднимает локальный сервер
+#
+QT += network xml
+
+LIBS += -L$$DESTDIR/../../libs/webloader/ -lwebloader
+
+INCLUDEPATH += $$PWD/../../libs/webloader/src
+DEPENDPATH += $$PWD/../../libs/webloader/src
+
+HEADERS += \
+    $$SCENARIST_CORE/ManagementLayer/Synchronization/SubscriptionChannel.h
+
+SOURCES += \
+    $$SCENARIST_CORE/ManagementLayer/Synchronization/SubscriptionChannel.cpp \
+    SubscriptionChannelTest.cpp
@@ -0,0 +1,306 @@
+#include <ManagementLayer/Synchronization/SubscriptionChannel.h>
+
+#include <QPointer>
+#include <QQueue>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtTest>
+
+using ManagementLayer::SubscriptionChannel;
+
+namespace {
+    /**
+     * @brief Сколько ждать событий канала
+     */
+    const int WAIT_TIMEOUT = 5000;
+
+    /**
+     * @brief Ответ сервера с событиями проекта
+     */
+    const QByteArray EVENTS_RESPONSE =
+            "<?xml version=\"1.0\"?>\n"
+            "<response>\n"
+            "<status result=\"true\"/>\n"
+            "<events last_event_id=\"42\">\n"
+            "<change id=\"{change-1}\"/>\n"
+            "<change id=\"{change-2}\"/>\n"
+            "<data id=\"{data-1}\"/>\n"
+            "<cursors>\n"
+            "<cursor username=\"first@example.com\" position=\"10\" is_draft=\"0\"/>\n"
+            "<cursor username=\"second@example.com\" position=\"20\" is_draft=\"1\"/>\n"
+            "</cursors>\n"
+            "</events>\n"
+            "</response>\n";
+
+    /**
+     * @brief Ответ сервера, не поддерживающего подписку
+     */
+    const QByteArray REJECTED_RESPONSE =
+            "<?xml version=\"1.0\"?>\n"
+            "<response>\n"
+            "<status result=\"false\" error_code=\"404\"/>\n"
+            "</response>\n";
+}
+
+
+/**
+ * @brief Локальный сервер, заменяющий сервер подписки
+ *
+ * Отвечает на запросы заранее заданными ответами по порядку, а когда они заканчиваются,
+ * удерживает запрос, как это делает сервер при отсутствии событий
+ */
+class SubscriptionServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SubscriptionServer(QObject* _parent = 0) :
+        QObject(_parent)
+    {
+        connect(&m_server, &QTcpServer::newConnection, this, &SubscriptionServer::acceptConnection);
+        m_server.listen(QHostAddress::LocalHost);
+    }
+
+    /**
+     * @brief Адрес сервера
+     */
+    QUrl url() const {
+        return QUrl(QString("http://127.0.0.1:%1/api/projects/subscribe/").arg(m_server.serverPort()));
+    }
+
+    /**
+     * @brief Добавить ответ в очередь
+     */
+    void enqueueResponse(const QByteArray& _response) {
+        m_responses.enqueue(_response);
+    }
+
+    /**
+     * @brief Полученные запросы
+     */
+    QList<QByteArray> requests() const {
+        return m_requests;
+    }
+
+    /**
+     * @brief Соединение, в котором удерживается запрос
+     */
+    QTcpSocket* heldConnection() const {
+        return m_heldConnection.data();
+    }
+
+signals:
+    /**
+     * @brief Получен запрос
+     */
+    void requestReceived();
+
+private:
+    /**
+     * @brief Принять соединение
+     */
+    void acceptConnection() {
+        while (m_server.hasPendingConnections()) {
+            QTcpSocket* socket = m_server.nextPendingConnection();
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket] { readRequest(socket); });
+            connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+        }
+    }
+
+    /**
+     * @brief Считать запрос и, когда он получен полностью, ответить на него
+     */
+    void readRequest(QTcpSocket* _socket) {
+        QByteArray request = _socket->property("request").toByteArray() + _socket->readAll();
+        _socket->setProperty("request", request);
+
+        const int headersEnd = request.indexOf("\r\n\r\n");
+        if (headersEnd == -1) {
+            return;
+        }
+        const QByteArray headers = request.left(headersEnd).toLower();
+        const QByteArray contentLengthHeader = "content-length:";
+        const int contentLengthIndex = headers.indexOf(contentLengthHeader);
+        if (contentLengthIndex != -1) {
+            const int contentLengthEnd = headers.indexOf("\r\n", contentLengthIndex);
+            const int contentLength =
+                    headers.mid(contentLengthIndex + contentLengthHeader.size(),
+                                contentLengthEnd - contentLengthIndex - contentLengthHeader.size()).trimmed().toInt();
+            if (request.size() < headersEnd + 4 + contentLength) {
+                return;
+            }
+        }
+
+        m_requests.append(request);
+        emit requestReceived();
+
+        if (m_responses.isEmpty()) {
+            m_heldConnection = _socket;
+            return;
+        }
+
+        const QByteArray body = m_responses.dequeue();
+        _socket->write("HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/xml; charset=utf-8\r\n"
+                       "Connection: close\r\n"
+                       "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                       "\r\n" + body);
+        _socket->disconnectFromHost();
+    }
+
+private:
+    QTcpServer m_server;
+    QQueue<QByteArray> m_responses;
+    QList<QByteArray> m_requests;
+    QPointer<QTcpSocket> m_heldConnection;
+};
+
+
+/**
+ * @brief Тесты канала подписки на события проекта
+ */
+class SubscriptionChannelTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    SubscriptionChannelTest() {
+        qRegisterMetaType<QList<QString> >("QList<QString>");
+        qRegisterMetaType<QMap<QString, int> >("QMap<QString,int>");
+    }
+
+private slots:
+    /**
+     * @brief События из ответа сервера доставляются сигналами, а следующий запрос
+     *        отправляется с идентификатором последнего полученного события
+     */
+    void eventsAreDelivered();
+
+    /**
+     * @brief Если сервер не поддерживает подписку, канал остаётся неактивным
+     */
+    void rejectedSubscriptionIsInactive();
+
+    /**
+     * @brief Остановка канала прерывает удерживаемый сервером запрос
+     */
+    void stopInterruptsHeldRequest();
+
+private:
+    /**
+     * @brief Значение параметра запроса
+     */
+    static QByteArray requestAttribute(const QByteArray& _request, const QByteArray& _name);
+};
+
+void SubscriptionChannelTest::eventsAreDelivered()
+{
+    SubscriptionServer server;
+    server.enqueueResponse(EVENTS_RESPONSE);
+
+    SubscriptionChannel channel;
+    channel.setUrl(server.url());
+    QSignalSpy activeSpy(&channel, &SubscriptionChannel::activeChanged);
+    QSignalSpy scenarioSpy(&channel, &SubscriptionChannel::scenarioChangesAvailable);
+    QSignalSpy dataSpy(&channel, &SubscriptionChannel::dataChangesAvailable);
+    QSignalSpy cursorsSpy(&channel, &SubscriptionChannel::cursorsUpdated);
+    QSignalSpy requestsSpy(&server, &SubscriptionServer::requestReceived);
+
+    channel.start("session", 7);
+
+    QTRY_COMPARE_WITH_TIMEOUT(requestsSpy.count(), 2, WAIT_TIMEOUT);
+    QVERIFY(channel.isActive());
+    QCOMPARE(activeSpy.count(), 1);
+    QCOMPARE(activeSpy.first().first().toBool(), true);
+
+    QCOMPARE(scenarioSpy.count(), 1);
+    QCOMPARE(scenarioSpy.first().first().value<QList<QString> >(),
+             QList<QString>() << "{change-1}" << "{change-2}");
+    QCOMPARE(dataSpy.count(), 1);
+    QCOMPARE(dataSpy.first().first().value<QList<QString> >(), QList<QString>() << "{data-1}");
+
+    QCOMPARE(cursorsSpy.count(), 2);
+    QMap<QString, int> cleanCursors;
+    cleanCursors.insert("first@example.com", 10);
+    QMap<QString, int> draftCursors;
+    draftCursors.insert("second@example.com", 20);
+    QCOMPARE(cursorsSpy.at(0).at(0).value<QMap<QString, int> >(), cleanCursors);
+    QCOMPARE(cursorsSpy.at(0).at(1).toBool(), false);
+    QCOMPARE(cursorsSpy.at(1).at(0).value<QMap<QString, int> >(), draftCursors);
+    QCOMPARE(cursorsSpy.at(1).at(1).toBool(), true);
+
+    const QList<QByteArray> requests = server.requests();
+    QCOMPARE(requestAttribute(requests.at(0), "project_id"), QByteArray("7"));
+    QCOMPARE(requestAttribute(requests.at(0), "last_event_id"), QByteArray());
+    QCOMPARE(requestAttribute(requests.at(1), "last_event_id"), QByteArray("42"));
+
+    channel.stop();
+}
+
+void SubscriptionChannelTest::rejectedSubscriptionIsInactive()
+{
+    SubscriptionServer server;
+    server.enqueueResponse(REJECTED_RESPONSE);
+
+    SubscriptionChannel channel;
+    channel.setUrl(server.url());
+    QSignalSpy activeSpy(&channel, &SubscriptionChannel::activeChanged);
+    QSignalSpy scenarioSpy(&channel, &SubscriptionChannel::scenarioChangesAvailable);
+    QSignalSpy requestsSpy(&server, &SubscriptionServer::requestReceived);
+
+    channel.start("session", 7);
+
+    QTRY_COMPARE_WITH_TIMEOUT(requestsSpy.count(), 1, WAIT_TIMEOUT);
+    //
+    // Даём каналу обработать ответ и убеждаемся, что повторный запрос не отправлен сразу
+    //
+    QTest::qWait(500);
+    QCOMPARE(requestsSpy.count(), 1);
+    QVERIFY(channel.isRunning());
+    QVERIFY(!channel.isActive());
+    QCOMPARE(activeSpy.count(), 0);
+    QCOMPARE(scenarioSpy.count(), 0);
+
+    channel.stop();
+}
+
+void SubscriptionChannelTest::stopInterruptsHeldRequest()
+{
+    SubscriptionServer server;
+
+    SubscriptionChannel channel;
+    channel.setUrl(server.url());
+    QSignalSpy requestsSpy(&server, &SubscriptionServer::requestReceived);
+
+    channel.start("session", 7);
+
+    QTRY_COMPARE_WITH_TIMEOUT(requestsSpy.count(), 1, WAIT_TIMEOUT);
+    QPointer<QTcpSocket> heldConnection = server.heldConnection();
+    QVERIFY(!heldConnection.isNull());
+
+    channel.stop();
+    QVERIFY(!channel.isRunning());
+
+    //
+    // Соединение закрывается клиентом, не дожидаясь таймаута запроса
+    //
+    QTRY_VERIFY_WITH_TIMEOUT(heldConnection.isNull()
+                             || heldConnection->state() == QAbstractSocket::UnconnectedState,
+                             WAIT_TIMEOUT);
+}
+
+QByteArray SubscriptionChannelTest::requestAttribute(const QByteArray& _request, const QByteArray& _name)
+{
+    const QByteArray disposition = "name=\"" + _name + "\"\r\n\r\n";
+    const int valueStart = _request.indexOf(disposition);
+    if (valueStart == -1) {
+        return QByteArray();
+    }
+    const int valueBegin = valueStart + disposition.size();
+    return _request.mid(valueBegin, _request.indexOf("\r\n", valueBegin) - valueBegin);
+}
+
+QTEST_GUILESS_MAIN(SubscriptionChannelTest)
+
+#include "SubscriptionChannelTest.moc"
@@ -0,0 +1,28 @@
+#
+# Общие настройки тестов
+#
+QT += testlib
+QT -= gui
+
+CONFIG += c++11 testcase console
+CONFIG -= app_bundle
+
+#
+# Конфигурируем расположение файлов сборки
+#
+CONFIG(debug, debug|release) {
+    DESTDIR = $$PWD/../../build/Debug/tests/$$TARGET
+} else {
+    DESTDIR = $$PWD/../../build/Release/tests/$$TARGET
+}
+
+OBJECTS_DIR = $$DESTDIR/.obj
+MOC_DIR = $$DESTDIR/.moc
+RCC_DIR = $$DESTDIR/.qrc
+UI_DIR = $$DESTDIR/.ui
+
+#
+# Тестируемый код берётся непосредственно из исходников приложения
+#
+SCENARIST_CORE = $$PWD/../bin/scenarist-core
+INCLUDEPATH += $$SCENARIST_CORE
@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+SUBDIRS = \
+    DatabaseHelper \
+    DatabaseIndexes \
+    DiffMatchPatchHelper \
+    ScenarioXmlChecksum \
+    SubscriptionChannel